@@ -0,0 +1,130 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+#include <algorithm>
+
+
+namespace MagoST
+{
+    // An address index of the lexical blocks (and nested functions and
+    // thunks) under one function, so that the chain of scopes around an
+    // address can be found without decoding the child symbols of each level.
+    //
+    // Add each scope with the index of the scope it's in, then call Build.
+    // Scopes are expected to nest. Sorted by start, the innermost scope
+    // around an address is then the last scope that starts at or before it,
+    // or one of that scope's ancestors.
+
+    class BlockScopeIndex
+    {
+        struct Node
+        {
+            uint32_t    Start;
+            uint32_t    End;
+            uint32_t    Parent;
+            uint32_t    Depth;
+            SymHandle   Handle;
+
+            bool operator<( const Node& other ) const
+            {
+                // parents come before children that start at the same place
+                if ( Start != other.Start )
+                    return Start < other.Start;
+                return Depth < other.Depth;
+            }
+        };
+
+        std::vector<Node>   mNodes;
+
+    public:
+        static const uint32_t   NoParent = 0xFFFFFFFF;
+
+        // Returns the index to pass as the parent of the scope's children.
+        uint32_t Add( uint32_t start, uint32_t length, uint32_t parent, const SymHandle& handle )
+        {
+            Node    node;
+
+            node.Start = start;
+            node.End = start + length;
+            node.Parent = parent;
+            node.Depth = (parent == NoParent) ? 0 : mNodes[parent].Depth + 1;
+            node.Handle = handle;
+
+            mNodes.push_back( node );
+            return (uint32_t) mNodes.size() - 1;
+        }
+
+        void Build()
+        {
+            std::vector<uint32_t>   order( mNodes.size() );
+            std::vector<uint32_t>   newIndexes( mNodes.size() );
+            std::vector<Node>       sorted( mNodes.size() );
+
+            for ( uint32_t i = 0; i < order.size(); i++ )
+                order[i] = i;
+
+            std::stable_sort( order.begin(), order.end(), OrderLess( mNodes ) );
+
+            for ( uint32_t i = 0; i < order.size(); i++ )
+            {
+                newIndexes[ order[i] ] = i;
+                sorted[i] = mNodes[ order[i] ];
+            }
+
+            for ( uint32_t i = 0; i < sorted.size(); i++ )
+            {
+                if ( sorted[i].Parent != NoParent )
+                    sorted[i].Parent = newIndexes[ sorted[i].Parent ];
+            }
+
+            mNodes.swap( sorted );
+        }
+
+        // Appends the handles of the scopes around the offset, outermost first.
+        void FindScopes( uint32_t offset, std::vector<SymHandle>& handles ) const
+        {
+            Node    key = { 0 };
+
+            key.Start = offset;
+            key.Depth = 0xFFFFFFFF;
+
+            std::vector<Node>::const_iterator   it = std::upper_bound( mNodes.begin(), mNodes.end(), key );
+            uint32_t                            index = NoParent;
+
+            if ( it != mNodes.begin() )
+                index = (uint32_t) (it - mNodes.begin()) - 1;
+
+            while ( (index != NoParent) && (offset >= mNodes[index].End) )
+                index = mNodes[index].Parent;
+
+            size_t  outerCount = handles.size();
+
+            for ( ; index != NoParent; index = mNodes[index].Parent )
+                handles.push_back( mNodes[index].Handle );
+
+            std::reverse( handles.begin() + outerCount, handles.end() );
+        }
+
+    private:
+        struct OrderLess
+        {
+            const std::vector<Node>*    Nodes;
+
+            explicit OrderLess( const std::vector<Node>& nodes )
+                :   Nodes( &nodes )
+            {
+            }
+
+            bool operator()( uint32_t left, uint32_t right ) const
+            {
+                return (*Nodes)[left] < (*Nodes)[right];
+            }
+        };
+    };
+}
@@ -8,6 +8,7 @@
 #include "Common.h"
 #include "CVSTIPublic.h"
 #include "DataSource.h"
+#include "../CVSym/PDBDebugStore.h"
 
 
 namespace MagoST
@@ -24,4 +25,9 @@ namespace MagoST
 
         return S_OK;
     }
+
+    void EnablePdbReader( bool enable )
+    {
+        PDBDebugStore::EnableReader( enable );
+    }
 }
@@ -23,4 +23,9 @@ namespace MagoST
 
 
     EXPORT HRESULT MakeDataSource( IDataSource*& dataSource );
+
+    // Whether PDBs opened after this have their source files and lines read
+    // straight from the PDB, or through DIA. On by default; it's there to 
+    // compare the two.
+    EXPORT void EnablePdbReader( bool enable );
 }
@@ -0,0 +1,141 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+
+namespace MagoST
+{
+    // A hash index from name to handle over the children of one symbol or
+    // type scope. The names are copied into one buffer owned by the index,
+    // so that the index doesn't depend on how the store hands out names.
+    //
+    // Add all the children in scope order, then call Build. If more than one
+    // child has the same name, then the first one wins, like a linear search.
+
+    template <class THandle>
+    class ChildNameIndex
+    {
+        struct Entry
+        {
+            uint32_t    Hash;
+            uint32_t    NameOffset;
+            uint32_t    NameLen;
+            THandle     Handle;
+        };
+
+        static const uint32_t   EmptySlot = 0xFFFFFFFF;
+
+        std::vector<Entry>      mEntries;
+        std::vector<uint32_t>   mSlots;
+        std::vector<char>       mNames;
+
+    public:
+        void Add( const char* name, size_t nameLen, const THandle& handle )
+        {
+            Entry   entry;
+
+            // nothing can look up an unnamed child
+            if ( nameLen == 0 )
+                return;
+
+            entry.Hash = GetNameHash( name, nameLen );
+            entry.NameOffset = (uint32_t) mNames.size();
+            entry.NameLen = (uint32_t) nameLen;
+            entry.Handle = handle;
+
+            mNames.insert( mNames.end(), name, name + nameLen );
+            mEntries.push_back( entry );
+        }
+
+        void Build()
+        {
+            uint32_t    slotCount = 16;
+
+            while ( slotCount < (mEntries.size() * 2) )
+                slotCount *= 2;
+
+            mSlots.assign( slotCount, EmptySlot );
+
+            for ( uint32_t i = 0; i < mEntries.size(); i++ )
+            {
+                const Entry&    entry = mEntries[i];
+                uint32_t        slot = 0;
+
+                if ( FindSlot( &mNames[0] + entry.NameOffset, entry.NameLen, entry.Hash, slot ) )
+                    continue;
+
+                mSlots[slot] = i;
+            }
+        }
+
+        bool Find( const char* name, size_t nameLen, THandle& handle ) const
+        {
+            uint32_t    slot = 0;
+
+            if ( mSlots.size() == 0 )
+                return false;
+
+            if ( !FindSlot( name, nameLen, GetNameHash( name, nameLen ), slot ) )
+                return false;
+
+            handle = mEntries[ mSlots[slot] ].Handle;
+            return true;
+        }
+
+        static uint32_t GetNameHash( const char* name, size_t nameLen )
+        {
+            // FNV-1a
+            uint32_t    hash = 2166136261U;
+
+            for ( size_t i = 0; i < nameLen; i++ )
+            {
+                hash ^= (uint8_t) name[i];
+                hash *= 16777619U;
+            }
+
+            return hash;
+        }
+
+    private:
+        // Returns whether the name is in the table. Either way, slot is set to
+        // the slot where it was found or where it should be put.
+
+        bool FindSlot( const char* name, size_t nameLen, uint32_t hash, uint32_t& slot ) const
+        {
+            const uint32_t  mask = (uint32_t) mSlots.size() - 1;
+
+            for ( slot = hash & mask; mSlots[slot] != EmptySlot; slot = (slot + 1) & mask )
+            {
+                const Entry&    entry = mEntries[ mSlots[slot] ];
+
+                if ( (entry.Hash == hash)
+                    && (entry.NameLen == nameLen)
+                    && (memcmp( &mNames[0] + entry.NameOffset, name, nameLen ) == 0) )
+                    return true;
+            }
+
+            return false;
+        }
+    };
+
+
+    // Both symbol stores fill in the whole handle, even the PDB store, whose 
+    // handles only need part of it, so all of it can be compared.
+
+    template <class THandle>
+    struct HandleLess
+    {
+        bool operator()( const THandle& left, const THandle& right ) const
+        {
+            if ( left.unused1 != right.unused1 )
+                return left.unused1 < right.unused1;
+
+            return left.unused2 < right.unused2;
+        }
+    };
+}
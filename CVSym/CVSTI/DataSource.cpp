@@ -11,7 +11,9 @@
 #include "IAddressMap.h"
 #include "ImageDebugContainer.h"
 #include "Session.h"
+#include "STIUtil.h"
 #include "../CVSym/PDBDebugStore.h"
+#include <algorithm>
 
 using namespace std;
 
@@ -22,7 +24,10 @@ namespace MagoST
         :   mRefCount( 0 ),
             mDebugView( NULL ),
             mDebugSize( 0 ),
-            mStore( NULL )
+            mStore( NULL ),
+            mHasImageIdentity( false ),
+            mImageTimeStamp( 0 ),
+            mImageCheckSum( 0 )
     {
     }
 
@@ -75,6 +80,8 @@ namespace MagoST
         if ( FAILED( hr ) )
             return hr;
 
+        mHasImageIdentity = container->GetImageIdentity( mImageTimeStamp, mImageCheckSum );
+
         mAddrMap.Attach( addrMap.Detach() );
         mDebugContainer.reset( container.release() );
 
@@ -86,6 +93,8 @@ namespace MagoST
         HRESULT hr;
 
         delete mStore;
+        mIndexCacheView = NULL;
+
         if( mDebugView && memcmp( mDebugView, "RSDS", 4 ) == 0 )
         {
             PDBDebugStore* pdbStore = new PDBDebugStore;
@@ -100,13 +109,268 @@ namespace MagoST
                 store->SetTLSSegment( mAddrMap->FindSection( ".tls" ) );
                 store->SetTextSegment( mAddrMap->FindSection( "_TEXT" ) );
             }
-            hr = store->InitDebugInfo( mDebugView, mDebugSize );
+            hr = InitDebugStore( filename, store );
             mStore = store;
         }
 
         return hr;
     }
 
+    // The index cache of an image lives in the temp folder, named after the
+    // image and its identity, so that each build of a program has its own.
+    // Every build leaves one behind, so the folder is trimmed to the caches 
+    // used recently, and to a total size, whenever a new one is written.
+
+    static const DWORD      IndexCacheMaxAgeDays = 30;
+    static const ULONGLONG  IndexCacheMaxTotalSize = 256 * 1024 * 1024;
+
+    static bool GetIndexCacheDir( wstring& dir )
+    {
+        wchar_t         tempPath[MAX_PATH] = L"";
+        DWORD           len = 0;
+
+        len = GetTempPath( _countof( tempPath ), tempPath );
+        if ( (len == 0) || (len >= _countof( tempPath )) )
+            return false;
+
+        dir = tempPath;
+        dir.append( L"MagoSymCache" );
+
+        if ( !CreateDirectory( dir.c_str(), NULL ) && (GetLastError() != ERROR_ALREADY_EXISTS) )
+            return false;
+
+        return true;
+    }
+
+    static bool GetIndexCachePath( const wchar_t* filename, DWORD timeStamp, DWORD checkSum, wstring& path )
+    {
+        wchar_t         suffix[32] = L"";
+        const wchar_t*  baseName = filename;
+
+        if ( !GetIndexCacheDir( path ) )
+            return false;
+
+        for ( const wchar_t* p = filename; *p != L'\0'; p++ )
+        {
+            if ( (*p == L'\\') || (*p == L'/') || (*p == L':') )
+                baseName = p + 1;
+        }
+
+        swprintf_s( suffix, L".%08X%08X.idx", timeStamp, checkSum );
+
+        path.append( L"\\" );
+        path.append( baseName );
+        path.append( suffix );
+        return true;
+    }
+
+    static ULONGLONG FileTimeToUInt64( const FILETIME& fileTime )
+    {
+        return ((ULONGLONG) fileTime.dwHighDateTime << 32) | fileTime.dwLowDateTime;
+    }
+
+    // the last write time of a cache is when it was last used
+    static void TouchIndexCache( const wchar_t* path )
+    {
+        FileHandlePtr   hFile;
+        FILETIME        now = { 0 };
+
+        hFile = CreateFile( path, FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, 
+            NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+        if ( hFile.IsEmpty() )
+            return;
+
+        GetSystemTimeAsFileTime( &now );
+        SetFileTime( hFile, NULL, NULL, &now );
+    }
+
+    struct IndexCacheFile
+    {
+        wstring     Name;
+        ULONGLONG   LastWriteTime;
+        ULONGLONG   Size;
+    };
+
+    static bool IndexCacheFileOlder( const IndexCacheFile& file1, const IndexCacheFile& file2 )
+    {
+        return file1.LastWriteTime < file2.LastWriteTime;
+    }
+
+    static void TrimIndexCaches()
+    {
+        const ULONGLONG         TicksPerDay = 24ULL * 60 * 60 * 10000000;
+
+        wstring                 dir;
+        wstring                 pattern;
+        HANDLE                  hFind = INVALID_HANDLE_VALUE;
+        WIN32_FIND_DATA         findData = { 0 };
+        FILETIME                nowFileTime = { 0 };
+        ULONGLONG               now = 0;
+        ULONGLONG               totalSize = 0;
+        vector<IndexCacheFile>  files;
+
+        if ( !GetIndexCacheDir( dir ) )
+            return;
+
+        pattern = dir;
+        pattern.append( L"\\*.idx" );
+
+        hFind = FindFirstFile( pattern.c_str(), &findData );
+        if ( hFind == INVALID_HANDLE_VALUE )
+            return;
+
+        do
+        {
+            IndexCacheFile  file;
+
+            if ( (findData.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0 )
+                continue;
+
+            file.Name = dir;
+            file.Name.append( L"\\" );
+            file.Name.append( findData.cFileName );
+            file.LastWriteTime = FileTimeToUInt64( findData.ftLastWriteTime );
+            file.Size = ((ULONGLONG) findData.nFileSizeHigh << 32) | findData.nFileSizeLow;
+
+            files.push_back( file );
+        }
+        while ( FindNextFile( hFind, &findData ) );
+
+        FindClose( hFind );
+
+        GetSystemTimeAsFileTime( &nowFileTime );
+        now = FileTimeToUInt64( nowFileTime );
+
+        // oldest first, so the ones used most recently are kept; a cache that 
+        // another debugger has mapped can't be deleted, so it's skipped
+
+        std::sort( files.begin(), files.end(), IndexCacheFileOlder );
+
+        for ( size_t i = 0; i < files.size(); i++ )
+            totalSize += files[i].Size;
+
+        for ( size_t i = 0; i < files.size(); i++ )
+        {
+            bool    expired = (now > files[i].LastWriteTime) 
+                && ((now - files[i].LastWriteTime) / TicksPerDay >= IndexCacheMaxAgeDays);
+
+            if ( !expired && (totalSize <= IndexCacheMaxTotalSize) )
+                break;
+
+            if ( DeleteFile( files[i].Name.c_str() ) )
+                totalSize -= files[i].Size;
+        }
+    }
+
+    static HRESULT MapIndexCache( const wchar_t* path, MappedPtr& view, DWORD& size )
+    {
+        FileHandlePtr   hFile;
+        HandlePtr       hMapping;
+        DWORD           hiSize = 0;
+
+        hFile = CreateFile( path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+        if ( hFile.IsEmpty() )
+            return GetLastHr();
+
+        size = GetFileSize( hFile, &hiSize );
+        if ( size == INVALID_FILE_SIZE )
+            return GetLastHr();
+        if ( (size == 0) || (hiSize > 0) )
+            return E_BAD_FORMAT;
+
+        hMapping = CreateFileMapping( hFile, NULL, PAGE_READONLY, 0, 0, NULL );
+        if ( hMapping.IsEmpty() )
+            return GetLastHr();
+
+        view = MapViewOfFile( hMapping, FILE_MAP_READ, 0, 0, 0 );
+        if ( view.IsEmpty() )
+            return GetLastHr();
+
+        return S_OK;
+    }
+
+    static HRESULT WriteIndexCache( const wchar_t* path, const vector<BYTE>& bytes )
+    {
+        // write it whole under another name first, so that another debugger
+        // never maps half of a cache file
+
+        wstring         tempPath( path );
+        wchar_t         suffix[32] = L"";
+        FileHandlePtr   hFile;
+        DWORD           written = 0;
+
+        swprintf_s( suffix, L".%u.tmp", GetCurrentProcessId() );
+        tempPath.append( suffix );
+
+        hFile = CreateFile( tempPath.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL );
+        if ( hFile.IsEmpty() )
+            return GetLastHr();
+
+        if ( !WriteFile( hFile, &bytes[0], (DWORD) bytes.size(), &written, NULL ) || (written != bytes.size()) )
+        {
+            HRESULT hr = GetLastHr();
+            CloseHandle( hFile.Detach() );
+            DeleteFile( tempPath.c_str() );
+            return hr;
+        }
+
+        CloseHandle( hFile.Detach() );
+
+        if ( !MoveFileEx( tempPath.c_str(), path, MOVEFILE_REPLACE_EXISTING ) )
+        {
+            HRESULT hr = GetLastHr();
+            DeleteFile( tempPath.c_str() );
+            return hr;
+        }
+
+        return S_OK;
+    }
+
+    HRESULT DataSource::InitDebugStore( const wchar_t* filename, DebugStore* store )
+    {
+        HRESULT     hr = S_OK;
+        wstring     cachePath;
+        DWORD       cacheSize = 0;
+
+        // the cache is only an optimization, so any problem with it just
+        // means that the indexes are built from the debug info
+
+        if ( !mHasImageIdentity || (filename == NULL) 
+            || !GetIndexCachePath( filename, mImageTimeStamp, mImageCheckSum, cachePath ) )
+            return store->InitDebugInfo( mDebugView, mDebugSize );
+
+        store->SetImageIdentity( mImageTimeStamp, mImageCheckSum );
+
+        hr = MapIndexCache( cachePath.c_str(), mIndexCacheView, cacheSize );
+        if ( SUCCEEDED( hr ) )
+            store->SetIndexCache( (BYTE*) mIndexCacheView.Get(), cacheSize );
+
+        hr = store->InitDebugInfo( mDebugView, mDebugSize );
+        if ( FAILED( hr ) )
+            return hr;
+
+        // the store reads the indexes straight from the mapped cache, so it 
+        // stays mapped as long as the store is alive
+
+        if ( store->IsIndexCacheLoaded() )
+        {
+            TouchIndexCache( cachePath.c_str() );
+        }
+        else
+        {
+            vector<BYTE>    cacheBytes;
+
+            // unmap it, so that a stale one can be replaced
+            mIndexCacheView = NULL;
+
+            if ( SUCCEEDED( store->SaveIndexCache( cacheBytes ) ) 
+                && SUCCEEDED( WriteIndexCache( cachePath.c_str(), cacheBytes ) ) )
+                TrimIndexCaches();
+        }
+
+        return S_OK;
+    }
+
     HRESULT DataSource::InitDebugInfo( IDiaSession* session, IAddressMap* addrMap )
     {
         PDBDebugStore* pdbStore = new PDBDebugStore;
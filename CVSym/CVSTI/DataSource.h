@@ -8,11 +8,13 @@
 #pragma once
 
 #include "IDataSource.h"
+#include "STIUtil.h"
 
 namespace MagoST
 {
     class IDebugContainer;
     class IAddressMap;
+    class DebugStore;
 
 
     class DataSource : public IDataSource
@@ -24,6 +26,13 @@ namespace MagoST
         DWORD                           mDebugSize;
         MagoST::IDebugStore*            mStore;
 
+        bool                            mHasImageIdentity;
+        DWORD                           mImageTimeStamp;
+        DWORD                           mImageCheckSum;
+
+        // the index cache that the store uses in place
+        MappedPtr                       mIndexCacheView;
+
         RefPtr<IAddressMap>             mAddrMap;
 
     public:
@@ -45,5 +54,8 @@ namespace MagoST
 
         IDebugStore* GetDebugStore();
         RefPtr<IAddressMap> GetAddressMap();
+
+    private:
+        HRESULT InitDebugStore( const wchar_t* filename, DebugStore* store );
     };
 }
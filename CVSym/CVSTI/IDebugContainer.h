@@ -23,5 +23,8 @@ namespace MagoST
 
         virtual bool HasAddressMap() = 0;
         virtual HRESULT GetAddressMap( IAddressMap*& map ) = 0;
+
+        // the link time stamp and checksum from the image or DBG file header
+        virtual bool GetImageIdentity( DWORD& timeStamp, DWORD& checkSum ) = 0;
     };
 }
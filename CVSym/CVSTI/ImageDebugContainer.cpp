@@ -291,4 +291,27 @@ namespace MagoST
 
         return S_OK;
     }
+
+    bool ImageDebugContainer::GetImageIdentity( DWORD& timeStamp, DWORD& checkSum )
+    {
+        if ( mImage.get() != NULL )
+        {
+            // the checksum is at the same place in 32 and 64-bit optional headers
+            IMAGE_NT_HEADERS32* ntHeaders = (IMAGE_NT_HEADERS32*) mImage->GetNtHeadersBase();
+
+            timeStamp = ntHeaders->FileHeader.TimeDateStamp;
+            checkSum = ntHeaders->OptionalHeader.CheckSum;
+        }
+        else if ( mDbg.get() != NULL )
+        {
+            const IMAGE_SEPARATE_DEBUG_HEADER*  dbgHeader = mDbg->GetHeader();
+
+            timeStamp = dbgHeader->TimeDateStamp;
+            checkSum = dbgHeader->CheckSum;
+        }
+        else
+            return false;
+
+        return true;
+    }
 }
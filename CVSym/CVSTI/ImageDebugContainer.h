@@ -31,6 +31,8 @@ namespace MagoST
         virtual bool HasAddressMap();
         virtual HRESULT GetAddressMap( IAddressMap*& map );
 
+        virtual bool GetImageIdentity( DWORD& timeStamp, DWORD& checkSum );
+
     private:
         HRESULT LoadDbg( 
             BinImage::ImageFile* image, 
@@ -110,6 +110,31 @@ namespace MagoST
     }
 
     HRESULT Session::FindChildSymbol( SymHandle parentHandle, const char* nameChars, size_t nameLen, SymHandle& handle )
+    {
+        HRESULT     hr = S_OK;
+        GuardedArea guard( mNameIndexGuard );
+
+        SymNameIndexMap::iterator   it = mSymNameIndexes.find( parentHandle );
+
+        if ( it == mSymNameIndexes.end() )
+        {
+            it = mSymNameIndexes.insert( SymNameIndexMap::value_type( parentHandle, SymNameIndex() ) ).first;
+
+            hr = BuildSymNameIndex( parentHandle, it->second );
+            if ( FAILED( hr ) )
+            {
+                mSymNameIndexes.erase( it );
+                return hr;
+            }
+        }
+
+        if ( !it->second.Find( nameChars, nameLen, handle ) )
+            return S_FALSE;
+
+        return S_OK;
+    }
+
+    HRESULT Session::BuildSymNameIndex( SymHandle parentHandle, SymNameIndex& index )
     {
         HRESULT     hr = S_OK;
         SymbolScope scope = { 0 };
@@ -132,14 +157,11 @@ namespace MagoST
             if ( !symInfo->GetName( pstrName ) )
                 continue;
 
-            if ( (nameLen == pstrName.GetLength()) && (memcmp( nameChars, pstrName.GetName(), nameLen ) == 0) )
-            {
-                handle = childHandle;
-                return S_OK;
-            }
+            index.Add( pstrName.GetName(), pstrName.GetLength(), childHandle );
         }
 
-        return S_FALSE;
+        index.Build();
+        return S_OK;
     }
 
     HRESULT Session::FindOuterSymbolByAddr( SymbolHeapId heapId, WORD segment, DWORD offset, SymHandle& handle )
@@ -185,33 +207,67 @@ namespace MagoST
         if ( !symInfo->GetAddressSegment( funcSeg ) || (funcSeg != segment) )
             return E_FAIL;
 
-        // recursing down the block children has to stop somewhere
-        for ( int i = 0; i < USHRT_MAX; i++ )
+        GuardedArea guard( mBlockScopeIndexGuard );
+
+        BlockScopeIndexMap::iterator    it = mBlockScopeIndexes.find( parentHandle );
+
+        if ( it == mBlockScopeIndexes.end() )
         {
-            SymbolScope scope = { 0 };
-            // in case there are no children
-            SymHandle   curHandle = parentHandle;
-            bool        foundChild = false;
+            it = mBlockScopeIndexes.insert( BlockScopeIndexMap::value_type( parentHandle, BlockScopeIndex() ) ).first;
 
-            handles.push_back( parentHandle );
+            hr = BuildBlockScopeIndex( parentHandle, it->second );
+            if ( FAILED( hr ) )
+            {
+                mBlockScopeIndexes.erase( it );
+                return hr;
+            }
+        }
 
-            hr = mStore->SetChildSymbolScope( parentHandle, scope );
+        handles.push_back( parentHandle );
+        it->second.FindScopes( offset, handles );
+
+        return S_OK;
+    }
+
+    HRESULT Session::BuildBlockScopeIndex( SymHandle funcHandle, BlockScopeIndex& index )
+    {
+        struct PendingScope
+        {
+            SymHandle   Handle;
+            uint32_t    Index;
+        };
+
+        HRESULT                     hr = S_OK;
+        SymInfoData                 infoData = { 0 };
+        std::vector<PendingScope>   pending;
+        PendingScope                func = { funcHandle, BlockScopeIndex::NoParent };
+
+        pending.push_back( func );
+
+        // walking down the block children has to stop somewhere
+        for ( int i = 0; (i < USHRT_MAX) && !pending.empty(); i++ )
+        {
+            PendingScope    parent = pending.back();
+            SymbolScope     scope = { 0 };
+            SymHandle       childHandle = { 0 };
+
+            pending.pop_back();
+
+            hr = mStore->SetChildSymbolScope( parent.Handle, scope );
             if ( FAILED( hr ) )
                 return hr;
 
-            for ( int j = 0; (j < USHRT_MAX) && !foundChild && mStore->NextSymbol( scope, curHandle, offset ); j++ )
+            for ( int j = 0; (j < USHRT_MAX) && mStore->NextSymbol( scope, childHandle, ~0U ); j++ )
             {
-                SymTag          tag = SymTagNull;
+                ISymbolInfo*    symInfo = NULL;
                 uint32_t        childOffset = 0;
                 uint32_t        childLen = 0;
 
-                hr = mStore->GetSymbolInfo( curHandle, infoData, symInfo );
+                hr = mStore->GetSymbolInfo( childHandle, infoData, symInfo );
                 if ( FAILED( hr ) )
                     continue;
 
-                tag = symInfo->GetSymTag();
-
-                switch ( tag )
+                switch ( symInfo->GetSymTag() )
                 {
                 case SymTagBlock:
                 case SymTagFunction:
@@ -221,19 +277,18 @@ namespace MagoST
                         continue;
                     if ( !symInfo->GetLength( childLen ) )
                         continue;
-                    if ( (offset >= childOffset) && (offset < (childOffset + childLen)) )
-                        foundChild = true;
+
+                    {
+                        PendingScope    child = { childHandle, index.Add( childOffset, childLen, parent.Index, childHandle ) };
+
+                        pending.push_back( child );
+                    }
                     break;
                 }
             }
-
-            if ( foundChild )
-                parentHandle = curHandle;
-            else
-                // didn't find a good child, return what we have
-                break;
         }
 
+        index.Build();
         return S_OK;
     }
 
@@ -277,6 +332,31 @@ namespace MagoST
         const char* nameChars, 
         size_t nameLen, 
         TypeHandle& handle )
+    {
+        HRESULT     hr = S_OK;
+        GuardedArea guard( mNameIndexGuard );
+
+        TypeNameIndexMap::iterator  it = mTypeNameIndexes.find( parentHandle );
+
+        if ( it == mTypeNameIndexes.end() )
+        {
+            it = mTypeNameIndexes.insert( TypeNameIndexMap::value_type( parentHandle, TypeNameIndex() ) ).first;
+
+            hr = BuildTypeNameIndex( parentHandle, it->second );
+            if ( FAILED( hr ) )
+            {
+                mTypeNameIndexes.erase( it );
+                return hr;
+            }
+        }
+
+        if ( !it->second.Find( nameChars, nameLen, handle ) )
+            return S_FALSE;
+
+        return S_OK;
+    }
+
+    HRESULT Session::BuildTypeNameIndex( TypeHandle parentHandle, TypeNameIndex& index )
     {
         HRESULT     hr = S_OK;
         TypeScope   scope = { 0 };
@@ -299,14 +379,11 @@ namespace MagoST
             if ( !symInfo->GetName( pstrName ) )
                 continue;
 
-            if ( (nameLen == pstrName.GetLength()) && (memcmp( nameChars, pstrName.GetName(), nameLen ) == 0) )
-            {
-                handle = childHandle;
-                return S_OK;
-            }
+            index.Add( pstrName.GetName(), pstrName.GetLength(), childHandle );
         }
 
-        return S_FALSE;
+        index.Build();
+        return S_OK;
     }
 
     // source files
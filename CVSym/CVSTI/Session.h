@@ -8,6 +8,10 @@
 #pragma once
 
 #include "ISession.h"
+#include "ChildNameIndex.h"
+#include "BlockScopeIndex.h"
+#include <Guard.h>
+#include <map>
 
 
 namespace MagoST
@@ -19,6 +23,12 @@ namespace MagoST
 
     class Session : public ISession
     {
+        typedef ChildNameIndex<SymHandle>   SymNameIndex;
+        typedef ChildNameIndex<TypeHandle>  TypeNameIndex;
+        typedef std::map< SymHandle, SymNameIndex, HandleLess<SymHandle> >      SymNameIndexMap;
+        typedef std::map< TypeHandle, TypeNameIndex, HandleLess<TypeHandle> >   TypeNameIndexMap;
+        typedef std::map< SymHandle, BlockScopeIndex, HandleLess<SymHandle> >   BlockScopeIndexMap;
+
         long        mRefCount;
 
         uint64_t            mLoadAddr;
@@ -26,6 +36,15 @@ namespace MagoST
         IDebugStore*        mStore;         // valid while we hold onto data source
         RefPtr<IAddressMap> mAddrMap;
 
+        // name indexes of child scopes, built the first time a scope is searched
+        SymNameIndexMap     mSymNameIndexes;
+        TypeNameIndexMap    mTypeNameIndexes;
+        Guard               mNameIndexGuard;
+
+        // block scopes of functions, built the first time an address in one is looked up
+        BlockScopeIndexMap  mBlockScopeIndexes;
+        Guard               mBlockScopeIndexGuard;
+
     public:
         Session( DataSource* dataSource );
 
@@ -104,5 +123,10 @@ namespace MagoST
 
         virtual bool FindLines( bool exactMatch, const char* fileName, size_t fileNameLen, uint16_t reqLineStart, uint16_t reqLineEnd, 
                                 std::list<LineNumber>& lines );
+
+    private:
+        HRESULT BuildSymNameIndex( SymHandle parentHandle, SymNameIndex& index );
+        HRESULT BuildTypeNameIndex( TypeHandle parentHandle, TypeNameIndex& index );
+        HRESULT BuildBlockScopeIndex( SymHandle funcHandle, BlockScopeIndex& index );
     };
 }
@@ -12,7 +12,9 @@
 #include "SymbolInfo.h"
 #include "TypeInfo.h"
 #include "Util.h"
+#include "IndexCacheFormat.h"
 #include "cvinfo.h"
+#include <algorithm>
 
 using namespace std;
 
@@ -21,6 +23,20 @@ typedef pair<DWORD, DWORD> OffsetPair;
 
 namespace MagoST
 {
+    static uint32_t HashBytes( const BYTE* bytes, size_t size )
+    {
+        // FNV-1a
+        uint32_t    hash = 2166136261U;
+
+        for ( size_t i = 0; i < size; i++ )
+        {
+            hash ^= bytes[i];
+            hash *= 16777619U;
+        }
+
+        return hash;
+    }
+
     DebugStore::DebugStore()
         :   mInit( false ),
             mCVBuf( NULL ),
@@ -30,15 +46,32 @@ namespace MagoST
             mGlobalTypesDir( NULL ),
             mCompilandCount( 0 ),
             mTLSSegment( 0 ),
-            mTextSegment( 2 )
+            mTextSegment( 2 ),
+            mImageTimeStamp( 0 ),
+            mImageCheckSum( 0 ),
+            mCVDirHash( 0 ),
+            mIndexCache( NULL ),
+            mIndexCacheSize( 0 ),
+            mIndexCacheLoaded( false )
     {
         memset( mSymsDir, 0, sizeof mSymsDir );
 
+        mLineOffsets.Set( NULL, 0 );
+        mLineRanges.Set( NULL, 0 );
+        mFileNames.Set( NULL, 0 );
+        mFileRefs.Set( NULL, 0 );
+        mFileNameKeys.Set( NULL, 0 );
+
         C_ASSERT( sizeof( SymbolScopeIn ) == sizeof( SymbolScope ) );
         C_ASSERT( sizeof( TypeScopeIn ) == sizeof( TypeScope ) );
         C_ASSERT( sizeof( EnumNamedSymbolsDataIn ) == sizeof( EnumNamedSymbolsData ) );
         C_ASSERT( sizeof( TypeHandleIn ) == sizeof( TypeHandle ) );
         C_ASSERT( sizeof( SymHandleIn ) == sizeof( SymHandle ) );
+
+        C_ASSERT( sizeof( IndexCacheHeader ) == 88 );
+        C_ASSERT( sizeof( IndexCacheLineRange ) == 20 );
+        C_ASSERT( sizeof( IndexCacheFileName ) == 16 );
+        C_ASSERT( sizeof( IndexCacheFileRef ) == 4 );
     }
 
     DebugStore::~DebugStore()
@@ -120,6 +153,9 @@ namespace MagoST
             return E_OUTOFMEMORY;
         memset( mCompilandDetails.Get(), 0, mCompilandCount * sizeof( CompilandDetails ) );
 
+        mCVDirHash = HashBytes( dirStart, dirHeader->cDir * dirHeader->cbDirEntry );
+        mIndexCacheLoaded = LoadIndexCache();
+
         dir = dirStart;
         for ( DWORD i = 0; i < dirHeader->cDir; i++ )
         {
@@ -135,6 +171,15 @@ namespace MagoST
         mDirHeader = (OMFDirHeader*) dirHeader;
         mDirs = (OMFDirEntry*) dirStart;
 
+        if ( !mIndexCacheLoaded )
+        {
+            SortLineOffsets();
+
+            // needs all the line offsets marked for FixEndOffset
+            BuildLineRanges();
+            BuildFileNameIndex();
+        }
+
         return S_OK;
     }
 
@@ -148,6 +193,12 @@ namespace MagoST
         mTextSegment = seg;
     }
 
+    void DebugStore::SetImageIdentity( DWORD timeStamp, DWORD checkSum )
+    {
+        mImageTimeStamp = timeStamp;
+        mImageCheckSum = checkSum;
+    }
+
     HRESULT DebugStore::ProcessDirEntry( OMFDirEntry* entry )
     {
         _ASSERT( entry != NULL );
@@ -158,8 +209,9 @@ namespace MagoST
         switch ( entry->SubSection )
         {
         case sstModule:
-            
-            MarkLineNumbers( entry );
+            // the index cache has the sorted line offsets
+            if ( !mIndexCacheLoaded )
+                MarkLineNumbers( entry );
             break;
 
         case sstAlignSym:
@@ -175,7 +227,8 @@ namespace MagoST
             else
                 _ASSERT( false );
 
-            MarkLineNumbers( entry );
+            if ( !mIndexCacheLoaded )
+                MarkLineNumbers( entry );
             break;
 
         case sstGlobalTypes:
@@ -1519,6 +1572,74 @@ namespace MagoST
     bool DebugStore::FindLines( bool exactMatch, const char* fileName, size_t fileNameLen, uint16_t reqLineStart, uint16_t reqLineEnd, 
                                 std::list<LineNumber>& lines )
     {
+        std::string                 key;
+        const IndexCacheFileName*   name = NULL;
+
+        GetFileNameKey( fileName, fileNameLen, key );
+
+        name = FindFileName( key );
+        if ( name == NULL )
+            return false;
+
+        const IndexCacheFileRef*    files = mFileRefs.Begin() + name->FirstRef;
+
+        for ( uint32_t i = 0; i < name->RefCount; i++ )
+        {
+            uint16_t            compIx = files[i].CompIndex;
+            uint16_t            fileIx = files[i].FileIndex;
+            MagoST::FileInfo    fileInfo = { 0 };
+            bool                matches = false;
+
+            HRESULT hr = GetFileInfo( compIx, fileIx, fileInfo );
+            if ( FAILED( hr ) )
+                continue;
+
+            if ( exactMatch )
+                matches = ExactFileNameMatch( fileName, fileNameLen, fileInfo.Name.ptr, fileInfo.Name.length );
+            else
+                matches = PartialFileNameMatch( fileName, fileNameLen, fileInfo.Name.ptr, fileInfo.Name.length );
+
+            if ( !matches )
+                continue;
+
+            MagoST::LineNumber  line = { 0 };
+            if ( !FindLineByNum( compIx, fileIx, (uint16_t) reqLineStart, line ) )
+                continue;
+
+            // do the line ranges overlap?
+            if ( ((line.Number <= reqLineEnd) && (line.NumberEnd >= reqLineStart)) )
+            {
+                do
+                {
+                    lines.push_back (line);
+                }
+                while( FindNextLineByNum( compIx, fileIx, (uint16_t) reqLineStart, line ) );
+            }
+        }
+        return lines.size() > 0;
+    }
+
+    static int CompareFileNameKeys( const char* key1, size_t len1, const char* key2, size_t len2 )
+    {
+        int result = memcmp( key1, key2, (len1 < len2) ? len1 : len2 );
+
+        if ( result != 0 )
+            return result;
+        if ( len1 < len2 )
+            return -1;
+        if ( len1 > len2 )
+            return 1;
+        return 0;
+    }
+
+    void DebugStore::BuildFileNameIndex()
+    {
+        typedef std::map< std::string, std::vector<IndexCacheFileRef> >  FileNameMap;
+
+        std::string key;
+        FileNameMap fileNames;
+
+        // in compiland and file order, so FindLines returns lines in the same order as a full search
         for ( uint16_t compIx = 1; compIx <= mCompilandCount; compIx++ )
         {
             MagoST::CompilandInfo   compInfo = { 0 };
@@ -1530,92 +1651,121 @@ namespace MagoST
             for ( uint16_t fileIx = 0; fileIx < compInfo.FileCount; fileIx++ )
             {
                 MagoST::FileInfo    fileInfo = { 0 };
-                bool                matches = false;
+                IndexCacheFileRef   fileRef = { compIx, fileIx };
 
                 hr = GetFileInfo( compIx, fileIx, fileInfo );
                 if ( FAILED( hr ) )
                     continue;
 
-                if ( exactMatch )
-                    matches = ExactFileNameMatch( fileName, fileNameLen, fileInfo.Name.ptr, fileInfo.Name.length );
-                else
-                    matches = PartialFileNameMatch( fileName, fileNameLen, fileInfo.Name.ptr, fileInfo.Name.length );
+                GetFileNameKey( fileInfo.Name.ptr, fileInfo.Name.length, key );
 
-                if ( !matches )
-                    continue;
+                fileNames[key].push_back( fileRef );
+            }
+        }
 
-                MagoST::LineNumber  line = { 0 };
-                if ( !FindLineByNum( compIx, fileIx, (uint16_t) reqLineStart, line ) )
-                    continue;
+        // flatten it into the same records as the index cache; the map's 
+        // order is the same as CompareFileNameKeys
+        mBuiltFileNames.clear();
+        mBuiltFileRefs.clear();
+        mBuiltFileNameKeys.clear();
 
-                // do the line ranges overlap?
-                if ( ((line.Number <= reqLineEnd) && (line.NumberEnd >= reqLineStart)) )
-                {
-                    do
-                    {
-                        lines.push_back (line);
-                    }
-                    while( FindNextLineByNum( compIx, fileIx, (uint16_t) reqLineStart, line ) );
-                }
-            }
+        for ( FileNameMap::const_iterator it = fileNames.begin(); it != fileNames.end(); it++ )
+        {
+            IndexCacheFileName  name = { 0 };
+
+            name.KeyOffset = (uint32_t) mBuiltFileNameKeys.size();
+            name.KeyLen = (uint32_t) it->first.size();
+            name.FirstRef = (uint32_t) mBuiltFileRefs.size();
+            name.RefCount = (uint32_t) it->second.size();
+
+            mBuiltFileNameKeys.insert( mBuiltFileNameKeys.end(), it->first.begin(), it->first.end() );
+            mBuiltFileRefs.insert( mBuiltFileRefs.end(), it->second.begin(), it->second.end() );
+            mBuiltFileNames.push_back( name );
         }
-        return lines.size() > 0;
+
+        mFileNames.Set( mBuiltFileNames );
+        mFileRefs.Set( mBuiltFileRefs );
+        mFileNameKeys.Set( mBuiltFileNameKeys );
     }
 
-    bool DebugStore::FindCompilandFileSegmentByOffset( WORD seg, DWORD offset, uint16_t& compIndex, uint16_t& fileIndex, FileSegmentInfo& fileSegInfo )
-    {
-        uint32_t    compCount = 0;
+    // The records can come straight from the index cache file, so each one 
+    // is checked against the tables it points into before it's used.
 
-        GetCompilandCount( compCount );
+    const IndexCacheFileName* DebugStore::FindFileName( const std::string& key )
+    {
+        uint32_t    low = 0;
+        uint32_t    high = mFileNames.Count;
 
-        for ( uint16_t zCompIx = 0; zCompIx < compCount; zCompIx++ )
+        while ( low < high )
         {
-            // no source, no files
-            if ( mCompilandDetails[ zCompIx ].SourceEntry == NULL )
-                continue;
+            uint32_t                    mid = low + (high - low) / 2;
+            const IndexCacheFileName&   name = mFileNames.Items[mid];
 
-            OMFDirEntry*        entry = &mDirs[zCompIx];
-            OMFModule*          mod = GetCVPtr<OMFModule>( entry->lfo );
-            OMFSegDesc*         segDescTable = NULL;
+            if ( (name.KeyOffset > mFileNameKeys.Count) 
+                || (name.KeyLen > mFileNameKeys.Count - name.KeyOffset) )
+                return NULL;
 
-            if ( mod == NULL )
-                continue;
+            int result = CompareFileNameKeys( 
+                key.data(), key.size(), mFileNameKeys.Items + name.KeyOffset, name.KeyLen );
 
-            segDescTable = (OMFSegDesc*) (mod + 1);
-
-            for ( uint16_t modSegIx = 0; modSegIx < mod->cSeg; modSegIx++ )
+            if ( result < 0 )
+                high = mid;
+            else if ( result > 0 )
+                low = mid + 1;
+            else
             {
-                if ( (segDescTable[modSegIx].Seg == seg) 
-                    && (offset >= segDescTable[modSegIx].Off)
-                    && ((offset - segDescTable[modSegIx].Off + 1) <= segDescTable[modSegIx].cbSeg) )
-                {
-                    if ( FindFileSegment( seg, offset, zCompIx + 1, fileIndex, fileSegInfo ) )
-                    {
-                        compIndex = zCompIx + 1;
-                        return true;
-                    }
-                    break;
-                }
+                if ( (name.FirstRef > mFileRefs.Count) 
+                    || (name.RefCount > mFileRefs.Count - name.FirstRef) )
+                    return NULL;
+
+                return &name;
             }
         }
 
-        return false;
+        return NULL;
     }
 
-    bool    DebugStore::FindFileSegment( WORD seg, DWORD offset, uint16_t compIndex, uint16_t& fileIndex, FileSegmentInfo& fileSegInfo )
+    bool DebugStore::FindCompilandFileSegmentByOffset( WORD seg, DWORD offset, uint16_t& compIndex, uint16_t& fileIndex, FileSegmentInfo& fileSegInfo )
     {
-        if ( (compIndex < 1) || (compIndex > mCompilandCount) )
+        const LineRange*    range = FindLineRange( seg, offset );
+
+        if ( range == NULL )
             return false;
 
-        const uint16_t      zCompIx = compIndex - 1;
-        OMFSourceModule*    srcMod = NULL;
+        if ( !GetFileSegment( range->CompIndex, range->FileIndex, range->SegInstance, fileSegInfo ) )
+            return false;
 
-        if ( mCompilandDetails[zCompIx].SourceEntry != NULL )
-            srcMod = GetCVPtr<OMFSourceModule>( mCompilandDetails[zCompIx].SourceEntry->lfo );
+        compIndex = range->CompIndex;
+        fileIndex = range->FileIndex;
+        return true;
+    }
 
-        if ( srcMod == NULL )
-            return false;
+    static bool LineRangeOrderLess( WORD compA, WORD fileA, WORD segInstA, WORD compB, WORD fileB, WORD segInstB )
+    {
+        if ( compA != compB )
+            return compA < compB;
+        if ( fileA != fileB )
+            return fileA < fileB;
+        return segInstA < segInstB;
+    }
+
+    template <class TRange>
+    struct LineRangeStartLess
+    {
+        bool operator()( const TRange& left, const TRange& right ) const
+        {
+            if ( left.Seg != right.Seg )
+                return left.Seg < right.Seg;
+            return left.Start < right.Start;
+        }
+    };
+
+    // Finds the part of the segment that a compiland's source module says it 
+    // has lines for. A module without a range for the segment has no lines in 
+    // it. Only the first entry for the segment counts.
 
+    static bool GetSourceModuleRange( OMFSourceModule* srcMod, WORD seg, DWORD& start, DWORD& end )
+    {
         DWORD*      filePtrTable = (DWORD*) (((BYTE*) srcMod) + 4);
         OffsetPair* offsetTable = (OffsetPair*) (filePtrTable + srcMod->cFile);
         WORD*       segTable = (WORD*) (offsetTable + srcMod->cSeg);
@@ -1625,67 +1775,298 @@ namespace MagoST
             if ( segTable[zModSegIx] != seg )
                 continue;
 
-            if ( ((offsetTable[zModSegIx].first == 0) && (offsetTable[zModSegIx].second == 0))
-                || ((offset >= offsetTable[zModSegIx].first) && (offset <= offsetTable[zModSegIx].second)) )
+            start = offsetTable[zModSegIx].first;
+            end = offsetTable[zModSegIx].second;
+
+            // no range means the whole segment
+            if ( (start == 0) && (end == 0) )
+                end = 0xFFFFFFFF;
+
+            return true;
+        }
+
+        return false;
+    }
+
+    // The ranges are clipped to the code that each compiland's module entry 
+    // says it contributed, because that's what decides which compiland owns 
+    // an address. When ranges overlap, FindLineRange picks the first one in 
+    // compiland, file, and segment instance order. Segment instances without 
+    // a range cover all of their compiland's code in the segment.
+
+    void DebugStore::BuildLineRanges()
+    {
+        mBuiltLineRanges.clear();
+
+        for ( uint16_t zCompIx = 0; zCompIx < mCompilandCount; zCompIx++ )
+        {
+            OMFDirEntry*        entry = mCompilandDetails[zCompIx].SourceEntry;
+            OMFSourceModule*    srcMod = NULL;
+            OMFModule*          mod = NULL;
+            OMFSegDesc*         segDescTable = NULL;
+
+            // no source, no files
+            if ( entry == NULL )
+                continue;
+
+            srcMod = GetCVPtr<OMFSourceModule>( entry->lfo );
+            if ( srcMod == NULL )
+                continue;
+
+            // the module entries come first in the directory, in compiland order
+            mod = GetCVPtr<OMFModule>( mDirs[zCompIx].lfo );
+            if ( mod == NULL )
+                continue;
+
+            segDescTable = (OMFSegDesc*) (mod + 1);
+
+            DWORD*  filePtrTable = (DWORD*) (((BYTE*) srcMod) + 4);
+
+            for ( uint16_t zFileIx = 0; zFileIx < srcMod->cFile; zFileIx++ )
             {
-                for ( uint16_t zFileIx = 0; zFileIx < srcMod->cFile; zFileIx++ )
+                OMFSourceFile*  file = GetCVPtr<OMFSourceFile>( entry->lfo + filePtrTable[zFileIx] );
+
+                if ( file == NULL )
+                    continue;
+
+                DWORD*          srcLinePtrTable = (DWORD*) ((BYTE*) file + 4);
+                OffsetPair*     startEndTable = (OffsetPair*) (srcLinePtrTable + file->cSeg);
+
+                for ( uint16_t zSegIx = 0; zSegIx < file->cSeg; zSegIx++ )
                 {
-                    OMFSourceFile*  file = (OMFSourceFile*) ((BYTE*) srcMod + filePtrTable[zFileIx]);
+                    OMFSourceLine*  line = GetCVPtr<OMFSourceLine>( entry->lfo + srcLinePtrTable[zSegIx] );
+                    DWORD           start = 0;
+                    DWORD           end = 0;
+                    DWORD           modStart = 0;
+                    DWORD           modEnd = 0;
 
-                    if ( FindFileSegment( seg, offset, srcMod, file, fileSegInfo ) )
+                    if ( (line == NULL) || (line->cLnOff == 0) )
+                        continue;
+
+                    if ( !GetSourceModuleRange( srcMod, line->Seg, modStart, modEnd ) )
+                        continue;
+
+                    start = startEndTable[zSegIx].first;
+                    end = startEndTable[zSegIx].second;
+
+                    if ( (start == 0) && (end == 0) )
+                        end = 0xFFFFFFFF;
+                    else
+                        FixEndOffset( line->offset[line->cLnOff - 1], end );
+
+                    if ( start < modStart )
+                        start = modStart;
+                    if ( end > modEnd )
+                        end = modEnd;
+
+                    for ( uint16_t modSegIx = 0; modSegIx < mod->cSeg; modSegIx++ )
                     {
-                        fileIndex = zFileIx;
-                        return true;
+                        const OMFSegDesc&   segDesc = segDescTable[modSegIx];
+                        LineRange           range = { 0 };
+                        DWORD               segDescEnd = segDesc.Off + segDesc.cbSeg - 1;
+
+                        if ( (segDesc.Seg != line->Seg) || (segDesc.cbSeg == 0) )
+                            continue;
+
+                        range.Seg = line->Seg;
+                        range.CompIndex = zCompIx + 1;
+                        range.FileIndex = zFileIx;
+                        range.SegInstance = zSegIx;
+                        range.Start = (start > segDesc.Off) ? start : segDesc.Off;
+                        range.End = (end < segDescEnd) ? end : segDescEnd;
+
+                        if ( range.Start > range.End )
+                            continue;
+
+                        mBuiltLineRanges.push_back( range );
                     }
                 }
             }
-            break;
         }
 
-        return false;
+        std::stable_sort( mBuiltLineRanges.begin(), mBuiltLineRanges.end(), LineRangeStartLess<LineRange>() );
+
+        for ( size_t i = 0; i < mBuiltLineRanges.size(); i++ )
+        {
+            LineRange&  range = mBuiltLineRanges[i];
+            LineRange*  prev = (i > 0) ? &mBuiltLineRanges[i - 1] : NULL;
+
+            range.MaxEnd = range.End;
+
+            if ( (prev != NULL) && (prev->Seg == range.Seg) && (prev->MaxEnd > range.MaxEnd) )
+                range.MaxEnd = prev->MaxEnd;
+        }
+
+        mLineRanges.Set( mBuiltLineRanges );
     }
 
-    bool DebugStore::FindFileSegment( 
-        WORD seg, 
-        DWORD offset, 
-        OMFSourceModule* srcMod, 
-        OMFSourceFile* file, 
-        FileSegmentInfo& fileSegInfo )
+    const DebugStore::LineRange* DebugStore::FindLineRange( WORD seg, DWORD offset )
     {
-        DWORD*          srcLinePtrTable = (DWORD*) ((BYTE*) file + 4);
-        OffsetPair*     startEndTable = (OffsetPair*) (srcLinePtrTable + file->cSeg);
+        LineRange           key = { 0 };
+        const LineRange*    found = NULL;
+
+        key.Seg = seg;
+        key.Start = offset;
+
+        // the ranges starting at or before the offset are the ones before this one
+        const LineRange*    it = 
+            std::upper_bound( mLineRanges.Begin(), mLineRanges.End(), key, LineRangeStartLess<LineRange>() );
 
-        for ( uint16_t zSegIx = 0; zSegIx < file->cSeg; zSegIx++ )
+        // ranges can overlap; walk back until no earlier range can reach the offset,
+        // and pick the first one in compiland and file order, like a linear search would
+        while ( it != mLineRanges.Begin() )
         {
-            OMFSourceLine*  line = (OMFSourceLine*) ((BYTE*) srcMod + srcLinePtrTable[zSegIx]);
+            --it;
 
-            if ( line->Seg != seg )
+            if ( (it->Seg != seg) || (it->MaxEnd < offset) )
+                break;
+
+            if ( it->End < offset )
                 continue;
 
-            DWORD*  offsetTable = (DWORD*) ((BYTE*) line + 4);
-            WORD*   numberTable = (WORD*) (offsetTable + line->cLnOff);
+            if ( (found == NULL) 
+                || LineRangeOrderLess( it->CompIndex, it->FileIndex, it->SegInstance, 
+                    found->CompIndex, found->FileIndex, found->SegInstance ) )
+                found = it;
+        }
+
+        return found;
+    }
 
-            DWORD end = startEndTable[zSegIx].second;
-            FixEndOffset( offsetTable[line->cLnOff - 1], end );
+    //------------------------------------------------------------------------
+    //  Index cache
+    //------------------------------------------------------------------------
 
-            if ( ((startEndTable[zSegIx].first == 0) && (startEndTable[zSegIx].second == 0))
-                || ((startEndTable[zSegIx].first <= offset) && (end >= offset)) )
-            {
-                fileSegInfo.SegmentIndex = line->Seg;
-                fileSegInfo.SegmentInstance = zSegIx;
-                fileSegInfo.Start = startEndTable[zSegIx].first;
-                fileSegInfo.End = end;
-                fileSegInfo.LineCount = line->cLnOff;
-                fileSegInfo.LineNumbers = numberTable;
-                fileSegInfo.Offsets = offsetTable;
-                return true;
-            }
-            // don't leave yet, because the addr might be in another file/segment instance
-        }
+    static const char   IndexCacheMagic[8] = "MAGOIDX";
 
-        return false;
+    template <class TRecord>
+    static bool GetCacheSection( const BYTE* cache, DWORD cacheSize, const IndexCacheSection& section, const TRecord*& records )
+    {
+        records = NULL;
+
+        if ( section.Count == 0 )
+            return true;
+        if ( (section.Offset < sizeof( IndexCacheHeader )) || (section.Offset > cacheSize) )
+            return false;
+        if ( (section.Offset % __alignof( TRecord )) != 0 )
+            return false;
+        if ( section.Count > (cacheSize - section.Offset) / sizeof( TRecord ) )
+            return false;
+
+        records = (const TRecord*) (cache + section.Offset);
+        return true;
+    }
+
+    template <class TRecord>
+    static void AppendCacheSection( std::vector<BYTE>& bytes, const TRecord* records, size_t count, IndexCacheSection& section )
+    {
+        // keep every section aligned for its records
+        while ( (bytes.size() % __alignof( TRecord )) != 0 )
+            bytes.push_back( 0 );
+
+        section.Offset = (uint32_t) bytes.size();
+        section.Count = (uint32_t) count;
+
+        if ( count > 0 )
+            bytes.insert( bytes.end(), (const BYTE*) records, (const BYTE*) (records + count) );
+    }
+
+    void DebugStore::SetIndexCache( const BYTE* bytes, DWORD size )
+    {
+        mIndexCache = bytes;
+        mIndexCacheSize = size;
+    }
+
+    bool DebugStore::IsIndexCacheLoaded()
+    {
+        return mIndexCacheLoaded;
+    }
+
+    void DebugStore::GetIndexCacheKey( IndexCacheHeader& header )
+    {
+        memset( &header, 0, sizeof header );
+
+        memcpy( header.Magic, IndexCacheMagic, sizeof header.Magic );
+        header.Version = IndexCacheVersion;
+        header.HeaderSize = sizeof header;
+
+        header.ImageTimeStamp = mImageTimeStamp;
+        header.ImageCheckSum = mImageCheckSum;
+        memcpy( header.CVSignature, mCVBuf, sizeof header.CVSignature );
+        header.CVSize = mCVBufSize;
+        header.CVDirHash = mCVDirHash;
+        header.TextSegment = mTextSegment;
+        header.TLSSegment = mTLSSegment;
+        header.CompilandCount = mCompilandCount;
     }
 
+    bool DebugStore::LoadIndexCache()
+    {
+        if ( (mIndexCache == NULL) || (mIndexCacheSize < sizeof( IndexCacheHeader )) )
+            return false;
+
+        // nothing in the file is trusted until the key and every section have 
+        // been checked; the records in them are checked when they're used
+
+        const IndexCacheHeader*     header = (const IndexCacheHeader*) mIndexCache;
+        IndexCacheHeader            key;
+        const uint32_t*             lineOffsets = NULL;
+        const IndexCacheLineRange*  ranges = NULL;
+        const IndexCacheFileName*   fileNames = NULL;
+        const IndexCacheFileRef*    fileRefs = NULL;
+        const char*                 strings = NULL;
+
+        GetIndexCacheKey( key );
+
+        // the file size sits between the version and the key
+        if ( memcmp( header, &key, offsetof( IndexCacheHeader, FileSize ) ) != 0 )
+            return false;
+        if ( memcmp( &header->ImageTimeStamp, &key.ImageTimeStamp, 
+            offsetof( IndexCacheHeader, LineOffsets ) - offsetof( IndexCacheHeader, ImageTimeStamp ) ) != 0 )
+            return false;
+        if ( header->FileSize != mIndexCacheSize )
+            return false;
+
+        if ( !GetCacheSection( mIndexCache, mIndexCacheSize, header->LineOffsets, lineOffsets )
+            || !GetCacheSection( mIndexCache, mIndexCacheSize, header->LineRanges, ranges )
+            || !GetCacheSection( mIndexCache, mIndexCacheSize, header->FileNames, fileNames )
+            || !GetCacheSection( mIndexCache, mIndexCacheSize, header->FileRefs, fileRefs )
+            || !GetCacheSection( mIndexCache, mIndexCacheSize, header->Strings, strings ) )
+            return false;
+
+        mLineOffsets.Set( lineOffsets, header->LineOffsets.Count );
+        mLineRanges.Set( ranges, header->LineRanges.Count );
+        mFileNames.Set( fileNames, header->FileNames.Count );
+        mFileRefs.Set( fileRefs, header->FileRefs.Count );
+        mFileNameKeys.Set( strings, header->Strings.Count );
+
+        return true;
+    }
+
+    HRESULT DebugStore::SaveIndexCache( std::vector<BYTE>& bytes )
+    {
+        if ( !mInit || (mCVBuf == NULL) )
+            return E_FAIL;
+
+        IndexCacheHeader    header;
+
+        GetIndexCacheKey( header );
+
+        bytes.clear();
+        bytes.resize( sizeof header );
+
+        AppendCacheSection( bytes, mLineOffsets.Items, mLineOffsets.Count, header.LineOffsets );
+        AppendCacheSection( bytes, mLineRanges.Items, mLineRanges.Count, header.LineRanges );
+        AppendCacheSection( bytes, mFileNames.Items, mFileNames.Count, header.FileNames );
+        AppendCacheSection( bytes, mFileRefs.Items, mFileRefs.Count, header.FileRefs );
+        AppendCacheSection( bytes, mFileNameKeys.Items, mFileNameKeys.Count, header.Strings );
+
+        header.FileSize = (uint32_t) bytes.size();
+        memcpy( &bytes[0], &header, sizeof header );
+
+        return S_OK;
+    }
+
     HRESULT DebugStore::GetSymbolBytePtr( SymHandle handle, BYTE* bytes, DWORD& size )
     {
         SymHandleIn*    internalHandle = (SymHandleIn*) &handle;
@@ -1845,19 +2226,28 @@ namespace MagoST
     //  the last code byte. This causes the debugger to switch to assembly
     //  because there is a gap without associated source
     //
-    // workaround: create a bitmap of all available line offsets plus some
-    //  more offsets that are probable function boundaries, and expand the
-    //  end offset up to the next found line offset
+    // workaround: collect all available line offsets plus some more offsets 
+    //  that are probable function boundaries, and expand the end offset up 
+    //  to the next found line offset
 
-    bool DebugStore::MarkLineOffsetInBitmap( size_t adr )
+    bool DebugStore::MarkLineOffset( DWORD adr )
     {
-        if ( adr >= mMarkOffsets.size() )
-            mMarkOffsets.resize( adr + 10000 );
-
-        mMarkOffsets[adr] = true;
+        mBuiltLineOffsets.push_back( adr );
         return true;
     }
 
+    void DebugStore::SortLineOffsets()
+    {
+        std::sort( mBuiltLineOffsets.begin(), mBuiltLineOffsets.end() );
+        mBuiltLineOffsets.erase( 
+            std::unique( mBuiltLineOffsets.begin(), mBuiltLineOffsets.end() ), mBuiltLineOffsets.end() );
+
+        // it was grown one offset at a time
+        std::vector<uint32_t>( mBuiltLineOffsets ).swap( mBuiltLineOffsets );
+
+        mLineOffsets.Set( mBuiltLineOffsets );
+    }
+
     bool DebugStore::MarkLineNumbers( OMFDirEntry* entry )
     {
         if ( entry->SubSection == sstAlignSym )
@@ -1884,11 +2274,11 @@ namespace MagoST
                             if( srcLine->Seg == mTextSegment )
                             {
                                 // also mark the start of the line info segment
-                                MarkLineOffsetInBitmap( lnSegOffsetTable[s].first );
+                                MarkLineOffset( lnSegOffsetTable[s].first );
 
                                 uint16_t cnt = srcLine->cLnOff;
                                 for( uint16_t ln = 0; ln < cnt; ln++ )
-                                    MarkLineOffsetInBitmap( srcLine->offset[ln] );
+                                    MarkLineOffset( srcLine->offset[ln] );
                             }
                         }
                     }
@@ -1904,8 +2294,8 @@ namespace MagoST
             for (uint16_t s = 0; s < module->cSeg; s++)
                 if( segDesc[s].Seg == mTextSegment )
                 {
-                    MarkLineOffsetInBitmap( segDesc[s].Off );
-                    MarkLineOffsetInBitmap( segDesc[s].Off + segDesc[s].cbSeg );
+                    MarkLineOffset( segDesc[s].Off );
+                    MarkLineOffset( segDesc[s].Off + segDesc[s].cbSeg );
                 }
         }
         return true;
@@ -1916,10 +2306,14 @@ namespace MagoST
         if( lastLineOffset != off )
             return false;
 
-        for ( ; off + 1 < mMarkOffsets.size(); off++ )
-            if( mMarkOffsets[off + 1] )
-                return true;
-        return false;
+        const uint32_t* it = 
+            std::upper_bound( mLineOffsets.Begin(), mLineOffsets.End(), (uint32_t) off );
+
+        if ( it == mLineOffsets.End() )
+            return false;
+
+        off = *it - 1;
+        return true;
     }
 
     // this cannot be used because writing to the image is not allowed!
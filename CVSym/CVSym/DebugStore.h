@@ -7,6 +7,9 @@
 
 #pragma once
 
+#include <map>
+#include <string>
+#include "IndexCacheFormat.h"
 
 struct OMFDirEntry;
 struct OMFDirHeader;
@@ -103,6 +106,33 @@ namespace MagoST
             WORD            TypeCount;
         };
 
+        // the code range of one segment instance of a source file; MaxEnd is 
+        // the highest End up to here in the segment, and CompIndex is 1-based
+        typedef IndexCacheLineRange LineRange;
+
+        // An index is an array of index cache records. It points either into 
+        // the mapped index cache, or into the vector that it was built in.
+        template <class TRecord>
+        struct IndexTable
+        {
+            const TRecord*  Items;
+            uint32_t        Count;
+
+            void Set( const TRecord* items, size_t count )
+            {
+                Items = items;
+                Count = (uint32_t) count;
+            }
+
+            void Set( const std::vector<TRecord>& records )
+            {
+                Set( records.empty() ? NULL : &records[0], records.size() );
+            }
+
+            const TRecord* Begin() const { return Items; }
+            const TRecord* End() const { return Items + Count; }
+        };
+
         bool    mInit;
         BYTE*   mCVBuf;
         DWORD   mCVBufSize;
@@ -117,7 +147,33 @@ namespace MagoST
         UniquePtr<CompilandDetails[]>   mCompilandDetails;
 
         uint16_t mTextSegment;
-        std::vector<bool> mMarkOffsets;
+
+        // the line offsets marked for FixEndOffset, sorted and unique
+        IndexTable<uint32_t>            mLineOffsets;
+
+        // all file segments sorted by segment and start offset, so that finding
+        // the line for an address doesn't have to walk every compiland
+        IndexTable<LineRange>           mLineRanges;
+
+        // source files by GetFileNameKey, sorted by key, so that binding a 
+        // breakpoint only has to look at the files with the right name
+        IndexTable<IndexCacheFileName>  mFileNames;
+        IndexTable<IndexCacheFileRef>   mFileRefs;
+        IndexTable<char>                mFileNameKeys;
+
+        // the indexes that were built, when they weren't in the index cache
+        std::vector<uint32_t>           mBuiltLineOffsets;
+        std::vector<LineRange>          mBuiltLineRanges;
+        std::vector<IndexCacheFileName> mBuiltFileNames;
+        std::vector<IndexCacheFileRef>  mBuiltFileRefs;
+        std::vector<char>               mBuiltFileNameKeys;
+
+        DWORD       mImageTimeStamp;
+        DWORD       mImageCheckSum;
+        DWORD       mCVDirHash;
+        const BYTE* mIndexCache;
+        DWORD       mIndexCacheSize;
+        bool        mIndexCacheLoaded;
 
     public:
         DebugStore();
@@ -130,6 +186,21 @@ namespace MagoST
         void SetTLSSegment( WORD seg );
         void SetTextSegment( WORD seg );
 
+        // index cache
+
+        // The image that the debug info came from. This is part of the key of
+        // the index cache, along with the debug info itself.
+        void SetImageIdentity( DWORD timeStamp, DWORD checkSum );
+
+        // Set the contents of a cache file made by SaveIndexCache before 
+        // calling InitDebugInfo. If it matches, then the line and file indexes
+        // are used in place instead of being built, so the bytes have to stay 
+        // valid as long as the store if IsIndexCacheLoaded returns true. 
+        // Otherwise, they're not used after InitDebugInfo returns.
+        void SetIndexCache( const BYTE* bytes, DWORD size );
+        bool IsIndexCacheLoaded();
+        HRESULT SaveIndexCache( std::vector<BYTE>& bytes );
+
         // symbols
 
         virtual HRESULT SetSymbolScope( SymbolHeapId heapId, SymbolScope& scope );
@@ -228,20 +299,13 @@ namespace MagoST
             CodeViewSymbol*& newSymbol, 
             OMFDirEntry*& newHeapDir );
 
-        bool FindFileSegment( 
-            WORD seg, 
-            DWORD offset, 
-            uint16_t compIndex, 
-            uint16_t& fileIndex, 
-            FileSegmentInfo& segInfo );
-        bool FindFileSegment( 
-            WORD seg, 
-            DWORD offset, 
-            OMFSourceModule* srcMod, 
-            OMFSourceFile* file, 
-            FileSegmentInfo& segInfo );
-
         bool FindCompilandFileSegmentByOffset( WORD seg, DWORD offset, uint16_t& compIndex, uint16_t& fileIndex, FileSegmentInfo& segInfo );
+        void BuildLineRanges();
+        void BuildFileNameIndex();
+        const IndexCacheFileName* FindFileName( const std::string& key );
+        const LineRange* FindLineRange( WORD seg, DWORD offset );
+        void GetIndexCacheKey( IndexCacheHeader& header );
+        bool LoadIndexCache();
         bool FindCompilandFileSegmentByLine( uint16_t line, uint16_t compIndex, uint16_t fileIndex, uint16_t firstSegIndex, FileSegmentInfo& segInfo );
         void SetLineNumberFromSegment( uint16_t compIx, uint16_t fileIx, const FileSegmentInfo& segInfo, uint16_t lineIndex, LineNumber& lineNumber );
 
@@ -250,7 +314,8 @@ namespace MagoST
 
         // patching line info
         bool MarkLineNumbers( OMFDirEntry* entry );
-        bool MarkLineOffsetInBitmap( size_t adr );
+        bool MarkLineOffset( DWORD adr );
+        void SortLineOffsets();
         bool FixEndOffset( DWORD lastLineOffset, DWORD& off );
         bool PatchLineNumberInfo();
     };
@@ -0,0 +1,82 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+
+// The layout of the index cache file that DebugStore saves beside its
+// CodeView info, so that the next session with the same image can use the
+// line and file indexes in place instead of walking all the line info.
+//
+// Everything is little-endian and naturally aligned, and there are no
+// pointers or Windows types, so the file can be read anywhere. Sections are
+// arrays of the records below, found by offset from the start of the file.
+// DebugStore uses the same records for the indexes it builds, so a mapped
+// file needs no parsing.
+
+namespace MagoST
+{
+    const uint32_t  IndexCacheVersion = 3;
+
+    struct IndexCacheSection
+    {
+        uint32_t    Offset;
+        uint32_t    Count;
+    };
+
+    struct IndexCacheHeader
+    {
+        char        Magic[8];           // "MAGOIDX", zero terminated
+        uint32_t    Version;
+        uint32_t    HeaderSize;
+        uint32_t    FileSize;
+
+        // the key; a cache is only used if all of these match
+
+        uint32_t    ImageTimeStamp;
+        uint32_t    ImageCheckSum;
+        char        CVSignature[4];
+        uint32_t    CVSize;
+        uint32_t    CVDirHash;          // FNV-1a of the subsection directory
+        uint16_t    TextSegment;
+        uint16_t    TLSSegment;
+        uint32_t    CompilandCount;
+
+        IndexCacheSection   LineOffsets;        // uint32_t, sorted and unique
+        IndexCacheSection   LineRanges;         // IndexCacheLineRange, sorted by segment and start
+        IndexCacheSection   FileNames;          // IndexCacheFileName, sorted by key
+        IndexCacheSection   FileRefs;           // IndexCacheFileRef
+        IndexCacheSection   Strings;            // char
+    };
+
+    struct IndexCacheLineRange
+    {
+        uint32_t    Start;
+        uint32_t    End;
+        uint32_t    MaxEnd;
+        uint16_t    Seg;
+        uint16_t    CompIndex;
+        uint16_t    FileIndex;
+        uint16_t    SegInstance;
+    };
+
+    struct IndexCacheFileName
+    {
+        uint32_t    KeyOffset;          // in Strings
+        uint32_t    KeyLen;
+        uint32_t    FirstRef;           // in FileRefs
+        uint32_t    RefCount;
+    };
+
+    struct IndexCacheFileRef
+    {
+        uint16_t    CompIndex;
+        uint16_t    FileIndex;
+    };
+}
@@ -7,6 +7,7 @@
 
 #include "Common.h"
 #include "PDBDebugStore.h"
+#include "PDBReader.h"
 #include "ISymbolInfo.h"
 #include "Util.h"
 
@@ -455,11 +456,16 @@ namespace MagoST
 #endif
     };
 
+    volatile bool   PDBDebugStore::sReaderEnabled = true;
+
     PDBDebugStore::PDBDebugStore()
         :   mSource( NULL ),
             mSession( NULL ),
             mGlobal( NULL ),
             mFindLineEnumLineNumbers( NULL ),
+            mChildEnumSymbols( NULL ),
+            mChildEnumId( 0 ),
+            mChildEnumAddr( 0 ),
             mInit( false ),
             mCompilandCount( -1 )
     {
@@ -598,15 +604,36 @@ namespace MagoST
             }
         }
 
+        // Read the line info straight from the PDB that DIA loaded, if it can
+        // be opened. If not, DIA answers for the source files too. Symbols
+        // and types are always answered by DIA.
+        BSTR bstrPdbName = NULL;
+        if ( sReaderEnabled && (mGlobal->get_symbolsFileName( &bstrPdbName ) == S_OK) )
+        {
+            std::auto_ptr<PDBReader> reader( new PDBReader() );
+
+            if ( reader->Open( bstrPdbName ) == S_OK )
+                mReader = reader;
+
+            SysFreeString( bstrPdbName );
+        }
+
         return S_OK;
     }
 
+    void PDBDebugStore::EnableReader( bool enable )
+    {
+        sReaderEnabled = enable;
+    }
+
     void PDBDebugStore::CloseDebugInfo()
     {
         if( !mInit )
             return;
 
         releaseFindLineEnumLineNumbers();
+        releaseChildEnumSymbols();
+        mReader.reset();
 
         if ( mGlobal ) 
         {
@@ -640,6 +667,17 @@ namespace MagoST
         
     }
 
+    void PDBDebugStore::releaseChildEnumSymbols()
+    {
+        GuardedArea guard( mChildEnumGuard );
+
+        if ( mChildEnumSymbols )
+        {
+            mChildEnumSymbols->Release();
+            mChildEnumSymbols = NULL;
+        }
+    }
+
     HRESULT PDBDebugStore::SetCompilandSymbolScope( DWORD compilandIndex, SymbolScope& scope )
     {
         UNREFERENCED_PARAMETER( compilandIndex );
@@ -673,14 +711,34 @@ namespace MagoST
         PDBStore::SymHandleIn& symIn = (PDBStore::SymHandleIn&) handle;
         PDBStore::SymbolScopeIn& scopeIn = (PDBStore::SymbolScopeIn&) scope;
 
-        IDiaSymbol* pSymbol = NULL;
-        HRESULT hr = mSession->symbolById( scopeIn.id, &pSymbol );
-        IDiaEnumSymbols* pEnumSymbols = NULL;
-        if ( !FAILED( hr ) && pSymbol )
-            if ( addr == ~0 )
-                hr = pSymbol->findChildrenEx( SymTagNull, NULL, nsNone, &pEnumSymbols );
-            else
-                hr = pSymbol->findChildrenExByRVA( SymTagNull, NULL, nsNone, addr, &pEnumSymbols );
+        // the id only fills part of the handle, and the rest has to be set, 
+        // because callers compare whole handles
+        memset( &handle, 0, sizeof handle );
+
+        GuardedArea guard( mChildEnumGuard );
+
+        // Finding the children costs as much as walking them, so the
+        // enumerator is kept while the same scope is walked. Item takes an
+        // index, so a scope's position still holds when it's found again.
+        HRESULT hr = S_OK;
+        if ( !mChildEnumSymbols || (mChildEnumId != scopeIn.id) || (mChildEnumAddr != addr) )
+        {
+            releaseChildEnumSymbols();
+
+            IDiaSymbol* pSymbol = NULL;
+            hr = mSession->symbolById( scopeIn.id, &pSymbol );
+            if ( !FAILED( hr ) && pSymbol )
+                if ( addr == ~0 )
+                    hr = pSymbol->findChildrenEx( SymTagNull, NULL, nsNone, &mChildEnumSymbols );
+                else
+                    hr = pSymbol->findChildrenExByRVA( SymTagNull, NULL, nsNone, addr, &mChildEnumSymbols );
+            if ( pSymbol )
+                pSymbol->Release();
+
+            mChildEnumId = scopeIn.id;
+            mChildEnumAddr = addr;
+        }
+        IDiaEnumSymbols* pEnumSymbols = mChildEnumSymbols;
         IDiaSymbol* pChild = NULL;
         if ( !FAILED( hr ) && pEnumSymbols )
             hr = pEnumSymbols->Item( scopeIn.current, &pChild );
@@ -691,10 +749,6 @@ namespace MagoST
 
         if ( pChild )
             pChild->Release();
-        if ( pEnumSymbols )
-            pEnumSymbols->Release();
-        if ( pSymbol )
-            pSymbol->Release();
         return !FAILED( hr ) && pChild;
     }
 
@@ -743,6 +797,8 @@ namespace MagoST
     {
         const PDBStore::EnumNamedSymbolsDataIn& dataIn = (const PDBStore::EnumNamedSymbolsDataIn&) searchData;
         PDBStore::SymHandleIn& symIn = (PDBStore::SymHandleIn&) handle;
+
+        memset( &handle, 0, sizeof handle );
         symIn.id = dataIn.id;
         return S_OK;
     }
@@ -753,6 +809,8 @@ namespace MagoST
 
         PDBStore::SymHandleIn& handleIn = (PDBStore::SymHandleIn&) handle;
 
+        memset( &handle, 0, sizeof handle );
+
         IDiaSymbol* pSymbol1 = NULL;
         IDiaSymbol* pSymbol2 = NULL;
         IDiaSymbol* pSymbol3 = NULL;
@@ -805,6 +863,8 @@ namespace MagoST
     bool PDBDebugStore::GetTypeFromTypeIndex( TypeIndex typeIndex, TypeHandle& handle )
     {
         PDBStore::TypeHandleIn& handleIn = (PDBStore::TypeHandleIn&) handle;
+
+        memset( &handle, 0, sizeof handle );
         handleIn.id = typeIndex;
         return true;
     }
@@ -825,6 +885,8 @@ namespace MagoST
         PDBStore::TypeHandleIn& typeIn = (PDBStore::TypeHandleIn&) handle;
         PDBStore::TypeScopeIn& scopeIn = (PDBStore::TypeScopeIn&) scope;
 
+        memset( &handle, 0, sizeof handle );
+
         IDiaSymbol* pSymbol = NULL;
         HRESULT hr = mSession->symbolById( scopeIn.id, &pSymbol );
         IDiaEnumSymbols* pEnumSymbols = NULL;
@@ -876,12 +938,18 @@ namespace MagoST
 
     HRESULT PDBDebugStore::GetCompilandCount( uint32_t& count )
     {
+        if ( mReader.get() != NULL )
+            return mReader->GetCompilandCount( count );
+
         count = getCompilandCount();
         return S_OK;
     }
 
     HRESULT PDBDebugStore::GetCompilandInfo( uint16_t index, CompilandInfo& info )
     {
+        if ( mReader.get() != NULL )
+            return mReader->GetCompilandInfo( index, info );
+
         if ( (index < 1) || (index > getCompilandCount()) )
             return E_INVALIDARG;
 
@@ -935,6 +1003,9 @@ namespace MagoST
 
     HRESULT PDBDebugStore::GetFileInfo( uint16_t compilandIndex, uint16_t fileIndex, FileInfo& info )
     {
+        if ( mReader.get() != NULL )
+            return mReader->GetFileInfo( compilandIndex, fileIndex, info );
+
         if ( (compilandIndex < 1) || (compilandIndex > getCompilandCount()) )
             return E_INVALIDARG;
 
@@ -1008,6 +1079,9 @@ namespace MagoST
 
     bool PDBDebugStore::GetFileSegment( uint16_t compIndex, uint16_t fileIndex, uint16_t segInstanceIndex, FileSegmentInfo& segInfo )
     {
+        if ( mReader.get() != NULL )
+            return mReader->GetFileSegment( compIndex, fileIndex, segInstanceIndex, segInfo );
+
         if ( (compIndex < 1) || (compIndex > getCompilandCount()) )
             return false;
         if( segInstanceIndex > 0 )
@@ -1225,6 +1299,9 @@ namespace MagoST
 
     bool PDBDebugStore::FindLine( WORD seg, uint32_t offset, LineNumber& lineNumber )
     {
+        if ( mReader.get() != NULL )
+            return mReader->FindLine( seg, offset, lineNumber );
+
         HRESULT hr = S_OK;
         IDiaEnumLineNumbers *pEnumLineNumbers = NULL;
         if( !FAILED( hr ) )
@@ -1253,6 +1330,9 @@ namespace MagoST
 
     bool PDBDebugStore::FindLineByNum( uint16_t compIndex, uint16_t fileIndex, uint16_t line, LineNumber& lineNumber )
     {
+        if ( mReader.get() != NULL )
+            return mReader->FindLineByNum( compIndex, fileIndex, line, lineNumber );
+
         if ( (compIndex < 1) || (compIndex > getCompilandCount()) )
             return false;
 
@@ -1303,6 +1383,9 @@ namespace MagoST
 
     bool PDBDebugStore::FindNextLineByNum( uint16_t compIndex, uint16_t fileIndex, uint16_t line, LineNumber& lineNumber )
     {
+        if ( mReader.get() != NULL )
+            return mReader->FindNextLineByNum( compIndex, fileIndex, line, lineNumber );
+
         // assume arguments are the same as last call to FindLineByNum
         UNREFERENCED_PARAMETER( compIndex );
         UNREFERENCED_PARAMETER( fileIndex );
@@ -1330,6 +1413,9 @@ namespace MagoST
     bool PDBDebugStore::FindLines( bool exactMatch, const char* fileName, size_t fileNameLen, uint16_t reqLineStart, uint16_t reqLineEnd, 
                                    std::list<LineNumber>& lines )
     {
+        if ( mReader.get() != NULL )
+            return mReader->FindLines( exactMatch, fileName, fileNameLen, reqLineStart, reqLineEnd, lines );
+
         IDiaEnumSymbols *pEnumSymbols = NULL;
         HRESULT hr = mGlobal->findChildren( SymTagCompiland, NULL, nsNone, &pEnumSymbols );
         if( !FAILED( hr ) )
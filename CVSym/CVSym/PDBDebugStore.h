@@ -8,10 +8,12 @@
 #pragma once
 
 #include "DebugStore.h"
+#include <Guard.h>
 
 struct IDiaDataSource;
 struct IDiaSession;
 struct IDiaSymbol;
+struct IDiaEnumSymbols;
 struct IDiaEnumLineNumbers;
 struct IDiaLineNumber;
 struct IDiaSourceFile;
@@ -19,6 +21,7 @@ struct IDiaSourceFile;
 namespace MagoST
 {
     class IAddressMap;
+    class PDBReader;
 
     class PDBDebugStore : public IDebugStore
     {
@@ -32,6 +35,11 @@ namespace MagoST
         void CloseDebugInfo();
         IDiaSession* getSession() const { return mSession; }
 
+        // Whether stores opened after this read the source files and lines
+        // straight from the PDB, or through DIA. On by default. Symbols and
+        // types always go through DIA.
+        static void EnableReader( bool enable );
+
         // symbols
 
         virtual HRESULT SetSymbolScope( SymbolHeapId heapId, SymbolScope& scope );
@@ -81,6 +89,7 @@ namespace MagoST
 
     private:
         void releaseFindLineEnumLineNumbers();
+        void releaseChildEnumSymbols();
         HRESULT fillFileSegmentInfo( IDiaEnumLineNumbers *pEnumLineNumbers, FileSegmentInfo& segInfo );
         HRESULT findCompilandAndFile( IDiaSymbol *pCompiland, IDiaSourceFile *pSourceFile, uint16_t& compIndex, uint16_t& fileIndex );
         HRESULT setLineNumber( IDiaLineNumber* pLineNumber, uint16_t lineIndex, LineNumber& lineNumber );
@@ -93,6 +102,13 @@ namespace MagoST
         IDiaSymbol      *mGlobal;
         IDiaEnumLineNumbers *mFindLineEnumLineNumbers;
 
+        // the children of the scope that NextSymbol last walked, so that
+        // walking a scope doesn't find all its children again for each one
+        IDiaEnumSymbols *mChildEnumSymbols;
+        DWORD            mChildEnumId;
+        DWORD            mChildEnumAddr;
+        Guard            mChildEnumGuard;
+
         DWORD            mMachineType;
         long             mCompilandCount;
 
@@ -100,5 +116,10 @@ namespace MagoST
         std::auto_ptr<char>  mLastFileInfoName;
         std::auto_ptr<DWORD> mLastSegInfoOffsets;
         std::auto_ptr<WORD>  mLastSegInfoLineNumbers;
+
+        // reads the source files and lines without DIA, if the PDB could be opened
+        std::auto_ptr<PDBReader> mReader;
+
+        static volatile bool    sReaderEnabled;
     };
 }
@@ -0,0 +1,1250 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "Common.h"
+#include "PDBReader.h"
+#include "Util.h"
+#include <algorithm>
+
+
+namespace MagoST
+{
+    // The layouts of the PDB records that are read here. They're all
+    // naturally aligned, but the bytes they're read from might not be, so
+    // they're always copied out with ReadRecord.
+
+    static const char       MsfMagic[32] = "Microsoft C/C++ MSF 7.00\r\n\x1a" "DS\0\0";
+    static const uint32_t   NilStreamSize = 0xFFFFFFFF;
+    static const uint16_t   NilModStream = 0xFFFF;
+
+    static const uint32_t   InfoStream = 1;
+    static const uint32_t   DbiStream = 3;
+
+    static const uint32_t   NamesMagic = 0xEFFEEFFE;
+    static const uint32_t   SectionContribV60 = 0xEFFE0000 + 19970605;
+    static const uint32_t   SectionContribV2 = 0xEFFE0000 + 20140516;
+
+    static const uint32_t   DebugSIgnore = 0x80000000;
+    static const uint32_t   DebugSLines = 0xF2;
+    static const uint32_t   DebugSFileChecksums = 0xF4;
+
+    // lines at or above this are hidden, like 0xFEEFEE and 0xF00F00
+    static const uint32_t   HiddenLineStart = 0xF00000;
+    static const uint32_t   HiddenFileIndex = 0xFFFFFFFF;
+
+    // the most compilands, files and lines that IDebugStore's 16 bit indexes can reach
+    static const uint32_t   MaxIndex16 = 0xFFFF;
+
+    struct MsfSuperBlock
+    {
+        char        Magic[32];
+        uint32_t    BlockSize;
+        uint32_t    FreeBlockMapBlock;
+        uint32_t    BlockCount;
+        uint32_t    DirectorySize;
+        uint32_t    Reserved;
+        uint32_t    BlockMapBlock;
+    };
+
+    struct PdbInfoHeader
+    {
+        uint32_t    Version;
+        uint32_t    Signature;
+        uint32_t    Age;
+        GUID        Guid;
+    };
+
+    struct NamesHeader
+    {
+        uint32_t    Magic;
+        uint32_t    HashVersion;
+        uint32_t    ByteSize;
+    };
+
+    struct DbiHeader
+    {
+        int32_t     VersionSignature;
+        uint32_t    VersionHeader;
+        uint32_t    Age;
+        uint16_t    GlobalStream;
+        uint16_t    BuildNumber;
+        uint16_t    PublicStream;
+        uint16_t    PdbDllVersion;
+        uint16_t    SymRecordStream;
+        uint16_t    PdbDllRbld;
+        uint32_t    ModInfoSize;
+        uint32_t    SectionContribSize;
+        uint32_t    SectionMapSize;
+        uint32_t    SourceInfoSize;
+        uint32_t    TypeServerMapSize;
+        uint32_t    MfcTypeServerIndex;
+        uint32_t    OptionalDbgHeaderSize;
+        uint32_t    ECSubstreamSize;
+        uint16_t    Flags;
+        uint16_t    Machine;
+        uint32_t    Reserved;
+    };
+
+    struct DbiSectionContrib
+    {
+        uint16_t    Section;
+        uint16_t    Padding1;
+        int32_t     Offset;
+        int32_t     Size;
+        uint32_t    Characteristics;
+        uint16_t    ModIndex;
+        uint16_t    Padding2;
+        uint32_t    DataCrc;
+        uint32_t    RelocCrc;
+    };
+
+    struct DbiModInfo
+    {
+        uint32_t            Reserved1;
+        DbiSectionContrib   Contrib;
+        uint16_t            Flags;
+        uint16_t            Stream;
+        uint32_t            SymByteSize;
+        uint32_t            C11ByteSize;
+        uint32_t            C13ByteSize;
+        uint16_t            SourceFileCount;
+        uint16_t            Padding;
+        uint32_t            Reserved2;
+        uint32_t            SourceFileNameIndex;
+        uint32_t            PdbFilePathNameIndex;
+        // followed by the module and object file names
+    };
+
+    struct C13SubsectionHeader
+    {
+        uint32_t    Kind;
+        uint32_t    Size;
+    };
+
+    struct C13LinesHeader
+    {
+        uint32_t    Offset;
+        uint16_t    Section;
+        uint16_t    Flags;
+        uint32_t    Size;
+    };
+
+    struct C13FileBlockHeader
+    {
+        uint32_t    ChecksumOffset;
+        uint32_t    LineCount;
+        uint32_t    Size;
+        // followed by the lines, and then the columns if the block has them
+    };
+
+    struct C13Line
+    {
+        uint32_t    Offset;
+        uint32_t    Flags;      // start:24, delta to end:7, statement:1
+    };
+
+    // file checksum entries have a 6 byte header: name offset, size, kind
+    static const uint32_t   ChecksumHeaderSize = 6;
+
+
+    template <class T>
+    static bool ReadRecord( const BYTE* bytes, uint32_t size, uint32_t offset, T& record )
+    {
+        if ( (offset > size) || ((size - offset) < sizeof record) )
+            return false;
+
+        memcpy( &record, bytes + offset, sizeof record );
+        return true;
+    }
+
+    static bool ReadString( const BYTE* bytes, uint32_t size, uint32_t offset, const char*& str, size_t& len )
+    {
+        if ( offset >= size )
+            return false;
+
+        const BYTE* end = (const BYTE*) memchr( bytes + offset, 0, size - offset );
+        if ( end == NULL )
+            return false;
+
+        str = (const char*) bytes + offset;
+        len = end - (bytes + offset);
+        return true;
+    }
+
+    static uint32_t AlignUp4( uint32_t offset )
+    {
+        return (offset + 3) & ~3;
+    }
+
+    // Moves to the next C13 subsection that isn't marked to be ignored.
+
+    static bool NextSubsection( const BYTE* bytes, uint32_t size, uint32_t& pos, uint32_t& kind, const BYTE*& data, uint32_t& dataSize )
+    {
+        C13SubsectionHeader header;
+
+        while ( ReadRecord( bytes, size, pos, header ) )
+        {
+            uint32_t    dataPos = pos + sizeof header;
+
+            if ( header.Size > size - dataPos )
+                return false;
+
+            pos = AlignUp4( dataPos + header.Size );
+
+            if ( (header.Kind & DebugSIgnore) != 0 )
+                continue;
+
+            kind = header.Kind;
+            data = bytes + dataPos;
+            dataSize = header.Size;
+            return true;
+        }
+
+        return false;
+    }
+
+
+    //------------------------------------------------------------------------
+    //  MsfFile
+    //------------------------------------------------------------------------
+
+    MsfFile::MsfFile()
+        :   mData( NULL ),
+            mSize( 0 ),
+            mBlockSize( 0 )
+    {
+    }
+
+    HRESULT MsfFile::Init( const BYTE* data, uint32_t size )
+    {
+        MsfSuperBlock   super;
+
+        if ( !ReadRecord( data, size, 0, super ) )
+            return E_BAD_FORMAT;
+
+        if ( memcmp( super.Magic, MsfMagic, sizeof MsfMagic ) != 0 )
+            return E_BAD_FORMAT;
+
+        switch ( super.BlockSize )
+        {
+        case 512:
+        case 1024:
+        case 2048:
+        case 4096:
+            break;
+        default:
+            return E_BAD_FORMAT;
+        }
+
+        if ( ((uint64_t) super.BlockCount * super.BlockSize) > size )
+            return E_BAD_FORMAT;
+
+        mData = data;
+        mSize = size;
+        mBlockSize = super.BlockSize;
+
+        // the directory is spread over the blocks listed in the block map
+
+        uint32_t    dirSize = super.DirectorySize;
+        uint32_t    dirBlockCount = (dirSize / mBlockSize) + ((dirSize % mBlockSize) != 0 ? 1 : 0);
+        const BYTE* blockMap = NULL;
+
+        if ( (dirSize < sizeof( uint32_t )) || (dirBlockCount > (mBlockSize / sizeof( uint32_t ))) )
+            return E_BAD_FORMAT;
+
+        if ( !GetBlock( super.BlockMapBlock, blockMap ) )
+            return E_BAD_FORMAT;
+
+        std::vector<BYTE>   dir( dirBlockCount * mBlockSize );
+
+        for ( uint32_t i = 0; i < dirBlockCount; i++ )
+        {
+            uint32_t    block = 0;
+            const BYTE* blockBytes = NULL;
+
+            memcpy( &block, blockMap + (i * sizeof block), sizeof block );
+
+            if ( !GetBlock( block, blockBytes ) )
+                return E_BAD_FORMAT;
+
+            memcpy( &dir[i * mBlockSize], blockBytes, mBlockSize );
+        }
+
+        // the directory is the stream count, the size of each stream, and
+        // then the blocks of each stream
+
+        uint32_t    streamCount = 0;
+
+        ReadRecord( &dir[0], dirSize, 0, streamCount );
+
+        if ( streamCount > ((dirSize / sizeof( uint32_t )) - 1) )
+            return E_BAD_FORMAT;
+
+        uint32_t    pos = (1 + streamCount) * sizeof( uint32_t );
+
+        mStreamSizes.resize( streamCount );
+        mStreamBlockStart.resize( streamCount );
+        mStreamBlocks.clear();
+
+        for ( uint32_t i = 0; i < streamCount; i++ )
+        {
+            uint32_t    streamSize = 0;
+
+            ReadRecord( &dir[0], dirSize, (1 + i) * sizeof( uint32_t ), streamSize );
+
+            if ( streamSize == NilStreamSize )
+                streamSize = 0;
+
+            uint32_t    blockCount = (streamSize / mBlockSize) + ((streamSize % mBlockSize) != 0 ? 1 : 0);
+
+            if ( blockCount > ((dirSize - pos) / sizeof( uint32_t )) )
+                return E_BAD_FORMAT;
+
+            mStreamSizes[i] = streamSize;
+            mStreamBlockStart[i] = (uint32_t) mStreamBlocks.size();
+
+            for ( uint32_t j = 0; j < blockCount; j++ )
+            {
+                uint32_t    block = 0;
+
+                ReadRecord( &dir[0], dirSize, pos, block );
+                pos += sizeof block;
+
+                if ( block >= super.BlockCount )
+                    return E_BAD_FORMAT;
+
+                mStreamBlocks.push_back( block );
+            }
+        }
+
+        return S_OK;
+    }
+
+    uint32_t MsfFile::GetStreamCount() const
+    {
+        return (uint32_t) mStreamSizes.size();
+    }
+
+    HRESULT MsfFile::GetStreamBytes( uint32_t stream, const BYTE*& bytes, uint32_t& size, std::vector<BYTE>& copy ) const
+    {
+        if ( stream >= mStreamSizes.size() )
+            return E_NOT_FOUND;
+
+        uint32_t    streamSize = mStreamSizes[stream];
+        uint32_t    blockCount = (streamSize / mBlockSize) + ((streamSize % mBlockSize) != 0 ? 1 : 0);
+
+        if ( blockCount == 0 )
+        {
+            bytes = mData;
+            size = 0;
+            return S_OK;
+        }
+
+        const uint32_t* blocks = &mStreamBlocks[ mStreamBlockStart[stream] ];
+        bool            contiguous = true;
+
+        for ( uint32_t i = 1; i < blockCount; i++ )
+        {
+            if ( blocks[i] != blocks[0] + i )
+            {
+                contiguous = false;
+                break;
+            }
+        }
+
+        if ( contiguous )
+        {
+            bytes = mData + ((size_t) blocks[0] * mBlockSize);
+            size = streamSize;
+            return S_OK;
+        }
+
+        copy.resize( (size_t) blockCount * mBlockSize );
+
+        for ( uint32_t i = 0; i < blockCount; i++ )
+        {
+            memcpy( &copy[(size_t) i * mBlockSize], mData + ((size_t) blocks[i] * mBlockSize), mBlockSize );
+        }
+
+        bytes = &copy[0];
+        size = streamSize;
+        return S_OK;
+    }
+
+    bool MsfFile::GetBlock( uint32_t block, const BYTE*& bytes ) const
+    {
+        if ( ((uint64_t) block + 1) * mBlockSize > mSize )
+            return false;
+
+        bytes = mData + ((size_t) block * mBlockSize);
+        return true;
+    }
+
+
+    //------------------------------------------------------------------------
+    //  PDBReader
+    //------------------------------------------------------------------------
+
+    PDBReader::PDBReader()
+        :   mMapping( NULL ),
+            mNames( NULL ),
+            mNamesSize( 0 ),
+            mHasFileModules( false )
+    {
+    }
+
+    PDBReader::~PDBReader()
+    {
+        if ( mMapping != NULL )
+            UnmapViewOfFile( mMapping );
+    }
+
+    HRESULT PDBReader::Open( const wchar_t* filename )
+    {
+        if ( filename == NULL )
+            return E_INVALIDARG;
+        if ( mMapping != NULL )
+            return E_ALREADY_INIT;
+
+        FileHandlePtr   hFile;
+        LARGE_INTEGER   fileSize = { 0 };
+
+        hFile = CreateFile( filename, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+        if ( hFile.IsEmpty() )
+            return HRESULT_FROM_WIN32( GetLastError() );
+
+        if ( !GetFileSizeEx( hFile, &fileSize ) )
+            return HRESULT_FROM_WIN32( GetLastError() );
+
+        if ( (fileSize.QuadPart == 0) || (fileSize.HighPart != 0) )
+            return E_BAD_FORMAT;
+
+        mMapHandle = CreateFileMapping( hFile, NULL, PAGE_READONLY, 0, 0, NULL );
+        if ( mMapHandle.IsEmpty() )
+            return HRESULT_FROM_WIN32( GetLastError() );
+
+        mMapping = (const BYTE*) MapViewOfFile( mMapHandle, FILE_MAP_READ, 0, 0, 0 );
+        if ( mMapping == NULL )
+            return HRESULT_FROM_WIN32( GetLastError() );
+
+        return Init( mMapping, fileSize.LowPart );
+    }
+
+    HRESULT PDBReader::Init( const BYTE* data, uint32_t size )
+    {
+        HRESULT hr = S_OK;
+
+        if ( data == NULL )
+            return E_INVALIDARG;
+
+        hr = mMsf.Init( data, size );
+        if ( FAILED( hr ) )
+            return hr;
+
+        hr = ReadNames();
+        if ( FAILED( hr ) )
+            return hr;
+
+        return ReadDbi();
+    }
+
+    // The file names that the line info refers to are in the "/names"
+    // stream, which is found through the named stream map of the info stream.
+
+    HRESULT PDBReader::ReadNames()
+    {
+        HRESULT             hr = S_OK;
+        const BYTE*         info = NULL;
+        uint32_t            infoSize = 0;
+        std::vector<BYTE>   infoCopy;
+
+        hr = mMsf.GetStreamBytes( InfoStream, info, infoSize, infoCopy );
+        if ( FAILED( hr ) )
+            return hr;
+
+        uint32_t    pos = sizeof( PdbInfoHeader );
+        uint32_t    stringsSize = 0;
+
+        if ( !ReadRecord( info, infoSize, pos, stringsSize ) )
+            return E_BAD_FORMAT;
+
+        pos += sizeof stringsSize;
+        if ( stringsSize > infoSize - pos )
+            return E_BAD_FORMAT;
+
+        uint32_t    stringsPos = pos;
+        uint32_t    entryCount = 0;
+        uint32_t    capacity = 0;
+        uint32_t    presentWords = 0;
+        uint32_t    deletedWords = 0;
+
+        pos += stringsSize;
+        if ( !ReadRecord( info, infoSize, pos, entryCount )
+            || !ReadRecord( info, infoSize, pos + 4, capacity )
+            || !ReadRecord( info, infoSize, pos + 8, presentWords ) )
+            return E_BAD_FORMAT;
+
+        pos += 12;
+        if ( presentWords > (infoSize - pos) / sizeof( uint32_t ) )
+            return E_BAD_FORMAT;
+
+        uint32_t    presentPos = pos;
+
+        pos += presentWords * sizeof( uint32_t );
+        if ( !ReadRecord( info, infoSize, pos, deletedWords ) )
+            return E_BAD_FORMAT;
+
+        pos += sizeof deletedWords;
+        if ( deletedWords > (infoSize - pos) / sizeof( uint32_t ) )
+            return E_BAD_FORMAT;
+
+        pos += deletedWords * sizeof( uint32_t );
+
+        // the key and value of each present bucket follow, in bucket order
+
+        uint32_t    namesStream = NilStreamSize;
+
+        for ( uint32_t i = 0; (i < capacity) && (i < presentWords * 32); i++ )
+        {
+            uint32_t    word = 0;
+            uint32_t    key = 0;
+            uint32_t    value = 0;
+            const char* name = NULL;
+            size_t      nameLen = 0;
+
+            ReadRecord( info, infoSize, presentPos + ((i / 32) * sizeof word), word );
+
+            if ( (word & (1 << (i % 32))) == 0 )
+                continue;
+
+            if ( !ReadRecord( info, infoSize, pos, key ) || !ReadRecord( info, infoSize, pos + 4, value ) )
+                return E_BAD_FORMAT;
+
+            pos += 8;
+
+            if ( !ReadString( info + stringsPos, stringsSize, key, name, nameLen ) )
+                continue;
+
+            if ( (nameLen == 6) && (memcmp( name, "/names", 6 ) == 0) )
+            {
+                namesStream = value;
+                break;
+            }
+        }
+
+        if ( namesStream == NilStreamSize )
+            return E_NOT_FOUND;
+
+        const BYTE* names = NULL;
+        uint32_t    namesSize = 0;
+        NamesHeader header;
+
+        hr = mMsf.GetStreamBytes( namesStream, names, namesSize, mNamesCopy );
+        if ( FAILED( hr ) )
+            return hr;
+
+        if ( !ReadRecord( names, namesSize, 0, header ) )
+            return E_BAD_FORMAT;
+
+        if ( (header.Magic != NamesMagic) || (header.ByteSize > namesSize - sizeof header) )
+            return E_BAD_FORMAT;
+
+        mNames = (const char*) names + sizeof header;
+        mNamesSize = header.ByteSize;
+        return S_OK;
+    }
+
+    HRESULT PDBReader::ReadDbi()
+    {
+        HRESULT     hr = S_OK;
+        const BYTE* dbi = NULL;
+        uint32_t    dbiSize = 0;
+        DbiHeader   header;
+
+        // the module names point into this stream, so it's kept
+        hr = mMsf.GetStreamBytes( DbiStream, dbi, dbiSize, mDbiCopy );
+        if ( FAILED( hr ) )
+            return hr;
+
+        if ( !ReadRecord( dbi, dbiSize, 0, header ) )
+            return E_BAD_FORMAT;
+
+        if ( header.VersionSignature != -1 )
+            return E_BAD_FORMAT;
+
+        uint32_t    modPos = sizeof header;
+
+        if ( header.ModInfoSize > dbiSize - modPos )
+            return E_BAD_FORMAT;
+
+        uint32_t    modEnd = modPos + header.ModInfoSize;
+
+        while ( modPos < modEnd )
+        {
+            DbiModInfo  modInfo;
+            const char* modName = NULL;
+            size_t      modNameLen = 0;
+            const char* objName = NULL;
+            size_t      objNameLen = 0;
+
+            if ( !ReadRecord( dbi, modEnd, modPos, modInfo ) )
+                return E_BAD_FORMAT;
+
+            uint32_t    pos = modPos + sizeof modInfo;
+
+            if ( !ReadString( dbi, modEnd, pos, modName, modNameLen ) )
+                return E_BAD_FORMAT;
+
+            pos += (uint32_t) modNameLen + 1;
+
+            if ( !ReadString( dbi, modEnd, pos, objName, objNameLen ) )
+                return E_BAD_FORMAT;
+
+            pos += (uint32_t) objNameLen + 1;
+            modPos = AlignUp4( pos );
+
+            Module  mod;
+
+            mod.Name = modName;
+            mod.NameLen = (uint32_t) modNameLen;
+            mod.Stream = modInfo.Stream;
+            mod.SymByteSize = modInfo.SymByteSize;
+            mod.C11ByteSize = modInfo.C11ByteSize;
+            mod.C13ByteSize = modInfo.C13ByteSize;
+            mod.Loaded = false;
+
+            mModules.push_back( mod );
+        }
+
+        // compiland indexes are 16 bits and 1-based
+        if ( mModules.size() >= MaxIndex16 )
+            return E_BAD_FORMAT;
+
+        if ( header.SectionContribSize > dbiSize - modEnd )
+            return E_BAD_FORMAT;
+
+        hr = ReadSectionContribs( dbi + modEnd, header.SectionContribSize );
+        if ( FAILED( hr ) )
+            return hr;
+
+        // the section map comes between the contributions and the file info
+
+        uint32_t    fileInfoPos = modEnd + header.SectionContribSize;
+
+        if ( (header.SectionMapSize <= dbiSize - fileInfoPos) 
+            && (header.SourceInfoSize <= dbiSize - fileInfoPos - header.SectionMapSize) )
+        {
+            fileInfoPos += header.SectionMapSize;
+
+            // without it, FindLines reads every module
+            ReadFileInfo( dbi + fileInfoPos, header.SourceInfoSize );
+        }
+
+        return S_OK;
+    }
+
+    HRESULT PDBReader::ReadSectionContribs( const BYTE* bytes, uint32_t size )
+    {
+        uint32_t    version = 0;
+        uint32_t    entrySize = 0;
+
+        if ( !ReadRecord( bytes, size, 0, version ) )
+            return E_BAD_FORMAT;
+
+        if ( version == SectionContribV60 )
+            entrySize = sizeof( DbiSectionContrib );
+        else if ( version == SectionContribV2 )
+            entrySize = sizeof( DbiSectionContrib ) + sizeof( uint32_t );
+        else
+            return E_BAD_FORMAT;
+
+        for ( uint32_t pos = sizeof version; (size - pos) >= entrySize; pos += entrySize )
+        {
+            DbiSectionContrib   entry;
+            SectionContrib      contrib;
+
+            ReadRecord( bytes, size, pos, entry );
+
+            if ( (entry.ModIndex >= mModules.size()) || (entry.Size <= 0) )
+                continue;
+
+            contrib.Section = entry.Section;
+            contrib.ModIndex = entry.ModIndex;
+            contrib.Offset = (uint32_t) entry.Offset;
+            contrib.Size = (uint32_t) entry.Size;
+
+            mContribs.push_back( contrib );
+        }
+
+        std::sort( mContribs.begin(), mContribs.end() );
+        return S_OK;
+    }
+
+    // The file info substream lists the names of each module's source files,
+    // so that FindLines can tell which modules to read. Its total file count
+    // is only 16 bits, so the count is added up from the modules' counts.
+
+    HRESULT PDBReader::ReadFileInfo( const BYTE* bytes, uint32_t size )
+    {
+        uint16_t    modCount = 0;
+
+        if ( !ReadRecord( bytes, size, 0, modCount ) )
+            return E_BAD_FORMAT;
+
+        if ( modCount != mModules.size() )
+            return E_BAD_FORMAT;
+
+        // the module indexes come before the file counts, but they're not needed
+
+        uint32_t    countsPos = (2 * sizeof( uint16_t )) + (modCount * sizeof( uint16_t ));
+        uint32_t    offsetsPos = countsPos + (modCount * sizeof( uint16_t ));
+        uint32_t    fileCount = 0;
+
+        if ( offsetsPos > size )
+            return E_BAD_FORMAT;
+
+        for ( uint16_t i = 0; i < modCount; i++ )
+        {
+            uint16_t    modFileCount = 0;
+
+            ReadRecord( bytes, size, countsPos + (i * sizeof modFileCount), modFileCount );
+            fileCount += modFileCount;
+        }
+
+        if ( fileCount > (size - offsetsPos) / sizeof( uint32_t ) )
+            return E_BAD_FORMAT;
+
+        uint32_t        namesPos = offsetsPos + (fileCount * sizeof( uint32_t ));
+        uint32_t        filePos = offsetsPos;
+        std::string     key;
+        FileModuleMap   fileModules;
+
+        for ( uint16_t i = 0; i < modCount; i++ )
+        {
+            uint16_t    modFileCount = 0;
+
+            ReadRecord( bytes, size, countsPos + (i * sizeof modFileCount), modFileCount );
+
+            for ( uint16_t j = 0; j < modFileCount; j++, filePos += sizeof( uint32_t ) )
+            {
+                uint32_t    nameOffset = 0;
+                const char* name = NULL;
+                size_t      nameLen = 0;
+
+                ReadRecord( bytes, size, filePos, nameOffset );
+
+                if ( !ReadString( bytes + namesPos, size - namesPos, nameOffset, name, nameLen ) )
+                    return E_BAD_FORMAT;
+
+                GetFileNameKey( name, nameLen, key );
+
+                // in module order, so each list stays sorted
+                std::vector<uint16_t>&  modIndexes = fileModules[key];
+
+                if ( modIndexes.empty() || (modIndexes.back() != i) )
+                    modIndexes.push_back( i );
+            }
+        }
+
+        mFileModules.swap( fileModules );
+        mHasFileModules = true;
+        return S_OK;
+    }
+
+    PDBReader::Module* PDBReader::GetModule( uint16_t compIndex )
+    {
+        if ( (compIndex < 1) || (compIndex > mModules.size()) )
+            return NULL;
+
+        Module& mod = mModules[compIndex - 1];
+
+        if ( !mod.Loaded )
+            LoadModule( mod );
+
+        return &mod;
+    }
+
+    PDBReader::ModFile* PDBReader::GetModFile( uint16_t compIndex, uint16_t fileIndex )
+    {
+        Module* mod = GetModule( compIndex );
+
+        if ( (mod == NULL) || (fileIndex >= mod->Files.size()) )
+            return NULL;
+
+        return &mod->Files[fileIndex];
+    }
+
+    HRESULT PDBReader::LoadModule( Module& mod )
+    {
+        HRESULT             hr = S_OK;
+        const BYTE*         bytes = NULL;
+        uint32_t            size = 0;
+        std::vector<BYTE>   copy;
+
+        // whether or not the lines can be read, only try once
+        mod.Loaded = true;
+
+        if ( mod.Stream == NilModStream )
+            return S_OK;
+
+        hr = mMsf.GetStreamBytes( mod.Stream, bytes, size, copy );
+        if ( FAILED( hr ) )
+            return hr;
+
+        if ( (mod.SymByteSize > size) || (mod.C11ByteSize > size - mod.SymByteSize) )
+            return E_BAD_FORMAT;
+
+        uint32_t    c13Pos = mod.SymByteSize + mod.C11ByteSize;
+
+        if ( mod.C13ByteSize > size - c13Pos )
+            return E_BAD_FORMAT;
+
+        const BYTE* c13 = bytes + c13Pos;
+        uint32_t    c13Size = mod.C13ByteSize;
+        uint32_t    pos = 0;
+        uint32_t    kind = 0;
+        const BYTE* data = NULL;
+        uint32_t    dataSize = 0;
+
+        // line blocks refer to files by the offset of their checksum entries,
+        // so the checksums have to be read first
+
+        std::vector<uint32_t>   checksumOffsets;
+
+        while ( NextSubsection( c13, c13Size, pos, kind, data, dataSize ) )
+        {
+            if ( kind == DebugSFileChecksums )
+            {
+                hr = ReadChecksums( data, dataSize, mod, checksumOffsets );
+                if ( FAILED( hr ) )
+                {
+                    mod.Files.clear();
+                    return hr;
+                }
+            }
+        }
+
+        for ( pos = 0; NextSubsection( c13, c13Size, pos, kind, data, dataSize ); )
+        {
+            if ( kind == DebugSLines )
+            {
+                hr = ReadLines( data, dataSize, mod, checksumOffsets );
+                if ( FAILED( hr ) )
+                {
+                    mod.Files.clear();
+                    return hr;
+                }
+            }
+        }
+
+        for ( size_t i = 0; i < mod.Files.size(); i++ )
+        {
+            ModFile&    file = mod.Files[i];
+
+            std::stable_sort( file.Lines.begin(), file.Lines.end() );
+
+            file.Offsets.resize( file.Lines.size() );
+            file.LineNumbers.resize( file.Lines.size() );
+
+            for ( size_t j = 0; j < file.Lines.size(); j++ )
+            {
+                uint32_t    number = file.Lines[j].Number;
+
+                file.Lines[j].LineIndex = (uint32_t) j;
+                file.Offsets[j] = file.Lines[j].Offset;
+                file.LineNumbers[j] = (number <= MaxIndex16) ? (WORD) number : 0;
+            }
+
+            mod.AddrLines.insert( mod.AddrLines.end(), file.Lines.begin(), file.Lines.end() );
+        }
+
+        std::stable_sort( mod.AddrLines.begin(), mod.AddrLines.end() );
+        return S_OK;
+    }
+
+    HRESULT PDBReader::ReadChecksums( const BYTE* bytes, uint32_t size, Module& mod, std::vector<uint32_t>& checksumOffsets )
+    {
+        for ( uint32_t pos = 0; (size - pos) >= ChecksumHeaderSize; )
+        {
+            uint32_t    nameOffset = 0;
+            uint8_t     checksumSize = bytes[pos + 4];
+
+            ReadRecord( bytes, size, pos, nameOffset );
+
+            if ( checksumSize > size - pos - ChecksumHeaderSize )
+                return E_BAD_FORMAT;
+
+            // the files after this can't be reached by a file index, so 
+            // their lines are left out
+            if ( mod.Files.size() >= MaxIndex16 )
+                break;
+
+            ModFile file;
+
+            file.NameOffset = nameOffset;
+            mod.Files.push_back( file );
+            checksumOffsets.push_back( pos );
+
+            pos = AlignUp4( pos + ChecksumHeaderSize + checksumSize );
+            if ( pos > size )
+                break;
+        }
+
+        return S_OK;
+    }
+
+    HRESULT PDBReader::ReadLines( const BYTE* bytes, uint32_t size, Module& mod, const std::vector<uint32_t>& checksumOffsets )
+    {
+        C13LinesHeader          header;
+        std::vector<LineEntry>  blockLines;
+
+        if ( !ReadRecord( bytes, size, 0, header ) )
+            return E_BAD_FORMAT;
+
+        for ( uint32_t pos = sizeof header; pos < size; )
+        {
+            C13FileBlockHeader  fileBlock;
+
+            if ( !ReadRecord( bytes, size, pos, fileBlock ) )
+                return E_BAD_FORMAT;
+
+            if ( (fileBlock.Size < sizeof fileBlock) || (fileBlock.Size > size - pos) )
+                return E_BAD_FORMAT;
+
+            if ( fileBlock.LineCount > (fileBlock.Size - sizeof fileBlock) / sizeof( C13Line ) )
+                return E_BAD_FORMAT;
+
+            std::vector<uint32_t>::const_iterator   it =
+                std::lower_bound( checksumOffsets.begin(), checksumOffsets.end(), fileBlock.ChecksumOffset );
+
+            if ( (it != checksumOffsets.end()) && (*it == fileBlock.ChecksumOffset) )
+            {
+                uint32_t    fileIndex = (uint32_t) (it - checksumOffsets.begin());
+
+                for ( uint32_t i = 0; i < fileBlock.LineCount; i++ )
+                {
+                    C13Line     line;
+                    LineEntry   entry = { 0 };
+
+                    ReadRecord( bytes, size, pos + sizeof fileBlock + (i * sizeof line), line );
+
+                    uint32_t    start = line.Flags & 0xFFFFFF;
+                    uint32_t    delta = (line.Flags >> 24) & 0x7F;
+
+                    entry.Offset = header.Offset + line.Offset;
+                    entry.Section = header.Section;
+                    entry.Number = start;
+                    entry.NumberEnd = start + delta;
+                    entry.FileIndex = (start >= HiddenLineStart) ? HiddenFileIndex : fileIndex;
+
+                    blockLines.push_back( entry );
+                }
+            }
+
+            pos += fileBlock.Size;
+        }
+
+        // a line runs until the next line of the block, and the last one
+        // runs to the end of the block; hidden lines end the line before
+        // them, but aren't kept
+
+        std::stable_sort( blockLines.begin(), blockLines.end() );
+
+        uint32_t    blockEnd = header.Offset + header.Size;
+
+        for ( size_t i = 0; i < blockLines.size(); i++ )
+        {
+            LineEntry&  entry = blockLines[i];
+            uint32_t    end = (i + 1 < blockLines.size()) ? blockLines[i + 1].Offset : blockEnd;
+
+            if ( entry.FileIndex == HiddenFileIndex )
+                continue;
+
+            entry.Length = (end > entry.Offset) ? (end - entry.Offset) : 0;
+
+            mod.Files[entry.FileIndex].Lines.push_back( entry );
+        }
+
+        return S_OK;
+    }
+
+    const char* PDBReader::GetName( uint32_t offset, size_t& len )
+    {
+        const char* name = NULL;
+
+        if ( !ReadString( (const BYTE*) mNames, mNamesSize, offset, name, len ) )
+            return NULL;
+
+        return name;
+    }
+
+    bool PDBReader::SetLineNumber( uint16_t compIndex, uint16_t fileIndex, const ModFile& file, uint32_t lineIndex, LineNumber& lineNumber )
+    {
+        const LineEntry&    entry = file.Lines[lineIndex];
+
+        if ( (lineIndex > MaxIndex16) || (entry.Number > MaxIndex16) )
+            return false;
+
+        lineNumber.CompilandIndex = compIndex;
+        lineNumber.FileIndex = fileIndex;
+        lineNumber.SegmentInstanceIndex = 0;
+        lineNumber.LineIndex = (uint16_t) lineIndex;
+
+        lineNumber.Number = (uint16_t) entry.Number;
+        lineNumber.NumberEnd = (uint16_t) ((entry.NumberEnd > MaxIndex16) ? MaxIndex16 : entry.NumberEnd);
+        lineNumber.Offset = entry.Offset;
+        lineNumber.Section = entry.Section;
+        lineNumber.Length = entry.Length;
+        return true;
+    }
+
+    HRESULT PDBReader::GetCompilandCount( uint32_t& count )
+    {
+        count = (uint32_t) mModules.size();
+        return S_OK;
+    }
+
+    uint32_t PDBReader::GetLoadedModuleCount()
+    {
+        GuardedArea guard( mGuard );
+
+        uint32_t    count = 0;
+
+        for ( size_t i = 0; i < mModules.size(); i++ )
+        {
+            if ( mModules[i].Loaded )
+                count++;
+        }
+
+        return count;
+    }
+
+    HRESULT PDBReader::GetCompilandInfo( uint16_t index, CompilandInfo& info )
+    {
+        GuardedArea guard( mGuard );
+
+        Module* mod = GetModule( index );
+        if ( mod == NULL )
+            return E_INVALIDARG;
+
+        info.Name.set( mod->NameLen, mod->Name, false );
+        info.FileCount = (WORD) mod->Files.size();
+        info.SegmentCount = 1;
+        return S_OK;
+    }
+
+    HRESULT PDBReader::GetFileInfo( uint16_t compilandIndex, uint16_t fileIndex, FileInfo& info )
+    {
+        GuardedArea guard( mGuard );
+
+        ModFile* file = GetModFile( compilandIndex, fileIndex );
+        if ( file == NULL )
+            return E_INVALIDARG;
+
+        size_t      nameLen = 0;
+        const char* name = GetName( file->NameOffset, nameLen );
+        if ( name == NULL )
+            return E_BAD_FORMAT;
+
+        info.Name.set( nameLen, name, false );
+        info.SegmentCount = 1;
+        return S_OK;
+    }
+
+    bool PDBReader::GetFileSegment( uint16_t compIndex, uint16_t fileIndex, uint16_t segInstanceIndex, FileSegmentInfo& segInfo )
+    {
+        if ( segInstanceIndex > 0 )
+            return false;
+
+        GuardedArea guard( mGuard );
+
+        // a loaded module's lines don't change, so the arrays can be handed out
+        ModFile* file = GetModFile( compIndex, fileIndex );
+        if ( (file == NULL) || file->Lines.empty() )
+            return false;
+
+        const LineEntry&    first = file->Lines.front();
+        const LineEntry&    last = file->Lines.back();
+
+        segInfo.SegmentIndex = first.Section;
+        segInfo.SegmentInstance = 0;
+        segInfo.Start = first.Offset;
+        segInfo.End = last.Offset + ((last.Length > 0) ? (last.Length - 1) : 0);
+        segInfo.LineCount = (WORD) ((file->Lines.size() > MaxIndex16) ? MaxIndex16 : file->Lines.size());
+        segInfo.Offsets = &file->Offsets[0];
+        segInfo.LineNumbers = &file->LineNumbers[0];
+        return true;
+    }
+
+    bool PDBReader::FindLine( WORD seg, uint32_t offset, LineNumber& lineNumber )
+    {
+        GuardedArea guard( mGuard );
+
+        SectionContrib  contribKey = { seg, 0, offset, 0 };
+
+        std::vector<SectionContrib>::iterator   contribIt =
+            std::upper_bound( mContribs.begin(), mContribs.end(), contribKey );
+
+        if ( contribIt == mContribs.begin() )
+            return false;
+
+        --contribIt;
+        if ( (contribIt->Section != seg) || ((offset - contribIt->Offset) >= contribIt->Size) )
+            return false;
+
+        uint16_t    compIndex = contribIt->ModIndex + 1;
+        Module*     mod = GetModule( compIndex );
+        LineEntry   lineKey = { 0 };
+
+        lineKey.Section = seg;
+        lineKey.Offset = offset;
+
+        std::vector<LineEntry>::iterator    lineIt =
+            std::upper_bound( mod->AddrLines.begin(), mod->AddrLines.end(), lineKey );
+
+        if ( lineIt == mod->AddrLines.begin() )
+            return false;
+
+        --lineIt;
+        uint32_t    lineLen = (lineIt->Length > 0) ? lineIt->Length : 1;
+
+        if ( (lineIt->Section != seg) || ((offset - lineIt->Offset) >= lineLen) )
+            return false;
+
+        return SetLineNumber( compIndex, (uint16_t) lineIt->FileIndex, mod->Files[lineIt->FileIndex], lineIt->LineIndex, lineNumber );
+    }
+
+    bool PDBReader::FindLineByNum( uint16_t compIndex, uint16_t fileIndex, uint16_t line, LineNumber& lineNumber )
+    {
+        GuardedArea guard( mGuard );
+
+        ModFile* file = GetModFile( compIndex, fileIndex );
+        if ( (file == NULL) || file->Lines.empty() )
+            return false;
+
+        // take the closest line at or after the target line, or the last
+        // line if they're all before it
+
+        const std::vector<LineEntry>&   fileLines = file->Lines;
+        int32_t                         closestLineIndex = -1;
+        uint32_t                        lastLineIndex = 0;
+
+        for ( uint32_t i = 0; i < fileLines.size(); i++ )
+        {
+            uint32_t    curLine = fileLines[i].Number;
+
+            if ( curLine > fileLines[lastLineIndex].Number )
+                lastLineIndex = i;
+
+            if ( (curLine >= line)
+                && ((closestLineIndex < 0) || (curLine < fileLines[closestLineIndex].Number)) )
+                closestLineIndex = (int32_t) i;
+        }
+
+        if ( closestLineIndex < 0 )
+            closestLineIndex = (int32_t) lastLineIndex;
+
+        return SetLineNumber( compIndex, fileIndex, *file, (uint32_t) closestLineIndex, lineNumber );
+    }
+
+    bool PDBReader::FindNextLineByNum( uint16_t compIndex, uint16_t fileIndex, uint16_t line, LineNumber& lineNumber )
+    {
+        UNREFERENCED_PARAMETER( line );
+
+        GuardedArea guard( mGuard );
+
+        // continue from the previous result
+        ModFile* file = GetModFile( compIndex, fileIndex );
+        if ( file == NULL )
+            return false;
+
+        for ( uint32_t i = lineNumber.LineIndex + 1; i < file->Lines.size(); i++ )
+        {
+            if ( file->Lines[i].Number == lineNumber.Number )
+                return SetLineNumber( compIndex, fileIndex, *file, i, lineNumber );
+        }
+
+        return false;
+    }
+
+    bool PDBReader::FindLines( bool exactMatch, const char* fileName, size_t fileNameLen, uint16_t reqLineStart, uint16_t reqLineEnd,
+                               std::list<LineNumber>& lines )
+    {
+        if ( !mHasFileModules )
+        {
+            for ( uint16_t compIx = 1; compIx <= mModules.size(); compIx++ )
+                FindLinesInModule( compIx, exactMatch, fileName, fileNameLen, reqLineStart, reqLineEnd, lines );
+        }
+        else
+        {
+            std::string                     key;
+            FileModuleMap::const_iterator   it;
+
+            GetFileNameKey( fileName, fileNameLen, key );
+
+            it = mFileModules.find( key );
+            if ( it != mFileModules.end() )
+            {
+                const std::vector<uint16_t>&    modIndexes = it->second;
+
+                for ( size_t i = 0; i < modIndexes.size(); i++ )
+                {
+                    FindLinesInModule( 
+                        modIndexes[i] + 1, exactMatch, fileName, fileNameLen, reqLineStart, reqLineEnd, lines );
+                }
+            }
+        }
+
+        return lines.size() > 0;
+    }
+
+    bool PDBReader::FindLinesInModule( uint16_t compIx, bool exactMatch, const char* fileName, size_t fileNameLen, 
+                                       uint16_t reqLineStart, uint16_t reqLineEnd, std::list<LineNumber>& lines )
+    {
+        CompilandInfo   compInfo = { 0 };
+        bool            found = false;
+
+        HRESULT hr = GetCompilandInfo( compIx, compInfo );
+        if ( FAILED( hr ) )
+            return false;
+
+        for ( uint16_t fileIx = 0; fileIx < compInfo.FileCount; fileIx++ )
+        {
+            FileInfo    fileInfo = { 0 };
+            LineNumber  line = { 0 };
+            bool        matches = false;
+
+            hr = GetFileInfo( compIx, fileIx, fileInfo );
+            if ( FAILED( hr ) )
+                continue;
+
+            if ( exactMatch )
+                matches = ExactFileNameMatch( fileName, fileNameLen, fileInfo.Name.GetName(), fileInfo.Name.GetLength() );
+            else
+                matches = PartialFileNameMatch( fileName, fileNameLen, fileInfo.Name.GetName(), fileInfo.Name.GetLength() );
+
+            if ( !matches )
+                continue;
+
+            if ( !FindLineByNum( compIx, fileIx, reqLineStart, line ) )
+                continue;
+
+            // do the line ranges overlap?
+            if ( (line.Number <= reqLineEnd) && (line.NumberEnd >= reqLineStart) )
+            {
+                do
+                {
+                    lines.push_back( line );
+                    found = true;
+                }
+                while ( FindNextLineByNum( compIx, fileIx, reqLineStart, line ) );
+            }
+        }
+
+        return found;
+    }
+}
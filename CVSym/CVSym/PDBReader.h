@@ -0,0 +1,178 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+#include <Guard.h>
+#include <map>
+#include <string>
+
+
+namespace MagoST
+{
+    // Reads the streams of a multi-stream file (MSF), the container format of
+    // a PDB. The file's bytes are owned by the caller and have to outlive it.
+
+    class MsfFile
+    {
+        const BYTE*             mData;
+        uint32_t                mSize;
+        uint32_t                mBlockSize;
+        std::vector<uint32_t>   mStreamSizes;
+        std::vector<uint32_t>   mStreamBlockStart;  // index into mStreamBlocks
+        std::vector<uint32_t>   mStreamBlocks;
+
+    public:
+        MsfFile();
+
+        HRESULT Init( const BYTE* data, uint32_t size );
+
+        uint32_t GetStreamCount() const;
+
+        // Sets bytes to the stream's bytes. If the blocks of the stream are
+        // laid out one after another in the file, then bytes points into the
+        // file. Otherwise, the stream is copied into copy, and bytes points
+        // there.
+        HRESULT GetStreamBytes( uint32_t stream, const BYTE*& bytes, uint32_t& size, std::vector<BYTE>& copy ) const;
+
+    private:
+        bool GetBlock( uint32_t block, const BYTE*& bytes ) const;
+    };
+
+
+    // Reads the source file and line number information of a PDB directly,
+    // without going through DIA. Only that: symbols, scopes and types are
+    // still read through DIA by PDBDebugStore.
+    //
+    // The module list, section contributions and the names of each module's
+    // source files come from the DBI stream; the
+    // lines and file checksums of each module come from the C13 subsections
+    // of its stream, and are only read the first time something asks for 
+    // that module. FindLines only reads the modules that have a source file
+    // with the right name.
+    //
+    // This answers the source file half of IDebugStore with the same
+    // signatures and index conventions: compilands are 1-based, files are
+    // 0-based, and each file has one segment instance. Line numbers and 
+    // indexes are kept in 32 bits; the ones that don't fit in the 16 bits of
+    // IDebugStore are left out of its answers, instead of wrapping around.
+
+    class PDBReader
+    {
+        struct LineEntry
+        {
+            uint32_t    Offset;
+            uint32_t    Length;
+            uint32_t    Number;
+            uint32_t    NumberEnd;
+            uint32_t    FileIndex;
+            uint32_t    LineIndex;      // in the file's Lines
+            uint16_t    Section;
+
+            bool operator<( const LineEntry& other ) const
+            {
+                if ( Section != other.Section )
+                    return Section < other.Section;
+                return Offset < other.Offset;
+            }
+        };
+
+        struct ModFile
+        {
+            uint32_t                NameOffset;     // in the names buffer
+            std::vector<LineEntry>  Lines;          // sorted by address
+            std::vector<DWORD>      Offsets;        // parallel to Lines
+            std::vector<WORD>       LineNumbers;    // parallel to Lines, 0 if it doesn't fit
+        };
+
+        struct Module
+        {
+            const char*             Name;
+            uint32_t                NameLen;
+            uint16_t                Stream;
+            uint32_t                SymByteSize;
+            uint32_t                C11ByteSize;
+            uint32_t                C13ByteSize;
+            bool                    Loaded;
+            std::vector<ModFile>    Files;
+            std::vector<LineEntry>  AddrLines;      // the lines of all files, sorted by address
+        };
+
+        struct SectionContrib
+        {
+            uint16_t    Section;
+            uint16_t    ModIndex;
+            uint32_t    Offset;
+            uint32_t    Size;
+
+            bool operator<( const SectionContrib& other ) const
+            {
+                if ( Section != other.Section )
+                    return Section < other.Section;
+                return Offset < other.Offset;
+            }
+        };
+
+        const BYTE*                 mMapping;
+        HandlePtr                   mMapHandle;
+        MsfFile                     mMsf;
+        std::vector<BYTE>           mDbiCopy;
+        std::vector<BYTE>           mNamesCopy;
+        const char*                 mNames;
+        uint32_t                    mNamesSize;
+        std::vector<Module>         mModules;
+        std::vector<SectionContrib> mContribs;          // sorted by address
+
+        // the modules with a source file, by GetFileNameKey
+        typedef std::map< std::string, std::vector<uint16_t> >  FileModuleMap;
+
+        FileModuleMap               mFileModules;
+        bool                        mHasFileModules;
+
+        Guard                       mGuard;
+
+    public:
+        PDBReader();
+        ~PDBReader();
+
+        HRESULT Open( const wchar_t* filename );
+        HRESULT Init( const BYTE* data, uint32_t size );
+
+        HRESULT GetCompilandCount( uint32_t& count );
+        HRESULT GetCompilandInfo( uint16_t index, CompilandInfo& info );
+        HRESULT GetFileInfo( uint16_t compilandIndex, uint16_t fileIndex, FileInfo& info );
+
+        bool    GetFileSegment( uint16_t compIndex, uint16_t fileIndex, uint16_t segInstanceIndex, FileSegmentInfo& segInfo );
+
+        bool    FindLine( WORD seg, uint32_t offset, LineNumber& lineNumber );
+        bool    FindLineByNum( uint16_t compIndex, uint16_t fileIndex, uint16_t line, LineNumber& lineNumber );
+        bool    FindNextLineByNum( uint16_t compIndex, uint16_t fileIndex, uint16_t line, LineNumber& lineNumber );
+
+        bool    FindLines( bool exactMatch, const char* fileName, size_t fileNameLen, uint16_t reqLineStart, uint16_t reqLineEnd,
+                           std::list<LineNumber>& lines );
+
+        // the number of modules whose lines have been read so far
+        uint32_t GetLoadedModuleCount();
+
+    private:
+        HRESULT ReadNames();
+        HRESULT ReadDbi();
+        HRESULT ReadSectionContribs( const BYTE* bytes, uint32_t size );
+        HRESULT ReadFileInfo( const BYTE* bytes, uint32_t size );
+        bool    FindLinesInModule( uint16_t compIndex, bool exactMatch, const char* fileName, size_t fileNameLen, 
+                                   uint16_t reqLineStart, uint16_t reqLineEnd, std::list<LineNumber>& lines );
+
+        Module* GetModule( uint16_t compIndex );
+        ModFile* GetModFile( uint16_t compIndex, uint16_t fileIndex );
+        HRESULT LoadModule( Module& mod );
+        HRESULT ReadChecksums( const BYTE* bytes, uint32_t size, Module& mod, std::vector<uint32_t>& checksumOffsets );
+        HRESULT ReadLines( const BYTE* bytes, uint32_t size, Module& mod, const std::vector<uint32_t>& checksumOffsets );
+
+        const char* GetName( uint32_t offset, size_t& len );
+        bool SetLineNumber( uint16_t compIndex, uint16_t fileIndex, const ModFile& file, uint32_t lineIndex, LineNumber& lineNumber );
+    };
+}
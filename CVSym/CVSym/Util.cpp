@@ -411,3 +411,15 @@ bool PartialFileNameMatch( const char* pathA, size_t pathALen, const char* pathB
     return true;
 }
 
+void GetFileNameKey( const char* path, size_t pathLen, std::string& key )
+{
+    size_t  start = pathLen;
+
+    while ( (start > 0) && (path[start - 1] != '\\') && (path[start - 1] != '/') )
+        start--;
+
+    key.resize( pathLen - start );
+
+    for ( size_t i = start; i < pathLen; i++ )
+        key[i - start] = (char) tolower( path[i] );
+}
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <string>
 
 union CodeViewFieldType;
 union CodeViewSymbol;
@@ -29,3 +30,7 @@ bool     QuickGetLength( CodeViewSymbol* sym, uint32_t& length );
 bool ExactFileNameMatch( const char* pathA, size_t pathALen, const char* pathB, size_t pathBLen );
 bool PartialFileNameMatch( const char* pathA, size_t pathALen, const char* pathB, size_t pathBLen );
 
+// The key is the last component of the path in lower case. Two paths that
+// match with PartialFileNameMatch or ExactFileNameMatch have the same key.
+void GetFileNameKey( const char* path, size_t pathLen, std::string& key );
+
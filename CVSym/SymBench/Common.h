@@ -0,0 +1,38 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+// stdafx.h : include file for standard system include files,
+// or project specific include files that are used frequently, but
+// are changed infrequently
+//
+
+#pragma once
+
+#include "targetver.h"
+
+// C
+#include <stdio.h>
+#include <stdlib.h>
+#include <inttypes.h>
+#include <crtdbg.h>
+
+// C++
+#include <string>
+#include <vector>
+#include <list>
+#include <map>
+#include <algorithm>
+
+// Windows
+#include <windows.h>
+#include <psapi.h>
+
+// Magus
+#include <SmartPtr.h>
+
+#include <MagoCVConst.h>
+#include <MagoCVSTI.h>
@@ -0,0 +1,512 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+
+   Purpose: Opens a module's symbols the way the debug engine does, replays
+            a workload of symbol queries against them, and reports how long
+            each kind of query took.
+*/
+
+#include "Common.h"
+
+using namespace MagoST;
+
+
+enum OpKind
+{
+    Op_Line,        // line <rva>               address to line
+    Op_Func,        // func <rva>               address to function and block scopes
+    Op_Bind,        // bind <line> <file>       file and line to addresses
+    Op_Name,        // name <name>              global name lookup
+    Op_Child,       // child <rva> <name>       name lookup in a function's scope
+    Op_Type,        // type <name>              type walk of a named symbol
+    Op_Max
+};
+
+const char* gOpNames[Op_Max] =
+{
+    "line",
+    "func",
+    "bind",
+    "name",
+    "child",
+    "type",
+};
+
+struct Op
+{
+    OpKind          Kind;
+    uint32_t        Rva;
+    uint32_t        Line;
+    std::string     Text;
+};
+
+struct OpStats
+{
+    std::vector<double> Times;      // microseconds
+    uint32_t            Misses;
+};
+
+
+LARGE_INTEGER   gFreq;
+
+
+double GetMicroseconds( const LARGE_INTEGER& start, const LARGE_INTEGER& end )
+{
+    return (double) (end.QuadPart - start.QuadPart) * 1000000.0 / (double) gFreq.QuadPart;
+}
+
+//----------------------------------------------------------------------------
+//  Queries
+//----------------------------------------------------------------------------
+
+HRESULT FindFunction( ISession* session, uint32_t rva, SymHandle& handle )
+{
+    HRESULT hr = S_OK;
+
+    hr = session->FindOuterSymbolByRVA( SymHeap_GlobalSymbols, rva, handle );
+    if ( hr != S_OK )
+        hr = session->FindOuterSymbolByRVA( SymHeap_StaticSymbols, rva, handle );
+    if ( hr != S_OK )
+        hr = session->FindOuterSymbolByRVA( SymHeap_PublicSymbols, rva, handle );
+
+    return hr;
+}
+
+HRESULT FindName( ISession* session, const std::string& name, SymHandle& handle )
+{
+    HRESULT hr = S_OK;
+
+    for ( int heap = SymHeap_GlobalSymbols; heap < SymHeap_Count; heap++ )
+    {
+        EnumNamedSymbolsData    enumData = { 0 };
+
+        hr = session->FindFirstSymbol( (SymbolHeapId) heap, name.c_str(), name.size(), enumData );
+        if ( hr != S_OK )
+            continue;
+
+        return session->GetCurrentSymbol( enumData, handle );
+    }
+
+    return HRESULT_FROM_WIN32( ERROR_NOT_FOUND );
+}
+
+HRESULT WalkType( ISession* session, TypeIndex typeIndex, uint32_t& count )
+{
+    HRESULT         hr = S_OK;
+    TypeHandle      typeHandle = { 0 };
+    TypeScope       scope = { 0 };
+    TypeHandle      childHandle = { 0 };
+    SymInfoData     infoData = { 0 };
+    ISymbolInfo*    symInfo = NULL;
+
+    if ( !session->GetTypeFromTypeIndex( typeIndex, typeHandle ) )
+        return HRESULT_FROM_WIN32( ERROR_NOT_FOUND );
+
+    hr = session->GetTypeInfo( typeHandle, infoData, symInfo );
+    if ( FAILED( hr ) )
+        return hr;
+
+    count++;
+
+    // a field list is where the members are
+    TypeIndex   fieldListIndex = 0;
+
+    if ( symInfo->GetFieldList( fieldListIndex ) && (fieldListIndex != 0) )
+    {
+        if ( !session->GetTypeFromTypeIndex( fieldListIndex, typeHandle ) )
+            return S_OK;
+    }
+
+    hr = session->SetChildTypeScope( typeHandle, scope );
+    if ( FAILED( hr ) )
+        return S_OK;
+
+    while ( session->NextType( scope, childHandle ) )
+    {
+        SymString   name;
+
+        hr = session->GetTypeInfo( childHandle, infoData, symInfo );
+        if ( FAILED( hr ) )
+            continue;
+
+        symInfo->GetName( name );
+        count++;
+    }
+
+    return S_OK;
+}
+
+bool RunOp( ISession* session, const Op& op )
+{
+    HRESULT         hr = S_OK;
+    SymHandle       handle = { 0 };
+    SymInfoData     infoData = { 0 };
+    ISymbolInfo*    symInfo = NULL;
+
+    switch ( op.Kind )
+    {
+    case Op_Line:
+        {
+            uint32_t    offset = 0;
+            uint16_t    sec = session->GetSecOffsetFromRVA( op.Rva, offset );
+            LineNumber  line = { 0 };
+
+            if ( sec == 0 )
+                return false;
+
+            return session->FindLine( sec, offset, line );
+        }
+
+    case Op_Func:
+        {
+            uint32_t                offset = 0;
+            uint16_t                sec = session->GetSecOffsetFromRVA( op.Rva, offset );
+            std::vector<SymHandle>  blocks;
+
+            if ( sec == 0 )
+                return false;
+
+            hr = FindFunction( session, op.Rva, handle );
+            if ( hr != S_OK )
+                return false;
+
+            hr = session->FindInnermostSymbol( handle, sec, offset, blocks );
+            return hr == S_OK;
+        }
+
+    case Op_Bind:
+        {
+            std::list<LineNumber>   lines;
+
+            return session->FindLines( false, op.Text.c_str(), op.Text.size(), (uint16_t) op.Line, (uint16_t) op.Line, lines );
+        }
+
+    case Op_Name:
+        hr = FindName( session, op.Text, handle );
+        return hr == S_OK;
+
+    case Op_Child:
+        {
+            SymHandle   childHandle = { 0 };
+
+            hr = FindFunction( session, op.Rva, handle );
+            if ( hr != S_OK )
+                return false;
+
+            hr = session->FindChildSymbol( handle, op.Text.c_str(), op.Text.size(), childHandle );
+            return hr == S_OK;
+        }
+
+    case Op_Type:
+        {
+            TypeIndex   typeIndex = 0;
+            uint32_t    count = 0;
+
+            hr = FindName( session, op.Text, handle );
+            if ( hr != S_OK )
+                return false;
+
+            hr = session->GetSymbolInfo( handle, infoData, symInfo );
+            if ( FAILED( hr ) )
+                return false;
+
+            if ( !symInfo->GetType( typeIndex ) )
+                return false;
+
+            hr = WalkType( session, typeIndex, count );
+            return hr == S_OK;
+        }
+    }
+
+    return false;
+}
+
+//----------------------------------------------------------------------------
+//  Workloads
+//----------------------------------------------------------------------------
+
+HRESULT ReadWorkload( const wchar_t* path, std::vector<Op>& ops )
+{
+    FILE*   file = NULL;
+    char    lineBuf[1024] = "";
+    int     lineNum = 0;
+
+    if ( _wfopen_s( &file, path, L"r" ) != 0 )
+        return E_FAIL;
+
+    while ( fgets( lineBuf, _countof( lineBuf ), file ) != NULL )
+    {
+        char*   context = NULL;
+        char*   verb = NULL;
+        Op      op;
+
+        lineNum++;
+        lineBuf[ strcspn( lineBuf, "\r\n" ) ] = '\0';
+
+        verb = strtok_s( lineBuf, " \t", &context );
+        if ( (verb == NULL) || (verb[0] == '#') )
+            continue;
+
+        int kind = 0;
+        for ( ; kind < Op_Max; kind++ )
+        {
+            if ( strcmp( verb, gOpNames[kind] ) == 0 )
+                break;
+        }
+
+        if ( kind == Op_Max )
+        {
+            fprintf( stderr, "%ls(%d): unknown operation '%s'\n", path, lineNum, verb );
+            continue;
+        }
+
+        op.Kind = (OpKind) kind;
+        op.Rva = 0;
+        op.Line = 0;
+
+        // the number comes first, and the rest of the line is the name,
+        // because file names can have spaces
+        if ( op.Kind != Op_Name && op.Kind != Op_Type )
+        {
+            char*   number = strtok_s( NULL, " \t", &context );
+
+            if ( number == NULL )
+            {
+                fprintf( stderr, "%ls(%d): missing number\n", path, lineNum );
+                continue;
+            }
+
+            if ( op.Kind == Op_Bind )
+                op.Line = strtoul( number, NULL, 10 );
+            else
+                op.Rva = strtoul( number, NULL, 16 );
+        }
+
+        if ( (context != NULL) && (op.Kind != Op_Line) && (op.Kind != Op_Func) )
+            op.Text = context + strspn( context, " \t" );
+
+        ops.push_back( op );
+    }
+
+    fclose( file );
+    return S_OK;
+}
+
+// Writes a workload that touches every file of every compiland: the start
+// of each line segment by address, the function around it, and its first
+// line by file and line number.
+
+void GenerateWorkload( ISession* session, uint32_t maxOps )
+{
+    HRESULT     hr = S_OK;
+    uint32_t    compCount = 0;
+    uint32_t    opCount = 0;
+
+    hr = session->GetCompilandCount( compCount );
+    if ( FAILED( hr ) )
+        return;
+
+    for ( uint16_t compIx = 1; (compIx <= compCount) && (opCount < maxOps); compIx++ )
+    {
+        CompilandInfo   compInfo = { 0 };
+
+        hr = session->GetCompilandInfo( compIx, compInfo );
+        if ( FAILED( hr ) )
+            continue;
+
+        for ( uint16_t fileIx = 0; (fileIx < compInfo.FileCount) && (opCount < maxOps); fileIx++ )
+        {
+            FileInfo    fileInfo = { 0 };
+
+            hr = session->GetFileInfo( compIx, fileIx, fileInfo );
+            if ( FAILED( hr ) )
+                continue;
+
+            for ( uint16_t segIx = 0; segIx < fileInfo.SegmentCount; segIx++ )
+            {
+                FileSegmentInfo segInfo = { 0 };
+
+                if ( !session->GetFileSegment( compIx, fileIx, segIx, segInfo ) || (segInfo.LineCount == 0) )
+                    continue;
+
+                uint32_t    rva = session->GetRVAFromSecOffset( segInfo.SegmentIndex, segInfo.Offsets[0] );
+
+                if ( rva == ~0U )
+                    continue;
+
+                printf( "line %x\n", rva );
+                printf( "func %x\n", rva );
+                printf( "bind %u %.*s\n", segInfo.LineNumbers[0], (int) fileInfo.Name.GetLength(), fileInfo.Name.GetName() );
+                opCount += 3;
+            }
+        }
+    }
+}
+
+//----------------------------------------------------------------------------
+//  Reporting
+//----------------------------------------------------------------------------
+
+double GetPercentile( const std::vector<double>& sortedTimes, double percent )
+{
+    if ( sortedTimes.size() == 0 )
+        return 0;
+
+    size_t  index = (size_t) ((percent / 100.0) * (sortedTimes.size() - 1) + 0.5);
+
+    return sortedTimes[index];
+}
+
+void PrintReport( double loadTime, OpStats* stats )
+{
+    PROCESS_MEMORY_COUNTERS memCounters = { 0 };
+
+    memCounters.cb = sizeof memCounters;
+    GetProcessMemoryInfo( GetCurrentProcess(), &memCounters, sizeof memCounters );
+
+    printf( "load: %.0f us\n\n", loadTime );
+    printf( "%-6s %8s %8s %10s %10s %10s %10s %10s\n", "op", "count", "misses", "mean", "p50", "p90", "p99", "max" );
+
+    for ( int i = 0; i < Op_Max; i++ )
+    {
+        std::vector<double>&    times = stats[i].Times;
+        double                  total = 0;
+
+        if ( times.size() == 0 )
+            continue;
+
+        std::sort( times.begin(), times.end() );
+
+        for ( size_t j = 0; j < times.size(); j++ )
+            total += times[j];
+
+        printf( "%-6s %8u %8u %10.1f %10.1f %10.1f %10.1f %10.1f\n",
+            gOpNames[i],
+            (uint32_t) times.size(),
+            stats[i].Misses,
+            total / times.size(),
+            GetPercentile( times, 50 ),
+            GetPercentile( times, 90 ),
+            GetPercentile( times, 99 ),
+            times.back() );
+    }
+
+    printf( "\ntimes in microseconds\n" );
+    printf( "peak working set: %u KB\n", (uint32_t) (memCounters.PeakWorkingSetSize / 1024) );
+    printf( "peak private bytes: %u KB\n", (uint32_t) (memCounters.PeakPagefileUsage / 1024) );
+}
+
+void PrintUsage()
+{
+    printf( "usage: SymBench <module> <workload> [-repeat <count>] [-dia]\n" );
+    printf( "       SymBench <module> -gen <max ops>\n" );
+    printf( "\n" );
+    printf( "Workload lines, with addresses as hex RVAs:\n" );
+    printf( "  line <rva>\n" );
+    printf( "  func <rva>\n" );
+    printf( "  bind <line> <file>\n" );
+    printf( "  name <name>\n" );
+    printf( "  child <rva> <name>\n" );
+    printf( "  type <name>\n" );
+    printf( "\n" );
+    printf( "-dia answers the source file and line queries of a PDB through DIA,\n" );
+    printf( "instead of reading the PDB directly.\n" );
+}
+
+int wmain( int argc, wchar_t* argv[] )
+{
+    HRESULT                 hr = S_OK;
+    RefPtr<IDataSource>     dataSource;
+    RefPtr<ISession>        session;
+    LARGE_INTEGER           start = { 0 };
+    LARGE_INTEGER           end = { 0 };
+    int                     repeat = 1;
+    bool                    generate = false;
+    uint32_t                maxOps = 0;
+
+    if ( argc < 3 )
+    {
+        PrintUsage();
+        return 2;
+    }
+
+    if ( wcscmp( argv[2], L"-gen" ) == 0 )
+    {
+        generate = true;
+        maxOps = (argc > 3) ? wcstoul( argv[3], NULL, 10 ) : 0xFFFFFFFF;
+    }
+    else
+    {
+        for ( int i = 3; i < argc; i++ )
+        {
+            if ( (wcscmp( argv[i], L"-repeat" ) == 0) && (i + 1 < argc) )
+                repeat = _wtoi( argv[++i] );
+            else if ( wcscmp( argv[i], L"-dia" ) == 0 )
+                EnablePdbReader( false );
+            else
+            {
+                PrintUsage();
+                return 2;
+            }
+        }
+    }
+
+    QueryPerformanceFrequency( &gFreq );
+    QueryPerformanceCounter( &start );
+
+    hr = MakeDataSource( dataSource.Ref() );
+    if ( SUCCEEDED( hr ) )
+        hr = dataSource->LoadDataForExe( argv[1], NULL );
+    if ( SUCCEEDED( hr ) )
+        hr = dataSource->InitDebugInfo( argv[1], NULL );
+    if ( SUCCEEDED( hr ) )
+        hr = dataSource->OpenSession( session.Ref() );
+
+    QueryPerformanceCounter( &end );
+
+    if ( FAILED( hr ) )
+    {
+        fprintf( stderr, "couldn't load symbols for %ls: %08x\n", argv[1], hr );
+        return 1;
+    }
+
+    if ( generate )
+    {
+        GenerateWorkload( session, maxOps );
+        return 0;
+    }
+
+    double              loadTime = GetMicroseconds( start, end );
+    std::vector<Op>     ops;
+    OpStats             stats[Op_Max];
+
+    hr = ReadWorkload( argv[2], ops );
+    if ( FAILED( hr ) )
+    {
+        fprintf( stderr, "couldn't read workload %ls\n", argv[2] );
+        return 1;
+    }
+
+    for ( int i = 0; i < Op_Max; i++ )
+        stats[i].Misses = 0;
+
+    for ( int i = 0; i < repeat; i++ )
+    {
+        for ( size_t j = 0; j < ops.size(); j++ )
+        {
+            QueryPerformanceCounter( &start );
+            bool found = RunOp( session, ops[j] );
+            QueryPerformanceCounter( &end );
+
+            stats[ ops[j].Kind ].Times.push_back( GetMicroseconds( start, end ) );
+            if ( !found )
+                stats[ ops[j].Kind ].Misses++;
+        }
+    }
+
+    PrintReport( loadTime, stats );
+    return 0;
+}
@@ -0,0 +1,325 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "stdafx.h"
+#include "PDBReaderSuite.h"
+#include "PdbBuilder.h"
+
+using namespace std;
+using namespace MagoST;
+
+
+const uint16_t  CodeSection = 1;
+const uint32_t  ModuleCode = 0x1000;      // the code of each module follows the one before it
+
+const PdbBuilder::Line  SimpleLines[] = 
+{
+    { 0x00, 10 },
+    { 0x08, 11 },
+    { 0x10, 10 },
+};
+
+
+PDBReaderSuite::PDBReaderSuite()
+{
+    TEST_ADD( PDBReaderSuite::BadMagic );
+    TEST_ADD( PDBReaderSuite::CompilandsAndFiles );
+    TEST_ADD( PDBReaderSuite::FindLineByAddress );
+    TEST_ADD( PDBReaderSuite::FindLineByNumber );
+    TEST_ADD( PDBReaderSuite::FindLinesReadsOnlyMatchingModules );
+    TEST_ADD( PDBReaderSuite::FindLinesWithoutFileInfo );
+    TEST_ADD( PDBReaderSuite::WideLineNumbers );
+    TEST_ADD( PDBReaderSuite::ManyLinesInFile );
+    TEST_ADD( PDBReaderSuite::ScatteredStreams );
+}
+
+// Each module has one file, with the simple lines at ModuleCode * (module + 1).
+
+void PDBReaderSuite::AddThreeModules( PdbBuilder& builder )
+{
+    const char* fileNames[] = { "c:\\src\\a.d", "c:\\src\\b.d", "c:\\src\\c.d" };
+
+    for ( uint16_t i = 0; i < _countof( fileNames ); i++ )
+    {
+        uint32_t    offset = ModuleCode * (i + 1);
+        uint16_t    mod = builder.AddModule( fileNames[i] );
+        uint16_t    file = builder.AddFile( mod, fileNames[i] );
+
+        builder.AddLines( mod, file, CodeSection, offset, 0x20, SimpleLines, _countof( SimpleLines ) );
+        builder.AddContrib( mod, CodeSection, offset, 0x20 );
+    }
+}
+
+void PDBReaderSuite::BadMagic()
+{
+    PdbBuilder      builder;
+    vector<BYTE>    pdb;
+    PDBReader       reader;
+
+    AddThreeModules( builder );
+    builder.Build( pdb );
+    pdb[0] = 'X';
+
+    TEST_ASSERT( FAILED( reader.Init( &pdb[0], (uint32_t) pdb.size() ) ) );
+}
+
+void PDBReaderSuite::CompilandsAndFiles()
+{
+    PdbBuilder      builder;
+    vector<BYTE>    pdb;
+    PDBReader       reader;
+    uint32_t        count = 0;
+    CompilandInfo   compInfo = { 0 };
+    FileInfo        fileInfo = { 0 };
+
+    uint16_t    mod = builder.AddModule( "c:\\obj\\main.obj" );
+    builder.AddFile( mod, "c:\\src\\main.d" );
+    builder.AddFile( mod, "c:\\src\\util.d" );
+    builder.Build( pdb );
+
+    TEST_ASSERT_RETURN( SUCCEEDED( reader.Init( &pdb[0], (uint32_t) pdb.size() ) ) );
+    TEST_ASSERT_RETURN( SUCCEEDED( reader.GetCompilandCount( count ) ) );
+    TEST_ASSERT( count == 1 );
+
+    // compilands are 1-based
+    TEST_ASSERT( FAILED( reader.GetCompilandInfo( 0, compInfo ) ) );
+    TEST_ASSERT_RETURN( SUCCEEDED( reader.GetCompilandInfo( 1, compInfo ) ) );
+    TEST_ASSERT( compInfo.FileCount == 2 );
+    TEST_ASSERT( compInfo.Name.GetLength() == strlen( "c:\\obj\\main.obj" ) );
+    TEST_ASSERT( strncmp( compInfo.Name.GetName(), "c:\\obj\\main.obj", compInfo.Name.GetLength() ) == 0 );
+
+    TEST_ASSERT_RETURN( SUCCEEDED( reader.GetFileInfo( 1, 1, fileInfo ) ) );
+    TEST_ASSERT( fileInfo.Name.GetLength() == strlen( "c:\\src\\util.d" ) );
+    TEST_ASSERT( strncmp( fileInfo.Name.GetName(), "c:\\src\\util.d", fileInfo.Name.GetLength() ) == 0 );
+    TEST_ASSERT( FAILED( reader.GetFileInfo( 1, 2, fileInfo ) ) );
+}
+
+void PDBReaderSuite::FindLineByAddress()
+{
+    PdbBuilder      builder;
+    vector<BYTE>    pdb;
+    PDBReader       reader;
+    LineNumber      line = { 0 };
+
+    AddThreeModules( builder );
+    builder.Build( pdb );
+
+    TEST_ASSERT_RETURN( SUCCEEDED( reader.Init( &pdb[0], (uint32_t) pdb.size() ) ) );
+
+    TEST_ASSERT_RETURN( reader.FindLine( CodeSection, (2 * ModuleCode) + 0x09, line ) );
+    TEST_ASSERT( line.CompilandIndex == 2 );
+    TEST_ASSERT( line.FileIndex == 0 );
+    TEST_ASSERT( line.Number == 11 );
+    TEST_ASSERT( line.Offset == (2 * ModuleCode) + 0x08 );
+    TEST_ASSERT( line.Length == 8 );
+
+    // the last line runs to the end of its block
+    TEST_ASSERT_RETURN( reader.FindLine( CodeSection, (2 * ModuleCode) + 0x1F, line ) );
+    TEST_ASSERT( line.Number == 10 );
+    TEST_ASSERT( line.Length == 0x10 );
+
+    // outside of any contribution, or in another section
+    TEST_ASSERT( !reader.FindLine( CodeSection, (2 * ModuleCode) + 0x20, line ) );
+    TEST_ASSERT( !reader.FindLine( CodeSection + 1, (2 * ModuleCode), line ) );
+    TEST_ASSERT( !reader.FindLine( CodeSection, 0, line ) );
+}
+
+void PDBReaderSuite::FindLineByNumber()
+{
+    PdbBuilder      builder;
+    vector<BYTE>    pdb;
+    PDBReader       reader;
+    LineNumber      line = { 0 };
+
+    AddThreeModules( builder );
+    builder.Build( pdb );
+
+    TEST_ASSERT_RETURN( SUCCEEDED( reader.Init( &pdb[0], (uint32_t) pdb.size() ) ) );
+
+    TEST_ASSERT_RETURN( reader.FindLineByNum( 1, 0, 11, line ) );
+    TEST_ASSERT( line.Number == 11 );
+    TEST_ASSERT( line.Offset == ModuleCode + 0x08 );
+
+    // the closest line after
+    TEST_ASSERT_RETURN( reader.FindLineByNum( 1, 0, 5, line ) );
+    TEST_ASSERT( line.Number == 10 );
+    TEST_ASSERT( line.Offset == ModuleCode );
+
+    // line 10 has two blocks of code
+    TEST_ASSERT_RETURN( reader.FindNextLineByNum( 1, 0, 5, line ) );
+    TEST_ASSERT( line.Number == 10 );
+    TEST_ASSERT( line.Offset == ModuleCode + 0x10 );
+    TEST_ASSERT( !reader.FindNextLineByNum( 1, 0, 5, line ) );
+
+    // the last line if they're all before it
+    TEST_ASSERT_RETURN( reader.FindLineByNum( 1, 0, 100, line ) );
+    TEST_ASSERT( line.Number == 11 );
+
+    TEST_ASSERT( !reader.FindLineByNum( 1, 1, 10, line ) );
+    TEST_ASSERT( !reader.FindLineByNum( 4, 0, 10, line ) );
+}
+
+void PDBReaderSuite::FindLinesReadsOnlyMatchingModules()
+{
+    PdbBuilder      builder;
+    vector<BYTE>    pdb;
+    PDBReader       reader;
+    list<LineNumber>    lines;
+    const char      exactName[] = "C:/SRC/b.d";
+    const char      partialName[] = "src\\c.d";
+    const char      missingName[] = "c:\\src\\d.d";
+
+    AddThreeModules( builder );
+    builder.Build( pdb );
+
+    TEST_ASSERT_RETURN( SUCCEEDED( reader.Init( &pdb[0], (uint32_t) pdb.size() ) ) );
+    TEST_ASSERT( reader.GetLoadedModuleCount() == 0 );
+
+    TEST_ASSERT_RETURN( reader.FindLines( true, exactName, strlen( exactName ), 10, 10, lines ) );
+    TEST_ASSERT( lines.size() == 2 );
+    TEST_ASSERT( lines.front().CompilandIndex == 2 );
+    TEST_ASSERT( reader.GetLoadedModuleCount() == 1 );
+
+    lines.clear();
+    TEST_ASSERT_RETURN( reader.FindLines( false, partialName, strlen( partialName ), 11, 11, lines ) );
+    TEST_ASSERT( lines.size() == 1 );
+    TEST_ASSERT( lines.front().CompilandIndex == 3 );
+    TEST_ASSERT( reader.GetLoadedModuleCount() == 2 );
+
+    lines.clear();
+    TEST_ASSERT( !reader.FindLines( true, missingName, strlen( missingName ), 10, 10, lines ) );
+    TEST_ASSERT( reader.GetLoadedModuleCount() == 2 );
+}
+
+void PDBReaderSuite::FindLinesWithoutFileInfo()
+{
+    PdbBuilder      builder;
+    vector<BYTE>    pdb;
+    PDBReader       reader;
+    list<LineNumber>    lines;
+    const char      fileName[] = "c:\\src\\b.d";
+
+    AddThreeModules( builder );
+    builder.SetHasFileInfo( false );
+    builder.Build( pdb );
+
+    TEST_ASSERT_RETURN( SUCCEEDED( reader.Init( &pdb[0], (uint32_t) pdb.size() ) ) );
+
+    // without the names of the files up front, every module has to be read
+    TEST_ASSERT_RETURN( reader.FindLines( true, fileName, strlen( fileName ), 11, 11, lines ) );
+    TEST_ASSERT( lines.size() == 1 );
+    TEST_ASSERT( lines.front().CompilandIndex == 2 );
+    TEST_ASSERT( reader.GetLoadedModuleCount() == 3 );
+}
+
+// Line 70000 doesn't fit in the 16 bits of a LineNumber. Cut down to 16 bits,
+// it would be 4464, so it mustn't show up as that line.
+
+void PDBReaderSuite::WideLineNumbers()
+{
+    PdbBuilder      builder;
+    vector<BYTE>    pdb;
+    PDBReader       reader;
+    LineNumber      line = { 0 };
+    FileSegmentInfo segInfo = { 0 };
+    const PdbBuilder::Line  wideLines[] = 
+    {
+        { 0x00, 4464 },
+        { 0x08, 70000 },
+    };
+
+    uint16_t    mod = builder.AddModule( "wide.obj" );
+    uint16_t    file = builder.AddFile( mod, "c:\\src\\wide.d" );
+    builder.AddLines( mod, file, CodeSection, ModuleCode, 0x10, wideLines, _countof( wideLines ) );
+    builder.AddContrib( mod, CodeSection, ModuleCode, 0x10 );
+    builder.Build( pdb );
+
+    TEST_ASSERT_RETURN( SUCCEEDED( reader.Init( &pdb[0], (uint32_t) pdb.size() ) ) );
+
+    TEST_ASSERT_RETURN( reader.FindLineByNum( 1, 0, 4464, line ) );
+    TEST_ASSERT( line.Number == 4464 );
+    TEST_ASSERT( line.Offset == ModuleCode );
+    TEST_ASSERT( !reader.FindNextLineByNum( 1, 0, 4464, line ) );
+
+    TEST_ASSERT( reader.FindLine( CodeSection, ModuleCode, line ) );
+    TEST_ASSERT( !reader.FindLine( CodeSection, ModuleCode + 0x08, line ) );
+
+    TEST_ASSERT_RETURN( reader.GetFileSegment( 1, 0, 0, segInfo ) );
+    TEST_ASSERT_RETURN( segInfo.LineCount == 2 );
+    TEST_ASSERT( segInfo.LineNumbers[0] == 4464 );
+    TEST_ASSERT( segInfo.LineNumbers[1] == 0 );
+}
+
+// A file with more lines than a 16-bit line index can reach.
+
+void PDBReaderSuite::ManyLinesInFile()
+{
+    PdbBuilder      builder;
+    vector<BYTE>    pdb;
+    PDBReader       reader;
+    LineNumber      line = { 0 };
+    FileSegmentInfo segInfo = { 0 };
+    const uint32_t  LineCount = 0x10000 + 100;
+    const uint32_t  LineSize = 2;
+    vector<PdbBuilder::Line>    manyLines( LineCount );
+
+    for ( uint32_t i = 0; i < LineCount; i++ )
+    {
+        manyLines[i].Offset = i * LineSize;
+        manyLines[i].Number = (i % 1000) + 1;
+    }
+
+    uint16_t    mod = builder.AddModule( "many.obj" );
+    uint16_t    file = builder.AddFile( mod, "c:\\src\\many.d" );
+    builder.AddLines( mod, file, CodeSection, ModuleCode, LineCount * LineSize, &manyLines[0], LineCount );
+    builder.AddContrib( mod, CodeSection, ModuleCode, LineCount * LineSize );
+    builder.Build( pdb );
+
+    TEST_ASSERT_RETURN( SUCCEEDED( reader.Init( &pdb[0], (uint32_t) pdb.size() ) ) );
+
+    TEST_ASSERT_RETURN( reader.FindLine( CodeSection, ModuleCode + (0xFFFF * LineSize), line ) );
+    TEST_ASSERT( line.LineIndex == 0xFFFF );
+    TEST_ASSERT( line.Number == (0xFFFF % 1000) + 1 );
+
+    // past the last index that fits, instead of wrapping around to index 0
+    TEST_ASSERT( !reader.FindLine( CodeSection, ModuleCode + (0x10000 * LineSize), line ) );
+
+    TEST_ASSERT_RETURN( reader.GetFileSegment( 1, 0, 0, segInfo ) );
+    TEST_ASSERT( segInfo.LineCount == 0xFFFF );
+}
+
+void PDBReaderSuite::ScatteredStreams()
+{
+    PdbBuilder      builder;
+    vector<BYTE>    pdb;
+    PDBReader       reader;
+    LineNumber      line = { 0 };
+    const uint32_t  LineCount = 200;
+    vector<PdbBuilder::Line>    lines( LineCount );
+
+    for ( uint32_t i = 0; i < LineCount; i++ )
+    {
+        lines[i].Offset = i * 4;
+        lines[i].Number = i + 1;
+    }
+
+    uint16_t    mod = builder.AddModule( "scattered.obj" );
+    uint16_t    file = builder.AddFile( mod, "c:\\src\\scattered.d" );
+    builder.AddLines( mod, file, CodeSection, ModuleCode, LineCount * 4, &lines[0], LineCount );
+    builder.AddContrib( mod, CodeSection, ModuleCode, LineCount * 4 );
+    builder.SetScatterStreams( true );
+    builder.Build( pdb );
+
+    TEST_ASSERT_RETURN( SUCCEEDED( reader.Init( &pdb[0], (uint32_t) pdb.size() ) ) );
+
+    // the module stream spans blocks, so its last lines are in its last block
+    TEST_ASSERT_RETURN( reader.FindLine( CodeSection, ModuleCode + ((LineCount - 1) * 4), line ) );
+    TEST_ASSERT( line.Number == LineCount );
+
+    TEST_ASSERT_RETURN( reader.FindLine( CodeSection, ModuleCode, line ) );
+    TEST_ASSERT( line.Number == 1 );
+}
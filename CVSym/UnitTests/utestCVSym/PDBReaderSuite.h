@@ -0,0 +1,30 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+class PdbBuilder;
+
+
+class PDBReaderSuite : public Test::Suite
+{
+public:
+    PDBReaderSuite();
+
+private:
+    void BadMagic();
+    void CompilandsAndFiles();
+    void FindLineByAddress();
+    void FindLineByNumber();
+    void FindLinesReadsOnlyMatchingModules();
+    void FindLinesWithoutFileInfo();
+    void WideLineNumbers();
+    void ManyLinesInFile();
+    void ScatteredStreams();
+
+    void AddThreeModules( PdbBuilder& builder );
+};
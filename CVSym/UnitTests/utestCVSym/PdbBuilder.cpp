@@ -0,0 +1,445 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "stdafx.h"
+#include "PdbBuilder.h"
+
+using namespace std;
+
+
+// the layouts that PDBReader reads, from the other side
+
+static const char       MsfMagic[32] = "Microsoft C/C++ MSF 7.00\r\n\x1a" "DS\0\0";
+static const uint32_t   BlockSize = 512;
+static const uint32_t   FirstDataBlock = 3;     // after the super block and the two free block maps
+
+static const uint32_t   InfoStream = 1;
+static const uint32_t   DbiStream = 3;
+static const uint32_t   NamesStream = 4;
+static const uint32_t   FirstModStream = 5;
+
+struct MsfSuperBlock
+{
+    char        Magic[32];
+    uint32_t    BlockSize;
+    uint32_t    FreeBlockMapBlock;
+    uint32_t    BlockCount;
+    uint32_t    DirectorySize;
+    uint32_t    Reserved;
+    uint32_t    BlockMapBlock;
+};
+
+struct DbiHeader
+{
+    int32_t     VersionSignature;
+    uint32_t    VersionHeader;
+    uint32_t    Age;
+    uint16_t    GlobalStream;
+    uint16_t    BuildNumber;
+    uint16_t    PublicStream;
+    uint16_t    PdbDllVersion;
+    uint16_t    SymRecordStream;
+    uint16_t    PdbDllRbld;
+    uint32_t    ModInfoSize;
+    uint32_t    SectionContribSize;
+    uint32_t    SectionMapSize;
+    uint32_t    SourceInfoSize;
+    uint32_t    TypeServerMapSize;
+    uint32_t    MfcTypeServerIndex;
+    uint32_t    OptionalDbgHeaderSize;
+    uint32_t    ECSubstreamSize;
+    uint16_t    Flags;
+    uint16_t    Machine;
+    uint32_t    Reserved;
+};
+
+struct DbiSectionContrib
+{
+    uint16_t    Section;
+    uint16_t    Padding1;
+    int32_t     Offset;
+    int32_t     Size;
+    uint32_t    Characteristics;
+    uint16_t    ModIndex;
+    uint16_t    Padding2;
+    uint32_t    DataCrc;
+    uint32_t    RelocCrc;
+};
+
+struct DbiModInfo
+{
+    uint32_t            Reserved1;
+    DbiSectionContrib   Contrib;
+    uint16_t            Flags;
+    uint16_t            Stream;
+    uint32_t            SymByteSize;
+    uint32_t            C11ByteSize;
+    uint32_t            C13ByteSize;
+    uint16_t            SourceFileCount;
+    uint16_t            Padding;
+    uint32_t            Reserved2;
+    uint32_t            SourceFileNameIndex;
+    uint32_t            PdbFilePathNameIndex;
+};
+
+struct C13LinesHeader
+{
+    uint32_t    Offset;
+    uint16_t    Section;
+    uint16_t    Flags;
+    uint32_t    Size;
+};
+
+struct C13FileBlockHeader
+{
+    uint32_t    ChecksumOffset;
+    uint32_t    LineCount;
+    uint32_t    Size;
+};
+
+struct C13Line
+{
+    uint32_t    Offset;
+    uint32_t    Flags;
+};
+
+// a checksum entry with no checksum bytes, padded to 4
+static const uint32_t   ChecksumEntrySize = 8;
+
+
+template <class T>
+static void Append( vector<BYTE>& bytes, const T& value )
+{
+    bytes.insert( bytes.end(), (const BYTE*) &value, (const BYTE*) (&value + 1) );
+}
+
+static void AppendString( vector<BYTE>& bytes, const char* str )
+{
+    bytes.insert( bytes.end(), (const BYTE*) str, (const BYTE*) str + strlen( str ) + 1 );
+}
+
+static void Align4( vector<BYTE>& bytes )
+{
+    while ( (bytes.size() % 4) != 0 )
+        bytes.push_back( 0 );
+}
+
+template <class T>
+static void Patch( vector<BYTE>& bytes, size_t offset, const T& value )
+{
+    memcpy( &bytes[offset], &value, sizeof value );
+}
+
+
+PdbBuilder::PdbBuilder()
+    :   mNames( 1, '\0' ),
+        mHasFileInfo( true ),
+        mScatterStreams( false )
+{
+}
+
+uint16_t PdbBuilder::AddModule( const char* name )
+{
+    Module  mod;
+
+    mod.Name = name;
+    mModules.push_back( mod );
+
+    return (uint16_t) (mModules.size() - 1);
+}
+
+uint16_t PdbBuilder::AddFile( uint16_t modIndex, const char* fileName )
+{
+    Module& mod = mModules[modIndex];
+
+    mod.FileNames.push_back( AddName( fileName ) );
+
+    return (uint16_t) (mod.FileNames.size() - 1);
+}
+
+void PdbBuilder::AddLines( uint16_t modIndex, uint16_t fileIndex, uint16_t section, uint32_t offset, uint32_t size,
+                           const Line* lines, uint32_t lineCount )
+{
+    LineBlock   block;
+
+    block.FileIndex = fileIndex;
+    block.Section = section;
+    block.Offset = offset;
+    block.Size = size;
+    block.Lines.assign( lines, lines + lineCount );
+
+    mModules[modIndex].Blocks.push_back( block );
+}
+
+void PdbBuilder::AddContrib( uint16_t modIndex, uint16_t section, uint32_t offset, uint32_t size )
+{
+    Contrib contrib = { modIndex, section, offset, size };
+
+    mContribs.push_back( contrib );
+}
+
+void PdbBuilder::SetHasFileInfo( bool hasFileInfo )
+{
+    mHasFileInfo = hasFileInfo;
+}
+
+void PdbBuilder::SetScatterStreams( bool scatter )
+{
+    mScatterStreams = scatter;
+}
+
+uint32_t PdbBuilder::AddName( const char* name )
+{
+    uint32_t    offset = (uint32_t) mNames.size();
+
+    mNames.append( name );
+    mNames.push_back( '\0' );
+
+    return offset;
+}
+
+void PdbBuilder::Build( vector<BYTE>& pdb )
+{
+    vector< vector<BYTE> >  streams( FirstModStream + mModules.size() );
+
+    for ( size_t i = 0; i < mModules.size(); i++ )
+        BuildModule( mModules[i], streams[FirstModStream + i] );
+
+    BuildInfo( NamesStream, streams[InfoStream] );
+    BuildNames( streams[NamesStream] );
+    BuildDbi( (uint16_t) FirstModStream, streams );
+
+    BuildMsf( streams, pdb );
+}
+
+void PdbBuilder::BuildInfo( uint32_t namesStream, vector<BYTE>& stream )
+{
+    const char  namesName[] = "/names";
+    GUID        guid = { 0 };
+
+    // the header: version, signature, age and GUID
+    Append( stream, (uint32_t) 20000404 );
+    Append( stream, (uint32_t) 0 );
+    Append( stream, (uint32_t) 1 );
+    Append( stream, guid );
+
+    // the named stream map: its strings, then a hash table of one entry
+    Append( stream, (uint32_t) sizeof namesName );
+    AppendString( stream, namesName );
+    Append( stream, (uint32_t) 1 );         // entries
+    Append( stream, (uint32_t) 1 );         // capacity
+    Append( stream, (uint32_t) 1 );         // present words
+    Append( stream, (uint32_t) 1 );
+    Append( stream, (uint32_t) 0 );         // deleted words
+    Append( stream, (uint32_t) 0 );         // key: the offset of the name
+    Append( stream, namesStream );
+    Append( stream, (uint32_t) 0 );
+}
+
+void PdbBuilder::BuildNames( vector<BYTE>& stream )
+{
+    Append( stream, (uint32_t) 0xEFFEEFFE );
+    Append( stream, (uint32_t) 1 );
+    Append( stream, (uint32_t) mNames.size() );
+    stream.insert( stream.end(), mNames.begin(), mNames.end() );
+    Align4( stream );
+
+    // an empty hash table and name count
+    Append( stream, (uint32_t) 0 );
+    Append( stream, (uint32_t) 0 );
+}
+
+void PdbBuilder::BuildModule( const Module& mod, vector<BYTE>& stream )
+{
+    // the symbols are only the signature
+    Append( stream, (uint32_t) 4 );
+
+    Append( stream, (uint32_t) 0xF4 );
+    Append( stream, (uint32_t) (mod.FileNames.size() * ChecksumEntrySize) );
+
+    for ( size_t i = 0; i < mod.FileNames.size(); i++ )
+    {
+        Append( stream, mod.FileNames[i] );
+        Append( stream, (uint32_t) 0 );     // checksum size, kind, and padding
+    }
+
+    for ( size_t i = 0; i < mod.Blocks.size(); i++ )
+    {
+        const LineBlock&    block = mod.Blocks[i];
+        C13LinesHeader      header = { block.Offset, block.Section, 0, block.Size };
+        C13FileBlockHeader  fileBlock = { 0 };
+
+        fileBlock.ChecksumOffset = block.FileIndex * ChecksumEntrySize;
+        fileBlock.LineCount = (uint32_t) block.Lines.size();
+        fileBlock.Size = sizeof fileBlock + (fileBlock.LineCount * sizeof( C13Line ));
+
+        Append( stream, (uint32_t) 0xF2 );
+        Append( stream, (uint32_t) (sizeof header + fileBlock.Size) );
+        Append( stream, header );
+        Append( stream, fileBlock );
+
+        for ( size_t j = 0; j < block.Lines.size(); j++ )
+        {
+            // a statement with no end delta
+            C13Line line = { block.Lines[j].Offset, (block.Lines[j].Number & 0xFFFFFF) | 0x80000000 };
+
+            Append( stream, line );
+        }
+    }
+}
+
+void PdbBuilder::BuildDbi( uint16_t firstModStream, vector< vector<BYTE> >& streams )
+{
+    vector<BYTE>&   stream = streams[DbiStream];
+    DbiHeader       header = { 0 };
+
+    header.VersionSignature = -1;
+    header.VersionHeader = 19990903;
+    header.Age = 1;
+    header.GlobalStream = 0xFFFF;
+    header.PublicStream = 0xFFFF;
+    header.SymRecordStream = 0xFFFF;
+    header.Machine = IMAGE_FILE_MACHINE_I386;
+
+    Append( stream, header );
+
+    size_t  start = stream.size();
+
+    for ( size_t i = 0; i < mModules.size(); i++ )
+    {
+        const Module&   mod = mModules[i];
+        DbiModInfo      modInfo = { 0 };
+
+        modInfo.Contrib.ModIndex = (uint16_t) i;
+        modInfo.Stream = (uint16_t) (firstModStream + i);
+        modInfo.SymByteSize = 4;
+        modInfo.C13ByteSize = (uint32_t) streams[firstModStream + i].size() - 4;
+        modInfo.SourceFileCount = (uint16_t) mod.FileNames.size();
+
+        Append( stream, modInfo );
+        AppendString( stream, mod.Name.c_str() );
+        AppendString( stream, mod.Name.c_str() );
+        Align4( stream );
+    }
+
+    header.ModInfoSize = (uint32_t) (stream.size() - start);
+    start = stream.size();
+
+    Append( stream, (uint32_t) (0xEFFE0000 + 19970605) );
+
+    for ( size_t i = 0; i < mContribs.size(); i++ )
+    {
+        DbiSectionContrib   entry = { 0 };
+
+        entry.Section = mContribs[i].Section;
+        entry.Offset = (int32_t) mContribs[i].Offset;
+        entry.Size = (int32_t) mContribs[i].Size;
+        entry.ModIndex = mContribs[i].ModIndex;
+
+        Append( stream, entry );
+    }
+
+    header.SectionContribSize = (uint32_t) (stream.size() - start);
+    start = stream.size();
+
+    if ( mHasFileInfo )
+    {
+        string      fileNames;
+        uint16_t    firstFile = 0;
+        uint32_t    fileCount = 0;
+
+        for ( size_t i = 0; i < mModules.size(); i++ )
+            fileCount += (uint32_t) mModules[i].FileNames.size();
+
+        Append( stream, (uint16_t) mModules.size() );
+        Append( stream, (uint16_t) fileCount );
+
+        for ( size_t i = 0; i < mModules.size(); i++ )
+        {
+            Append( stream, firstFile );
+            firstFile = (uint16_t) (firstFile + mModules[i].FileNames.size());
+        }
+
+        for ( size_t i = 0; i < mModules.size(); i++ )
+            Append( stream, (uint16_t) mModules[i].FileNames.size() );
+
+        for ( size_t i = 0; i < mModules.size(); i++ )
+        {
+            for ( size_t j = 0; j < mModules[i].FileNames.size(); j++ )
+            {
+                Append( stream, (uint32_t) fileNames.size() );
+                fileNames.append( mNames.c_str() + mModules[i].FileNames[j] );
+                fileNames.push_back( '\0' );
+            }
+        }
+
+        stream.insert( stream.end(), fileNames.begin(), fileNames.end() );
+        Align4( stream );
+    }
+
+    header.SourceInfoSize = (uint32_t) (stream.size() - start);
+
+    Patch( stream, 0, header );
+}
+
+void PdbBuilder::BuildMsf( const vector< vector<BYTE> >& streams, vector<BYTE>& pdb )
+{
+    vector<uint32_t>    dir;
+    uint32_t            nextBlock = FirstDataBlock;
+
+    pdb.assign( FirstDataBlock * BlockSize, 0 );
+
+    dir.push_back( (uint32_t) streams.size() );
+
+    for ( size_t i = 0; i < streams.size(); i++ )
+        dir.push_back( (uint32_t) streams[i].size() );
+
+    for ( size_t i = 0; i < streams.size(); i++ )
+    {
+        const vector<BYTE>& stream = streams[i];
+        uint32_t            blockCount = ((uint32_t) stream.size() + BlockSize - 1) / BlockSize;
+
+        pdb.resize( pdb.size() + (blockCount * BlockSize) );
+
+        for ( uint32_t j = 0; j < blockCount; j++ )
+        {
+            uint32_t    block = mScatterStreams ? (nextBlock + blockCount - 1 - j) : (nextBlock + j);
+            uint32_t    size = (uint32_t) stream.size() - (j * BlockSize);
+
+            if ( size > BlockSize )
+                size = BlockSize;
+
+            memcpy( &pdb[block * BlockSize], &stream[j * BlockSize], size );
+            dir.push_back( block );
+        }
+
+        nextBlock += blockCount;
+    }
+
+    // the directory's blocks, and then the block map that lists them
+
+    uint32_t    dirSize = (uint32_t) (dir.size() * sizeof( uint32_t ));
+    uint32_t    dirBlockCount = (dirSize + BlockSize - 1) / BlockSize;
+    uint32_t    blockMapBlock = nextBlock + dirBlockCount;
+
+    pdb.resize( (blockMapBlock + 1) * BlockSize );
+    memcpy( &pdb[nextBlock * BlockSize], &dir[0], dirSize );
+
+    for ( uint32_t i = 0; i < dirBlockCount; i++ )
+        Patch( pdb, (blockMapBlock * BlockSize) + (i * sizeof( uint32_t )), nextBlock + i );
+
+    MsfSuperBlock   super = { 0 };
+
+    memcpy( super.Magic, MsfMagic, sizeof super.Magic );
+    super.BlockSize = BlockSize;
+    super.FreeBlockMapBlock = 1;
+    super.BlockCount = blockMapBlock + 1;
+    super.DirectorySize = dirSize;
+    super.BlockMapBlock = blockMapBlock;
+
+    Patch( pdb, 0, super );
+}
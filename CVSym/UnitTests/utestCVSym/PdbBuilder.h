@@ -0,0 +1,80 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+
+// Builds the bytes of a small PDB with only what PDBReader reads: the MSF
+// container, the info stream with its "/names" entry, the names stream, the
+// DBI stream with module info, section contributions and file info, and a
+// module stream with C13 file checksums and lines for each module.
+
+class PdbBuilder
+{
+public:
+    struct Line
+    {
+        uint32_t    Offset;         // from the start of the block
+        uint32_t    Number;
+    };
+
+private:
+    struct LineBlock
+    {
+        uint16_t            FileIndex;
+        uint16_t            Section;
+        uint32_t            Offset;
+        uint32_t            Size;
+        std::vector<Line>   Lines;
+    };
+
+    struct Contrib
+    {
+        uint16_t    ModIndex;
+        uint16_t    Section;
+        uint32_t    Offset;
+        uint32_t    Size;
+    };
+
+    struct Module
+    {
+        std::string                 Name;
+        std::vector<uint32_t>       FileNames;      // offsets in the names buffer
+        std::vector<LineBlock>      Blocks;
+    };
+
+    std::vector<Module>     mModules;
+    std::vector<Contrib>    mContribs;
+    std::string             mNames;
+    bool                    mHasFileInfo;
+    bool                    mScatterStreams;
+
+public:
+    PdbBuilder();
+
+    uint16_t AddModule( const char* name );
+    uint16_t AddFile( uint16_t modIndex, const char* fileName );
+    void AddLines( uint16_t modIndex, uint16_t fileIndex, uint16_t section, uint32_t offset, uint32_t size,
+                   const Line* lines, uint32_t lineCount );
+    void AddContrib( uint16_t modIndex, uint16_t section, uint32_t offset, uint32_t size );
+
+    // leave out the DBI file info, so that readers can't tell a module's files without reading it
+    void SetHasFileInfo( bool hasFileInfo );
+
+    // lay out the blocks of each stream backwards, so that no stream is contiguous
+    void SetScatterStreams( bool scatter );
+
+    void Build( std::vector<BYTE>& pdb );
+
+private:
+    uint32_t AddName( const char* name );
+    void BuildInfo( uint32_t namesStream, std::vector<BYTE>& stream );
+    void BuildNames( std::vector<BYTE>& stream );
+    void BuildDbi( uint16_t firstModStream, std::vector< std::vector<BYTE> >& streams );
+    void BuildModule( const Module& mod, std::vector<BYTE>& stream );
+    void BuildMsf( const std::vector< std::vector<BYTE> >& streams, std::vector<BYTE>& pdb );
+};
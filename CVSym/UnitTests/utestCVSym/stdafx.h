@@ -0,0 +1,64 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+// stdafx.h : include file for standard system include files,
+// or project specific include files that are used frequently, but
+// are changed infrequently
+//
+
+#pragma once
+
+#define _CRTDBG_MAP_ALLOC
+
+#include "targetver.h"
+
+// C
+#include <stdio.h>
+#include <tchar.h>
+#include <inttypes.h>
+#include <crtdbg.h>
+
+// C++
+#include <iostream>
+#include <fstream>
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Windows
+#include <windows.h>
+
+// Other
+#include <cpptest.h>
+#include <SmartPtr.h>
+
+// CVSym (test target)
+#include "..\..\CVSym\Error.h"
+#include "..\..\CVSym\CVSymPublic.h"
+#include "..\..\CVSym\CVSymInternal.h"
+#include "..\..\CVSym\PDBReader.h"
+
+
+#define TEST_ASSERT_RETURN( expr )                                  \
+    {                                                               \
+        if (!(expr))                                                \
+        {                                                           \
+            assertment(::Test::Source(__FILE__, __LINE__, #expr));  \
+            return;                                                 \
+        }                                                           \
+    }
+
+#define TEST_ASSERT_RETURN_MSG( expr, msg )                         \
+    {                                                               \
+        if (!(expr))                                                \
+        {                                                           \
+            assertment(::Test::Source(__FILE__, __LINE__, msg));    \
+            return;                                                 \
+        }                                                           \
+    }
@@ -64,6 +64,56 @@ void Scenario1()
     }
 }
 
+// A line with a loop in it. Range stepping through it should only stop 
+// when it leaves the range, not on every instruction of every iteration.
+
+void __declspec( naked ) RunLoop()
+{
+    _asm
+    {
+        mov ecx, 100000
+    again:
+        dec ecx
+        jnz again
+        ret
+    }
+}
+
+void Scenario2()
+{
+    _asm
+    {
+        int 3
+        call RunLoop
+    }
+}
+
+DWORD WINAPI RunLoopThread( void* param )
+{
+    UNREFERENCED_PARAMETER( param );
+
+    for ( ;; )
+        RunLoop();
+}
+
+// While one thread runs through the loop's range, another thread keeps 
+// running through the same code, and reaching the BPs set for the range.
+
+void Scenario3()
+{
+    HANDLE  hThread = CreateThread( NULL, 0, RunLoopThread, NULL, 0, NULL );
+
+    if ( hThread == NULL )
+        RaiseException( 0xAA0034fe, 0, 0, NULL );
+
+    // let the other thread get going
+    Sleep( 100 );
+
+    Scenario2();
+
+    CloseHandle( hThread );
+}
+
 int _tmain(int argc, _TCHAR* argv[])
 {
     if ( argc < 2 )
@@ -74,6 +124,8 @@ int _tmain(int argc, _TCHAR* argv[])
     switch ( scenario )
     {
     case 1: Scenario1(); break;
+    case 2: Scenario2(); break;
+    case 3: Scenario3(); break;
     }
 
     return 0;
@@ -29,6 +29,7 @@
 #include <map>
 #include <vector>
 #include <limits>
+#include <algorithm>
 #include <type_traits>
 
 // Windows
@@ -276,6 +276,16 @@ namespace MagoCore
         return mExec.ReadMemory( process, address, length, lengthRead, lengthUnreadable, buffer );
     }
 
+    HRESULT DebuggerProxy::ReadMemoryV( 
+        IProcess* process, 
+        uint32_t rangeCount, 
+        ReadMemoryRange* ranges, 
+        uint8_t** buffers )
+    {
+        // free threaded like ReadMemory, so the whole batch is one call
+        return mExec.ReadMemoryV( process, rangeCount, ranges, buffers );
+    }
+
     HRESULT DebuggerProxy::WriteMemory( 
         IProcess* process, 
         Address address,
@@ -54,6 +54,12 @@ namespace MagoCore
             uint32_t& lengthUnreadable, 
             uint8_t* buffer );
 
+        HRESULT ReadMemoryV( 
+            IProcess* process, 
+            uint32_t rangeCount, 
+            ReadMemoryRange* ranges, 
+            uint8_t** buffers );
+
         HRESULT WriteMemory( 
             IProcess* process, 
             Address address,
@@ -286,3 +286,335 @@ InstructionType GetInstructionTypeAndSize( uint8_t* mem, int memLen, CpuSizeMode
 
     return type;
 }
+
+
+// Operand flags for the decoding tables
+
+enum OperandFlags
+{
+    Op_None     = 0,
+    Op_ModRm    = 0x01,
+    Op_Imm8     = 0x02,
+    Op_Imm16    = 0x04,
+    Op_ImmZ     = 0x08,     // 16 or 32 bits, by operand size
+    Op_ImmV     = 0x10,     // 16, 32, or 64 bits, by operand size
+    Op_MOffs    = 0x20,     // an address, by address size
+    Op_Far      = 0x40,     // a 16 bit selector, and 16 or 32 bit offset
+    Op_Bad      = 0x80,
+};
+
+#define M       Op_ModRm
+#define I8      Op_Imm8
+#define I16     Op_Imm16
+#define IZ      Op_ImmZ
+#define IV      Op_ImmV
+#define MO      Op_MOffs
+#define FAR     Op_Far
+#define BAD     Op_Bad
+
+// The prefix bytes are read before the opcode, so they aren't in here.
+
+static const uint8_t    OneByteOps[256] = 
+{
+//  0       1       2       3       4       5       6       7       8       9       A       B       C       D       E       F
+    M,      M,      M,      M,      I8,     IZ,     0,      0,      M,      M,      M,      M,      I8,     IZ,     0,      0,      // 0
+    M,      M,      M,      M,      I8,     IZ,     0,      0,      M,      M,      M,      M,      I8,     IZ,     0,      0,      // 1
+    M,      M,      M,      M,      I8,     IZ,     0,      0,      M,      M,      M,      M,      I8,     IZ,     0,      0,      // 2
+    M,      M,      M,      M,      I8,     IZ,     0,      0,      M,      M,      M,      M,      I8,     IZ,     0,      0,      // 3
+    0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      // 4
+    0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      // 5
+    0,      0,      M,      M,      0,      0,      0,      0,      IZ,     M|IZ,   I8,     M|I8,   0,      0,      0,      0,      // 6
+    I8,     I8,     I8,     I8,     I8,     I8,     I8,     I8,     I8,     I8,     I8,     I8,     I8,     I8,     I8,     I8,     // 7
+    M|I8,   M|IZ,   M|I8,   M|I8,   M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      // 8
+    0,      0,      0,      0,      0,      0,      0,      0,      0,      0,      FAR,    0,      0,      0,      0,      0,      // 9
+    MO,     MO,     MO,     MO,     0,      0,      0,      0,      I8,     IZ,     0,      0,      0,      0,      0,      0,      // A
+    I8,     I8,     I8,     I8,     I8,     I8,     I8,     I8,     IV,     IV,     IV,     IV,     IV,     IV,     IV,     IV,     // B
+    M|I8,   M|I8,   I16,    0,      M,      M,      M|I8,   M|IZ,   I16|I8, 0,      I16,    0,      0,      I8,     0,      0,      // C
+    M,      M,      M,      M,      I8,     I8,     0,      0,      M,      M,      M,      M,      M,      M,      M,      M,      // D
+    I8,     I8,     I8,     I8,     I8,     I8,     I8,     I8,     IZ,     IZ,     FAR,    I8,     0,      0,      0,      0,      // E
+    0,      0,      0,      0,      0,      0,      M,      M,      0,      0,      0,      0,      0,      0,      M,      M,      // F
+};
+
+// The 0F 38 and 0F 3A escapes are decoded separately.
+
+static const uint8_t    TwoByteOps[256] = 
+{
+//  0       1       2       3       4       5       6       7       8       9       A       B       C       D       E       F
+    M,      M,      M,      M,      BAD,    0,      0,      0,      0,      0,      BAD,    0,      BAD,    M,      0,      M|I8,   // 0
+    M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      // 1
+    M,      M,      M,      M,      BAD,    BAD,    BAD,    BAD,    M,      M,      M,      M,      M,      M,      M,      M,      // 2
+    0,      0,      0,      0,      0,      0,      BAD,    0,      BAD,    BAD,    BAD,    BAD,    BAD,    BAD,    BAD,    BAD,    // 3
+    M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      // 4
+    M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      // 5
+    M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      // 6
+    M|I8,   M|I8,   M|I8,   M|I8,   M,      M,      M,      0,      M,      M,      BAD,    BAD,    M,      M,      M,      M,      // 7
+    IZ,     IZ,     IZ,     IZ,     IZ,     IZ,     IZ,     IZ,     IZ,     IZ,     IZ,     IZ,     IZ,     IZ,     IZ,     IZ,     // 8
+    M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      // 9
+    0,      0,      0,      M,      M|I8,   M,      BAD,    BAD,    0,      0,      0,      M,      M|I8,   M,      M,      M,      // A
+    M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M|I8,   M,      M,      M,      M,      M,      // B
+    M,      M,      M|I8,   M,      M|I8,   M|I8,   M|I8,   M,      0,      0,      0,      0,      0,      0,      0,      0,      // C
+    M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      // D
+    M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      // E
+    M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      M,      BAD,    // F
+};
+
+#undef M
+#undef I8
+#undef I16
+#undef IZ
+#undef IV
+#undef MO
+#undef FAR
+#undef BAD
+
+static bool IsInvalidIn64Bit( uint8_t opcode )
+{
+    switch ( opcode )
+    {
+    case 0x06: case 0x07: case 0x0E: case 0x16: case 0x17: case 0x1E: case 0x1F:
+    case 0x27: case 0x2F: case 0x37: case 0x3F: case 0x60: case 0x61: case 0x62:
+    case 0x82: case 0x9A: case 0xC4: case 0xC5: case 0xCE: case 0xD4: case 0xD5:
+    case 0xD6: case 0xEA:
+        return true;
+    }
+
+    return false;
+}
+
+// Gets the size of the ModR/M byte, and the SIB byte and displacement that 
+// follow it. Returns false if they run past the end of memory.
+
+static bool GetModRmLength( uint8_t* mem, int memLen, bool addr16, int& length )
+{
+    if ( memLen < 1 )
+        return false;
+
+    BYTE    mod = (mem[0] >> 6) & 3;
+    BYTE    rm = (mem[0] & 7);
+    int     len = 1;
+
+    if ( addr16 )
+    {
+        if ( mod == 2 || ((mod == 0) && (rm == 6)) )
+            len += 2;
+        else if ( mod == 1 )
+            len += 1;
+    }
+    else if ( mod != 3 )
+    {
+        if ( rm == 4 )
+        {
+            if ( memLen < 2 )
+                return false;
+
+            len += 1;       // SIB
+
+            // no base register, only a disp32
+            if ( (mod == 0) && ((mem[1] & 7) == 5) )
+                len += 4;
+        }
+
+        if ( mod == 2 || ((mod == 0) && (rm == 5)) )
+            len += 4;
+        else if ( mod == 1 )
+            len += 1;
+    }
+
+    if ( len > memLen )
+        return false;
+
+    length = len;
+    return true;
+}
+
+static int32_t ReadDisplacement( uint8_t* mem, int size )
+{
+    if ( size == 1 )
+        return (int8_t) mem[0];
+    if ( size == 2 )
+        return (int16_t) (mem[0] | (mem[1] << 8));
+
+    return (int32_t) (mem[0] | (mem[1] << 8) | (mem[2] << 16) | (mem[3] << 24));
+}
+
+bool GetInstructionBranch( 
+    uint8_t* mem, 
+    int memLen, 
+    CpuSizeMode mode, 
+    Address address, 
+    int& size, 
+    BranchType& type, 
+    Address& target )
+{
+    _ASSERT( (mode == Cpu_32) || (mode == Cpu_64) );
+
+    int             prefixSize = 0;
+    Prefixes        prefixes = { 0 };
+    uint8_t         flags = 0;
+    uint8_t         opcode = 0;
+    int             len = 0;
+    bool            twoByte = false;
+    bool            rexW = false;
+    bool            addr16 = false;
+    bool            op16 = false;
+
+    if ( memLen > MAX_INSTRUCTION_SIZE )
+        memLen = MAX_INSTRUCTION_SIZE;
+
+    prefixSize = ReadPrefixes( mem, memLen, mode, prefixes );
+    if ( prefixSize >= memLen )
+        return false;
+
+    rexW = (mode == Cpu_64) && prefixes.Pre64.Rex.Bits.W;
+    addr16 = (mode == Cpu_32) && prefixes.Pre32.AddressSize;
+    op16 = prefixes.Pre32.OperandSize && !rexW;
+
+    len = prefixSize;
+    opcode = mem[len++];
+
+    if ( opcode == 0x0F )
+    {
+        if ( len >= memLen )
+            return false;
+
+        twoByte = true;
+        opcode = mem[len++];
+
+        if ( opcode == 0x38 || opcode == 0x3A )
+        {
+            // the three byte opcodes all have a ModR/M byte
+            if ( len >= memLen )
+                return false;
+
+            len++;
+            flags = (opcode == 0x3A) ? (Op_ModRm | Op_Imm8) : Op_ModRm;
+        }
+        else
+        {
+            flags = TwoByteOps[opcode];
+        }
+    }
+    else
+    {
+        if ( (mode == Cpu_64) && IsInvalidIn64Bit( opcode ) )
+            return false;
+
+        // VEX and EVEX take the place of LES, LDS, and BOUND with a register operand
+        if ( (opcode == 0xC4 || opcode == 0xC5 || opcode == 0x62) 
+            && (len < memLen) && ((mem[len] & 0xC0) == 0xC0) )
+            return false;
+
+        flags = OneByteOps[opcode];
+    }
+
+    if ( (flags & Op_Bad) != 0 )
+        return false;
+
+    uint8_t*    modRm = &mem[len];
+
+    if ( (flags & Op_ModRm) != 0 )
+    {
+        int modRmLen = 0;
+
+        if ( !GetModRmLength( modRm, memLen - len, addr16, modRmLen ) )
+            return false;
+
+        len += modRmLen;
+
+        // TEST in group 3 has an immediate operand, but the others don't
+        if ( !twoByte && (opcode == 0xF6 || opcode == 0xF7) && (((*modRm >> 3) & 7) < 2) )
+            flags |= (opcode == 0xF6) ? Op_Imm8 : Op_ImmZ;
+    }
+
+    int     immOffset = len;
+    int     immSize = 0;
+
+    if ( (flags & Op_Imm8) != 0 )
+        immSize += 1;
+    if ( (flags & Op_Imm16) != 0 )
+        immSize += 2;
+    if ( (flags & Op_ImmZ) != 0 )
+        immSize += op16 ? 2 : 4;
+    if ( (flags & Op_ImmV) != 0 )
+        immSize += rexW ? 8 : (op16 ? 2 : 4);
+    if ( (flags & Op_MOffs) != 0 )
+    {
+        if ( mode == Cpu_64 )
+            immSize += prefixes.Pre32.AddressSize ? 4 : 8;
+        else
+            immSize += addr16 ? 2 : 4;
+    }
+    if ( (flags & Op_Far) != 0 )
+        immSize += op16 ? 4 : 6;
+
+    // in 64-bit mode, near branches always have a 32 bit displacement
+    bool    relZ = (!twoByte && (opcode == 0xE8 || opcode == 0xE9))
+                || (twoByte && (opcode >= 0x80 && opcode <= 0x8F));
+
+    if ( relZ && (mode == Cpu_64) )
+        immSize = 4;
+
+    len += immSize;
+
+    if ( len > memLen )
+        return false;
+
+    Address nextAddr = address + len;
+
+    type = Branch_None;
+
+    if ( twoByte )
+    {
+        if ( opcode >= 0x80 && opcode <= 0x8F )
+        {
+            type = Branch_Conditional;
+            target = nextAddr + ReadDisplacement( &mem[immOffset], immSize );
+        }
+        else if ( opcode == 0x05 || opcode == 0x07 || opcode == 0x0B 
+            || opcode == 0x34 || opcode == 0x35 )
+        {
+            type = Branch_Other;
+        }
+    }
+    else
+    {
+        switch ( opcode )
+        {
+        case 0x70: case 0x71: case 0x72: case 0x73: case 0x74: case 0x75: case 0x76: case 0x77:
+        case 0x78: case 0x79: case 0x7A: case 0x7B: case 0x7C: case 0x7D: case 0x7E: case 0x7F:
+        case 0xE0: case 0xE1: case 0xE2: case 0xE3:
+            type = Branch_Conditional;
+            target = nextAddr + ReadDisplacement( &mem[immOffset], immSize );
+            break;
+
+        case 0xEB:
+        case 0xE9:
+            type = Branch_Direct;
+            target = nextAddr + ReadDisplacement( &mem[immOffset], immSize );
+            break;
+
+        case 0xE8:
+        case 0x9A: case 0xEA:
+        case 0xC2: case 0xC3: case 0xCA: case 0xCB:
+        case 0xCC: case 0xCD: case 0xCE: case 0xCF:
+        case 0xF1: case 0xF4:
+            type = Branch_Other;
+            break;
+
+        case 0xFF:
+            {
+                BYTE    regOp = (*modRm >> 3) & 7;
+                if ( regOp >= 2 && regOp <= 5 )
+                    type = Branch_Other;
+            }
+            break;
+        }
+    }
+
+    // a 16 bit operand size wraps the instruction pointer
+    if ( (type == Branch_Direct || type == Branch_Conditional) && (mode == Cpu_32) && op16 )
+        target &= 0xFFFF;
+
+    size = len;
+    return true;
+}
@@ -25,6 +25,14 @@ enum InstructionType
     Inst_Syscall,
 };
 
+enum BranchType
+{
+    Branch_None,        // always goes on to the next instruction
+    Branch_Direct,      // always jumps to the target
+    Branch_Conditional, // jumps to the target or goes on to the next instruction
+    Branch_Other,       // calls, returns, indirect jumps, interrupts, and system calls
+};
+
 
 // IA-32 Intel Architecture: Software Developers Manual
 // Volume 2A: Instruction Set Reference, A-M
@@ -33,3 +41,16 @@ const int   MAX_INSTRUCTION_SIZE = 15;
 
 
 InstructionType GetInstructionTypeAndSize( uint8_t* mem, int memLen, CpuSizeMode mode, int& size );
+
+// Decodes the size of any general purpose, x87, or SSE instruction, and 
+// where it can send control. The target is only set for direct and 
+// conditional branches. Returns false if the instruction isn't known, 
+// including the VEX and EVEX encoded ones.
+bool GetInstructionBranch( 
+    uint8_t* mem, 
+    int memLen, 
+    CpuSizeMode mode, 
+    Address address, 
+    int& size, 
+    BranchType& type, 
+    Address& target );
@@ -1145,6 +1145,37 @@ HRESULT Exec::ReadMemory(
     return hr;
 }
 
+    // not tied to the exec debugger thread
+HRESULT Exec::ReadMemoryV( 
+    IProcess* process, 
+    uint32_t rangeCount, 
+    ReadMemoryRange* ranges, 
+    uint8_t** buffers )
+{
+    _ASSERT( process != NULL );
+    if ( process == NULL )
+        return E_INVALIDARG;
+    if ( (rangeCount > 0) && ((ranges == NULL) || (buffers == NULL)) )
+        return E_INVALIDARG;
+    if ( mIsShutdown )
+        return E_WRONG_STATE;
+
+    HRESULT         hr = S_OK;
+    Process*        proc = (Process*) process;
+
+    ProcessGuard    guard( proc );
+
+    if ( proc->IsDeleted() || proc->IsTerminating() )
+        return E_PROCESS_ENDED;
+
+    IMachine*   machine = proc->GetMachine();
+    _ASSERT( machine != NULL );
+
+    hr = machine->ReadMemoryV( rangeCount, ranges, buffers );
+
+    return hr;
+}
+
 
 HRESULT Exec::WriteMemory( 
     IProcess* process, 
@@ -1177,6 +1208,29 @@ HRESULT Exec::WriteMemory(
     return hr;
 }
 
+HRESULT Exec::GetMemoryCacheStats( IProcess* process, MemoryCacheStats& stats )
+{
+    _ASSERT( process != NULL );
+    if ( process == NULL )
+        return E_INVALIDARG;
+    if ( mIsShutdown )
+        return E_WRONG_STATE;
+
+    Process*        proc = (Process*) process;
+
+    ProcessGuard    guard( proc );
+
+    if ( proc->IsDeleted() || proc->IsTerminating() )
+        return E_PROCESS_ENDED;
+
+    IMachine*   machine = proc->GetMachine();
+    _ASSERT( machine != NULL );
+
+    machine->GetMemoryCacheStats( stats );
+
+    return S_OK;
+}
+
 
     // not tied to the wait/continue state
 HRESULT Exec::SetBreakpoint( IProcess* process, Address address )
@@ -42,7 +42,9 @@ Mode    Disp.   Thread  Method
         Allowed
 ------------------------------------
 any     yes     any     ReadMemory
+any     yes     any     ReadMemoryV
 break   yes     any     WriteMemory
+any     yes     any     GetMemoryCacheStats
 any     yes     any     SetBreakpoint
 any     yes     any     RemoveBreakpoint
 break   no*     Debug   StepOut
@@ -167,8 +169,9 @@ public:
     //
     HRESULT ResumeLaunchedProcess( IProcess* process );
 
-    // Reads a block of memory from a process's address space. The memory is 
-    // read straight from the debuggee and not cached.
+    // Reads a block of memory from a process's address space. While the 
+    // process is in break mode, the pages that are read are cached until it 
+    // runs again or its memory is written.
     //
     HRESULT ReadMemory( 
         IProcess* process, 
@@ -178,6 +181,16 @@ public:
         uint32_t& lengthUnreadable, 
         uint8_t* buffer );
 
+    // Reads several blocks of memory from a process's address space, each 
+    // into its own buffer, while holding the process's lock only once. A 
+    // block that fails doesn't fail the others; see ReadMemoryRange.
+    //
+    HRESULT ReadMemoryV( 
+        IProcess* process, 
+        uint32_t rangeCount, 
+        ReadMemoryRange* ranges, 
+        uint8_t** buffers );
+
     // Writes a block of memory to a process's address space. The memory is 
     // written straight to the debuggee and not cached.
     //
@@ -188,6 +201,11 @@ public:
         uint32_t& lengthWritten, 
         uint8_t* buffer );
 
+    // Gets the counts of memory pages found in and missing from a process's 
+    // memory cache, added up over all the times it was in break mode.
+    //
+    HRESULT GetMemoryCacheStats( IProcess* process, MemoryCacheStats& stats );
+
     // Adds or removes a breakpoint. If the process is running when this 
     // method is called, then all threads will be suspended first.
     //
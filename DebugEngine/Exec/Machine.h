@@ -50,6 +50,11 @@ public:
         uint32_t& lengthUnreadable, 
         uint8_t* buffer ) = 0;
 
+    virtual HRESULT ReadMemoryV( 
+        uint32_t rangeCount, 
+        ReadMemoryRange* ranges, 
+        uint8_t** buffers ) = 0;
+
     virtual HRESULT WriteMemory( 
         Address address,
         uint32_t length, 
@@ -60,6 +65,8 @@ public:
     virtual HRESULT RemoveBreakpoint( Address address ) = 0;
     virtual bool IsBreakpointActive( Address address ) = 0;
 
+    virtual void    GetMemoryCacheStats( MemoryCacheStats& stats ) = 0;
+
     virtual HRESULT SetContinue() = 0;
     virtual HRESULT SetStepOut( Address targetAddress ) = 0;
     virtual HRESULT SetStepInstruction( bool stepIn ) = 0;
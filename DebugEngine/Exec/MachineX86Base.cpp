@@ -28,6 +28,9 @@ const uint8_t   BreakpointInstruction = 0xCC;
 const uint32_t  STATUS_WX86_SINGLE_STEP = 0x4000001E;
 const uint32_t  STATUS_WX86_BREAKPOINT = 0x4000001F;
 
+// Longer ranges are single stepped instead of decoded.
+const uint32_t  MaxRunRangeSize = 0x2000;
+
 
 class Breakpoint
 {
@@ -249,9 +252,43 @@ HRESULT MachineX86Base::ReadMemory(
     uint32_t& lengthUnreadable, 
     uint8_t* buffer )
 {
+    // memory can only be cached while the debuggee can't change it
+    if ( mStopped )
+        return ReadCachedMemory( address, length, lengthRead, lengthUnreadable, buffer );
+
     return ReadCleanMemory( address, length, lengthRead, lengthUnreadable, buffer );
 }
 
+HRESULT MachineX86Base::ReadMemoryV( 
+    uint32_t rangeCount, 
+    ReadMemoryRange* ranges, 
+    uint8_t** buffers )
+{
+    _ASSERT( ranges != NULL );
+    _ASSERT( buffers != NULL );
+
+    for ( uint32_t i = 0; i < rangeCount; i++ )
+    {
+        ReadMemoryRange&    range = ranges[i];
+        HRESULT             hr = S_OK;
+
+        hr = ReadMemory( 
+            range.Addr, 
+            range.Length, 
+            range.LengthRead, 
+            range.LengthUnreadable, 
+            buffers[i] );
+        if ( FAILED( hr ) )
+        {
+            // one bad block doesn't keep the others from being read
+            range.LengthRead = 0;
+            range.LengthUnreadable = 0;
+        }
+    }
+
+    return S_OK;
+}
+
 HRESULT MachineX86Base::WriteMemory( 
     Address address, 
     uint32_t length, 
@@ -262,6 +299,9 @@ HRESULT MachineX86Base::WriteMemory(
     if ( mStoppedThreadId == 0 )
         return E_WRONG_STATE;
 
+    // even a failed write might have changed some of the memory
+    mMemCache.Invalidate( address, length );
+
     return WriteCleanMemory( address, length, lengthWritten, buffer );
 }
 
@@ -294,6 +334,11 @@ bool MachineX86Base::IsBreakpointActive( Address address )
     return isActive;
 }
 
+void MachineX86Base::GetMemoryCacheStats( MemoryCacheStats& stats )
+{
+    mMemCache.GetStats( stats );
+}
+
 HRESULT MachineX86Base::SetBreakpointInternal( Address address, bool user )
 {
     HRESULT                     hr = S_OK;
@@ -522,6 +567,8 @@ HRESULT MachineX86Base::Detach()
         mAddrTable->clear();
     }
 
+    mMemCache.Clear();
+
     if ( mStopped )
     {
         SetSingleStep( false );
@@ -602,6 +649,9 @@ HRESULT MachineX86Base::OnContinue()
 
     HRESULT hr = S_OK;
 
+    // whether stepping or running, the debuggee is about to change its memory
+    mMemCache.Clear();
+
     hr = FlushThreadContext();
     if ( FAILED( hr ) )
         goto Error;
@@ -672,6 +722,25 @@ Error:
     return false;
 }
 
+// whether a thread's range step set a BP at the address
+
+bool MachineX86Base::AtRangeBP( Address address )
+{
+    for ( ThreadMap::iterator it = mThreads.begin();
+        it != mThreads.end();
+        it++ )
+    {
+        ExpectedEvent*  event = it->second->GetTopExpected();
+
+        if ( event != NULL 
+            && event->RemoveRangeBPs 
+            && std::binary_search( event->Range->StopAddrs.begin(), event->Range->StopAddrs.end(), address ) )
+            return true;
+    }
+
+    return false;
+}
+
 HRESULT MachineX86Base::Rewind()
 {
     return ChangeCurrentPC( -1 );
@@ -679,6 +748,8 @@ HRESULT MachineX86Base::Rewind()
 
 void    MachineX86Base::OnDestroyProcess()
 {
+    mMemCache.Clear();
+
     mhProcess = NULL;
     mProcess = NULL;
     mCurThread = NULL;
@@ -753,6 +824,13 @@ HRESULT MachineX86Base::RunAllActions( bool cancel, MachineResult& result )
             goto Error;
     }
 
+    if ( event->RemoveRangeBPs )
+    {
+        hr = RemoveRangeBreakpoints( event->Range );
+        if ( FAILED( hr ) )
+            goto Error;
+    }
+
     if ( event->ResumeThreads )
     {
         hr = ResumeOtherThreads( mStoppedThreadId );
@@ -1073,7 +1151,10 @@ HRESULT    MachineX86Base::DispatchBreakpoint( const EXCEPTION_DEBUG_INFO* excep
 
     ExpectedEvent* event = mCurThread->GetTopExpected();
 
-    if ( event != NULL && event->Code == Expect_BP && event->BPAddress == exceptAddr )
+    if ( event != NULL && event->Code == Expect_BP 
+        && ((event->BPAddress == exceptAddr) 
+            || (event->RemoveRangeBPs 
+                && std::binary_search( event->Range->StopAddrs.begin(), event->Range->StopAddrs.end(), exceptAddr ))) )
     {
         if ( !embeddedBP )
         {
@@ -1106,6 +1187,17 @@ HRESULT    MachineX86Base::DispatchBreakpoint( const EXCEPTION_DEBUG_INFO* excep
     }
 
     Rewind();
+
+    // This thread hit a BP at the exit of another thread's range step. The 
+    // BP stays until that step is done, so step this thread over it, or 
+    // else it would hit it again as soon as it runs.
+    if ( AtRangeBP( exceptAddr ) )
+    {
+        hr = SetContinue();
+        if ( FAILED( hr ) )
+            return hr;
+    }
+
     result = MacRes_HandledContinue;
     return S_OK;
 }
@@ -1626,9 +1718,21 @@ HRESULT MachineX86Base::SetStepInstructionCore( Motion motion, RangeStepPtr& ran
         }
         else
         {
-            hr = DontPassBP( motion, pc, instType, instLen, notifier, rangeStep );
-            if ( FAILED( hr ) )
-                goto Error;
+            bool    runRange = false;
+
+            if ( rangeStep.Get() != NULL )
+            {
+                hr = SetRangeBreakpoints( motion, pc, notifier, rangeStep, runRange );
+                if ( FAILED( hr ) )
+                    goto Error;
+            }
+
+            if ( !runRange )
+            {
+                hr = DontPassBP( motion, pc, instType, instLen, notifier, rangeStep );
+                if ( FAILED( hr ) )
+                    goto Error;
+            }
         }
     }
 
@@ -1636,6 +1740,180 @@ Error:
     return hr;
 }
 
+// Instead of single stepping every instruction in the range, let the 
+// debuggee run until it reaches an instruction that has to be stepped by 
+// itself, or it leaves the range. Loops that stay in the range don't cause 
+// any debug events. If it can't be done, then set is false, and the caller 
+// should single step. The other threads keep running, and DispatchBreakpoint
+// steps them over these BPs when they reach them.
+
+HRESULT MachineX86Base::SetRangeBreakpoints( 
+    Motion motion, 
+    Address pc, 
+    int notifier, 
+    RangeStepPtr& rangeStep, 
+    bool& set )
+{
+    _ASSERT( rangeStep.Get() != NULL );
+
+    HRESULT         hr = S_OK;
+    RangeStep*      range = rangeStep.Get();
+    ExpectedEvent*  event = NULL;
+    size_t          setCount = 0;
+
+    set = false;
+
+    if ( range->InThunk )
+        return S_OK;
+
+    if ( !range->Decoded )
+    {
+        hr = DecodeRange( range );
+        if ( FAILED( hr ) )
+            return hr;
+    }
+
+    if ( !range->CanRun
+        || !std::binary_search( range->InstStarts.begin(), range->InstStarts.end(), pc )
+        || std::binary_search( range->StepInsts.begin(), range->StepInsts.end(), pc ) )
+        return S_OK;
+
+    for ( ; setCount < range->StopAddrs.size(); setCount++ )
+    {
+        hr = SetBreakpointInternal( range->StopAddrs[setCount], false );
+        if ( FAILED( hr ) )
+            break;
+    }
+
+    if ( setCount == range->StopAddrs.size() )
+        event = mCurThread->PushExpected( Expect_BP, notifier );
+
+    if ( event == NULL )
+    {
+        for ( size_t i = 0; i < setCount; i++ )
+            RemoveBreakpointInternal( range->StopAddrs[i], false );
+
+        if ( setCount == range->StopAddrs.size() )
+            return E_FAIL;
+
+        // a BP couldn't be set, so don't try this range again
+        range->CanRun = false;
+        return S_OK;
+    }
+
+    event->RemoveRangeBPs = true;
+    event->Motion = motion;
+    event->Range = rangeStep.Detach();
+
+    set = true;
+    return S_OK;
+}
+
+HRESULT MachineX86Base::RemoveRangeBreakpoints( RangeStep* rangeStep )
+{
+    _ASSERT( rangeStep != NULL );
+
+    HRESULT hr = S_OK;
+
+    for ( size_t i = 0; i < rangeStep->StopAddrs.size(); i++ )
+    {
+        HRESULT hrRemove = RemoveBreakpointInternal( rangeStep->StopAddrs[i], false );
+        if ( FAILED( hrRemove ) && SUCCEEDED( hr ) )
+            hr = hrRemove;
+    }
+
+    return hr;
+}
+
+HRESULT MachineX86Base::DecodeRange( RangeStep* rangeStep )
+{
+    _ASSERT( rangeStep != NULL );
+
+    HRESULT         hr = S_OK;
+    Address         begin = rangeStep->Range.Begin;
+    Address         end = rangeStep->Range.End;
+    uint32_t        length = 0;
+    uint32_t        lenRead = 0;
+    uint32_t        lenUnreadable = 0;
+    CpuSizeMode     cpu = Is64Bit() ? Cpu_64 : Cpu_32;
+    BranchType      lastType = Branch_None;
+    Address         addr = begin;
+
+    std::vector<uint8_t>    mem;
+    std::vector<Address>    instStarts;
+    std::vector<Address>    stepInsts;
+    std::vector<Address>    stopAddrs;
+
+    rangeStep->Decoded = true;
+    rangeStep->CanRun = false;
+
+    if ( (end < begin) || ((end - begin) >= MaxRunRangeSize) )
+        return S_OK;
+
+    // the end is inclusive, and the last instruction can go past it
+    length = (uint32_t) (end - begin) + 1;
+    mem.resize( length + MAX_INSTRUCTION_SIZE - 1 );
+
+    // this unpatches all BPs in the buffer
+    hr = ReadCleanMemory( begin, (uint32_t) mem.size(), lenRead, lenUnreadable, &mem[0] );
+    if ( FAILED( hr ) )
+        return hr;
+
+    if ( lenRead < length )
+        return S_OK;
+
+    while ( addr <= end )
+    {
+        uint32_t        offset = (uint32_t) (addr - begin);
+        int             size = 0;
+        BranchType      type = Branch_None;
+        Address         target = 0;
+        int             bpSize = 0;
+
+        if ( !GetInstructionBranch( &mem[offset], (int) (lenRead - offset), cpu, addr, size, type, target ) )
+            return S_OK;
+
+        // the debuggee's own BPs are reported as exceptions, not as stops in the range
+        if ( GetInstructionTypeAndSize( &mem[offset], (int) (lenRead - offset), cpu, bpSize ) == Inst_Breakpoint )
+            return S_OK;
+
+        instStarts.push_back( addr );
+
+        if ( type == Branch_Other )
+        {
+            // calls, returns, and indirect branches have to be stepped
+            stepInsts.push_back( addr );
+            stopAddrs.push_back( addr );
+        }
+        else if ( (type == Branch_Direct || type == Branch_Conditional) 
+            && ((target < begin) || (target > end)) )
+        {
+            stopAddrs.push_back( target );
+        }
+
+        // don't wrap around the end of the address space
+        if ( addr + size < addr )
+            return S_OK;
+
+        lastType = type;
+        addr += size;
+    }
+
+    // falling off the end of the range
+    if ( lastType == Branch_None || lastType == Branch_Conditional )
+        stopAddrs.push_back( addr );
+
+    std::sort( stopAddrs.begin(), stopAddrs.end() );
+    stopAddrs.erase( std::unique( stopAddrs.begin(), stopAddrs.end() ), stopAddrs.end() );
+
+    rangeStep->InstStarts.swap( instStarts );
+    rangeStep->StepInsts.swap( stepInsts );
+    rangeStep->StopAddrs.swap( stopAddrs );
+    rangeStep->CanRun = true;
+
+    return S_OK;
+}
+
 HRESULT MachineX86Base::GetThreadContext( 
     uint32_t threadId, 
     uint32_t features, 
@@ -1677,6 +1955,113 @@ ThreadX86Base* MachineX86Base::GetStoppedThread()
     return mCurThread;
 }
 
+HRESULT MachineX86Base::ReadCachedMemory( 
+    Address address, 
+    uint32_t length, 
+    uint32_t& lengthRead, 
+    uint32_t& lengthUnreadable, 
+    uint8_t* buffer )
+{
+    Address endAddr = address + length;
+
+    if ( (length > MemoryCache::MaxReadSize) || (endAddr < address) )
+        return ReadCleanMemory( address, length, lengthRead, lengthUnreadable, buffer );
+
+    HRESULT     hr = S_OK;
+    uint32_t    lenRead = 0;
+    uint32_t    lenUnreadable = 0;
+    Address     curAddr = address;
+
+    // Like ReadMemory in Utility.cpp, return the readable bytes at the start 
+    // and the unreadable ones right after them, but stop at readable memory 
+    // after unreadable memory.
+
+    while ( curAddr < endAddr )
+    {
+        Address     pageAddr = MemoryCache::GetPageAddress( curAddr );
+        uint32_t    pageOffset = (uint32_t) (curAddr - pageAddr);
+        uint32_t    chunkLen = MemoryCache::PageSize - pageOffset;
+        bool        hit = false;
+
+        const MemoryCache::Page*    page = NULL;
+
+        if ( chunkLen > endAddr - curAddr )
+            chunkLen = (uint32_t) (endAddr - curAddr);
+
+        hr = ReadCachedPage( pageAddr, page, hit );
+        if ( FAILED( hr ) )
+        {
+            // the page couldn't be cached whole, so leave it to the process
+            return ReadCleanMemory( address, length, lengthRead, lengthUnreadable, buffer );
+        }
+
+        if ( page->Readable )
+        {
+            if ( lenUnreadable > 0 )
+                break;
+
+            memcpy( buffer + lenRead, page->Bytes + pageOffset, chunkLen );
+            lenRead += chunkLen;
+
+            if ( hit )
+                mMemCache.RecordHit( chunkLen );
+        }
+        else
+        {
+            lenUnreadable += chunkLen;
+
+            if ( hit )
+                mMemCache.RecordHit( 0 );
+        }
+
+        curAddr += chunkLen;
+    }
+
+    lengthRead = lenRead;
+    lengthUnreadable = lenUnreadable;
+
+    return S_OK;
+}
+
+HRESULT MachineX86Base::ReadCachedPage( Address pageAddr, const MemoryCache::Page*& page, bool& hit )
+{
+    page = mMemCache.FindPage( pageAddr );
+    if ( page != NULL )
+    {
+        hit = true;
+        return S_OK;
+    }
+
+    HRESULT     hr = S_OK;
+    uint32_t    lenRead = 0;
+    uint32_t    lenUnreadable = 0;
+
+    std::auto_ptr< MemoryCache::Page >  newPage( new MemoryCache::Page() );
+
+    if ( newPage.get() == NULL )
+        return E_OUTOFMEMORY;
+
+    hr = ReadCleanMemory( pageAddr, MemoryCache::PageSize, lenRead, lenUnreadable, newPage->Bytes );
+    if ( FAILED( hr ) )
+        return hr;
+
+    // protection is per page, so anything else means the read was cut short
+    if ( lenRead == MemoryCache::PageSize )
+        newPage->Readable = true;
+    else if ( lenUnreadable == MemoryCache::PageSize )
+        newPage->Readable = false;
+    else
+        return E_FAIL;
+
+    mMemCache.RecordMiss();
+
+    page = newPage.get();
+    hit = false;
+    mMemCache.AddPage( pageAddr, newPage.release() );
+
+    return S_OK;
+}
+
 HRESULT MachineX86Base::ReadCleanMemory( 
     Address address, 
     uint32_t length, 
@@ -1697,13 +2082,13 @@ HRESULT MachineX86Base::ReadCleanMemory(
 
         // unpatch all BPs from the memory area we're returning
 
-        for ( BPAddressTable::iterator it = mAddrTable->begin();
-            it != mAddrTable->end();
+        for ( BPAddressTable::iterator it = mAddrTable->lower_bound( startAddr );
+            (it != mAddrTable->end()) && (it->first <= endAddr);
             it++ )
         {
             Breakpoint* bp = it->second;
 
-            if ( bp->IsPatched() && (it->first >= startAddr) && (it->first <= endAddr) )
+            if ( bp->IsPatched() )
             {
                 Address offset = it->first - startAddr;
                 buffer[ offset ] = bp->GetOriginalInstructionByte();
@@ -1735,13 +2120,15 @@ HRESULT MachineX86Base::WriteCleanMemory(
     Address startAddr = address;
     Address endAddr = address + length - 1;
 
-    for ( BPAddressTable::iterator it = mAddrTable->begin();
-        it != mAddrTable->end();
+    // the table is sorted by address, so only look at the BPs in the range
+
+    for ( BPAddressTable::iterator it = mAddrTable->lower_bound( startAddr );
+        (it != mAddrTable->end()) && (it->first <= endAddr);
         it++ )
     {
         Breakpoint* bp = it->second;
 
-        if ( bp->IsPatched() && (it->first >= startAddr) && (it->first <= endAddr) )
+        if ( bp->IsPatched() )
         {
             Address offset = it->first - startAddr;
 
@@ -1765,13 +2152,13 @@ HRESULT MachineX86Base::WriteCleanMemory(
 
     endAddr = address + lengthWritten - 1;
 
-    for ( BPAddressTable::iterator it = mAddrTable->begin();
-        it != mAddrTable->end();
+    for ( BPAddressTable::iterator it = mAddrTable->lower_bound( startAddr );
+        (it != mAddrTable->end()) && (it->first <= endAddr);
         it++ )
     {
         Breakpoint* bp = it->second;
 
-        if ( bp->IsPatched() && (it->first >= startAddr) && (it->first <= endAddr) )
+        if ( bp->IsPatched() )
         {
             bp->SetOriginalInstructionByte( bp->GetTempInstructionByte() );
         }
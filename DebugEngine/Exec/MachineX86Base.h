@@ -8,6 +8,7 @@
 #pragma once
 
 #include "Machine.h"
+#include "MemoryCache.h"
 
 class BPAddressTable;
 class Breakpoint;
@@ -31,6 +32,7 @@ class MachineX86Base : public IMachine
     Process*        mProcess;
     HANDLE          mhProcess;
     BPAddressTable* mAddrTable;
+    MemoryCache     mMemCache;
     uint32_t        mStoppedThreadId;
     bool            mStoppedOnException;
     bool            mStopped;
@@ -63,6 +65,11 @@ public:
         uint32_t& lengthUnreadable, 
         uint8_t* buffer );
 
+    virtual HRESULT ReadMemoryV( 
+        uint32_t rangeCount, 
+        ReadMemoryRange* ranges, 
+        uint8_t** buffers );
+
     virtual HRESULT WriteMemory( 
         Address address, 
         uint32_t length, 
@@ -73,6 +80,8 @@ public:
     virtual HRESULT RemoveBreakpoint( Address address );
     virtual bool IsBreakpointActive( Address address );
 
+    virtual void    GetMemoryCacheStats( MemoryCacheStats& stats );
+
     virtual HRESULT SetContinue();
     virtual HRESULT SetStepOut( Address targetAddress );
     virtual HRESULT SetStepInstruction( bool stepIn );
@@ -123,6 +132,15 @@ protected:
     HANDLE  GetProcessHandle();
 
 private:
+    HRESULT ReadCachedMemory( 
+        Address address, 
+        uint32_t length, 
+        uint32_t& lengthRead, 
+        uint32_t& lengthUnreadable, 
+        uint8_t* buffer );
+
+    HRESULT ReadCachedPage( Address pageAddr, const MemoryCache::Page*& page, bool& hit );
+
     HRESULT ReadCleanMemory( 
         Address address, 
         uint32_t length, 
@@ -226,6 +244,15 @@ private:
 
     HRESULT SetStepInstructionCore( Motion motion, RangeStepPtr& rangeStep, int notifier );
 
+    HRESULT SetRangeBreakpoints( 
+        Motion motion, 
+        Address pc, 
+        int notifier, 
+        RangeStepPtr& rangeStep, 
+        bool& set );
+    HRESULT RemoveRangeBreakpoints( RangeStep* rangeStep );
+    HRESULT DecodeRange( RangeStep* rangeStep );
+
     HRESULT SuspendOtherThreads( UINT32 threadId );
     HRESULT ResumeOtherThreads( UINT32 threadId );
 
@@ -245,6 +272,7 @@ private:
     Breakpoint* FindBP( Address address );
     ThreadX86Base* FindThread( uint32_t threadId );
     bool AtEmbeddedBP( Address address, Breakpoint* bp );
+    bool AtRangeBP( Address address );
 
     // like the public SetStepRange, but uses the range info we already have
     HRESULT SetStepRange( bool stepIn, RangeStepPtr& rangeStep );
@@ -0,0 +1,115 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "Common.h"
+#include "MemoryCache.h"
+
+
+MemoryCache::MemoryCache()
+    :   mUsedThisStop( false )
+{
+    memset( &mStats, 0, sizeof mStats );
+}
+
+MemoryCache::~MemoryCache()
+{
+    DeletePages();
+}
+
+const MemoryCache::Page* MemoryCache::FindPage( Address pageAddr )
+{
+    _ASSERT( pageAddr == GetPageAddress( pageAddr ) );
+
+    PageMap::iterator   it = mPages.find( pageAddr );
+
+    if ( it == mPages.end() )
+        return NULL;
+
+    return it->second;
+}
+
+void MemoryCache::AddPage( Address pageAddr, Page* page )
+{
+    _ASSERT( pageAddr == GetPageAddress( pageAddr ) );
+    _ASSERT( page != NULL );
+
+    if ( mPages.size() >= MaxPages )
+        DeletePages();
+
+    PageMap::iterator   it = mPages.find( pageAddr );
+
+    if ( it != mPages.end() )
+    {
+        delete it->second;
+        it->second = page;
+    }
+    else
+    {
+        mPages.insert( PageMap::value_type( pageAddr, page ) );
+    }
+}
+
+void MemoryCache::Invalidate( Address address, uint32_t length )
+{
+    if ( length == 0 || mPages.empty() )
+        return;
+
+    Address     firstPage = GetPageAddress( address );
+    Address     lastPage = GetPageAddress( address + length - 1 );
+
+    // the range wrapped around the end of the address space
+    if ( lastPage < firstPage )
+        lastPage = GetPageAddress( (Address) -1 );
+
+    PageMap::iterator   it = mPages.lower_bound( firstPage );
+
+    while ( (it != mPages.end()) && (it->first <= lastPage) )
+    {
+        delete it->second;
+        it = mPages.erase( it );
+    }
+}
+
+void MemoryCache::Clear()
+{
+    if ( mUsedThisStop )
+        mStats.Stops++;
+
+    mUsedThisStop = false;
+
+    DeletePages();
+}
+
+void MemoryCache::RecordHit( uint32_t bytesSaved )
+{
+    mStats.Hits++;
+    mStats.BytesSaved += bytesSaved;
+    mUsedThisStop = true;
+}
+
+void MemoryCache::RecordMiss()
+{
+    mStats.Misses++;
+    mUsedThisStop = true;
+}
+
+void MemoryCache::GetStats( MemoryCacheStats& stats )
+{
+    stats = mStats;
+}
+
+void MemoryCache::DeletePages()
+{
+    for ( PageMap::iterator it = mPages.begin();
+        it != mPages.end();
+        it++ )
+    {
+        delete it->second;
+    }
+
+    mPages.clear();
+}
@@ -0,0 +1,72 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+
+// Holds the pages of a debuggee's memory that were read while it's stopped.
+// The debuggee can't change its own memory until it runs again, so the pages
+// stay good until the machine continues or steps, and then they're all
+// thrown away. Writes by the debugger throw away the pages they touch.
+//
+// The pages hold clean memory: breakpoint instructions are already replaced
+// with the original bytes. So setting or removing a breakpoint doesn't
+// change them.
+
+class MemoryCache
+{
+public:
+    static const uint32_t   PageSize = 0x1000;
+
+    // Reads larger than this go straight to the process.
+    static const uint32_t   MaxReadSize = 16 * PageSize;
+
+    // When this many pages are cached, they're thrown away to make room.
+    static const uint32_t   MaxPages = 1024;
+
+    struct Page
+    {
+        bool        Readable;
+        uint8_t     Bytes[PageSize];
+    };
+
+private:
+    typedef std::map< Address, Page* >  PageMap;
+
+    PageMap             mPages;
+    MemoryCacheStats    mStats;
+    bool                mUsedThisStop;
+
+public:
+    MemoryCache();
+    ~MemoryCache();
+
+    static Address GetPageAddress( Address address )
+    {
+        return address & ~((Address) PageSize - 1);
+    }
+
+    // Returns NULL if the page isn't cached.
+    const Page* FindPage( Address pageAddr );
+
+    // Takes ownership of the page.
+    void AddPage( Address pageAddr, Page* page );
+
+    // Throws away the pages that overlap the range.
+    void Invalidate( Address address, uint32_t length );
+
+    // Throws away all the pages, and ends the stop they were read in.
+    void Clear();
+
+    void RecordHit( uint32_t bytesSaved );
+    void RecordMiss();
+
+    void GetStats( MemoryCacheStats& stats );
+
+private:
+    void DeletePages();
+};
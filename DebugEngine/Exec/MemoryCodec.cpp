@@ -0,0 +1,290 @@
+/*
+   Copyright (c) 2013 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "Common.h"
+#include "MemoryCodec.h"
+
+
+enum PackedPageTag
+{
+    PackedPage_Zero,
+    PackedPage_Raw,
+    PackedPage_Lz,
+};
+
+const uint32_t  MinMatch = 4;
+const uint32_t  MaxMatch = 0x7F + MinMatch;
+const uint32_t  MaxLiteralRun = 0x80;
+const int       HashBits = 12;
+const uint16_t  NoPos = 0xFFFF;
+
+C_ASSERT( PackedPageSize < NoPos );
+
+
+static uint32_t HashSeq( const uint8_t* p )
+{
+    uint32_t    seq = p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24);
+
+    return (seq * 2654435761U) >> (32 - HashBits);
+}
+
+static bool IsZeroPage( const uint8_t* page, uint32_t length )
+{
+    for ( uint32_t i = 0; i < length; i++ )
+    {
+        if ( page[i] != 0 )
+            return false;
+    }
+
+    return true;
+}
+
+static bool PutLiterals( 
+    const uint8_t* src, uint32_t count, uint8_t* dest, uint32_t destCap, uint32_t& destLen )
+{
+    while ( count > 0 )
+    {
+        uint32_t    run = (count > MaxLiteralRun) ? MaxLiteralRun : count;
+
+        if ( destCap - destLen < run + 1 )
+            return false;
+
+        dest[destLen++] = (uint8_t) (run - 1);
+        memcpy( dest + destLen, src, run );
+        destLen += run;
+        src += run;
+        count -= run;
+    }
+
+    return true;
+}
+
+// Returns the length of the LZ codes, or 0 if they don't fit in destCap.
+
+static uint32_t CompressPage( const uint8_t* src, uint32_t length, uint8_t* dest, uint32_t destCap )
+{
+    uint16_t    table[1 << HashBits];
+    uint32_t    destLen = 0;
+    uint32_t    litStart = 0;
+    uint32_t    i = 0;
+
+    for ( int j = 0; j < _countof( table ); j++ )
+        table[j] = NoPos;
+
+    while ( i + MinMatch <= length )
+    {
+        uint32_t    hash = HashSeq( src + i );
+        uint32_t    cand = table[hash];
+
+        table[hash] = (uint16_t) i;
+
+        if ( (cand == NoPos) || (memcmp( src + cand, src + i, MinMatch ) != 0) )
+        {
+            i++;
+            continue;
+        }
+
+        uint32_t    matchLen = MinMatch;
+
+        while ( (i + matchLen < length) 
+            && (matchLen < MaxMatch) 
+            && (src[cand + matchLen] == src[i + matchLen]) )
+            matchLen++;
+
+        if ( !PutLiterals( src + litStart, i - litStart, dest, destCap, destLen ) )
+            return 0;
+
+        if ( destCap - destLen < 3 )
+            return 0;
+
+        uint32_t    offset = i - cand;
+
+        dest[destLen++] = (uint8_t) (0x80 | (matchLen - MinMatch));
+        dest[destLen++] = (uint8_t) offset;
+        dest[destLen++] = (uint8_t) (offset >> 8);
+
+        i += matchLen;
+        litStart = i;
+    }
+
+    if ( !PutLiterals( src + litStart, length - litStart, dest, destCap, destLen ) )
+        return 0;
+
+    return destLen;
+}
+
+static bool DecompressPage( const uint8_t* src, uint32_t srcLen, uint8_t* dest, uint32_t length )
+{
+    uint32_t    in = 0;
+    uint32_t    out = 0;
+
+    while ( in < srcLen )
+    {
+        uint8_t     control = src[in++];
+
+        if ( control < 0x80 )
+        {
+            uint32_t    run = control + 1;
+
+            if ( (srcLen - in < run) || (length - out < run) )
+                return false;
+
+            memcpy( dest + out, src + in, run );
+            in += run;
+            out += run;
+        }
+        else
+        {
+            uint32_t    matchLen = (control & 0x7F) + MinMatch;
+
+            if ( srcLen - in < 2 )
+                return false;
+
+            uint32_t    offset = src[in] | (src[in + 1] << 8);
+
+            in += 2;
+
+            if ( (offset == 0) || (offset > out) || (length - out < matchLen) )
+                return false;
+
+            // the match can overlap what it writes, so copy a byte at a time
+            for ( uint32_t j = 0; j < matchLen; j++, out++ )
+                dest[out] = dest[out - offset];
+        }
+    }
+
+    return out == length;
+}
+
+
+uint32_t GetMaxPackedSize( uint32_t length )
+{
+    uint32_t    pageCount = (length / PackedPageSize) + ((length % PackedPageSize) != 0 ? 1 : 0);
+
+    // a page that can't be made smaller is sent raw with its tag byte
+    return length + pageCount;
+}
+
+HRESULT PackMemory( 
+    const uint8_t* mem, 
+    uint32_t length, 
+    uint8_t* packed, 
+    uint32_t packedCapacity, 
+    uint32_t& packedSize )
+{
+    _ASSERT( (mem != NULL) || (length == 0) );
+    _ASSERT( packed != NULL );
+
+    if ( packedCapacity < GetMaxPackedSize( length ) )
+        return E_INVALIDARG;
+
+    uint32_t    outLen = 0;
+
+    for ( uint32_t pageStart = 0; pageStart < length; pageStart += PackedPageSize )
+    {
+        const uint8_t*  page = mem + pageStart;
+        uint32_t        pageLen = length - pageStart;
+
+        if ( pageLen > PackedPageSize )
+            pageLen = PackedPageSize;
+
+        if ( IsZeroPage( page, pageLen ) )
+        {
+            packed[outLen++] = PackedPage_Zero;
+            continue;
+        }
+
+        // only use the LZ codes if they and their length are smaller than the raw page
+        uint32_t    lzLen = 0;
+
+        if ( pageLen > 3 )
+            lzLen = CompressPage( page, pageLen, packed + outLen + 3, pageLen - 3 );
+
+        if ( lzLen > 0 )
+        {
+            packed[outLen] = PackedPage_Lz;
+            packed[outLen + 1] = (uint8_t) lzLen;
+            packed[outLen + 2] = (uint8_t) (lzLen >> 8);
+            outLen += 3 + lzLen;
+        }
+        else
+        {
+            packed[outLen++] = PackedPage_Raw;
+            memcpy( packed + outLen, page, pageLen );
+            outLen += pageLen;
+        }
+    }
+
+    packedSize = outLen;
+    return S_OK;
+}
+
+HRESULT UnpackMemory( 
+    const uint8_t* packed, 
+    uint32_t packedSize, 
+    uint8_t* mem, 
+    uint32_t length )
+{
+    _ASSERT( (packed != NULL) || (packedSize == 0) );
+    _ASSERT( (mem != NULL) || (length == 0) );
+
+    uint32_t    in = 0;
+
+    for ( uint32_t pageStart = 0; pageStart < length; pageStart += PackedPageSize )
+    {
+        uint8_t*    page = mem + pageStart;
+        uint32_t    pageLen = length - pageStart;
+
+        if ( pageLen > PackedPageSize )
+            pageLen = PackedPageSize;
+
+        if ( in >= packedSize )
+            return E_FAIL;
+
+        switch ( packed[in++] )
+        {
+        case PackedPage_Zero:
+            memset( page, 0, pageLen );
+            break;
+
+        case PackedPage_Raw:
+            if ( packedSize - in < pageLen )
+                return E_FAIL;
+
+            memcpy( page, packed + in, pageLen );
+            in += pageLen;
+            break;
+
+        case PackedPage_Lz:
+            {
+                if ( packedSize - in < 2 )
+                    return E_FAIL;
+
+                uint32_t    lzLen = packed[in] | (packed[in + 1] << 8);
+
+                in += 2;
+
+                if ( packedSize - in < lzLen )
+                    return E_FAIL;
+
+                if ( !DecompressPage( packed + in, lzLen, page, pageLen ) )
+                    return E_FAIL;
+
+                in += lzLen;
+            }
+            break;
+
+        default:
+            return E_FAIL;
+        }
+    }
+
+    if ( in != packedSize )
+        return E_FAIL;
+
+    return S_OK;
+}
@@ -0,0 +1,44 @@
+/*
+   Copyright (c) 2013 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+
+// Packs blocks of debuggee memory to be sent over a slow link. The block is 
+// cut into pages. A page of all zeros is sent as one tag byte. Other pages 
+// are compressed with a small LZ codec, or sent as they are if that doesn't 
+// make them smaller.
+//
+// A packed page is a tag byte and then:
+//   PackedPage_Zero    nothing
+//   PackedPage_Raw     the page's bytes
+//   PackedPage_Lz      a 2 byte little endian length, and then that many 
+//                      bytes of LZ codes
+//
+// An LZ code starts with a control byte C:
+//   C < 0x80   C + 1 literal bytes follow
+//   C >= 0x80  copy (C & 0x7F) + 4 bytes starting the distance back given 
+//              by the 2 byte little endian offset that follows
+
+const uint32_t  PackedPageSize = 0x1000;
+
+// Returns the most bytes that packing a block of the given length can take.
+uint32_t GetMaxPackedSize( uint32_t length );
+
+HRESULT PackMemory( 
+    const uint8_t* mem, 
+    uint32_t length, 
+    uint8_t* packed, 
+    uint32_t packedCapacity, 
+    uint32_t& packedSize );
+
+// Fails if the packed bytes don't unpack to exactly length bytes.
+HRESULT UnpackMemory( 
+    const uint8_t* packed, 
+    uint32_t packedSize, 
+    uint8_t* mem, 
+    uint32_t length );
@@ -87,11 +87,5 @@ void ThreadX86Base::PopExpected()
 
 RangeStep* ThreadX86Base::AllocRange()
 {
-    RangeStep* range = new RangeStep();
-
-    if ( range == NULL )
-        return NULL;
-
-    memset( range, 0, sizeof *range );
-    return range;
+    return new RangeStep();
 }
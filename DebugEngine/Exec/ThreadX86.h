@@ -42,6 +42,27 @@ struct RangeStep
     AddressRange    Range;
     AddressRange    ThunkRange;
     bool            InThunk;
+
+    // The range is decoded the first time it's stepped. If all of its 
+    // instructions are known, then the debuggee can run through it with 
+    // breakpoints on the instructions that have to be stepped one at a time, 
+    // and on the targets of the branches that leave the range.
+    bool                    Decoded;
+    bool                    CanRun;
+    std::vector<Address>    InstStarts;     // sorted
+    std::vector<Address>    StepInsts;      // sorted
+    std::vector<Address>    StopAddrs;      // sorted
+
+    RangeStep()
+        :   InThunk( false ),
+            Decoded( false ),
+            CanRun( false )
+    {
+        Range.Begin = 0;
+        Range.End = 0;
+        ThunkRange.Begin = 0;
+        ThunkRange.End = 0;
+    }
 };
 
 struct ExpectedEvent
@@ -56,6 +77,7 @@ struct ExpectedEvent
     bool            ResumeThreads;
     bool            ClearTF;
     bool            RemoveBP;
+    bool            RemoveRangeBPs;     // the BPs at Range->StopAddrs
 };
 
 class ThreadX86Base
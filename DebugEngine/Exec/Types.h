@@ -30,3 +30,22 @@ enum ProbeRunMode
     ProbeRunMode_Wait,
     ProbeRunMode_WalkThunk,
 };
+
+// One block of a vectored memory read. The caller fills in Addr and Length, 
+// and the read fills in the rest like the matching arguments of ReadMemory. 
+// If the block couldn't be read at all, then both lengths are zero.
+struct ReadMemoryRange
+{
+    Address     Addr;
+    uint32_t    Length;
+    uint32_t    LengthRead;
+    uint32_t    LengthUnreadable;
+};
+
+struct MemoryCacheStats
+{
+    uint32_t    Stops;          // stops that read memory
+    uint32_t    Hits;           // pages found in the cache
+    uint32_t    Misses;         // pages read from the process
+    uint64_t    BytesSaved;     // bytes returned from cached pages
+};
@@ -104,6 +104,16 @@ namespace Mago
             uint32_t threadContextSize,
             IRegisterSet*& regSet ) = 0;
 
+        // Gets the PC, stack pointer, and frame pointer of a thread context.
+        // These are the registers that tiny register sets keep, and they 
+        // tell one stack frame apart from another.
+        virtual HRESULT GetFrameAddresses( 
+            const void* threadContext,
+            uint32_t threadContextSize,
+            Address64& pc,
+            Address64& stack,
+            Address64& frame ) = 0;
+
         virtual uint32_t GetRegisterGroupCount() = 0;
         virtual bool GetRegisterGroup( uint32_t index, RegGroup& group ) = 0;
 
@@ -8,7 +8,7 @@
 #include "Common.h"
 #include "ArchDataX64.h"
 #include "RegisterSet.h"
-#include "WinStackWalker.h"
+#include "StackWalkerX64.h"
 #include <MagoDECommon.h>
 #include <WinPlat.h>
 #include <MagoCVConst.h>
@@ -81,18 +81,13 @@ namespace
         if ( contextSize < sizeof( CONTEXT_X64 ) )
             return E_INVALIDARG;
 
-        const CONTEXT_X64*  context = (const CONTEXT_X64*) contextPtr;
-        UniquePtr<WindowsStackWalker> walker( new WindowsStackWalker(
-            IMAGE_FILE_MACHINE_AMD64,
-            context->Rip,
-            context->Rsp,
-            context->Rbp,
+        UniquePtr<StackWalkerX64> walker( new StackWalkerX64(
             processContext,
             readMemProc,
             funcTabProc,
             getModBaseProc ) );
 
-        hr = walker->Init( context, contextSize );
+        hr = walker->Init( contextPtr, contextSize );
         if ( FAILED( hr ) )
             return hr;
 
@@ -153,6 +148,28 @@ namespace
         return S_OK;
     }
 
+    HRESULT ArchDataX64::GetFrameAddresses( 
+        const void* threadContext,
+        uint32_t threadContextSize,
+        Address64& pc,
+        Address64& stack,
+        Address64& frame )
+    {
+        _ASSERT( threadContextSize >= sizeof( CONTEXT_X64 ) );
+        if ( threadContext == NULL )
+            return E_INVALIDARG;
+        if ( threadContextSize < sizeof( CONTEXT_X64 ) )
+            return E_INVALIDARG;
+
+        const CONTEXT_X64*  context = (const CONTEXT_X64*) threadContext;
+
+        pc = (Address64) context->Rip;
+        stack = (Address64) context->Rsp;
+        frame = (Address64) context->Rbp;
+
+        return S_OK;
+    }
+
     uint32_t ArchDataX64::GetRegisterGroupCount()
     {
         const RegGroupInternal* groups = NULL;
@@ -162,6 +162,28 @@ namespace
         return S_OK;
     }
 
+    HRESULT ArchDataX86::GetFrameAddresses( 
+        const void* threadContext,
+        uint32_t threadContextSize,
+        Address64& pc,
+        Address64& stack,
+        Address64& frame )
+    {
+        _ASSERT( threadContextSize >= sizeof( CONTEXT_X86 ) );
+        if ( threadContext == NULL )
+            return E_INVALIDARG;
+        if ( threadContextSize < sizeof( CONTEXT_X86 ) )
+            return E_INVALIDARG;
+
+        const CONTEXT_X86*  context = (const CONTEXT_X86*) threadContext;
+
+        pc = (Address64) context->Eip;
+        stack = (Address64) context->Esp;
+        frame = (Address64) context->Ebp;
+
+        return S_OK;
+    }
+
     uint32_t ArchDataX86::GetRegisterGroupCount()
     {
         const RegGroupInternal* groups = NULL;
@@ -39,6 +39,12 @@ namespace Mago
             const void* threadContext,
             uint32_t threadContextSize,
             IRegisterSet*& regSet );
+        virtual HRESULT GetFrameAddresses( 
+            const void* threadContext,
+            uint32_t threadContextSize,
+            Address64& pc,
+            Address64& stack,
+            Address64& frame );
 
         virtual uint32_t GetRegisterGroupCount();
         virtual bool GetRegisterGroup( uint32_t index, RegGroup& group );
@@ -0,0 +1,180 @@
+/*
+   Copyright (c) 2013 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "Common.h"
+#include "BulkMemoryReader.h"
+#include "..\Exec\MemoryCodec.h"
+
+
+namespace Mago
+{
+    static uint64_t GetMicros()
+    {
+        LARGE_INTEGER   freq = { 0 };
+        LARGE_INTEGER   count = { 0 };
+
+        QueryPerformanceFrequency( &freq );
+        QueryPerformanceCounter( &count );
+
+        if ( freq.QuadPart == 0 )
+            return 0;
+
+        return (count.QuadPart / freq.QuadPart) * 1000000 
+            + (count.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart;
+    }
+
+
+    BulkMemoryReader::BulkMemoryReader()
+    {
+        memset( &mStats, 0, sizeof mStats );
+    }
+
+    HRESULT BulkMemoryReader::Read( 
+        IBulkReadTransport* transport, 
+        Address64 address,
+        uint32_t length, 
+        uint32_t& lengthRead, 
+        uint32_t& lengthUnreadable, 
+        uint8_t* buffer )
+    {
+        _ASSERT( transport != NULL );
+        _ASSERT( buffer != NULL );
+        if ( transport == NULL || buffer == NULL )
+            return E_INVALIDARG;
+
+        HRESULT     hr = S_OK;
+        HRESULT     requestHr = S_OK;
+        uint32_t    slotCount = transport->GetSlotCount();
+        uint32_t    chunkCount = (length / ChunkSize) + ((length % ChunkSize) != 0 ? 1 : 0);
+        uint32_t    nextChunk = 0;      // the next one to request
+        uint32_t    doneChunk = 0;      // the next one to finish
+        bool        finished = false;   // the result is known
+        bool        requesting = true;
+        uint32_t    lenRead = 0;
+        uint32_t    lenUnreadable = 0;
+        uint64_t    packedBytes = 0;
+        uint64_t    startMicros = GetMicros();
+
+        _ASSERT( slotCount > 0 );
+
+        while ( doneChunk < chunkCount )
+        {
+            // keep every slot busy until the end of the block is known
+            while ( requesting 
+                && !finished 
+                && (nextChunk < chunkCount) 
+                && (nextChunk - doneChunk < slotCount) )
+            {
+                uint32_t    offset = nextChunk * ChunkSize;
+                uint32_t    chunkLen = ((length - offset) < ChunkSize) ? (length - offset) : ChunkSize;
+
+                requestHr = transport->BeginRead( nextChunk % slotCount, address + offset, chunkLen );
+                if ( FAILED( requestHr ) )
+                {
+                    // the chunks already requested can still end the block
+                    requesting = false;
+                    break;
+                }
+
+                nextChunk++;
+            }
+
+            if ( doneChunk == nextChunk )
+                break;
+
+            // the outstanding chunks are always taken back, even after the 
+            // result is known
+            BulkReadChunk   chunk = { 0 };
+            uint32_t        offset = doneChunk * ChunkSize;
+            uint32_t        chunkLen = ((length - offset) < ChunkSize) ? (length - offset) : ChunkSize;
+
+            transport->EndRead( doneChunk % slotCount, chunk );
+            doneChunk++;
+
+            if ( finished )
+                continue;
+
+            packedBytes += chunk.PackedSize;
+
+            if ( SUCCEEDED( chunk.Result ) 
+                && ((chunk.LengthRead > chunkLen) || (chunk.LengthUnreadable > chunkLen - chunk.LengthRead)) )
+                chunk.Result = E_UNEXPECTED;
+
+            if ( SUCCEEDED( chunk.Result ) && (lenUnreadable == 0) )
+            {
+                chunk.Result = UnpackMemory( 
+                    chunk.Packed, 
+                    chunk.PackedSize, 
+                    buffer + offset, 
+                    chunk.LengthRead );
+            }
+
+            if ( FAILED( chunk.Result ) )
+            {
+                hr = chunk.Result;
+                finished = true;
+            }
+            else if ( lenUnreadable == 0 )
+            {
+                lenRead += chunk.LengthRead;
+                lenUnreadable = chunk.LengthUnreadable;
+
+                if ( chunk.LengthRead + chunk.LengthUnreadable < chunkLen )
+                    finished = true;
+            }
+            else
+            {
+                // readable memory after unreadable memory isn't returned
+                if ( chunk.LengthRead > 0 )
+                {
+                    finished = true;
+                }
+                else
+                {
+                    lenUnreadable += chunk.LengthUnreadable;
+
+                    if ( chunk.LengthUnreadable < chunkLen )
+                        finished = true;
+                }
+            }
+        }
+
+        RecordRead( doneChunk, lenRead, packedBytes, GetMicros() - startMicros );
+
+        // Only a short chunk ends the block early. If the chunks ran out 
+        // because the transport failed, then what was read isn't all there 
+        // is, so the read fails rather than come back short.
+        if ( SUCCEEDED( hr ) && !finished && (doneChunk < chunkCount) )
+            hr = requestHr;
+
+        if ( FAILED( hr ) )
+            return hr;
+
+        lengthRead = lenRead;
+        lengthUnreadable = lenUnreadable;
+
+        return S_OK;
+    }
+
+    void BulkMemoryReader::GetStats( BulkReadStats& stats )
+    {
+        GuardedArea guard( mGuard );
+
+        stats = mStats;
+    }
+
+    void BulkMemoryReader::RecordRead( uint32_t chunks, uint32_t bytes, uint64_t packedBytes, uint64_t micros )
+    {
+        GuardedArea guard( mGuard );
+
+        mStats.Reads++;
+        mStats.Chunks += chunks;
+        mStats.Bytes += bytes;
+        mStats.PackedBytes += packedBytes;
+        mStats.Micros += micros;
+    }
+}
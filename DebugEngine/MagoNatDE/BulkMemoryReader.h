@@ -0,0 +1,81 @@
+/*
+   Copyright (c) 2013 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+
+namespace Mago
+{
+    struct BulkReadChunk
+    {
+        HRESULT         Result;
+        uint32_t        LengthRead;
+        uint32_t        LengthUnreadable;
+        uint32_t        PackedSize;
+        const uint8_t*  Packed;
+    };
+
+    // Carries the chunk reads of a BulkMemoryReader. Each slot can hold one 
+    // outstanding read, whose memory comes back packed as described in 
+    // MemoryCodec.h.
+
+    class IBulkReadTransport
+    {
+    public:
+        virtual uint32_t GetSlotCount() = 0;
+
+        virtual HRESULT BeginRead( uint32_t slot, Address64 address, uint32_t length ) = 0;
+
+        // Waits for the read in the slot to finish. The chunk's packed bytes 
+        // stay good until the slot is used again.
+        virtual void EndRead( uint32_t slot, BulkReadChunk& chunk ) = 0;
+    };
+
+    struct BulkReadStats
+    {
+        uint32_t    Reads;
+        uint32_t    Chunks;
+        uint64_t    Bytes;
+        uint64_t    PackedBytes;
+        uint64_t    Micros;
+    };
+
+
+    // Reads a large block of memory over a slow link. The block is cut into 
+    // chunks, and as many of them as the transport has slots are requested 
+    // at once, so that the link doesn't sit idle for a round trip between 
+    // chunks. Each chunk is unpacked as it comes in.
+    //
+    // The result is the same as a plain ReadMemory: the readable bytes at 
+    // the start, and the unreadable ones right after them. Once a chunk comes 
+    // back short, no more chunks are requested. If a chunk fails, or the 
+    // transport fails before the end of the block is known, the read fails.
+
+    class BulkMemoryReader
+    {
+        BulkReadStats   mStats;
+        Guard           mGuard;
+
+    public:
+        static const uint32_t   ChunkSize = 0x10000;
+
+        BulkMemoryReader();
+
+        HRESULT Read( 
+            IBulkReadTransport* transport, 
+            Address64 address,
+            uint32_t length, 
+            uint32_t& lengthRead, 
+            uint32_t& lengthUnreadable, 
+            uint8_t* buffer );
+
+        void GetStats( BulkReadStats& stats );
+
+    private:
+        void RecordRead( uint32_t chunks, uint32_t bytes, uint64_t packedBytes, uint64_t micros );
+    };
+}
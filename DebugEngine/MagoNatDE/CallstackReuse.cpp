@@ -0,0 +1,120 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "Common.h"
+#include "CallstackReuse.h"
+
+
+namespace Mago
+{
+    CallstackReuse::CallstackReuse( const FrameKeyList& lastKeys, uint32_t ptrSize )
+        :   mLastKeys( lastKeys ),
+            mPtrSize( ptrSize ),
+            mLastIndex( 0 ),
+            mEnabled( true )
+    {
+        _ASSERT( (ptrSize > 0) && (ptrSize <= sizeof( Address64 )) );
+    }
+
+    bool CallstackReuse::FindFrame( 
+        const FrameKey& key, 
+        IReturnAddressReader* reader, 
+        size_t& lastIndex )
+    {
+        _ASSERT( reader != NULL );
+
+        if ( !mEnabled )
+            return false;
+
+        if ( !FindLastFrame( key, mLastIndex ) )
+            return false;
+
+        if ( !CheckReturnAddresses( mLastIndex, reader ) )
+        {
+            // the thread left the frame and came back to the same place, 
+            // so the frames under it can't be trusted
+            mEnabled = false;
+            return false;
+        }
+
+        lastIndex = mLastIndex;
+        return true;
+    }
+
+    // Looks for the frame in the last callstack, starting at index and going
+    // up the stack. The frames of a walk come in the same order, so each 
+    // search picks up where the one before it left off.
+
+    bool CallstackReuse::FindLastFrame( const FrameKey& key, size_t& index )
+    {
+        for ( ; index < mLastKeys.size(); index++ )
+        {
+            const FrameKey& lastKey = mLastKeys[index];
+
+            // the frame is younger than any left in the last callstack, 
+            // but the next frames of the walk might still be found
+            if ( lastKey.Stack > key.Stack )
+                return false;
+
+            if ( lastKey.Stack == key.Stack )
+            {
+                return (index >= FullFrameCount)
+                    && (lastKey.PC == key.PC)
+                    && (lastKey.Frame == key.Frame);
+            }
+        }
+
+        return false;
+    }
+
+    // A frame found in the last callstack could have been returned from and 
+    // called again from somewhere else. So check that the older frames' 
+    // return addresses are still on the stack, each one just under the stack
+    // pointer of the frame it returns to. They're all read in one go.
+
+    bool CallstackReuse::CheckReturnAddresses( size_t index, IReturnAddressReader* reader )
+    {
+        const size_t    firstIndex = index + 1;
+        const size_t    count = mLastKeys.size() - firstIndex;
+
+        if ( count == 0 )
+            return true;
+
+        HRESULT                         hr = S_OK;
+        std::vector<ReadMemoryRange64>  ranges( count );
+        std::vector<uint8_t*>           buffers( count );
+        std::vector<uint8_t>            retAddrs( count * mPtrSize );
+
+        for ( size_t i = 0; i < count; i++ )
+        {
+            ranges[i].Addr = mLastKeys[firstIndex + i].Stack - mPtrSize;
+            ranges[i].Length = mPtrSize;
+            ranges[i].LengthRead = 0;
+            ranges[i].LengthUnreadable = 0;
+            buffers[i] = &retAddrs[i * mPtrSize];
+        }
+
+        hr = reader->ReadMemoryV( (uint32_t) count, &ranges[0], &buffers[0] );
+        if ( FAILED( hr ) )
+            return false;
+
+        for ( size_t i = 0; i < count; i++ )
+        {
+            Address64   retAddr = 0;
+
+            if ( ranges[i].LengthRead < mPtrSize )
+                return false;
+
+            memcpy( &retAddr, buffers[i], mPtrSize );
+
+            if ( retAddr != mLastKeys[firstIndex + i].PC )
+                return false;
+        }
+
+        return true;
+    }
+}
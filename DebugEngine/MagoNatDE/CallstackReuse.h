@@ -0,0 +1,78 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+
+namespace Mago
+{
+    // A frame's PC, stack pointer, and frame pointer. Past the first frames 
+    // of a callstack, these are all that a frame's register set holds, so 
+    // two frames with the same key are the same.
+
+    struct FrameKey
+    {
+        Address64   PC;
+        Address64   Stack;
+        Address64   Frame;
+    };
+
+    typedef std::vector<FrameKey> FrameKeyList;
+
+    struct CallstackStats
+    {
+        uint32_t    Walks;
+        uint32_t    Frames;
+        uint32_t    ReusedFrames;
+    };
+
+    // Reads the return addresses that CallstackReuse checks, all in one go.
+
+    class IReturnAddressReader
+    {
+    public:
+        virtual HRESULT ReadMemoryV( 
+            uint32_t count, 
+            ReadMemoryRange64* ranges, 
+            uint8_t** buffers ) = 0;
+    };
+
+
+    // Finds where a new walk of a thread's stack joins the callstack walked 
+    // last time. Once a walked frame is found in the last callstack, and the 
+    // frames older than it are still on the stack, the walk can stop, and 
+    // take the rest of its frames from the last callstack.
+    //
+    // The frames of a walk have to be passed in the order they're walked.
+
+    class CallstackReuse
+    {
+        const FrameKeyList& mLastKeys;
+        uint32_t            mPtrSize;
+        size_t              mLastIndex;
+        bool                mEnabled;
+
+    public:
+        // The top frame and its caller have full register sets, which 
+        // change from stop to stop. Only the frames after them are 
+        // described completely by their frame keys.
+        static const size_t FullFrameCount = 2;
+
+        CallstackReuse( const FrameKeyList& lastKeys, uint32_t ptrSize );
+
+        // Returns true if the walked frame and the ones older than it can 
+        // be taken from the last callstack, starting at lastIndex.
+        bool FindFrame( 
+            const FrameKey& key, 
+            IReturnAddressReader* reader, 
+            size_t& lastIndex );
+
+    private:
+        bool FindLastFrame( const FrameKey& key, size_t& index );
+        bool CheckReturnAddresses( size_t index, IReturnAddressReader* reader );
+    };
+}
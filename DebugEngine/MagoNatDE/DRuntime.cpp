@@ -608,6 +608,7 @@ namespace Mago
 
         const int MAX_AA_SEARCH_NODES = 1000000;
         const int AAA_BUF_SIZE = sizeof( aaA64 ) + 4 * sizeof( MagoEE::DataValue );
+        const uint32_t ProbeBatchSize = 8;
 
         const int HASH_EMPTY = 0;
         //const int HASH_DELETED = 0x1;
@@ -631,59 +632,96 @@ namespace Mago
 
         valueAddr = 0;
 
-        for ( int j = 0; j < MAX_AA_SEARCH_NODES; bucketIndex = ( bucketIndex + ++j ) % bb.buckets.length )
+        HRESULT hr = S_OK;
+        bool    done = false;
+
+        for ( int j = 0; (j < MAX_AA_SEARCH_NODES) && !done; )
         {
-            uint64_t    bucketHash;
-            HRESULT hr = ReadAddress( bb.buckets.ptr, 2 * bucketIndex, bucketHash );
+            // The buckets to probe are known ahead of time, so read the hash 
+            // and entry of a batch of them in one go. They're next to each 
+            // other in each bucket.
+            uint64_t            slots[ProbeBatchSize][2] = { 0 };
+            ReadMemoryRange64   ranges[ProbeBatchSize] = { 0 };
+            uint8_t*            buffers[ProbeBatchSize] = { 0 };
+            uint32_t            probeCount = 0;
+
+            for ( ; (probeCount < ProbeBatchSize) && (j + (int) probeCount < MAX_AA_SEARCH_NODES); probeCount++ )
+            {
+                ranges[probeCount].Addr = bb.buckets.ptr + (2 * bucketIndex * mPtrSize);
+                ranges[probeCount].Length = 2 * mPtrSize;
+                buffers[probeCount] = (uint8_t*) slots[probeCount];
+
+                bucketIndex = (bucketIndex + j + probeCount + 1) % bb.buckets.length;
+            }
+
+            hr = mDebugger->ReadMemoryV( mCoreProc.Get(), probeCount, ranges, buffers );
             if ( FAILED( hr ) )
                 return hr;
 
-            if ( bucketHash == HASH_EMPTY )
-                break;
+            for ( uint32_t i = 0; (i < probeCount) && !done; i++, j++ )
+            {
+                uint64_t    bucketHash;
 
-            if ( bucketHash != hash )
-                continue;
+                if ( ranges[i].LengthRead < 2 * mPtrSize )
+                    return HRESULT_FROM_WIN32( ERROR_PARTIAL_COPY );
 
-            hr = ReadAddress( bb.buckets.ptr, 2 * bucketIndex + 1, aaAAddr );
-            if ( FAILED( hr ) )
-                return hr;
+                if ( mPtrSize == 4 )
+                {
+                    bucketHash = ((uint32_t*) slots[i])[0];
+                    aaAAddr = ((uint32_t*) slots[i])[1];
+                }
+                else
+                {
+                    bucketHash = slots[i][0];
+                    aaAAddr = slots[i][1];
+                }
 
-            MagoEE::DataValue nodeKey = { 0 };
-            bool     found = false;
+                if ( bucketHash == HASH_EMPTY )
+                {
+                    done = true;
+                    break;
+                }
 
-            hr = ReadMemory( aaAAddr, bb.keysz, aaa );
-            if ( FAILED( hr ) )
-                return hr;
+                if ( bucketHash != hash )
+                    continue;
 
-            if ( key._Type->AsTypeStruct() != NULL )
-            {
-                found = EqualStruct( key, keyBuf, aaa );
-            }
-            else if ( key._Type->IsSArray() )
-            {
-                found = EqualSArray( key, keyBuf, aaa );
-            }
-            else if ( key._Type->IsDArray() )
-            {
-                hr = FromRawValue( aaa, key._Type, nodeKey );
-                if ( FAILED( hr ) )
-                    return hr;
+                MagoEE::DataValue nodeKey = { 0 };
+                bool     found = false;
 
-                found = EqualDArray( key, keyBuf, nodeArrayBuf, nodeKey );
-            }
-            else
-            {
-                hr = FromRawValue( aaa, key._Type, nodeKey );
+                hr = ReadMemory( aaAAddr, bb.keysz, aaa );
                 if ( FAILED( hr ) )
                     return hr;
 
-                found = EqualValue( key._Type, key.Value, nodeKey );
-            }
+                if ( key._Type->AsTypeStruct() != NULL )
+                {
+                    found = EqualStruct( key, keyBuf, aaa );
+                }
+                else if ( key._Type->IsSArray() )
+                {
+                    found = EqualSArray( key, keyBuf, aaa );
+                }
+                else if ( key._Type->IsDArray() )
+                {
+                    hr = FromRawValue( aaa, key._Type, nodeKey );
+                    if ( FAILED( hr ) )
+                        return hr;
 
-            if ( found )
-            {
-                valueAddr = aaAAddr + bb.valoff;
-                break;
+                    found = EqualDArray( key, keyBuf, nodeArrayBuf, nodeKey );
+                }
+                else
+                {
+                    hr = FromRawValue( aaa, key._Type, nodeKey );
+                    if ( FAILED( hr ) )
+                        return hr;
+
+                    found = EqualValue( key._Type, key.Value, nodeKey );
+                }
+
+                if ( found )
+                {
+                    valueAddr = aaAAddr + bb.valoff;
+                    done = true;
+                }
             }
         }
 
@@ -1071,7 +1109,6 @@ namespace Mago
         _ASSERT( pbstrInfo != NULL );
 
         Throwable64 throwable;
-        uint32_t read, unread;
         HRESULT hr = S_OK;
     
         hr = ReadThrowable( addr, throwable );
@@ -1087,29 +1124,42 @@ namespace Mago
         else
         {
             CAutoVectorPtr<char>    buf;
+            CAutoVectorPtr<char>    strBuf;
             if ( !buf.Allocate( (size_t) (throwable.msg.length + throwable.file.length + 30) ) )
                 return E_OUTOFMEMORY;
+            if ( !strBuf.Allocate( (size_t) (throwable.msg.length + throwable.file.length + 1) ) )
+                return E_OUTOFMEMORY;
+
+            // read the message and file name together
+            ReadMemoryRange64   ranges[2] = { 0 };
+            uint8_t*            strs[2] = { (uint8_t*) (char*) strBuf, (uint8_t*) (char*) strBuf + throwable.msg.length };
+
+            ranges[0].Addr = throwable.msg.ptr;
+            ranges[0].Length = (uint32_t) throwable.msg.length;
+            ranges[1].Addr = throwable.file.ptr;
+            ranges[1].Length = (uint32_t) throwable.file.length;
+
+            hr = mDebugger->ReadMemoryV( mCoreProc, _countof( ranges ), ranges, strs );
+            if ( FAILED( hr ) )
+                return hr;
+
+            // a block that failed comes back with both lengths zero
             char* p = buf;
-            if ( throwable.msg.length > 0 )
+            if ( (ranges[0].LengthRead + ranges[0].LengthUnreadable) > 0 )
             {
-                hr = mDebugger->ReadMemory( mCoreProc, throwable.msg.ptr, (uint32_t) throwable.msg.length, 
-                                            read, unread, (uint8_t*) p );
-                if ( SUCCEEDED( hr ) )
-                {
-                    p += read;    // read at most throwable.msg.length
-                    *p++ = ' ';
-                }
+                memcpy( p, strs[0], ranges[0].LengthRead );
+                p += ranges[0].LengthRead;    // read at most throwable.msg.length
+                *p++ = ' ';
             }
             if ( throwable.file.length > 0 )
             {
                 *p++ = 'a';
                 *p++ = 't';
                 *p++ = ' ';
-                hr = mDebugger->ReadMemory( mCoreProc, throwable.file.ptr, (uint32_t) throwable.file.length, 
-                                            read, unread, (uint8_t*) p );
-                if ( SUCCEEDED( hr ) )
+                if ( (ranges[1].LengthRead + ranges[1].LengthUnreadable) > 0 )
                 {
-                    p += read;    // read at most throwable.file.length
+                    memcpy( p, strs[1], ranges[1].LengthRead );
+                    p += ranges[1].LengthRead;    // read at most throwable.file.length
                     *p++ = '(';
                     p += sprintf_s( p, 12, "%d", (uint32_t) throwable.line );
                     *p++ = ')';
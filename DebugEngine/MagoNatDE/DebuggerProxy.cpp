@@ -117,6 +117,8 @@ namespace Mago
 
         IProcess* execProc = ((LocalProcess*) process)->GetExecProcess();
 
+        mContextCache.Clear();
+
         return mExecThread.Terminate( execProc );
     }
 
@@ -127,6 +129,8 @@ namespace Mago
 
         IProcess* execProc = ((LocalProcess*) process)->GetExecProcess();
 
+        mContextCache.Clear();
+
         return mExecThread.Detach( execProc );
     }
 
@@ -137,6 +141,8 @@ namespace Mago
 
         IProcess* execProc = ((LocalProcess*) process)->GetExecProcess();
 
+        mContextCache.Clear();
+
         return mExecThread.ResumeLaunchedProcess( execProc );
     }
 
@@ -162,6 +168,43 @@ namespace Mago
             buffer );
     }
 
+    HRESULT DebuggerProxy::ReadMemoryV( 
+        ICoreProcess* process, 
+        uint32_t rangeCount, 
+        ReadMemoryRange64* ranges, 
+        uint8_t** buffers )
+    {
+        if ( process->GetProcessType() != CoreProcess_Local )
+            return E_FAIL;
+
+        if ( rangeCount == 0 )
+            return S_OK;
+
+        HRESULT     hr = S_OK;
+        IProcess*   execProc = ((LocalProcess*) process)->GetExecProcess();
+        std::vector<ReadMemoryRange>    execRanges( rangeCount );
+
+        for ( uint32_t i = 0; i < rangeCount; i++ )
+        {
+            execRanges[i].Addr = (Address) ranges[i].Addr;
+            execRanges[i].Length = ranges[i].Length;
+            execRanges[i].LengthRead = 0;
+            execRanges[i].LengthUnreadable = 0;
+        }
+
+        hr = mExecThread.ReadMemoryV( execProc, rangeCount, &execRanges[0], buffers );
+        if ( FAILED( hr ) )
+            return hr;
+
+        for ( uint32_t i = 0; i < rangeCount; i++ )
+        {
+            ranges[i].LengthRead = execRanges[i].LengthRead;
+            ranges[i].LengthUnreadable = execRanges[i].LengthUnreadable;
+        }
+
+        return S_OK;
+    }
+
     HRESULT DebuggerProxy::WriteMemory( 
         ICoreProcess* process, 
         Address64 address,
@@ -209,6 +252,8 @@ namespace Mago
 
         IProcess* execProc = ((LocalProcess*) process)->GetExecProcess();
 
+        mContextCache.Clear();
+
         return mExecThread.StepOut( execProc, (Address) targetAddr, handleException );
     }
 
@@ -219,6 +264,8 @@ namespace Mago
 
         IProcess* execProc = ((LocalProcess*) process)->GetExecProcess();
 
+        mContextCache.Clear();
+
         return mExecThread.StepInstruction( execProc, stepIn, handleException );
     }
 
@@ -231,6 +278,8 @@ namespace Mago
         IProcess* execProc = ((LocalProcess*) process)->GetExecProcess();
         AddressRange        range32 = { (Address) range.Begin, (Address) range.End };
 
+        mContextCache.Clear();
+
         return mExecThread.StepRange( execProc, stepIn, range32, handleException );
     }
 
@@ -241,6 +290,8 @@ namespace Mago
 
         IProcess* execProc = ((LocalProcess*) process)->GetExecProcess();
 
+        mContextCache.Clear();
+
         return mExecThread.Continue( execProc, handleException );
     }
 
@@ -251,6 +302,8 @@ namespace Mago
 
         IProcess* execProc = ((LocalProcess*) process)->GetExecProcess();
 
+        mContextCache.Clear();
+
         return mExecThread.Execute( execProc, handleException );
     }
 
@@ -289,15 +342,32 @@ namespace Mago
         if ( context.IsEmpty() )
             return E_OUTOFMEMORY;
 
-        hr = mExecThread.GetThreadContext( 
-            execProc, 
+        if ( !mContextCache.Find( 
+            execProc->GetId(), 
             execThread->GetId(), 
-            contextSpec.FeatureMask,
-            contextSpec.ExtFeatureMask,
-            context.Get(), 
-            contextSpec.Size );
-        if ( FAILED( hr ) )
-            return hr;
+            contextSpec.FeatureMask, 
+            contextSpec.ExtFeatureMask, 
+            contextSpec.Size, 
+            context.Get() ) )
+        {
+            hr = mExecThread.GetThreadContext( 
+                execProc, 
+                execThread->GetId(), 
+                contextSpec.FeatureMask,
+                contextSpec.ExtFeatureMask,
+                context.Get(), 
+                contextSpec.Size );
+            if ( FAILED( hr ) )
+                return hr;
+
+            mContextCache.Add( 
+                execProc->GetId(), 
+                execThread->GetId(), 
+                contextSpec.FeatureMask, 
+                contextSpec.ExtFeatureMask, 
+                context.Get(), 
+                contextSpec.Size );
+        }
 
         hr = mArch->BuildRegisterSet( context.Get(), contextSpec.Size, regSet );
         if ( FAILED( hr ) )
@@ -333,6 +403,8 @@ namespace Mago
         if ( FAILED( hr ) )
             return hr;
 
+        mContextCache.Invalidate( execProc->GetId(), execThread->GetId() );
+
         return S_OK;
     }
 
@@ -431,12 +503,23 @@ namespace Mago
             exceptRec64.ExceptionInformation[i] = exceptRec->ExceptionInformation[i];
         }
 
-        return mCallback->OnException( process->GetId(), threadId, firstChance, &exceptRec64 );
+        RunMode mode = mCallback->OnException( process->GetId(), threadId, firstChance, &exceptRec64 );
+
+        // the debuggee runs without being told to
+        if ( mode == RunMode_Run )
+            mContextCache.Clear();
+
+        return mode;
     }
 
     RunMode DebuggerProxy::OnBreakpoint( IProcess* process, uint32_t threadId, Address address, bool embedded )
     {
-        return mCallback->OnBreakpoint( process->GetId(), threadId, address, embedded );
+        RunMode mode = mCallback->OnBreakpoint( process->GetId(), threadId, address, embedded );
+
+        if ( mode == RunMode_Run )
+            mContextCache.Clear();
+
+        return mode;
     }
 
     void DebuggerProxy::OnStepComplete( IProcess* process, uint32_t threadId )
@@ -464,6 +547,9 @@ namespace Mago
         thunkRange.Begin = (Address) thunkRange64.Begin;
         thunkRange.End = (Address) thunkRange64.End;
 
+        if ( (mode == ProbeRunMode_Run) || (mode == ProbeRunMode_WalkThunk) )
+            mContextCache.Clear();
+
         return mode;
     }
 
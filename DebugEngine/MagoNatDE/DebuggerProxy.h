@@ -8,6 +8,7 @@
 #pragma once
 
 #include "IDebuggerProxy.h"
+#include "ThreadContextCache.h"
 #include "..\Exec\DebuggerProxy.h"
 
 #include <string>
@@ -26,6 +27,7 @@ namespace Mago
         MagoCore::DebuggerProxy mExecThread;
         RefPtr<ArchData>        mArch;
         RefPtr<EventCallback>   mCallback;
+        ThreadContextCache      mContextCache;
 
     public:
         DebuggerProxy();
@@ -53,6 +55,12 @@ namespace Mago
             uint32_t& lengthUnreadable, 
             uint8_t* buffer );
 
+        HRESULT ReadMemoryV( 
+            ICoreProcess* process, 
+            uint32_t rangeCount, 
+            ReadMemoryRange64* ranges, 
+            uint8_t** buffers );
+
         HRESULT WriteMemory( 
             ICoreProcess* process, 
             Address64 address,
@@ -0,0 +1,149 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "Common.h"
+#include "DeclCache.h"
+#include "ExprContext.h"
+
+
+namespace Mago
+{
+    DeclCache::DeclCache()
+        :   mDisposed( false )
+    {
+        memset( &mStats, 0, sizeof mStats );
+    }
+
+    DeclCache::~DeclCache()
+    {
+    }
+
+    bool DeclCache::FindDecl( MagoST::SymHandle handle, MagoEE::Declaration*& decl )
+    {
+        GuardedArea guard( mGuard );
+
+        DeclMap::iterator   it = mDecls.find( handle );
+
+        if ( it == mDecls.end() )
+        {
+            mStats.DeclMisses++;
+            return false;
+        }
+
+        mStats.DeclHits++;
+        decl = it->second;
+        decl->AddRef();
+        return true;
+    }
+
+    bool DeclCache::FindType( MagoST::TypeIndex typeIndex, MagoEE::Type*& type )
+    {
+        GuardedArea guard( mGuard );
+
+        TypeMap::iterator   it = mTypes.find( typeIndex );
+
+        if ( it == mTypes.end() )
+        {
+            mStats.TypeMisses++;
+            return false;
+        }
+
+        mStats.TypeHits++;
+        type = it->second;
+        type->AddRef();
+        return true;
+    }
+
+    void DeclCache::AddDecl( MagoST::SymHandle handle, MagoEE::Declaration* decl )
+    {
+        _ASSERT( decl != NULL );
+        GuardedArea guard( mGuard );
+
+        mDecls[handle] = decl;
+    }
+
+    void DeclCache::AddType( MagoST::TypeIndex typeIndex, MagoEE::Type* type )
+    {
+        _ASSERT( type != NULL );
+        GuardedArea guard( mGuard );
+
+        mTypes[typeIndex] = type;
+    }
+
+    HRESULT DeclCache::GetSymbolStore( Module* module, int ptrSize, ExprContext*& symStore )
+    {
+        _ASSERT( module != NULL );
+        GuardedArea guard( mGuard );
+
+        if ( mSymStore == NULL )
+        {
+            HRESULT                 hr = S_OK;
+            RefPtr<ExprContext>     newStore;
+
+            hr = MakeCComObject( newStore );
+            if ( FAILED( hr ) )
+                return hr;
+
+            hr = newStore->InitSymbolStore( module, ptrSize );
+            if ( FAILED( hr ) )
+                return hr;
+
+            // a disposed module doesn't keep it, so that it doesn't hold the module
+            if ( mDisposed )
+            {
+                symStore = newStore.Detach();
+                return S_OK;
+            }
+
+            mSymStore = newStore;
+        }
+
+        symStore = mSymStore;
+        symStore->AddRef();
+        return S_OK;
+    }
+
+    void DeclCache::Clear()
+    {
+        // release the objects outside of the lock, because they can reach
+        // back into the module that owns this cache
+
+        DeclMap             decls;
+        TypeMap             types;
+        RefPtr<ExprContext> symStore;
+
+        {
+            GuardedArea guard( mGuard );
+
+            mDecls.swap( decls );
+            mTypes.swap( types );
+            symStore.Attach( mSymStore.Detach() );
+        }
+
+        // the store's types refer to the store, and it stops adding to the cache
+        if ( symStore != NULL )
+            symStore->Dispose();
+    }
+
+    void DeclCache::Dispose()
+    {
+        {
+            GuardedArea guard( mGuard );
+
+            mDisposed = true;
+        }
+
+        Clear();
+    }
+
+    void DeclCache::GetStats( DeclCacheStats& stats )
+    {
+        GuardedArea guard( mGuard );
+
+        stats = mStats;
+    }
+}
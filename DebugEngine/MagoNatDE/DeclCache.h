@@ -0,0 +1,82 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+#include <MagoEED.h>
+
+
+namespace Mago
+{
+    class ExprContext;
+    class Module;
+
+
+    struct DeclCacheStats
+    {
+        uint32_t    DeclHits;
+        uint32_t    DeclMisses;
+        uint32_t    TypeHits;
+        uint32_t    TypeMisses;
+    };
+
+
+    // Holds the declarations and types made from a module's symbols, so that 
+    // looking up the same symbols again, in any frame and after any step, 
+    // doesn't have to decode the CodeView records and rebuild the type graph.
+    //
+    // Declarations and types refer to the context that made them. So the 
+    // cached ones are made by the module's symbol store, a context that 
+    // isn't in any frame or thread, and only the ones that don't depend on 
+    // a frame or thread are cached. The store holds the module, so the 
+    // module has to clear the cache when it unloads.
+
+    class DeclCache
+    {
+        struct SymHandleLess
+        {
+            // the symbol stores fill in the whole handle
+            bool operator()( const MagoST::SymHandle& left, const MagoST::SymHandle& right ) const
+            {
+                if ( left.unused1 != right.unused1 )
+                    return left.unused1 < right.unused1;
+                return left.unused2 < right.unused2;
+            }
+        };
+
+        typedef std::map< MagoST::SymHandle, RefPtr<MagoEE::Declaration>, SymHandleLess >   DeclMap;
+        typedef std::map< MagoST::TypeIndex, RefPtr<MagoEE::Type> >                         TypeMap;
+
+        DeclMap             mDecls;
+        TypeMap             mTypes;
+        DeclCacheStats      mStats;
+        RefPtr<ExprContext> mSymStore;
+        bool                mDisposed;
+        Guard               mGuard;
+
+    public:
+        DeclCache();
+        ~DeclCache();
+
+        // These return true and an added reference if the handle was cached.
+        bool FindDecl( MagoST::SymHandle handle, MagoEE::Declaration*& decl );
+        bool FindType( MagoST::TypeIndex typeIndex, MagoEE::Type*& type );
+
+        void AddDecl( MagoST::SymHandle handle, MagoEE::Declaration* decl );
+        void AddType( MagoST::TypeIndex typeIndex, MagoEE::Type* type );
+
+        // Returns the context that makes the cached declarations and types. 
+        // It's made the first time it's asked for.
+        HRESULT GetSymbolStore( Module* module, int ptrSize, ExprContext*& symStore );
+
+        // Lets go of the declarations, types and symbol store.
+        void Clear();
+        // Clears the cache, and doesn't keep a symbol store any more.
+        void Dispose();
+        void GetStats( DeclCacheStats& stats );
+    };
+}
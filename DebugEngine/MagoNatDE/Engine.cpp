@@ -759,9 +759,13 @@ Error:
 
     void Engine::DeleteProgram( Program* prog )
     {
-        GuardedArea guard( mProgsGuard );
-        mProgs.erase( prog->GetCoreProcess()->GetPid() );
+        {
+            GuardedArea guard( mProgsGuard );
+            mProgs.erase( prog->GetCoreProcess()->GetPid() );
+        }
 
+        // disposing modules waits for their symbol loads, whose callbacks 
+        // bind breakpoints, and binding can look for programs
         prog->Dispose();
     }
 
@@ -811,6 +815,13 @@ Error:
         mBindBPGuard.Leave();
     }
 
+    bool Engine::HasPendingBPs()
+    {
+        GuardedArea guard( mPendingBPGuard );
+
+        return !mBPs.empty();
+    }
+
     HRESULT Engine::BindPendingBPsToModule( Module* mod, Program* prog )
     {
         _ASSERT( mod != NULL );
@@ -144,6 +144,9 @@ namespace Mago
         bool FindExceptionInfo( const GUID& guid, DWORD code, ExceptionInfo& excInfo );
         bool FindExceptionInfo( const GUID& guid, LPCOLESTR name, ExceptionInfo& excInfo );
 
+        // Returns true if there are any pending breakpoints, which could bind 
+        // to a module that's loading.
+        bool HasPendingBPs();
         HRESULT BindPendingBPsToModule( Module* mod, Program* prog );
         HRESULT UnbindPendingBPsFromModule( Module* mod, Program* prog );
 
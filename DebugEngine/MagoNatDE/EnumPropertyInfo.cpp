@@ -83,17 +83,22 @@ namespace Mago
         MagoEE::EvalOptions options = { 0 };
         wstring     name;
         wstring     fullName;
+        wstring*    fullNameOut = NULL;
 
         if ( celt > countLeft )
             celt = countLeft;
 
+        // a property needs the full name for its own children
+        if ( (mFields & (DEBUGPROP_INFO_FULLNAME | DEBUGPROP_INFO_PROP)) != 0 )
+            fullNameOut = &fullName;
+
         for ( i = 0; i < celt; i++ )
         {
             // make sure this is in the loop so it gets cleaned up every time
             MagoEE::EvalResult  result = { 0 };
 
             // keep enumerating even if we fail to get an item
-            hr = mEEEnum->EvaluateNext( options, result, name, fullName );
+            hr = mEEEnum->EvaluateNext( options, result, name, fullNameOut );
             if ( FAILED( hr ) )
             {
                 hr = GetErrorPropertyInfo( hr, name.c_str(), fullName.c_str(), rgelt[i] );
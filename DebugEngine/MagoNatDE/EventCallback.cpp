@@ -34,6 +34,47 @@ namespace Mago
     const BPCookie EntryPointCookie = 1;
 
 
+    class ModuleSymbolsNotifier : public ISymbolLoadCallback
+    {
+        long                    mRefCount;
+        RefPtr<EventCallback>   mCallback;
+        RefPtr<Program>         mProg;
+        bool                    mBindBPs;
+
+    public:
+        ModuleSymbolsNotifier( EventCallback* callback, Program* prog, bool bindBPs )
+            :   mRefCount( 0 ),
+                mCallback( callback ),
+                mProg( prog ),
+                mBindBPs( bindBPs )
+        {
+        }
+
+        virtual void AddRef()
+        {
+            InterlockedIncrement( &mRefCount );
+        }
+
+        virtual void Release()
+        {
+            long    newRef = InterlockedDecrement( &mRefCount );
+            _ASSERT( newRef >= 0 );
+            if ( newRef == 0 )
+            {
+                delete this;
+            }
+        }
+
+        virtual void OnSymbolsLoaded( Module* mod, HRESULT hrLoad )
+        {
+            UNREFERENCED_PARAMETER( hrLoad );
+            // the symbol search event says whether the load worked
+
+            mCallback->OnModuleSymbolsLoaded( mProg, mod, mBindBPs );
+        }
+    };
+
+
     EventCallback::EventCallback( Engine* engine )
         :   mRefCount( 0 ),
             mEngine( engine )
@@ -174,6 +215,14 @@ namespace Mago
 
     void EventCallback::OnModuleUnload( DWORD uniquePid, Address64 baseAddr )
     {
+        RefPtr<Program>             prog;
+        RefPtr<Module>              mod;
+
+        // a symbol load that's still going binds breakpoints to the module,
+        // so let it finish before taking the bind lock that it needs
+        if ( mEngine->FindProgram( uniquePid, prog ) && prog->FindModule( baseAddr, mod ) )
+            mod->WaitForSymbolLoad();
+
         mEngine->BeginBindBP();
         OnModuleUnloadInternal( uniquePid, baseAddr );
         mEngine->EndBindBP();
@@ -188,6 +237,8 @@ namespace Mago
         RefPtr<Program>             prog;
         RefPtr<Module>              mod;
         CComPtr<IDebugModule2>      mod2;
+        RefPtr<ModuleSymbolsNotifier>   notifier;
+        bool                        bindHere = false;
 
         if ( !mEngine->FindProgram( uniquePid, prog ) )
             return;
@@ -200,27 +251,60 @@ namespace Mago
         if ( FAILED( hr ) )
             return;
 
-        hr = mod->LoadSymbols( false );
-        // later we'll check if symbols were loaded
+        // it goes ahead of the symbol search event sent from the loader thread
+
+        hr = MakeCComObject( event );
+        if ( SUCCEEDED( hr ) )
+            hr = mod->QueryInterface( __uuidof( IDebugModule2 ), (void**) &mod2 );
 
-        prog->UpdateAAVersion( mod.Get() );
+        if ( SUCCEEDED( hr ) )
+        {
+            // TODO: message
+            event->Init( mod2, NULL, true );
 
-        hr = mEngine->BindPendingBPsToModule( mod.Get(), prog.Get() );
+            SendEvent( event.Get(), prog.Get(), NULL );
+        }
 
-        hr = MakeCComObject( event );
-        if ( FAILED( hr ) )
-            return;
+        // Load the symbols in the background, so that this thread doesn't 
+        // wait for them. But pending breakpoints have to be bound before the 
+        // debuggee runs, or it can go past them in DllMain and module 
+        // constructors. So if there are any, this thread waits for the 
+        // symbols and binds them before the debuggee goes on.
+
+        bindHere = mEngine->HasPendingBPs();
+
+        notifier = new ModuleSymbolsNotifier( this, prog.Get(), !bindHere );
+        if ( notifier != NULL )
+            hr = mod->StartLoadSymbols( notifier );
+        else
+            hr = E_OUTOFMEMORY;
 
-        hr = mod->QueryInterface( __uuidof( IDebugModule2 ), (void**) &mod2 );
         if ( FAILED( hr ) )
-            return;
+        {
+            hr = mod->LoadSymbols( false );
+            // later we'll check if symbols were loaded
 
-        // TODO: message
-        event->Init( mod2, NULL, true );
+            OnModuleSymbolsLoaded( prog.Get(), mod.Get(), true );
+        }
+        else if ( bindHere )
+        {
+            // binding waits for the symbols; this thread has the bind lock
+            mEngine->BindPendingBPsToModule( mod.Get(), prog.Get() );
+        }
+    }
 
-        SendEvent( event.Get(), prog.Get(), NULL );
+    void EventCallback::OnModuleSymbolsLoaded( Program* prog, Module* mod, bool bindBPs )
+    {
+        HRESULT     hr = S_OK;
+
+        prog->UpdateAAVersion( mod );
 
-        //-------------------------
+        if ( bindBPs )
+        {
+            mEngine->BeginBindBP();
+            hr = mEngine->BindPendingBPsToModule( mod, prog );
+            mEngine->EndBindBP();
+        }
 
         RefPtr<SymbolSearchEvent>       symEvent;
         CComPtr<IDebugModule3>          mod3;
@@ -247,7 +331,7 @@ namespace Mago
 
         symEvent->Init( mod3, msg.m_str, flags );
 
-        hr = SendEvent( symEvent.Get(), prog.Get(), NULL );
+        hr = SendEvent( symEvent.Get(), prog, NULL );
     }
 
     void EventCallback::OnModuleUnloadInternal( DWORD uniquePid, Address64 baseAddr )
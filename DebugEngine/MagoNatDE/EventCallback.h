@@ -13,6 +13,7 @@ namespace Mago
     class Engine;
     class Program;
     class Thread;
+    class Module;
     class EventBase;
     class ICoreThread;
     class ICoreModule;
@@ -48,6 +49,10 @@ namespace Mago
         virtual ProbeRunMode OnCallProbe( 
             DWORD uniquePid, uint32_t threadId, Address64 address, AddressRange64& thunkRange );
 
+        // finishes loading a module once its symbols are loaded in the 
+        // background, and binds pending breakpoints if bindBPs is true
+        void OnModuleSymbolsLoaded( Program* prog, Module* mod, bool bindBPs );
+
     private:
         HRESULT SendEvent( EventBase* eventBase, Program* program, Thread* thread );
 
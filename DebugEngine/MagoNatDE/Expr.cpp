@@ -18,11 +18,15 @@ namespace Mago
     // Expr
 
     Expr::Expr()
+        :   mFlags( 0 ),
+            mRadix( 0 )
     {
     }
 
     Expr::~Expr()
     {
+        if ( (mContext != NULL) && (mParsedExpr != NULL) )
+            mContext->ReleaseParsedExpr( mExprText, mFlags, mRadix, mParsedExpr );
     }
 
 
@@ -100,7 +104,12 @@ namespace Mago
         return hrErr;
     }
 
-    HRESULT Expr::Init( MagoEE::IEEDParsedExpr* parsedExpr, const wchar_t* exprText, ExprContext* exprContext )
+    HRESULT Expr::Init( 
+        MagoEE::IEEDParsedExpr* parsedExpr, 
+        const wchar_t* exprText, 
+        uint32_t flags, 
+        uint32_t radix, 
+        ExprContext* exprContext )
     {
         _ASSERT( parsedExpr != NULL );
         _ASSERT( exprText != NULL );
@@ -115,6 +124,8 @@ namespace Mago
 
         mParsedExpr = parsedExpr;
         mExprText = exprText;
+        mFlags = flags;
+        mRadix = radix;
         mContext = exprContext;
 
         return S_OK;
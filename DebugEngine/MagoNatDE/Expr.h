@@ -24,6 +24,8 @@ namespace Mago
         public IDebugExpression2
     {
         CComBSTR                        mExprText;
+        uint32_t                        mFlags;
+        uint32_t                        mRadix;
         RefPtr<ExprContext>             mContext;
         RefPtr<MagoEE::IEEDParsedExpr>  mParsedExpr;
 
@@ -53,7 +55,13 @@ namespace Mago
             IDebugProperty2** ppResult );
 
     public:
-        HRESULT Init( MagoEE::IEEDParsedExpr* parsedExpr, const wchar_t* exprText, ExprContext* exprContext );
+        // The expression goes back to the context's cache when this goes away.
+        HRESULT Init( 
+            MagoEE::IEEDParsedExpr* parsedExpr, 
+            const wchar_t* exprText, 
+            uint32_t flags, 
+            uint32_t radix, 
+            ExprContext* exprContext );
 
     private:
         HRESULT MakeErrorPropertyOrReturnOriginalError( HRESULT hrErr, IDebugProperty2** ppResult );
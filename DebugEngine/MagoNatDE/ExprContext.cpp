@@ -40,7 +40,8 @@ namespace Mago
     // ExprContext
 
     ExprContext::ExprContext()
-        :   mPC( 0 )
+        :   mPC( 0 ),
+            mDisposed( false )
     {
         memset( &mFuncSH, 0, sizeof mFuncSH );
     }
@@ -76,26 +77,20 @@ namespace Mago
         if ( FAILED( hr ) )
             return hr;
 
-        hr = MagoEE::ParseText( pszCode, GetTypeEnv(), GetStringTable(), parsedExpr.Ref() );
+        hr = GetParsedExpr( pszCode, dwFlags, nRadix, parsedExpr.Ref() );
         if ( FAILED( hr ) )
         {
             MagoEE::EED::GetErrorString( hr, *pbstrError );
             return hr;
         }
 
-        MagoEE::EvalOptions options = { 0 };
-
-        hr = parsedExpr->Bind( options, this );
+        hr = expr->Init( parsedExpr, pszCode, dwFlags, nRadix, this );
         if ( FAILED( hr ) )
         {
-            MagoEE::EED::GetErrorString( hr, *pbstrError );
+            ReleaseParsedExpr( pszCode, dwFlags, nRadix, parsedExpr );
             return hr;
         }
 
-        hr = expr->Init( parsedExpr, pszCode, this );
-        if ( FAILED( hr ) )
-            return hr;
-
         *ppExpr = expr.Detach();
         return S_OK;
     }
@@ -112,7 +107,7 @@ namespace Mago
 
         decl->GetType( resultObj._Type.Ref() );
 
-        decl->GetAddress( resultObj.Addr );
+        GetAddress( decl, resultObj.Addr );
 
         return S_OK;
     }
@@ -320,7 +315,10 @@ namespace Mago
                 if ( !sym->GetAddressOffset( offset ) )
                     return E_FAIL;
 
+                // the module's symbol store isn't in any thread
                 tebAddr = GetTebBase();
+                if ( tebAddr == 0 )
+                    return E_FAIL;
 
                 if ( ptrSize == sizeof( UINT64 ) )
                     tlsArrayPtrAddr = tebAddr + offsetof( TEB64, ThreadLocalStoragePointer );
@@ -474,6 +472,62 @@ namespace Mago
         return FromRawValue( targetBuf, type, value );
     }
 
+    HRESULT ExprContext::GetValues( 
+        MagoEE::Address addr, 
+        MagoEE::Type* type, 
+        uint32_t count, 
+        MagoEE::DataValue* values )
+    {
+        _ASSERT( values != NULL );
+
+        HRESULT         hr = S_OK;
+        size_t          elemSize = type->GetSize();
+        uint32_t        lenRead = 0;
+
+        // no value to get for complex/aggregate types
+        if ( !type->IsScalar() 
+            && !type->IsDArray() 
+            && !type->IsAArray() 
+            && !type->IsDelegate() )
+            return S_OK;
+
+        _ASSERT( elemSize <= sizeof( MagoEE::DataValue ) );
+        if ( elemSize > sizeof( MagoEE::DataValue ) )
+            return E_UNEXPECTED;
+
+        if ( count == 0 )
+            return S_OK;
+        if ( count > UINT32_MAX / elemSize )
+            return E_INVALIDARG;
+
+        // one read for all the objects, instead of one for each
+        uint32_t                totalSize = (uint32_t) (elemSize * count);
+        UniquePtr<uint8_t[]>    buf;
+
+        buf.Attach( new uint8_t[ totalSize ] );
+        if ( buf.IsEmpty() )
+            return E_OUTOFMEMORY;
+
+        hr = ReadMemory( 
+            (Address64) addr, 
+            totalSize, 
+            lenRead, 
+            buf.Get() );
+        if ( FAILED( hr ) )
+            return hr;
+        if ( lenRead < totalSize )
+            return HRESULT_FROM_WIN32( ERROR_PARTIAL_COPY );
+
+        for ( uint32_t i = 0; i < count; i++ )
+        {
+            hr = FromRawValue( buf.Get() + (i * elemSize), type, values[i] );
+            if ( FAILED( hr ) )
+                return hr;
+        }
+
+        return S_OK;
+    }
+
     HRESULT ExprContext::GetValue(
         MagoEE::Address aArrayAddr, 
         const MagoEE::DataObject& key, 
@@ -682,6 +736,44 @@ namespace Mago
         return S_OK;
     }
 
+    HRESULT ExprContext::ReadMemoryV( 
+        uint32_t count, 
+        const MagoEE::Address* addrs, 
+        uint32_t sizeToRead, 
+        uint32_t* sizesRead, 
+        uint8_t* buffer )
+    {
+        if ( count == 0 )
+            return S_OK;
+
+        HRESULT         hr = S_OK;
+        IDebuggerProxy* debuggerProxy = mThread->GetDebuggerProxy();
+        std::vector<ReadMemoryRange64>  ranges( count );
+        std::vector<uint8_t*>           buffers( count );
+
+        for ( uint32_t i = 0; i < count; i++ )
+        {
+            ranges[i].Addr = (Address64) addrs[i];
+            ranges[i].Length = sizeToRead;
+            ranges[i].LengthRead = 0;
+            ranges[i].LengthUnreadable = 0;
+            buffers[i] = buffer + (i * sizeToRead);
+        }
+
+        hr = debuggerProxy->ReadMemoryV( 
+            mThread->GetCoreProcess(), 
+            count, 
+            &ranges[0], 
+            &buffers[0] );
+        if ( FAILED( hr ) )
+            return hr;
+
+        for ( uint32_t i = 0; i < count; i++ )
+            sizesRead[i] = ranges[i].LengthRead;
+
+        return S_OK;
+    }
+
     HRESULT ExprContext::WriteMemory( 
         MagoEE::Address addr, 
         uint32_t sizeToWrite, 
@@ -733,7 +825,33 @@ namespace Mago
         HRESULT hr = S_OK;
         ArchData*   archData = mThread->GetCoreProcess()->GetArchData();
 
-        hr = MagoEE::EED::MakeTypeEnv( archData->GetPointerSize(), mTypeEnv.Ref() );
+        // the cached declarations and types are made in the symbol store's 
+        // type env, so this context makes the rest of its types there too
+        hr = mModule->GetDeclCache()->GetSymbolStore( 
+            mModule, archData->GetPointerSize(), mSymStore.Ref() );
+        if ( FAILED( hr ) )
+            return hr;
+
+        mTypeEnv = mSymStore->GetTypeEnv();
+
+        hr = MagoEE::EED::MakeNameTable( mStrTable.Ref() );
+        if ( FAILED( hr ) )
+            return hr;
+
+        return S_OK;
+    }
+
+    HRESULT ExprContext::InitSymbolStore( 
+        Module* module,
+        int ptrSize )
+    {
+        _ASSERT( module != NULL );
+
+        mModule = module;
+
+        HRESULT hr = S_OK;
+
+        hr = MagoEE::EED::MakeTypeEnv( ptrSize, mTypeEnv.Ref() );
         if ( FAILED( hr ) )
             return hr;
 
@@ -848,6 +966,67 @@ namespace Mago
         return S_OK;
     }
 
+    HRESULT ExprContext::GetParsedExpr( 
+        const wchar_t* text, 
+        uint32_t flags, 
+        uint32_t radix, 
+        MagoEE::IEEDParsedExpr*& parsedExpr )
+    {
+        HRESULT hr = S_OK;
+        RefPtr<MagoEE::IEEDParsedExpr>  expr;
+        ParsedExprCache*    cache = mThread->GetProgram()->GetParsedExprCache();
+
+        // a cached expression was already bound to this context
+        if ( cache->Find( mModule->GetAddress(), mFuncSH, mTypeEnv, this, text, flags, radix, expr.Ref() ) )
+        {
+            parsedExpr = expr.Detach();
+            return S_OK;
+        }
+
+        hr = MagoEE::ParseText( text, GetTypeEnv(), GetStringTable(), expr.Ref() );
+        if ( FAILED( hr ) )
+            return hr;
+
+        // binding doesn't depend on the options, only evaluating does
+        MagoEE::EvalOptions options = { 0 };
+
+        hr = expr->Bind( options, this );
+        if ( FAILED( hr ) )
+            return hr;
+
+        parsedExpr = expr.Detach();
+        return S_OK;
+    }
+
+    void ExprContext::ReleaseParsedExpr( 
+        const wchar_t* text, 
+        uint32_t flags, 
+        uint32_t radix, 
+        MagoEE::IEEDParsedExpr* parsedExpr )
+    {
+        // the disposed context's expressions aren't cached anymore
+        if ( mDisposed )
+            return;
+
+        ParsedExprCache*    cache = mThread->GetProgram()->GetParsedExprCache();
+
+        cache->Add( mModule->GetAddress(), mFuncSH, mTypeEnv, this, text, flags, radix, parsedExpr );
+    }
+
+    void ExprContext::Dispose()
+    {
+        mDisposed = true;
+
+        // the expressions bound to this context can hold it
+        if ( mThread != NULL )
+            mThread->GetProgram()->GetParsedExprCache()->RemoveContext( this );
+
+        // the frames' contexts make their types in the symbol store's type 
+        // env, so its cache lives as long as the module, and goes with it
+        if ( (mSymStore == NULL) && (mTypeEnv != NULL) )
+            mTypeEnv->ClearTypes();
+    }
+
     MagoEE::ITypeEnv* ExprContext::GetTypeEnv()
     {
         return mTypeEnv;
@@ -873,7 +1052,6 @@ namespace Mago
         return mPC;
     }
 
-    // TODO: these declarations can be cached. We can keep a small cache for each module
     HRESULT ExprContext::MakeDeclarationFromSymbol( 
         MagoST::SymHandle handle, 
         MagoEE::Declaration*& decl )
@@ -884,16 +1062,34 @@ namespace Mago
         MagoST::ISymbolInfo*        symInfo = NULL;
         RefPtr<MagoST::ISession>    session;
         MagoST::TypeIndex           typeIndex;
+        MagoST::LocationType        loc = MagoST::LocIsNull;
+        bool                        cacheable = true;
+        DeclCache*                  cache = mModule->GetDeclCache();
 
         if ( GetSession( session.Ref() ) != S_OK )
             return E_NOT_FOUND;
 
+        if ( cache->FindDecl( handle, decl ) )
+            return S_OK;
+
         hr = session->GetSymbolInfo( handle, infoData, symInfo );
         if ( FAILED( hr ) )
             return hr;
 
         tag = symInfo->GetSymTag();
 
+        // locals depend on the frame, and TLS on the thread
+        if ( (tag == SymTagData) || (tag == SymTagFunction) )
+        {
+            if ( !symInfo->GetLocation( loc ) 
+                || ((loc != LocIsStatic) && (loc != LocIsConstant)) )
+                cacheable = false;
+        }
+
+        // the rest is made by the module's symbol store, so any frame can use it
+        if ( cacheable && (mSymStore != NULL) )
+            return mSymStore->MakeDeclarationFromSymbol( handle, decl );
+
         switch ( tag )
         {
         case SymTagData:
@@ -923,6 +1119,9 @@ namespace Mago
             break;
         }
 
+        if ( SUCCEEDED( hr ) && cacheable && !mDisposed )
+            cache->AddDecl( handle, decl );
+
         return hr;
     }
 
@@ -1193,6 +1392,31 @@ namespace Mago
     HRESULT ExprContext::GetTypeFromTypeSymbol( 
         MagoST::TypeIndex typeIndex,
         MagoEE::Type*& type )
+    {
+        HRESULT     hr = S_OK;
+        DeclCache*  cache = mModule->GetDeclCache();
+
+        if ( cache->FindType( typeIndex, type ) )
+            return S_OK;
+
+        // types don't depend on the frame, so they're made by the module's 
+        // symbol store
+        if ( mSymStore != NULL )
+            return mSymStore->GetTypeFromTypeSymbol( typeIndex, type );
+
+        hr = MakeTypeFromTypeSymbol( typeIndex, type );
+        if ( FAILED( hr ) )
+            return hr;
+
+        if ( (type != NULL) && !mDisposed )
+            cache->AddType( typeIndex, type );
+
+        return hr;
+    }
+
+    HRESULT ExprContext::MakeTypeFromTypeSymbol( 
+        MagoST::TypeIndex typeIndex,
+        MagoEE::Type*& type )
     {
         HRESULT                 hr = S_OK;
         MagoST::SymTag          tag = MagoST::SymTagNull;
@@ -1596,6 +1820,10 @@ namespace Mago
         HRESULT         hr = S_OK;
         RegisterValue   regVal = { 0 };
 
+        // the module's symbol store isn't in any frame
+        if ( mRegSet == NULL )
+            return E_FAIL;
+
         if ( reg == CV_REG_EDXEAX )
         {
             hr = mRegSet->GetValue( RegX86_EDX, regVal );
@@ -1658,6 +1886,9 @@ namespace Mago
 
     Address64 ExprContext::GetTebBase()
     {
+        if ( mThread == NULL )
+            return 0;
+
         return mThread->GetCoreThread()->GetTebBase();
     }
 
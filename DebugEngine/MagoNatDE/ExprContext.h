@@ -29,6 +29,8 @@ namespace Mago
         std::vector<MagoST::SymHandle>  mBlockSH;
         RefPtr<MagoEE::ITypeEnv>        mTypeEnv;
         RefPtr<MagoEE::NameTable>       mStrTable;
+        RefPtr<ExprContext>             mSymStore;  // NULL in the module's symbol store
+        bool                            mDisposed;
 
     public:
         ExprContext();
@@ -69,6 +71,10 @@ namespace Mago
         virtual HRESULT GetSuper( MagoEE::Declaration*& decl );
         virtual HRESULT GetReturnType( MagoEE::Type*& type );
 
+        virtual HRESULT GetAddress( 
+            MagoEE::Declaration* decl, 
+            MagoEE::Address& addr );
+
         virtual HRESULT GetValue( 
             MagoEE::Declaration* decl, 
             MagoEE::DataValue& value );
@@ -78,6 +84,12 @@ namespace Mago
             MagoEE::Type* type, 
             MagoEE::DataValue& value );
 
+        virtual HRESULT GetValues( 
+            MagoEE::Address addr, 
+            MagoEE::Type* type, 
+            uint32_t count, 
+            MagoEE::DataValue* values );
+
         virtual HRESULT GetValue(
             MagoEE::Address aArrayAddr, 
             const MagoEE::DataObject& key, 
@@ -103,6 +115,13 @@ namespace Mago
             uint32_t& sizeRead, 
             uint8_t* buffer );
 
+        virtual HRESULT ReadMemoryV( 
+            uint32_t count, 
+            const MagoEE::Address* addrs, 
+            uint32_t sizeToRead, 
+            uint32_t* sizesRead, 
+            uint8_t* buffer );
+
         virtual HRESULT WriteMemory( 
             MagoEE::Address addr, 
             uint32_t sizeToWrite, 
@@ -116,14 +135,34 @@ namespace Mago
         virtual DRuntime* GetDRuntime();
 
         ////////////////////////////////////////////////////////////
+        // Takes the expression from the program's cache if the same text 
+        // was bound to this context before, or parses it and binds it. The 
+        // caller has the expression to itself until it hands it back with 
+        // ReleaseParsedExpr.
+        HRESULT GetParsedExpr( 
+            const wchar_t* text, 
+            uint32_t flags, 
+            uint32_t radix, 
+            MagoEE::IEEDParsedExpr*& parsedExpr );
+
+        void ReleaseParsedExpr( 
+            const wchar_t* text, 
+            uint32_t flags, 
+            uint32_t radix, 
+            MagoEE::IEEDParsedExpr* parsedExpr );
+
+        // Stops adding to the module's declaration cache, and lets go of the 
+        // expressions cached for this context. It's called when the frame 
+        // goes away, and on the symbol store when the module's cache is 
+        // cleared.
+        void Dispose();
+
         MagoEE::ITypeEnv* GetTypeEnv();
         MagoEE::NameTable* GetStringTable();
         MagoST::SymHandle GetFunctionSH();
         const std::vector<MagoST::SymHandle>& GetBlockSH();
         Address64 GetPC();
 
-        HRESULT GetAddress( MagoEE::Declaration* decl, MagoEE::Address& addr );
-
         static MagoEE::ENUMTY GetBasicTy( DWORD diaBaseTypeId, DWORD size );
 
         HRESULT MakeDeclarationFromSymbol( 
@@ -158,6 +197,12 @@ namespace Mago
             Address64 pc,
             IRegisterSet* regSet );
 
+        // Sets up the context that makes the declarations and types of a 
+        // module's DeclCache. It isn't in any frame or thread.
+        HRESULT InitSymbolStore( 
+            Module* module,
+            int ptrSize );
+
         Thread* GetThread();
 
     private:
@@ -191,6 +236,10 @@ namespace Mago
             MagoST::TypeIndex typeIndex,
             MagoEE::Type*& type );
 
+        HRESULT MakeTypeFromTypeSymbol( 
+            MagoST::TypeIndex typeIndex,
+            MagoEE::Type*& type );
+
         HRESULT GetFunctionTypeFromTypeSymbol( 
             MagoST::TypeHandle typeHandle,
             const MagoST::SymInfoData& infoData,
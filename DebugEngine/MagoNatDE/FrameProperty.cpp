@@ -48,7 +48,7 @@ namespace Mago
             const MagoEE::EvalOptions& options, 
             MagoEE::EvalResult& result,
             std::wstring& name,
-            std::wstring& fullName );
+            std::wstring* fullName );
 
         HRESULT Init( ExprContext* exprContext );
     };
@@ -132,7 +132,7 @@ namespace Mago
         const MagoEE::EvalOptions& options, 
         MagoEE::EvalResult& result,
         std::wstring& name,
-        std::wstring& fullName )
+        std::wstring* fullName )
     {
         if ( mIndex >= GetCount() )
             return E_FAIL;
@@ -146,11 +146,16 @@ namespace Mago
         name.clear();
         name.append( mNames[curIndex] );
 
-        fullName.clear();
-        fullName.append( name );
+        if ( fullName != NULL )
+        {
+            fullName->clear();
+            fullName->append( name );
+        }
 
+        // Locals are parsed here and not cached, so that enumerating a big 
+        // frame doesn't push the watches out of the program's cache.
         hr = MagoEE::ParseText( 
-            fullName.c_str(), 
+            name.c_str(), 
             mExprContext->GetTypeEnv(), 
             mExprContext->GetStringTable(), 
             parsedExpr.Ref() );
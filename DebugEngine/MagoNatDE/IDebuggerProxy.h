@@ -34,6 +34,15 @@ namespace Mago
             uint32_t& lengthUnreadable, 
             uint8_t* buffer ) = 0;
 
+        // Reads each range into the buffer at the same index in one trip to 
+        // the debuggee. A range that can't be read is returned with both 
+        // lengths set to zero, and doesn't fail the call.
+        virtual HRESULT ReadMemoryV( 
+            ICoreProcess* process, 
+            uint32_t rangeCount, 
+            ReadMemoryRange64* ranges, 
+            uint8_t** buffers ) = 0;
+
         virtual HRESULT WriteMemory( 
             ICoreProcess* process, 
             Address64 address,
@@ -13,6 +13,7 @@ typedef struct MagoRemote_ThreadInfo MagoRemote_ThreadInfo;
 typedef struct MagoRemote_ModuleInfo MagoRemote_ModuleInfo;
 typedef struct MagoRemote_AddressRange MagoRemote_AddressRange;
 typedef struct MagoRemote_ExceptionRecord MagoRemote_ExceptionRecord;
+typedef struct MagoRemote_StopSnapshot MagoRemote_StopSnapshot;
 enum MagoRemote_RunMode;
 enum MagoRemote_ProbeRunMode;
 
@@ -44,10 +45,16 @@ namespace Mago
             unsigned int recordCount,
             MagoRemote_ExceptionRecord* exceptRecords ) = 0;
 
+        // The snapshot can be NULL, and is only good during the call.
         virtual MagoRemote_RunMode OnBreakpoint( 
-            uint32_t pid, uint32_t threadId, MagoRemote_Address address, bool embedded ) = 0;
+            uint32_t pid, 
+            uint32_t threadId, 
+            MagoRemote_Address address, 
+            bool embedded, 
+            MagoRemote_StopSnapshot* snapshot ) = 0;
 
-        virtual void OnStepComplete( uint32_t pid, uint32_t threadId ) = 0;
+        virtual void OnStepComplete( 
+            uint32_t pid, uint32_t threadId, MagoRemote_StopSnapshot* snapshot ) = 0;
         virtual void OnAsyncBreakComplete( uint32_t pid, uint32_t threadId ) = 0;
 
         virtual MagoRemote_ProbeRunMode OnCallProbe( 
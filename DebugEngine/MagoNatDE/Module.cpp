@@ -41,6 +41,10 @@ namespace Mago
 
         pInfo->dwValidFields = 0;
 
+        // these come from loading the symbols
+        if ( (dwFields & (MIF_DEBUGMESSAGE | MIF_URLSYMBOLLOCATION | MIF_FLAGS)) != 0 )
+            WaitForSymbols();
+
         if ( (dwFields & MIF_NAME) != 0 )
         {
             CComBSTR    name;
@@ -170,6 +174,9 @@ namespace Mago
 
     HRESULT Module::LoadSymbols()
     {
+        // don't race a background load of the same module
+        WaitForSymbols();
+
         return LoadSymbols( true );
     }
 
@@ -261,7 +268,13 @@ namespace Mago
         // these have to be closed when we're told to close
         // all other resources can be left open
 
+        // a load that's still running would set the session after this
+        WaitForSymbolLoad();
+
         SetSession( NULL );
+
+        mPDataTable.Clear();
+        mDeclCache.Dispose();
     }
 
     void    Module::GetPath( CComBSTR& path )
@@ -325,14 +338,105 @@ namespace Mago
 
     RefPtr<MagoST::ISession>    Module::GetSession()
     {
+        WaitForSymbols();
+
         GuardedArea guard( mSessionGuard );
         return mSession;
     }
 
     void    Module::SetSession( MagoST::ISession* session )
     {
-        GuardedArea guard( mSessionGuard );
-        mSession = session;
+        {
+            GuardedArea guard( mSessionGuard );
+            mSession = session;
+        }
+
+        // whatever was cached came from the old symbols
+        mDeclCache.Clear();
+    }
+
+    PDataTable* Module::GetPDataTable()
+    {
+        return &mPDataTable;
+    }
+
+    DeclCache*  Module::GetDeclCache()
+    {
+        return &mDeclCache;
+    }
+
+    HRESULT Module::InitSymbolLoad()
+    {
+        // both start out set, because no load is running yet
+
+        mSymbolsReady = CreateEvent( NULL, TRUE, TRUE, NULL );
+        if ( mSymbolsReady.IsEmpty() )
+            return HRESULT_FROM_WIN32( GetLastError() );
+
+        mSymbolLoadDone = CreateEvent( NULL, TRUE, TRUE, NULL );
+        if ( mSymbolLoadDone.IsEmpty() )
+            return HRESULT_FROM_WIN32( GetLastError() );
+
+        return S_OK;
+    }
+
+    HRESULT Module::StartLoadSymbols( ISymbolLoadCallback* callback )
+    {
+        if ( mSymbolsReady.IsEmpty() || mSymbolLoadDone.IsEmpty() )
+            return E_UNEXPECTED;
+
+        ResetEvent( mSymbolsReady );
+        ResetEvent( mSymbolLoadDone );
+
+        mSymbolLoadCallback = callback;
+
+        // the loader thread owns this reference
+        AddRef();
+
+        if ( !QueueUserWorkItem( LoadSymbolsProc, this, WT_EXECUTELONGFUNCTION ) )
+        {
+            // still load them, just not in the background
+            LoadSymbolsProc( this );
+        }
+
+        return S_OK;
+    }
+
+    void    Module::WaitForSymbolLoad()
+    {
+        if ( !mSymbolLoadDone.IsEmpty() )
+            WaitForSingleObject( mSymbolLoadDone, INFINITE );
+    }
+
+    void    Module::WaitForSymbols()
+    {
+        // a module that doesn't load its own symbols has no event
+        if ( mSymbolsReady.IsEmpty() )
+            return;
+
+        WaitForSingleObject( mSymbolsReady, INFINITE );
+    }
+
+    DWORD WINAPI Module::LoadSymbolsProc( void* param )
+    {
+        Module*                     mod = (Module*) param;
+        RefPtr<ISymbolLoadCallback> callback;
+        HRESULT                     hr = S_OK;
+
+        hr = mod->LoadSymbols( false );
+
+        // let the waiters go before the callback, which can send events 
+        // that make the debugger ask for symbols on other threads
+        SetEvent( mod->mSymbolsReady );
+
+        callback.Attach( mod->mSymbolLoadCallback.Detach() );
+
+        if ( callback != NULL )
+            callback->OnSymbolsLoaded( mod, hr );
+
+        SetEvent( mod->mSymbolLoadDone );
+        mod->Release();
+        return 0;
     }
 
     bool    Module::Contains( Address64 addr )
@@ -7,10 +7,27 @@
 
 #pragma once
 
+#include "PDataTable.h"
+#include "DeclCache.h"
+
 
 namespace Mago
 {
     class ICoreModule;
+    class Module;
+
+
+    // Told on a symbol loader thread once a module's symbols have been loaded,
+    // whether or not the load succeeded.
+
+    class ISymbolLoadCallback
+    {
+    public:
+        virtual void AddRef() = 0;
+        virtual void Release() = 0;
+
+        virtual void OnSymbolsLoaded( Module* mod, HRESULT hrLoad ) = 0;
+    };
 
 
     class Module : 
@@ -24,6 +41,14 @@ namespace Mago
         CComBSTR                    mLoadedSymPath;
         CComBSTR                    mSearchText;
         Guard                       mSessionGuard;
+        PDataTable                  mPDataTable;
+        DeclCache                   mDeclCache;
+
+        // a module's symbols load on a thread pool thread; these manual-reset 
+        // events say when callers that need the symbols can go ahead
+        HandlePtr                   mSymbolsReady;
+        HandlePtr                   mSymbolLoadDone;
+        RefPtr<ISymbolLoadCallback> mSymbolLoadCallback;
 
     public:
         Module();
@@ -80,7 +105,25 @@ namespace Mago
         HRESULT LoadSymbols( bool sendEvent );
         bool    Contains( Address64 addr );
 
+        // Makes the events that StartLoadSymbols uses. It's called before 
+        // the module is shared with other threads.
+        HRESULT InitSymbolLoad();
+
+        // Starts loading the symbols on a loader thread and returns right away.
+        // GetSession and GetSymbolSession wait until the load is done.
+        HRESULT StartLoadSymbols( ISymbolLoadCallback* callback );
+
+        // Waits until a load started by StartLoadSymbols is done, including 
+        // its callback. The callback takes locks, so don't hold any here.
+        void    WaitForSymbolLoad();
+
         RefPtr<MagoST::ISession>    GetSession();
         void    SetSession( MagoST::ISession* session );
+        PDataTable* GetPDataTable();
+        DeclCache*  GetDeclCache();
+
+    private:
+        void    WaitForSymbols();
+        static DWORD WINAPI LoadSymbolsProc( void* param );
     };
 }
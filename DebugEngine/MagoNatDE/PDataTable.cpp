@@ -0,0 +1,222 @@
+/*
+   Copyright (c) 2013 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "Common.h"
+#include "PDataTable.h"
+#include "ArchData.h"
+#include "ICoreProcess.h"
+#include "IDebuggerProxy.h"
+#include <algorithm>
+
+
+namespace Mago
+{
+    static HRESULT ReadWhole( 
+        IDebuggerProxy* debugger, 
+        ICoreProcess* process, 
+        Address64 address, 
+        uint32_t length, 
+        void* buffer )
+    {
+        HRESULT     hr = S_OK;
+        uint32_t    lenRead = 0;
+        uint32_t    lenUnreadable = 0;
+
+        hr = debugger->ReadMemory( process, address, length, lenRead, lenUnreadable, (uint8_t*) buffer );
+        if ( FAILED( hr ) )
+            return hr;
+
+        if ( lenRead < length )
+            return HRESULT_FROM_WIN32( ERROR_PARTIAL_COPY );
+
+        return S_OK;
+    }
+
+
+    PDataTable::PDataTable()
+        :   mLoaded( false ),
+            mLoadFailed( false ),
+            mEntries( RangeLess )
+    {
+    }
+
+    bool PDataTable::RangeLess( const AddressRange64& left, const AddressRange64& right )
+    {
+        return left.End < right.Begin;
+    }
+
+    const void* PDataTable::Find( 
+        IDebuggerProxy* debugger, 
+        ICoreProcess* process, 
+        Address64 imageBase, 
+        Address64 address )
+    {
+        _ASSERT( debugger != NULL );
+        _ASSERT( process != NULL );
+
+        GuardedArea guard( mGuard );
+
+        if ( !mLoaded && !mLoadFailed )
+        {
+            HRESULT hr = Load( debugger, process, imageBase );
+
+            mLoaded = SUCCEEDED( hr );
+            mLoadFailed = FAILED( hr );
+        }
+
+        if ( mLoaded )
+            return FindLoaded( address );
+
+        return FindEntry( debugger, process, imageBase, address );
+    }
+
+    void PDataTable::Clear()
+    {
+        GuardedArea guard( mGuard );
+
+        mLoaded = false;
+        mLoadFailed = false;
+        mTable.clear();
+        mRanges.clear();
+        mEntries.clear();
+    }
+
+    HRESULT PDataTable::Load( IDebuggerProxy* debugger, ICoreProcess* process, Address64 imageBase )
+    {
+        HRESULT                 hr = S_OK;
+        ArchData*               archData = process->GetArchData();
+        uint32_t                entrySize = archData->GetPDataSize();
+        IMAGE_DOS_HEADER        dosHeader = { 0 };
+        IMAGE_NT_HEADERS64      ntHeaders = { 0 };
+        DWORD                   dataDirCount = 0;
+        IMAGE_DATA_DIRECTORY*   dataDirs = NULL;
+
+        if ( entrySize == 0 )
+            return E_NOTIMPL;
+
+        hr = ReadWhole( debugger, process, imageBase, sizeof dosHeader, &dosHeader );
+        if ( FAILED( hr ) )
+            return hr;
+
+        if ( dosHeader.e_magic != IMAGE_DOS_SIGNATURE )
+            return E_FAIL;
+
+        hr = ReadWhole( debugger, process, imageBase + dosHeader.e_lfanew, sizeof ntHeaders, &ntHeaders );
+        if ( FAILED( hr ) )
+            return hr;
+
+        if ( ntHeaders.Signature != IMAGE_NT_SIGNATURE )
+            return E_FAIL;
+
+        if ( ntHeaders.OptionalHeader.Magic == IMAGE_NT_OPTIONAL_HDR64_MAGIC )
+        {
+            dataDirCount = ntHeaders.OptionalHeader.NumberOfRvaAndSizes;
+            dataDirs = ntHeaders.OptionalHeader.DataDirectory;
+        }
+        else if ( ntHeaders.OptionalHeader.Magic == IMAGE_NT_OPTIONAL_HDR32_MAGIC )
+        {
+            IMAGE_NT_HEADERS32* ntHeaders32 = (IMAGE_NT_HEADERS32*) &ntHeaders;
+
+            dataDirCount = ntHeaders32->OptionalHeader.NumberOfRvaAndSizes;
+            dataDirs = ntHeaders32->OptionalHeader.DataDirectory;
+        }
+        else
+            return E_FAIL;
+
+        if ( dataDirCount <= IMAGE_DIRECTORY_ENTRY_EXCEPTION )
+            return E_NOT_FOUND;
+
+        const IMAGE_DATA_DIRECTORY& pdataDir = dataDirs[IMAGE_DIRECTORY_ENTRY_EXCEPTION];
+        uint32_t    entryCount = pdataDir.Size / entrySize;
+
+        if ( pdataDir.VirtualAddress == 0 || entryCount == 0 )
+            return S_OK;
+
+        if ( pdataDir.Size > MaxTableSize )
+            return E_FAIL;
+
+        mTable.resize( entryCount * entrySize );
+
+        hr = ReadWhole( 
+            debugger, 
+            process, 
+            imageBase + pdataDir.VirtualAddress, 
+            entryCount * entrySize, 
+            &mTable[0] );
+        if ( FAILED( hr ) )
+        {
+            mTable.clear();
+            return hr;
+        }
+
+        mRanges.resize( entryCount );
+
+        for ( uint32_t i = 0; i < entryCount; i++ )
+        {
+            Range&  range = mRanges[i];
+
+            range.Offset = i * entrySize;
+            archData->GetPDataRange( imageBase, &mTable[range.Offset], range.Begin, range.End );
+        }
+
+        // the linker sorts the table, but don't count on it
+        std::sort( mRanges.begin(), mRanges.end() );
+
+        return S_OK;
+    }
+
+    const void* PDataTable::FindLoaded( Address64 address )
+    {
+        Range   key = { address, address, 0 };
+
+        std::vector<Range>::iterator it = std::upper_bound( mRanges.begin(), mRanges.end(), key );
+
+        if ( it == mRanges.begin() )
+            return NULL;
+
+        --it;
+
+        // the end address is one past the function
+        if ( address >= it->End )
+            return NULL;
+
+        return &mTable[it->Offset];
+    }
+
+    const void* PDataTable::FindEntry( 
+        IDebuggerProxy* debugger, 
+        ICoreProcess* process, 
+        Address64 imageBase, 
+        Address64 address )
+    {
+        AddressRange64  key = { address, address };
+
+        EntryMap::iterator it = mEntries.find( key );
+        if ( it != mEntries.end() )
+            return &it->second[0];
+
+        HRESULT                 hr = S_OK;
+        ArchData*               archData = process->GetArchData();
+        uint32_t                entrySize = archData->GetPDataSize();
+        uint32_t                sizeRead = 0;
+        std::vector<uint8_t>    entry( entrySize );
+
+        if ( entrySize == 0 )
+            return NULL;
+
+        hr = debugger->GetPData( process, address, imageBase, entrySize, sizeRead, &entry[0] );
+        if ( hr != S_OK )
+            return NULL;
+
+        AddressRange64  range = { 0 };
+
+        archData->GetPDataRange( imageBase, &entry[0], range.Begin, range.End );
+
+        it = mEntries.insert( EntryMap::value_type( range, entry ) ).first;
+        return &it->second[0];
+    }
+}
@@ -0,0 +1,79 @@
+/*
+   Copyright (c) 2013 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+
+namespace Mago
+{
+    class ArchData;
+    class ICoreProcess;
+    class IDebuggerProxy;
+
+
+    // Holds the function table (pdata) of a module. A module's pdata doesn't 
+    // change while it's loaded, so the whole table is read from the debuggee 
+    // the first time it's needed, and then it's shared by the stack walks of 
+    // all threads in all stops, until the module unloads.
+    //
+    // If the table can't be read whole, then each entry is asked for with 
+    // IDebuggerProxy::GetPData and kept.
+    //
+    // The entries that are returned stay good until the table is cleared.
+
+    class PDataTable
+    {
+        struct Range
+        {
+            Address64   Begin;
+            Address64   End;
+            uint32_t    Offset;
+
+            bool operator<( const Range& other ) const
+            {
+                return Begin < other.Begin;
+            }
+        };
+
+        typedef bool (*RangePred)( const AddressRange64& left, const AddressRange64& right );
+        typedef std::map<AddressRange64, std::vector<uint8_t>, RangePred>   EntryMap;
+
+        bool                    mLoaded;
+        bool                    mLoadFailed;
+        std::vector<uint8_t>    mTable;
+        std::vector<Range>      mRanges;        // sorted by Begin
+        EntryMap                mEntries;       // the ones that were asked for one at a time
+        Guard                   mGuard;
+
+    public:
+        // The most bytes of pdata that are read at once
+        static const uint32_t   MaxTableSize = 16 * 1024 * 1024;
+
+        PDataTable();
+
+        // Returns the entry for the function that contains the address, 
+        // or NULL if there isn't one.
+        const void* Find( 
+            IDebuggerProxy* debugger, 
+            ICoreProcess* process, 
+            Address64 imageBase, 
+            Address64 address );
+
+        void Clear();
+
+    private:
+        static bool RangeLess( const AddressRange64& left, const AddressRange64& right );
+
+        HRESULT Load( IDebuggerProxy* debugger, ICoreProcess* process, Address64 imageBase );
+        const void* FindLoaded( Address64 address );
+        const void* FindEntry( 
+            IDebuggerProxy* debugger, 
+            ICoreProcess* process, 
+            Address64 imageBase, 
+            Address64 address );
+    };
+}
@@ -0,0 +1,236 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "Common.h"
+#include "ParsedExprCache.h"
+
+
+namespace Mago
+{
+    // the symbol stores fill in the whole handle
+
+    bool ParsedExprCache::Key::operator<( const Key& other ) const
+    {
+        if ( ModuleBase != other.ModuleBase )
+            return ModuleBase < other.ModuleBase;
+        if ( FuncSH.unused1 != other.FuncSH.unused1 )
+            return FuncSH.unused1 < other.FuncSH.unused1;
+        if ( FuncSH.unused2 != other.FuncSH.unused2 )
+            return FuncSH.unused2 < other.FuncSH.unused2;
+        if ( TypeEnv != other.TypeEnv )
+            return TypeEnv < other.TypeEnv;
+        if ( Context != other.Context )
+            return Context < other.Context;
+        if ( Flags != other.Flags )
+            return Flags < other.Flags;
+        if ( Radix != other.Radix )
+            return Radix < other.Radix;
+        return Text < other.Text;
+    }
+
+
+    //------------------------------------------------------------------------
+
+    ParsedExprCache::ParsedExprCache()
+        :   mDisposed( false )
+    {
+        memset( &mStats, 0, sizeof mStats );
+        memset( &mStopStats, 0, sizeof mStopStats );
+    }
+
+    ParsedExprCache::~ParsedExprCache()
+    {
+    }
+
+    bool ParsedExprCache::Find(
+        Address64 moduleBase,
+        const MagoST::SymHandle& funcSH,
+        MagoEE::ITypeEnv* typeEnv,
+        ExprContext* context,
+        const wchar_t* text,
+        uint32_t flags,
+        uint32_t radix,
+        MagoEE::IEEDParsedExpr*& parsedExpr )
+    {
+        _ASSERT( text != NULL );
+        GuardedArea guard( mGuard );
+
+        Key key;
+
+        MakeKey( moduleBase, funcSH, typeEnv, context, text, flags, radix, key );
+
+        EntryMap::iterator  it = mEntryMap.find( key );
+
+        if ( it == mEntryMap.end() )
+        {
+            mStats.Misses++;
+            mStopStats.Misses++;
+            return false;
+        }
+
+        if ( it->second->ParsedExpr == NULL )
+        {
+            mStats.Busy++;
+            mStopStats.Busy++;
+            return false;
+        }
+
+        // move it to the front
+        mEntries.splice( mEntries.begin(), mEntries, it->second );
+
+        mStats.Hits++;
+        mStopStats.Hits++;
+        parsedExpr = it->second->ParsedExpr.Detach();
+        return true;
+    }
+
+    void ParsedExprCache::Add(
+        Address64 moduleBase,
+        const MagoST::SymHandle& funcSH,
+        MagoEE::ITypeEnv* typeEnv,
+        ExprContext* context,
+        const wchar_t* text,
+        uint32_t flags,
+        uint32_t radix,
+        MagoEE::IEEDParsedExpr* parsedExpr )
+    {
+        _ASSERT( text != NULL );
+        _ASSERT( parsedExpr != NULL );
+
+        // release the evicted expression outside of the lock
+        RefPtr<MagoEE::IEEDParsedExpr>  evictedExpr;
+        GuardedArea guard( mGuard );
+
+        if ( mDisposed )
+            return;
+
+        Entry   entry;
+
+        MakeKey( moduleBase, funcSH, typeEnv, context, text, flags, radix, entry.ExprKey );
+        entry.ParsedExpr = parsedExpr;
+
+        EntryMap::iterator  it = mEntryMap.find( entry.ExprKey );
+
+        if ( it != mEntryMap.end() )
+        {
+            // if two holders had the same text, keep the first one put back
+            if ( it->second->ParsedExpr == NULL )
+                it->second->ParsedExpr = parsedExpr;
+            mEntries.splice( mEntries.begin(), mEntries, it->second );
+            return;
+        }
+
+        if ( mEntries.size() >= MaxEntries )
+        {
+            evictedExpr = mEntries.back().ParsedExpr;
+            Evict( --mEntries.end() );
+        }
+
+        mEntries.push_front( entry );
+        mEntryMap.insert( EntryMap::value_type( entry.ExprKey, mEntries.begin() ) );
+    }
+
+    void ParsedExprCache::RemoveModule( Address64 moduleBase )
+    {
+        EntryList   removedEntries;
+        GuardedArea guard( mGuard );
+
+        for ( EntryList::iterator it = mEntries.begin(); it != mEntries.end(); )
+        {
+            EntryList::iterator curIt = it;
+            it++;
+
+            if ( curIt->ExprKey.ModuleBase == moduleBase )
+            {
+                mEntryMap.erase( curIt->ExprKey );
+                removedEntries.splice( removedEntries.end(), mEntries, curIt );
+            }
+        }
+    }
+
+    void ParsedExprCache::RemoveContext( ExprContext* context )
+    {
+        EntryList   removedEntries;
+        GuardedArea guard( mGuard );
+
+        for ( EntryList::iterator it = mEntries.begin(); it != mEntries.end(); )
+        {
+            EntryList::iterator curIt = it;
+            it++;
+
+            if ( curIt->ExprKey.Context == context )
+            {
+                mEntryMap.erase( curIt->ExprKey );
+                removedEntries.splice( removedEntries.end(), mEntries, curIt );
+            }
+        }
+    }
+
+    void ParsedExprCache::EndStop()
+    {
+        GuardedArea guard( mGuard );
+
+        if ( mStopStats.Hits > 0 || mStopStats.Misses > 0 || mStopStats.Busy > 0 )
+            mStats.Stops++;
+
+        memset( &mStopStats, 0, sizeof mStopStats );
+    }
+
+    void ParsedExprCache::Dispose()
+    {
+        EntryList   entries;
+
+        {
+            GuardedArea guard( mGuard );
+
+            mDisposed = true;
+            mEntryMap.clear();
+            mEntries.swap( entries );
+        }
+    }
+
+    void ParsedExprCache::GetStats( ParsedExprCacheStats& stats )
+    {
+        GuardedArea guard( mGuard );
+
+        stats = mStats;
+    }
+
+    void ParsedExprCache::GetStopStats( ParsedExprCacheStats& stats )
+    {
+        GuardedArea guard( mGuard );
+
+        stats = mStopStats;
+    }
+
+    void ParsedExprCache::MakeKey(
+        Address64 moduleBase,
+        const MagoST::SymHandle& funcSH,
+        MagoEE::ITypeEnv* typeEnv,
+        ExprContext* context,
+        const wchar_t* text,
+        uint32_t flags,
+        uint32_t radix,
+        Key& key )
+    {
+        key.Text = text;
+        key.Flags = flags;
+        key.Radix = radix;
+        key.ModuleBase = moduleBase;
+        key.FuncSH = funcSH;
+        key.TypeEnv = typeEnv;
+        key.Context = context;
+    }
+
+    void ParsedExprCache::Evict( EntryList::iterator it )
+    {
+        mEntryMap.erase( it->ExprKey );
+        mEntries.erase( it );
+        mStats.Evictions++;
+        mStopStats.Evictions++;
+    }
+}
@@ -0,0 +1,133 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+#include <MagoEED.h>
+
+
+namespace Mago
+{
+    class ExprContext;
+
+
+    struct ParsedExprCacheStats
+    {
+        uint32_t    Stops;
+        uint32_t    Hits;
+        uint32_t    Misses;
+        uint32_t    Busy;       // cached, but taken by another holder
+        uint32_t    Evictions;
+    };
+
+
+    // Holds the expressions that were parsed and bound in a program, by 
+    // their text, parse flags, radix, the module and function they were 
+    // parsed in, the type env that owns their types, and the context they 
+    // were bound to. A format specifier is part of the text. Asking for the 
+    // same text in the same context only has to evaluate the expression 
+    // again. A frame that's reused from the last callstack keeps its 
+    // context, so its expressions are found again in the next stops.
+    //
+    // Binding and evaluating an expression change its tree, so an 
+    // expression has one holder at a time. Find takes it out of the cache, 
+    // and the holder puts it back with Add when it's done. While it's out, 
+    // the same text has to be parsed again for anyone else.
+    //
+    // A bound expression can hold its context, so a context's expressions 
+    // are removed when it's disposed of, and a module's when it unloads. 
+    // The cache is disposed of with the program.
+    //
+    // When the cache is full, the least recently used expression is let go.
+
+    class ParsedExprCache
+    {
+        struct Key
+        {
+            std::wstring        Text;
+            uint32_t            Flags;
+            uint32_t            Radix;
+            Address64           ModuleBase;
+            MagoST::SymHandle   FuncSH;
+            MagoEE::ITypeEnv*   TypeEnv;
+            ExprContext*        Context;    // not held
+
+            bool operator<( const Key& other ) const;
+        };
+
+        struct Entry
+        {
+            Key                             ExprKey;
+            RefPtr<MagoEE::IEEDParsedExpr>  ParsedExpr;     // NULL while it's taken
+        };
+
+        typedef std::list<Entry>                        EntryList;  // most recently used first
+        typedef std::map<Key, EntryList::iterator>      EntryMap;
+
+        static const size_t     MaxEntries = 256;
+
+        EntryList               mEntries;
+        EntryMap                mEntryMap;
+        ParsedExprCacheStats    mStats;
+        ParsedExprCacheStats    mStopStats;
+        bool                    mDisposed;
+        Guard                   mGuard;
+
+    public:
+        ParsedExprCache();
+        ~ParsedExprCache();
+
+        // Returns true and takes the expression out of the cache if the 
+        // text was cached for the context, and nobody else has it.
+        bool Find(
+            Address64 moduleBase,
+            const MagoST::SymHandle& funcSH,
+            MagoEE::ITypeEnv* typeEnv,
+            ExprContext* context,
+            const wchar_t* text,
+            uint32_t flags,
+            uint32_t radix,
+            MagoEE::IEEDParsedExpr*& parsedExpr );
+
+        // Puts back an expression that the caller is done with. It can be 
+        // one that Find returned, or a new one bound to the context.
+        void Add(
+            Address64 moduleBase,
+            const MagoST::SymHandle& funcSH,
+            MagoEE::ITypeEnv* typeEnv,
+            ExprContext* context,
+            const wchar_t* text,
+            uint32_t flags,
+            uint32_t radix,
+            MagoEE::IEEDParsedExpr* parsedExpr );
+
+        void RemoveModule( Address64 moduleBase );
+        void RemoveContext( ExprContext* context );
+
+        // Starts counting the stats of the next stop.
+        void EndStop();
+
+        // Lets go of the expressions, and doesn't take any more.
+        void Dispose();
+
+        void GetStats( ParsedExprCacheStats& stats );
+        void GetStopStats( ParsedExprCacheStats& stats );
+
+    private:
+        static void MakeKey(
+            Address64 moduleBase,
+            const MagoST::SymHandle& funcSH,
+            MagoEE::ITypeEnv* typeEnv,
+            ExprContext* context,
+            const wchar_t* text,
+            uint32_t flags,
+            uint32_t radix,
+            Key& key );
+
+        void Evict( EntryList::iterator it );
+    };
+}
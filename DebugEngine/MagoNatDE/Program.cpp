@@ -340,11 +340,15 @@ namespace Mago
 
     HRESULT Program::Execute()
     {
+        mParsedExprs.EndStop();
+
         return mDebugger->Execute( GetCoreProcess(), !mPassExceptionToDebuggee );
     }
 
     HRESULT Program::Continue( IDebugThread2 *pThread )
     {
+        mParsedExprs.EndStop();
+
         return mDebugger->Continue( GetCoreProcess(), !mPassExceptionToDebuggee );
     }
 
@@ -355,6 +359,8 @@ namespace Mago
 
         HRESULT hr = S_OK;
 
+        mParsedExprs.EndStop();
+
         hr = StepInternal( pThread, sk, step );
         if ( FAILED( hr ) )
         {
@@ -390,6 +396,11 @@ namespace Mago
 
     void Program::Dispose()
     {
+        for ( ThreadMap::iterator it = mThreadMap.begin(); it != mThreadMap.end(); it++ )
+        {
+            it->second->Dispose();
+        }
+
         mThreadMap.clear();
 
         for ( ModuleMap::iterator it = mModMap.begin(); it != mModMap.end(); it++ )
@@ -399,6 +410,9 @@ namespace Mago
 
         mModMap.clear();
 
+        // the expressions hold contexts, which hold threads and modules
+        mParsedExprs.Dispose();
+
         mProgThread.Release();
         mProgMod.Release();
         mEngine.Release();
@@ -469,8 +483,12 @@ namespace Mago
 
     void Program::SetDRuntime( UniquePtr<DRuntime>& druntime )
     {
-        mDRuntime.Attach( NULL );
-        mDRuntime.Swap( druntime );
+        {
+            GuardedArea guard( mDRuntimeGuard );
+
+            mDRuntime.Attach( NULL );
+            mDRuntime.Swap( druntime );
+        }
 
         if ( mDRuntime && mDebugger && mCoreProc )
         {
@@ -481,23 +499,60 @@ namespace Mago
         }
     }
 
+    // This runs on a loader thread once a module's symbols are loaded. The 
+    // symbols and memory are looked up outside of the D runtime guard, 
+    // because both can wait on other threads. A module that's added before 
+    // the D runtime is set is updated again by SetDRuntime.
+
     void Program::UpdateAAVersion( Module* mod )
     {
-        if ( mDRuntime && mDebugger && mCoreProc )
+        if ( (mDebugger == NULL) || (mCoreProc == NULL) )
+            return;
+
         {
-            Address64 addr;
-            uint32_t read, unreadable, ver;
-            if ( FindGlobalSymbolAddress( mod, "__aaVersion", addr ) )
-            {
-                if ( mDebugger->ReadMemory( mCoreProc, addr, 4, read, unreadable, (uint8_t*) &ver ) == S_OK )
-                    mDRuntime->SetAAVersion( ver );
-            }
-            else if ( FindGlobalSymbolAddress( mod, "_D2rt3aaA11fakeEntryTIFxC8TypeInfoxC8TypeInfoZC15TypeInfo_Struct", addr ) )
-                mDRuntime->SetAAVersion( 1 );
+            GuardedArea guard( mDRuntimeGuard );
+
+            if ( !mDRuntime )
+                return;
+        }
+
+        Address64 addr;
+        uint32_t read, unreadable, ver;
+        int aaVersion = -1;
+        Address64 classInfoVtblAddr = 0;
 
-            if ( FindGlobalSymbolAddress( mod, "_D14TypeInfo_Class6__vtblZ", addr ) )
-                mDRuntime->SetClassInfoVtblAddr( mod->GetAddress() + addr );
+        if ( FindGlobalSymbolAddress( mod, "__aaVersion", addr ) )
+        {
+            if ( mDebugger->ReadMemory( mCoreProc, addr, 4, read, unreadable, (uint8_t*) &ver ) == S_OK )
+                aaVersion = ver;
         }
+        else if ( FindGlobalSymbolAddress( mod, "_D2rt3aaA11fakeEntryTIFxC8TypeInfoxC8TypeInfoZC15TypeInfo_Struct", addr ) )
+            aaVersion = 1;
+
+        if ( FindGlobalSymbolAddress( mod, "_D14TypeInfo_Class6__vtblZ", addr ) )
+            classInfoVtblAddr = mod->GetAddress() + addr;
+
+        GuardedArea guard( mDRuntimeGuard );
+
+        if ( !mDRuntime )
+            return;
+
+        if ( aaVersion != -1 )
+            mDRuntime->SetAAVersion( aaVersion );
+
+        if ( classInfoVtblAddr != 0 )
+            mDRuntime->SetClassInfoVtblAddr( classInfoVtblAddr );
+    }
+
+    ParsedExprCache* Program::GetParsedExprCache()
+    {
+        return &mParsedExprs;
+    }
+
+    void Program::GetParsedExprStats( ParsedExprCacheStats& stats, ParsedExprCacheStats& stopStats )
+    {
+        mParsedExprs.GetStats( stats );
+        mParsedExprs.GetStopStats( stopStats );
     }
 
     bool Program::GetAttached()
@@ -588,6 +643,8 @@ namespace Mago
     {
         GuardedArea guard( mThreadGuard );
         mThreadMap.erase( thread->GetCoreThread()->GetTid() );
+
+        thread->Dispose();
     }
 
     Address64 Program::FindEntryPoint()
@@ -609,7 +666,11 @@ namespace Mago
         mod->SetId( mEngine->GetNextModuleId() );
         mod->SetCoreModule( coreModule );
 
-        return hr;
+        hr = mod->InitSymbolLoad();
+        if ( FAILED( hr ) )
+            return hr;
+
+        return S_OK;
     }
 
     HRESULT Program::AddModule( Module* mod )
@@ -680,6 +741,8 @@ namespace Mago
 
         mModMap.erase( mod->GetAddress() );
 
+        mParsedExprs.RemoveModule( mod->GetAddress() );
+
         mod->Dispose();
     }
 
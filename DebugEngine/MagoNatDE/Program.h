@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include "ParsedExprCache.h"
+
 
 namespace Mago
 {
@@ -47,11 +49,13 @@ namespace Mago
         Guard                           mThreadGuard;
         Guard                           mModGuard;
         Guard                           mBPGuard;
+        Guard                           mDRuntimeGuard;     // modules update it from loader threads
         DWORD                           mNextModLoadIndex;  // protected by mod guard
         Address64                       mEntryPoint;
         RefPtr<Module>                  mProgMod;
         RefPtr<Thread>                  mProgThread;
         UniquePtr<DRuntime>             mDRuntime;
+        ParsedExprCache                 mParsedExprs;
 
     public:
         Program();
@@ -143,6 +147,10 @@ namespace Mago
         void        SetEntryPoint( Address64 address );
         void        UpdateAAVersion( Module* mod );
 
+        ParsedExprCache*    GetParsedExprCache();
+        // The parsed expressions' stats, over all stops and for the current one
+        void        GetParsedExprStats( ParsedExprCacheStats& stats, ParsedExprCacheStats& stopStats );
+
     private:
         HRESULT     StepInternal( IDebugThread2* pThread, STEPKIND sk, STEPUNIT step );
 
@@ -16,6 +16,7 @@
 #include "RemoteEventRpc.h"
 #include "RemoteProcess.h"
 #include "RpcUtil.h"
+#include "..\Exec\MemoryCodec.h"
 #include <MagoDECommon.h>
 
 
@@ -24,6 +25,16 @@
 
 namespace Mago
 {
+    // How much of the stack the agent sends with each stop
+    const uint32_t  SnapshotStackSize = 0x4000;
+
+    // Reads at least this long are packed and pipelined
+    const uint32_t  BulkReadMinSize = 0x4000;
+
+    // How many packed reads can be outstanding at once
+    const uint32_t  BulkReadSlotCount = 4;
+
+
     HRESULT StartAgent( const wchar_t* sessionGuidStr )
     {
         int                 ret = 0;
@@ -327,6 +338,12 @@ Error:
         }
     }
 
+    void RemoteDebuggerProxy::ClearStopState()
+    {
+        mSnapshot.Clear();
+        mContextCache.Clear();
+    }
+
     HCTXCMD RemoteDebuggerProxy::GetContextHandle()
     {
         if ( mEventPhysicalTid == GetCurrentThreadId() )
@@ -413,6 +430,10 @@ Error:
             Create_Launch,
             cmdProcInfo.MachineType,
             archData.Get() );
+
+        // snapshots only save time, so go on without them if they can't be had
+        SetStopSnapshot( coreProc.Get() );
+
         process = coreProc.Detach();
 
         MIDL_user_free( cmdProcInfo.ExePath );
@@ -473,6 +494,9 @@ Error:
             Create_Attach,
             cmdProcInfo.MachineType,
             archData.Get() );
+
+        SetStopSnapshot( coreProc.Get() );
+
         process = coreProc.Detach();
 
         MIDL_user_free( cmdProcInfo.ExePath );
@@ -502,6 +526,42 @@ Error:
         return hr;
     }
 
+    HRESULT SetStopSnapshotNoException( 
+        HCTXCMD hCtx, 
+        uint32_t pid, 
+        MagoRemote_SnapshotSpec& spec )
+    {
+        HRESULT hr = S_OK;
+
+        __try
+        {
+            hr = MagoRemoteCmd_SetStopSnapshot( hCtx, pid, &spec );
+        }
+        __except ( CommonRpcExceptionFilter( RpcExceptionCode() ) )
+        {
+            hr = HRESULT_FROM_WIN32( RpcExceptionCode() );
+        }
+
+        return hr;
+    }
+
+    HRESULT RemoteDebuggerProxy::SetStopSnapshot( ICoreProcess* process )
+    {
+        ArchData*               archData = process->GetArchData();
+        ArchThreadContextSpec   contextSpec;
+        MagoRemote_SnapshotSpec spec = { 0 };
+
+        archData->GetThreadContextSpec( contextSpec );
+
+        spec.StackSize = SnapshotStackSize;
+        spec.ContextSize = contextSpec.Size;
+        spec.MainFeatureMask = contextSpec.FeatureMask;
+        spec.ExtFeatureMask = contextSpec.ExtFeatureMask;
+        spec.PDataSize = archData->GetPDataSize();
+
+        return SetStopSnapshotNoException( GetContextHandle(), process->GetPid(), spec );
+    }
+
     HRESULT RemoteDebuggerProxy::Terminate( ICoreProcess* process )
     {
         _ASSERT( process != NULL );
@@ -511,6 +571,8 @@ Error:
         if ( process->GetProcessType() != CoreProcess_Remote )
             return E_INVALIDARG;
 
+        ClearStopState();
+
         HRESULT hr = S_OK;
 
         __try
@@ -536,6 +598,8 @@ Error:
         if ( process->GetProcessType() != CoreProcess_Remote )
             return E_INVALIDARG;
 
+        ClearStopState();
+
         HRESULT hr = S_OK;
 
         __try
@@ -561,6 +625,8 @@ Error:
         if ( process->GetProcessType() != CoreProcess_Remote )
             return E_INVALIDARG;
 
+        ClearStopState();
+
         HRESULT hr = S_OK;
 
         __try
@@ -577,6 +643,172 @@ Error:
         return hr;
     }
 
+    HRESULT ReadMemoryPackedNoException(
+        RPC_ASYNC_STATE* asyncState, 
+        HCTXCMD hCtx, 
+        uint32_t pid, 
+        Address64 address, 
+        uint32_t length, 
+        unsigned int* lengthRead, 
+        unsigned int* lengthUnreadable, 
+        uint32_t packedCapacity, 
+        unsigned int* packedSize, 
+        BYTE* packed )
+    {
+        HRESULT hr = S_OK;
+
+        __try
+        {
+            MagoRemoteCmd_ReadMemoryPacked(
+                asyncState,
+                hCtx,
+                pid,
+                address,
+                length,
+                lengthRead,
+                lengthUnreadable,
+                packedCapacity,
+                packedSize,
+                packed );
+        }
+        __except ( CommonRpcExceptionFilter( RpcExceptionCode() ) )
+        {
+            hr = HRESULT_FROM_WIN32( RpcExceptionCode() );
+        }
+
+        return hr;
+    }
+
+    // Sends the chunk reads of a BulkMemoryReader to the agent as 
+    // asynchronous calls. Each slot has its own call state, completion event, 
+    // and buffer for the packed memory.
+
+    class RpcBulkReadTransport : public IBulkReadTransport
+    {
+        struct Slot
+        {
+            RPC_ASYNC_STATE         AsyncState;
+            HandlePtr               Event;
+            bool                    Busy;
+            unsigned int            LengthRead;
+            unsigned int            LengthUnreadable;
+            unsigned int            PackedSize;
+            std::vector<uint8_t>    Packed;
+        };
+
+        HCTXCMD     mhContext;
+        uint32_t    mPid;
+        Slot        mSlots[BulkReadSlotCount];
+
+    public:
+        RpcBulkReadTransport( HCTXCMD hContext, uint32_t pid )
+            :   mhContext( hContext ),
+                mPid( pid )
+        {
+            for ( int i = 0; i < _countof( mSlots ); i++ )
+                mSlots[i].Busy = false;
+        }
+
+        ~RpcBulkReadTransport()
+        {
+            for ( uint32_t i = 0; i < _countof( mSlots ); i++ )
+            {
+                if ( mSlots[i].Busy )
+                {
+                    HRESULT hr = S_OK;
+
+                    // an aborted call doesn't signal its event, but still 
+                    // has to be completed to free it
+                    RpcAsyncCancelCall( &mSlots[i].AsyncState, TRUE );
+                    RpcAsyncCompleteCall( &mSlots[i].AsyncState, &hr );
+                }
+            }
+        }
+
+        virtual uint32_t GetSlotCount()
+        {
+            return _countof( mSlots );
+        }
+
+        virtual HRESULT BeginRead( uint32_t slotIndex, Address64 address, uint32_t length )
+        {
+            _ASSERT( slotIndex < _countof( mSlots ) );
+            _ASSERT( length <= MagoRemote_MaxReadMemoryPackedSize );
+
+            Slot&       slot = mSlots[slotIndex];
+            RPC_STATUS  rpcRet = RPC_S_OK;
+            HRESULT     hr = S_OK;
+            uint32_t    packedCapacity = GetMaxPackedSize( length );
+
+            _ASSERT( !slot.Busy );
+
+            if ( slot.Event.IsEmpty() )
+            {
+                slot.Event = CreateEvent( NULL, FALSE, FALSE, NULL );
+                if ( slot.Event.IsEmpty() )
+                    return GetLastHr();
+            }
+
+            rpcRet = RpcAsyncInitializeHandle( &slot.AsyncState, sizeof slot.AsyncState );
+            if ( rpcRet != RPC_S_OK )
+                return HRESULT_FROM_WIN32( rpcRet );
+
+            slot.AsyncState.UserInfo = NULL;
+            slot.AsyncState.NotificationType = RpcNotificationTypeEvent;
+            slot.AsyncState.u.hEvent = slot.Event.Get();
+
+            slot.LengthRead = 0;
+            slot.LengthUnreadable = 0;
+            slot.PackedSize = 0;
+            slot.Packed.resize( (packedCapacity > 0) ? packedCapacity : 1 );
+
+            hr = ReadMemoryPackedNoException(
+                &slot.AsyncState,
+                mhContext,
+                mPid,
+                address,
+                length,
+                &slot.LengthRead,
+                &slot.LengthUnreadable,
+                packedCapacity,
+                &slot.PackedSize,
+                &slot.Packed[0] );
+            if ( FAILED( hr ) )
+                return hr;
+
+            slot.Busy = true;
+            return S_OK;
+        }
+
+        virtual void EndRead( uint32_t slotIndex, BulkReadChunk& chunk )
+        {
+            _ASSERT( slotIndex < _countof( mSlots ) );
+
+            Slot&       slot = mSlots[slotIndex];
+            RPC_STATUS  rpcRet = RPC_S_OK;
+            HRESULT     hr = S_OK;
+
+            _ASSERT( slot.Busy );
+
+            WaitForSingleObject( slot.Event.Get(), INFINITE );
+
+            rpcRet = RpcAsyncCompleteCall( &slot.AsyncState, &hr );
+            if ( rpcRet != RPC_S_OK )
+                hr = HRESULT_FROM_WIN32( rpcRet );
+
+            slot.Busy = false;
+
+            chunk.Result = hr;
+            chunk.LengthRead = slot.LengthRead;
+            chunk.LengthUnreadable = slot.LengthUnreadable;
+            chunk.PackedSize = slot.PackedSize;
+            chunk.Packed = &slot.Packed[0];
+
+            if ( SUCCEEDED( hr ) && (slot.PackedSize > slot.Packed.size()) )
+                chunk.Result = E_UNEXPECTED;
+        }
+    };
+
     HRESULT RemoteDebuggerProxy::ReadMemory( 
         ICoreProcess* process, 
         Address64 address,
@@ -592,6 +824,16 @@ Error:
         if ( process->GetProcessType() != CoreProcess_Remote )
             return E_INVALIDARG;
 
+        if ( mSnapshot.ReadMemory( process->GetPid(), address, length, buffer ) )
+        {
+            lengthRead = length;
+            lengthUnreadable = 0;
+            return S_OK;
+        }
+
+        if ( length >= BulkReadMinSize )
+            return ReadBulkMemory( process, address, length, lengthRead, lengthUnreadable, buffer );
+
         HRESULT hr = S_OK;
 
         __try
@@ -613,6 +855,120 @@ Error:
         return hr;
     }
 
+    HRESULT RemoteDebuggerProxy::ReadBulkMemory( 
+        ICoreProcess* process, 
+        Address64 address,
+        uint32_t length, 
+        uint32_t& lengthRead, 
+        uint32_t& lengthUnreadable, 
+        uint8_t* buffer )
+    {
+        RpcBulkReadTransport    transport( GetContextHandle(), process->GetPid() );
+
+        return mBulkReader.Read( &transport, address, length, lengthRead, lengthUnreadable, buffer );
+    }
+
+    HRESULT ReadMemoryVNoException(
+        ICoreProcess* process, 
+        HCTXCMD hCtx, 
+        uint32_t rangeCount, 
+        MagoRemote_ReadMemoryRange* ranges, 
+        uint32_t bufferSize, 
+        BYTE* buffer )
+    {
+        HRESULT hr = S_OK;
+
+        __try
+        {
+            hr = MagoRemoteCmd_ReadMemoryV(
+                hCtx,
+                process->GetPid(),
+                rangeCount,
+                ranges,
+                bufferSize,
+                buffer );
+        }
+        __except ( CommonRpcExceptionFilter( RpcExceptionCode() ) )
+        {
+            hr = HRESULT_FROM_WIN32( RpcExceptionCode() );
+        }
+
+        return hr;
+    }
+
+    HRESULT RemoteDebuggerProxy::ReadMemoryV( 
+        ICoreProcess* process, 
+        uint32_t rangeCount, 
+        ReadMemoryRange64* ranges, 
+        uint8_t** buffers )
+    {
+        _ASSERT( process != NULL );
+        if ( process == NULL || ((rangeCount > 0) && (ranges == NULL || buffers == NULL)) )
+            return E_INVALIDARG;
+
+        if ( process->GetProcessType() != CoreProcess_Remote )
+            return E_INVALIDARG;
+
+        if ( rangeCount == 0 )
+            return S_OK;
+
+        HRESULT     hr = S_OK;
+        uint32_t    bufferSize = 0;
+        std::vector<MagoRemote_ReadMemoryRange> cmdRanges;
+        std::vector<uint32_t>                   cmdIndexes;
+
+        // the blocks come back one after another in a single buffer
+        for ( uint32_t i = 0; i < rangeCount; i++ )
+        {
+            if ( mSnapshot.ReadMemory( process->GetPid(), ranges[i].Addr, ranges[i].Length, buffers[i] ) )
+            {
+                ranges[i].LengthRead = ranges[i].Length;
+                ranges[i].LengthUnreadable = 0;
+                continue;
+            }
+
+            if ( ranges[i].Length > MagoRemote_MaxReadMemoryVSize - bufferSize )
+                return E_INVALIDARG;
+
+            MagoRemote_ReadMemoryRange  cmdRange = { 0 };
+
+            cmdRange.Addr = ranges[i].Addr;
+            cmdRange.Length = ranges[i].Length;
+            cmdRanges.push_back( cmdRange );
+            cmdIndexes.push_back( i );
+            bufferSize += ranges[i].Length;
+        }
+
+        if ( cmdRanges.empty() )
+            return S_OK;
+
+        std::vector<BYTE>   buffer( (bufferSize > 0) ? bufferSize : 1 );
+
+        hr = ReadMemoryVNoException( 
+            process, GetContextHandle(), (uint32_t) cmdRanges.size(), &cmdRanges[0], bufferSize, &buffer[0] );
+        if ( FAILED( hr ) )
+            return hr;
+
+        uint32_t    offset = 0;
+
+        for ( size_t j = 0; j < cmdRanges.size(); j++ )
+        {
+            uint32_t    i = cmdIndexes[j];
+            uint32_t    lengthRead = cmdRanges[j].LengthRead;
+
+            if ( lengthRead > ranges[i].Length )
+                return E_UNEXPECTED;
+
+            memcpy( buffers[i], &buffer[offset], lengthRead );
+
+            ranges[i].LengthRead = lengthRead;
+            ranges[i].LengthUnreadable = cmdRanges[j].LengthUnreadable;
+            offset += ranges[i].Length;
+        }
+
+        return S_OK;
+    }
+
     HRESULT RemoteDebuggerProxy::WriteMemory( 
         ICoreProcess* process, 
         Address64 address,
@@ -627,6 +983,8 @@ Error:
         if ( process->GetProcessType() != CoreProcess_Remote )
             return E_INVALIDARG;
 
+        mSnapshot.Clear();
+
         HRESULT hr = S_OK;
 
         __try
@@ -708,6 +1066,8 @@ Error:
         if ( process->GetProcessType() != CoreProcess_Remote )
             return E_INVALIDARG;
 
+        ClearStopState();
+
         HRESULT hr = S_OK;
 
         __try
@@ -735,6 +1095,8 @@ Error:
         if ( process->GetProcessType() != CoreProcess_Remote )
             return E_INVALIDARG;
 
+        ClearStopState();
+
         HRESULT hr = S_OK;
 
         __try
@@ -763,6 +1125,8 @@ Error:
         if ( process->GetProcessType() != CoreProcess_Remote )
             return E_INVALIDARG;
 
+        ClearStopState();
+
         HRESULT hr = S_OK;
 
         __try
@@ -793,6 +1157,8 @@ Error:
         if ( process->GetProcessType() != CoreProcess_Remote )
             return E_INVALIDARG;
 
+        ClearStopState();
+
         HRESULT hr = S_OK;
 
         __try
@@ -819,6 +1185,8 @@ Error:
         if ( process->GetProcessType() != CoreProcess_Remote )
             return E_INVALIDARG;
 
+        ClearStopState();
+
         HRESULT hr = S_OK;
 
         __try
@@ -915,9 +1283,29 @@ Error:
         if ( context.IsEmpty() )
             return E_OUTOFMEMORY;
 
-        hr = GetThreadContextNoException( process, thread, GetContextHandle(), contextSpec, context.Get() );
-        if ( FAILED( hr ) )
-            return hr;
+        if ( !mContextCache.Find( 
+            process->GetPid(), 
+            thread->GetTid(), 
+            contextSpec.FeatureMask, 
+            contextSpec.ExtFeatureMask, 
+            contextSpec.Size, 
+            context.Get() ) )
+        {
+            if ( !mSnapshot.GetThreadContext( process->GetPid(), thread->GetTid(), contextSpec.Size, context.Get() ) )
+            {
+                hr = GetThreadContextNoException( process, thread, GetContextHandle(), contextSpec, context.Get() );
+                if ( FAILED( hr ) )
+                    return hr;
+            }
+
+            mContextCache.Add( 
+                process->GetPid(), 
+                thread->GetTid(), 
+                contextSpec.FeatureMask, 
+                contextSpec.ExtFeatureMask, 
+                context.Get(), 
+                contextSpec.Size );
+        }
 
         hr = archData->BuildRegisterSet( context.Get(), contextSpec.Size, regSet );
         if ( FAILED( hr ) )
@@ -939,6 +1327,8 @@ Error:
             || thread->GetProcessType() != CoreProcess_Remote )
             return E_INVALIDARG;
 
+        mSnapshot.Clear();
+
         HRESULT         hr = S_OK;
         const void*     contextBuf = NULL;
         uint32_t        contextSize = 0;
@@ -960,6 +1350,9 @@ Error:
             hr = HRESULT_FROM_WIN32( RpcExceptionCode() );
         }
 
+        if ( SUCCEEDED( hr ) )
+            mContextCache.Invalidate( process->GetPid(), thread->GetTid() );
+
         return hr;
     }
 
@@ -981,6 +1374,12 @@ Error:
 
         HRESULT         hr = S_OK;
 
+        if ( mSnapshot.GetPData( process->GetPid(), address, imageBase, process->GetArchData(), size, pdata ) )
+        {
+            sizeRead = size;
+            return S_OK;
+        }
+
         __try
         {
             hr = MagoRemoteCmd_GetPData(
@@ -1100,19 +1499,40 @@ Error:
             exceptRec.ExceptionInformation[j] = exceptRecords[0].ExceptionInformation[j];
         }
 
-        return (MagoRemote_RunMode) 
-            mCallback->OnException( pid, threadId, firstChance, &exceptRec );
+        RunMode mode = mCallback->OnException( pid, threadId, firstChance, &exceptRec );
+
+        // the agent runs the debuggee without being told to
+        if ( mode == RunMode_Run )
+            ClearStopState();
+
+        return (MagoRemote_RunMode) mode;
     }
 
     MagoRemote_RunMode RemoteDebuggerProxy::OnBreakpoint( 
-        uint32_t pid, uint32_t threadId, MagoRemote_Address address, bool embedded )
+        uint32_t pid, 
+        uint32_t threadId, 
+        MagoRemote_Address address, 
+        bool embedded, 
+        MagoRemote_StopSnapshot* snapshot )
     {
-        return (MagoRemote_RunMode) 
-            mCallback->OnBreakpoint( pid, threadId, (Address64) address, embedded );
+        RunMode mode = RunMode_Run;
+
+        mSnapshot.Set( pid, threadId, snapshot );
+
+        mode = mCallback->OnBreakpoint( pid, threadId, (Address64) address, embedded );
+
+        // the agent runs the debuggee without being told to
+        if ( mode == RunMode_Run )
+            ClearStopState();
+
+        return (MagoRemote_RunMode) mode;
     }
 
-    void RemoteDebuggerProxy::OnStepComplete( uint32_t pid, uint32_t threadId )
+    void RemoteDebuggerProxy::OnStepComplete( 
+        uint32_t pid, uint32_t threadId, MagoRemote_StopSnapshot* snapshot )
     {
+        mSnapshot.Set( pid, threadId, snapshot );
+
         mCallback->OnStepComplete( pid, threadId );
     }
 
@@ -1141,6 +1561,9 @@ Error:
         thunkRange->Begin = execThunkRange.Begin;
         thunkRange->End = execThunkRange.End;
 
+        if ( (mode == ProbeRunMode_Run) || (mode == ProbeRunMode_WalkThunk) )
+            ClearStopState();
+
         return (MagoRemote_ProbeRunMode) mode;
     }
 
@@ -7,8 +7,11 @@
 
 #pragma once
 
+#include "BulkMemoryReader.h"
 #include "IDebuggerProxy.h"
 #include "IRemoteEventCallback.h"
+#include "StopSnapshot.h"
+#include "ThreadContextCache.h"
 
 
 typedef void* HCTXCMD;
@@ -32,6 +35,9 @@ namespace Mago
         HCTXCMD                 mhContext[2];
         DWORD                   mEventPhysicalTid;
         std::wstring            mSymbolSearchPath;
+        StopSnapshot            mSnapshot;
+        BulkMemoryReader        mBulkReader;
+        ThreadContextCache      mContextCache;
 
     public:
         RemoteDebuggerProxy();
@@ -62,6 +68,12 @@ namespace Mago
             uint32_t& lengthUnreadable, 
             uint8_t* buffer );
 
+        HRESULT ReadMemoryV( 
+            ICoreProcess* process, 
+            uint32_t rangeCount, 
+            ReadMemoryRange64* ranges, 
+            uint8_t** buffers );
+
         HRESULT WriteMemory( 
             ICoreProcess* process, 
             Address64 address,
@@ -115,9 +127,14 @@ namespace Mago
             MagoRemote_ExceptionRecord* exceptRecords );
 
         virtual MagoRemote_RunMode OnBreakpoint( 
-            uint32_t pid, uint32_t threadId, MagoRemote_Address address, bool embedded );
+            uint32_t pid, 
+            uint32_t threadId, 
+            MagoRemote_Address address, 
+            bool embedded, 
+            MagoRemote_StopSnapshot* snapshot );
 
-        virtual void OnStepComplete( uint32_t pid, uint32_t threadId );
+        virtual void OnStepComplete( 
+            uint32_t pid, uint32_t threadId, MagoRemote_StopSnapshot* snapshot );
         virtual void OnAsyncBreakComplete( uint32_t pid, uint32_t threadId );
 
         virtual MagoRemote_ProbeRunMode OnCallProbe( 
@@ -131,11 +148,20 @@ namespace Mago
 
     private:
         HCTXCMD GetContextHandle();
+        void ClearStopState();
         HRESULT LaunchNoException( 
             MagoRemote_LaunchInfo& cmdLaunchInfo, 
             MagoRemote_ProcInfo& cmdProcInfo );
         HRESULT AttachNoException( 
             uint32_t pid, 
             MagoRemote_ProcInfo& cmdProcInfo );
+        HRESULT SetStopSnapshot( ICoreProcess* process );
+        HRESULT ReadBulkMemory( 
+            ICoreProcess* process, 
+            Address64 address,
+            uint32_t length, 
+            uint32_t& lengthRead, 
+            uint32_t& lengthUnreadable, 
+            uint8_t* buffer );
     };
 }
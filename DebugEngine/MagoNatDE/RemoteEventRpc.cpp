@@ -237,7 +237,8 @@ MagoRemote_RunMode MagoRemoteEvent_OnBreakpoint(
     /* [in] */ unsigned int pid,
     /* [in] */ unsigned int threadId,
     /* [in] */ MagoRemote_Address address,
-    /* [in] */ boolean embedded)
+    /* [in] */ boolean embedded,
+    /* [in][unique] */ MagoRemote_StopSnapshot *snapshot)
 {
     if ( hContext == NULL )
         return MagoRemote_RunMode_Run;
@@ -249,7 +250,8 @@ MagoRemote_RunMode MagoRemoteEvent_OnBreakpoint(
         pid, 
         threadId, 
         address, 
-        embedded ? true : false );
+        embedded ? true : false, 
+        snapshot );
     context->Callback->SetEventLogicalThread( false );
 
     return mode;
@@ -258,7 +260,8 @@ MagoRemote_RunMode MagoRemoteEvent_OnBreakpoint(
 void MagoRemoteEvent_OnStepComplete( 
     /* [in] */ HCTXEVENT hContext,
     /* [in] */ unsigned int pid,
-    /* [in] */ unsigned int threadId)
+    /* [in] */ unsigned int threadId,
+    /* [in][unique] */ MagoRemote_StopSnapshot *snapshot)
 {
     if ( hContext == NULL )
         return;
@@ -266,7 +269,7 @@ void MagoRemoteEvent_OnStepComplete(
     EventContext*   context = (EventContext*) hContext;
 
     context->Callback->SetEventLogicalThread( true );
-    context->Callback->OnStepComplete( pid, threadId );
+    context->Callback->OnStepComplete( pid, threadId, snapshot );
     context->Callback->SetEventLogicalThread( false );
 }
 
@@ -28,6 +28,8 @@ namespace Mago
 
     StackFrame::~StackFrame()
     {
+        if ( mExprContext != NULL )
+            mExprContext->Dispose();
     }
 
     HRESULT StackFrame::GetCodeContext( 
@@ -0,0 +1,703 @@
+/*
+   Copyright (c) 2014 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "Common.h"
+#include "StackWalkerX64.h"
+
+
+namespace Mago
+{
+namespace
+{
+    // The layout of UNWIND_INFO and its unwind codes comes from the x64
+    // exception handling documentation. WinNT.h only has part of it, and
+    // only in x64 builds.
+
+    enum UnwindOp
+    {
+        UnwindOp_PushNonVol     = 0,
+        UnwindOp_AllocLarge     = 1,
+        UnwindOp_AllocSmall     = 2,
+        UnwindOp_SetFPReg       = 3,
+        UnwindOp_SaveNonVol     = 4,
+        UnwindOp_SaveNonVolFar  = 5,
+        UnwindOp_Epilog         = 6,    // UWOP_SAVE_XMM in version 1
+        UnwindOp_SpareCode      = 7,    // UWOP_SAVE_XMM_FAR in version 1
+        UnwindOp_SaveXmm128     = 8,
+        UnwindOp_SaveXmm128Far  = 9,
+        UnwindOp_PushMachFrame  = 10,
+    };
+
+    const uint8_t   UnwindFlag_ChainInfo = 4;
+
+    const uint32_t  UnwindInfoHeaderSize = 4;
+    const uint32_t  UnwindCodeSize = 2;
+    const uint32_t  MaxUnwindCodes = 255;
+    const uint32_t  MaxUnwindInfoSize =
+        UnwindInfoHeaderSize
+        + (MaxUnwindCodes + 1) * UnwindCodeSize
+        + sizeof( IMAGE_RUNTIME_FUNCTION_ENTRY );
+
+    // A function's unwind info can point to the unwind info of another part
+    // of the function. Stop following it after this many.
+    const int       MaxChainDepth = 32;
+
+    // Enough code to hold the longest epilog
+    const uint32_t  MaxEpilogSize = 64;
+
+    const uint32_t  RegRsp = 4;
+
+    uint8_t GetUnwindVersion( const uint8_t* unwindInfo )
+    {
+        return unwindInfo[0] & 7;
+    }
+
+    uint8_t GetUnwindFlags( const uint8_t* unwindInfo )
+    {
+        return unwindInfo[0] >> 3;
+    }
+
+    uint8_t GetPrologSize( const uint8_t* unwindInfo )
+    {
+        return unwindInfo[1];
+    }
+
+    uint8_t GetUnwindCodeCount( const uint8_t* unwindInfo )
+    {
+        return unwindInfo[2];
+    }
+
+    uint8_t GetFrameRegister( const uint8_t* unwindInfo )
+    {
+        return unwindInfo[3] & 0xF;
+    }
+
+    uint8_t GetFrameOffset( const uint8_t* unwindInfo )
+    {
+        return unwindInfo[3] >> 4;
+    }
+
+    // The codes are padded to an even count, and the chained entry follows.
+    uint32_t GetChainedEntryOffset( const uint8_t* unwindInfo )
+    {
+        uint32_t    slotCount = (GetUnwindCodeCount( unwindInfo ) + 1) & ~1;
+
+        return UnwindInfoHeaderSize + slotCount * UnwindCodeSize;
+    }
+
+    uint32_t GetUnwindInfoSize( const uint8_t* unwindInfo )
+    {
+        uint32_t    size = GetChainedEntryOffset( unwindInfo );
+
+        if ( (GetUnwindFlags( unwindInfo ) & UnwindFlag_ChainInfo) != 0 )
+            size += sizeof( IMAGE_RUNTIME_FUNCTION_ENTRY );
+
+        return size;
+    }
+
+    uint32_t GetUnwindCodeSlots( uint8_t op, uint8_t opInfo )
+    {
+        switch ( op )
+        {
+        case UnwindOp_AllocLarge:
+            return (opInfo == 0) ? 2 : 3;
+
+        case UnwindOp_SaveNonVol:
+        case UnwindOp_SaveXmm128:
+        case UnwindOp_Epilog:
+            return 2;
+
+        case UnwindOp_SaveNonVolFar:
+        case UnwindOp_SaveXmm128Far:
+        case UnwindOp_SpareCode:
+            return 3;
+
+        default:
+            return 1;
+        }
+    }
+
+    uint16_t ReadUInt16( const uint8_t* p )
+    {
+        return (uint16_t) (p[0] | (p[1] << 8));
+    }
+
+    uint32_t ReadUInt32( const uint8_t* p )
+    {
+        return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+    }
+
+    // The unwind codes number the integer registers in the same order as
+    // they're laid out in the context, starting at Rax.
+    DWORD64& GetIntReg( CONTEXT_X64& context, uint32_t reg )
+    {
+        _ASSERT( reg < 16 );
+        return (&context.Rax)[reg];
+    }
+
+    M128A& GetXmmReg( CONTEXT_X64& context, uint32_t reg )
+    {
+        _ASSERT( reg < 16 );
+        return (&context.Xmm0)[reg];
+    }
+
+    struct Epilog
+    {
+        enum AdjustKind
+        {
+            Adjust_None,
+            Adjust_Add,     // add rsp, imm
+            Adjust_Lea,     // lea rsp, [frameReg + disp]
+        };
+
+        AdjustKind  Adjust;
+        int64_t     Disp;
+        uint32_t    PopCount;
+        uint8_t     Pops[16];
+    };
+
+    // Decides whether the code at the PC is an epilog, and if so, what it
+    // does. An epilog is an optional stack adjustment, any number of pops
+    // of nonvolatile registers, and a return or a jump out of the function.
+    // That's all that's allowed in one, so it can be recognized without the
+    // unwind info describing it.
+
+    bool IsInFunction(
+        uint64_t address,
+        uint64_t imageBase,
+        const IMAGE_RUNTIME_FUNCTION_ENTRY& funcEntry )
+    {
+        return (address >= imageBase + funcEntry.BeginAddress)
+            && (address < imageBase + funcEntry.EndAddress);
+    }
+
+    // A jump to the part of the function that holds the PC, or to the 
+    // primary part that the other parts are chained to, stays in the 
+    // function, so it isn't a tail call.
+
+    bool DecodeEpilog(
+        const uint8_t* code,
+        uint32_t codeLen,
+        uint64_t pc,
+        uint64_t imageBase,
+        const IMAGE_RUNTIME_FUNCTION_ENTRY& funcEntry,
+        const IMAGE_RUNTIME_FUNCTION_ENTRY& primaryEntry,
+        uint32_t frameReg,
+        Epilog& epilog )
+    {
+        uint32_t    i = 0;
+
+        epilog.Adjust = Epilog::Adjust_None;
+        epilog.Disp = 0;
+        epilog.PopCount = 0;
+
+        if ( (codeLen >= 4) && (code[0] == 0x48) && (code[1] == 0x83) && (code[2] == 0xC4) )
+        {
+            epilog.Adjust = Epilog::Adjust_Add;
+            epilog.Disp = (int8_t) code[3];
+            i = 4;
+        }
+        else if ( (codeLen >= 7) && (code[0] == 0x48) && (code[1] == 0x81) && (code[2] == 0xC4) )
+        {
+            epilog.Adjust = Epilog::Adjust_Add;
+            epilog.Disp = (int32_t) ReadUInt32( &code[3] );
+            i = 7;
+        }
+        else if ( (codeLen >= 3)
+            && ((code[0] & 0xFE) == 0x48)
+            && (code[1] == 0x8D)
+            && ((code[2] & 0x38) == (RegRsp << 3)) )
+        {
+            uint8_t     mod = code[2] >> 6;
+            uint8_t     rm = code[2] & 7;
+            uint32_t    baseReg = rm | ((code[0] & 1) << 3);
+
+            // an rm of 4 means a SIB byte follows, which an epilog doesn't use
+            if ( (frameReg == 0) || (baseReg != frameReg) || (rm == RegRsp) )
+                return false;
+
+            if ( (mod == 1) && (codeLen >= 4) )
+            {
+                epilog.Disp = (int8_t) code[3];
+                i = 4;
+            }
+            else if ( (mod == 2) && (codeLen >= 7) )
+            {
+                epilog.Disp = (int32_t) ReadUInt32( &code[3] );
+                i = 7;
+            }
+            else
+                return false;
+
+            epilog.Adjust = Epilog::Adjust_Lea;
+        }
+
+        for ( ; ; )
+        {
+            uint32_t    reg = 0;
+
+            if ( (i < codeLen) && ((code[i] & 0xF8) == 0x58) )
+            {
+                reg = code[i] & 7;
+                i += 1;
+            }
+            else if ( (i + 1 < codeLen) && (code[i] == 0x41) && ((code[i + 1] & 0xF8) == 0x58) )
+            {
+                reg = 8 + (code[i + 1] & 7);
+                i += 2;
+            }
+            else
+                break;
+
+            if ( (reg == RegRsp) || (epilog.PopCount == _countof( epilog.Pops )) )
+                return false;
+
+            epilog.Pops[epilog.PopCount++] = (uint8_t) reg;
+        }
+
+        // ret or rep ret
+        if ( (i < codeLen) && (code[i] == 0xC3) )
+            return true;
+
+        if ( (i + 1 < codeLen) && (code[i] == 0xF3) && (code[i + 1] == 0xC3) )
+            return true;
+
+        // a tail call, which has to leave the function
+        if ( (i + 5 <= codeLen) && (code[i] == 0xE9) )
+        {
+            uint64_t    target = pc + i + 5 + (int32_t) ReadUInt32( &code[i + 1] );
+
+            return !IsInFunction( target, imageBase, funcEntry )
+                && !IsInFunction( target, imageBase, primaryEntry );
+        }
+
+        // jmp qword ptr [rip + disp32], with or without REX.W
+        if ( (i + 6 <= codeLen) && (code[i] == 0xFF) && (code[i + 1] == 0x25) )
+            return true;
+
+        if ( (i + 7 <= codeLen) && (code[i] == 0x48) && (code[i + 1] == 0xFF) && (code[i + 2] == 0x25) )
+            return true;
+
+        return false;
+    }
+}
+
+
+    StackWalkerX64::StackWalkerX64(
+        void* processContext,
+        ReadProcessMemory64Proc readMemProc,
+        FunctionTableAccess64Proc funcTabProc,
+        GetModuleBase64Proc getModBaseProc )
+        :   mProcessContext( processContext ),
+            mReadMemProc( readMemProc ),
+            mFuncTabProc( funcTabProc ),
+            mGetModBaseProc( getModBaseProc ),
+            mThreadContextSize( 0 ),
+            mFrameCount( 0 ),
+            mDone( false ),
+            mStackBlockAddr( 0 ),
+            mStackBlockLen( 0 ),
+            mStackReads( 0 ),
+            mUnwindInfoReads( 0 )
+    {
+    }
+
+    void StackWalkerX64::GetStats( StackWalkerX64Stats& stats )
+    {
+        stats.Frames = mFrameCount;
+        stats.StackReads = mStackReads;
+        stats.UnwindInfoReads = mUnwindInfoReads;
+    }
+
+    HRESULT StackWalkerX64::Init( const void* threadContext, uint32_t threadContextSize )
+    {
+        if ( threadContext == NULL )
+            return E_INVALIDARG;
+
+        _ASSERT( threadContextSize >= sizeof( CONTEXT_X64 ) );
+        if ( threadContextSize < sizeof( CONTEXT_X64 ) )
+            return E_INVALIDARG;
+
+        mThreadContext.Attach( new BYTE[threadContextSize] );
+        if ( mThreadContext.Get() == NULL )
+            return E_OUTOFMEMORY;
+
+        mThreadContextSize = threadContextSize;
+
+        memcpy( mThreadContext.Get(), threadContext, threadContextSize );
+        return S_OK;
+    }
+
+    bool StackWalkerX64::WalkStack()
+    {
+        if ( (mThreadContext.Get() == NULL) || mDone )
+            return false;
+
+        // like StackWalk64, the first frame is the one in the thread context
+        if ( mFrameCount == 0 )
+        {
+            mFrameCount++;
+            return true;
+        }
+
+        // unwind a copy, so that a failure leaves the last frame alone
+        CONTEXT_X64     context;
+
+        memcpy( &context, mThreadContext.Get(), sizeof context );
+
+        bool    ok = UnwindFrame( context, mFrameCount == 1 );
+
+        // the stack only grows down, so a caller's frame has to be above
+        if ( !ok
+            || (context.Rip == 0)
+            || (context.Rsp <= ((CONTEXT_X64*) mThreadContext.Get())->Rsp) )
+        {
+            mDone = true;
+            return false;
+        }
+
+        memcpy( mThreadContext.Get(), &context, sizeof context );
+        mFrameCount++;
+        return true;
+    }
+
+    void StackWalkerX64::GetThreadContext( const void*& context, uint32_t& contextSize )
+    {
+        context = mThreadContext.Get();
+        contextSize = mThreadContextSize;
+    }
+
+    bool StackWalkerX64::UnwindFrame( CONTEXT_X64& context, bool topFrame )
+    {
+        uint64_t    pc = context.Rip;
+        uint64_t    imageBase = mGetModBaseProc( mProcessContext, pc );
+        const IMAGE_RUNTIME_FUNCTION_ENTRY* funcEntryPtr = NULL;
+
+        if ( imageBase != 0 )
+            funcEntryPtr = (const IMAGE_RUNTIME_FUNCTION_ENTRY*) mFuncTabProc( mProcessContext, pc );
+
+        if ( funcEntryPtr == NULL )
+            return PopReturnAddress( context );
+
+        IMAGE_RUNTIME_FUNCTION_ENTRY    funcEntry = *funcEntryPtr;
+        const uint8_t*                  unwindInfo = NULL;
+
+        if ( !ReadUnwindInfo( imageBase + funcEntry.UnwindInfoAddress, unwindInfo ) )
+            return false;
+
+        // Only the top frame can be stopped in an epilog. Every other frame
+        // is at a return address, where the whole prolog has run and none of
+        // the epilog has.
+        if ( topFrame && (pc - (imageBase + funcEntry.BeginAddress) >= GetPrologSize( unwindInfo )) )
+        {
+            bool    inEpilog = false;
+
+            if ( !UnwindEpilog( context, funcEntry, imageBase, unwindInfo, inEpilog ) )
+                return false;
+
+            if ( inEpilog )
+                return true;
+        }
+
+        for ( int depth = 0; ; depth++ )
+        {
+            // in a chained entry, the offset is outside its prolog, so all
+            // of the codes apply
+            uint64_t    prologOffset = pc - (imageBase + funcEntry.BeginAddress);
+            bool        machineFrame = false;
+
+            if ( !ApplyUnwindCodes( context, unwindInfo, prologOffset, machineFrame ) )
+                return false;
+
+            // the machine frame has the return address and caller's stack
+            if ( machineFrame )
+                return true;
+
+            if ( (GetUnwindFlags( unwindInfo ) & UnwindFlag_ChainInfo) == 0 )
+                break;
+
+            if ( depth >= MaxChainDepth )
+                return false;
+
+            memcpy( &funcEntry, unwindInfo + GetChainedEntryOffset( unwindInfo ), sizeof funcEntry );
+
+            if ( !ReadUnwindInfo( imageBase + funcEntry.UnwindInfoAddress, unwindInfo ) )
+                return false;
+        }
+
+        return PopReturnAddress( context );
+    }
+
+    bool StackWalkerX64::UnwindEpilog(
+        CONTEXT_X64& context,
+        const IMAGE_RUNTIME_FUNCTION_ENTRY& funcEntry,
+        uint64_t imageBase,
+        const uint8_t* unwindInfo,
+        bool& inEpilog )
+    {
+        uint8_t     code[MaxEpilogSize] = { 0 };
+        DWORD       codeLen = 0;
+        Epilog      epilog = { Epilog::Adjust_None };
+        IMAGE_RUNTIME_FUNCTION_ENTRY    primaryEntry = { 0 };
+
+        inEpilog = false;
+
+        if ( !FindPrimaryEntry( funcEntry, imageBase, unwindInfo, primaryEntry ) )
+            return false;
+
+        if ( !mReadMemProc( mProcessContext, context.Rip, code, sizeof code, &codeLen ) )
+            return true;
+
+        if ( !DecodeEpilog(
+            code,
+            codeLen,
+            context.Rip,
+            imageBase,
+            funcEntry,
+            primaryEntry,
+            GetFrameRegister( unwindInfo ),
+            epilog ) )
+            return true;
+
+        inEpilog = true;
+
+        // finish running the epilog
+        if ( epilog.Adjust == Epilog::Adjust_Add )
+            context.Rsp += epilog.Disp;
+        else if ( epilog.Adjust == Epilog::Adjust_Lea )
+            context.Rsp = GetIntReg( context, GetFrameRegister( unwindInfo ) ) + epilog.Disp;
+
+        for ( uint32_t i = 0; i < epilog.PopCount; i++ )
+        {
+            if ( !ReadStack( context.Rsp, &GetIntReg( context, epilog.Pops[i] ), sizeof( DWORD64 ) ) )
+                return false;
+
+            context.Rsp += sizeof( DWORD64 );
+        }
+
+        return PopReturnAddress( context );
+    }
+
+    // Follows the chained unwind info of a part of a function back to the 
+    // entry of the function's primary part.
+
+    bool StackWalkerX64::FindPrimaryEntry(
+        const IMAGE_RUNTIME_FUNCTION_ENTRY& funcEntry,
+        uint64_t imageBase,
+        const uint8_t* unwindInfo,
+        IMAGE_RUNTIME_FUNCTION_ENTRY& primaryEntry )
+    {
+        primaryEntry = funcEntry;
+
+        for ( int depth = 0; (GetUnwindFlags( unwindInfo ) & UnwindFlag_ChainInfo) != 0; depth++ )
+        {
+            if ( depth >= MaxChainDepth )
+                return false;
+
+            memcpy( &primaryEntry, unwindInfo + GetChainedEntryOffset( unwindInfo ), sizeof primaryEntry );
+
+            if ( !ReadUnwindInfo( imageBase + primaryEntry.UnwindInfoAddress, unwindInfo ) )
+                return false;
+        }
+
+        return true;
+    }
+
+    // Undoes the operations of a prolog, last one first. The operations
+    // that come after the prolog offset haven't run yet, so they're skipped.
+
+    bool StackWalkerX64::ApplyUnwindCodes(
+        CONTEXT_X64& context,
+        const uint8_t* unwindInfo,
+        uint64_t prologOffset,
+        bool& machineFrame )
+    {
+        const uint8_t*  codes = unwindInfo + UnwindInfoHeaderSize;
+        uint32_t        count = GetUnwindCodeCount( unwindInfo );
+        uint32_t        i = 0;
+
+        machineFrame = false;
+
+        while ( i < count )
+        {
+            const uint8_t*  slot = codes + i * UnwindCodeSize;
+            uint8_t         codeOffset = slot[0];
+            uint8_t         op = slot[1] & 0xF;
+            uint8_t         opInfo = slot[1] >> 4;
+            uint32_t        slotCount = GetUnwindCodeSlots( op, opInfo );
+
+            if ( i + slotCount > count )
+                return false;
+
+            i += slotCount;
+
+            if ( prologOffset < codeOffset )
+                continue;
+
+            switch ( op )
+            {
+            case UnwindOp_PushNonVol:
+                if ( !ReadStack( context.Rsp, &GetIntReg( context, opInfo ), sizeof( DWORD64 ) ) )
+                    return false;
+                context.Rsp += sizeof( DWORD64 );
+                break;
+
+            case UnwindOp_AllocLarge:
+                if ( opInfo == 0 )
+                    context.Rsp += ReadUInt16( slot + UnwindCodeSize ) * 8;
+                else
+                    context.Rsp += ReadUInt32( slot + UnwindCodeSize );
+                break;
+
+            case UnwindOp_AllocSmall:
+                context.Rsp += opInfo * 8 + 8;
+                break;
+
+            case UnwindOp_SetFPReg:
+                if ( GetFrameRegister( unwindInfo ) == 0 )
+                    return false;
+                context.Rsp = GetIntReg( context, GetFrameRegister( unwindInfo ) )
+                    - GetFrameOffset( unwindInfo ) * 16;
+                break;
+
+            case UnwindOp_SaveNonVol:
+                if ( !ReadStack(
+                    context.Rsp + ReadUInt16( slot + UnwindCodeSize ) * 8,
+                    &GetIntReg( context, opInfo ),
+                    sizeof( DWORD64 ) ) )
+                    return false;
+                break;
+
+            case UnwindOp_SaveNonVolFar:
+                if ( !ReadStack(
+                    context.Rsp + ReadUInt32( slot + UnwindCodeSize ),
+                    &GetIntReg( context, opInfo ),
+                    sizeof( DWORD64 ) ) )
+                    return false;
+                break;
+
+            case UnwindOp_SaveXmm128:
+                if ( !ReadStack(
+                    context.Rsp + ReadUInt16( slot + UnwindCodeSize ) * 16,
+                    &GetXmmReg( context, opInfo ),
+                    sizeof( M128A ) ) )
+                    return false;
+                break;
+
+            case UnwindOp_SaveXmm128Far:
+                if ( !ReadStack(
+                    context.Rsp + ReadUInt32( slot + UnwindCodeSize ),
+                    &GetXmmReg( context, opInfo ),
+                    sizeof( M128A ) ) )
+                    return false;
+                break;
+
+            case UnwindOp_PushMachFrame:
+                {
+                    // an error code might have been pushed on top of it
+                    uint64_t    frame = context.Rsp + opInfo * 8;
+                    DWORD64     rip = 0;
+                    DWORD64     rsp = 0;
+
+                    if ( !ReadStack( frame, &rip, sizeof rip )
+                        || !ReadStack( frame + 24, &rsp, sizeof rsp ) )
+                        return false;
+
+                    context.Rip = rip;
+                    context.Rsp = rsp;
+                    machineFrame = true;
+                    return true;
+                }
+
+            case UnwindOp_Epilog:
+            case UnwindOp_SpareCode:
+                // epilog descriptions in version 2, and obsolete XMM saves
+                // in version 1; neither changes the integer registers
+                break;
+
+            default:
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    bool StackWalkerX64::PopReturnAddress( CONTEXT_X64& context )
+    {
+        if ( !ReadStack( context.Rsp, &context.Rip, sizeof context.Rip ) )
+            return false;
+
+        context.Rsp += sizeof context.Rip;
+        return true;
+    }
+
+    bool StackWalkerX64::ReadStack( uint64_t address, void* buffer, uint32_t length )
+    {
+        // Frames are unwound going up the stack, so a block read at the
+        // first address asked for serves the reads of the next frames, too.
+        if ( (address < mStackBlockAddr)
+            || (address - mStackBlockAddr > mStackBlockLen)
+            || (mStackBlockLen - (address - mStackBlockAddr) < length) )
+        {
+            DWORD   lenRead = 0;
+
+            mStackBlock.resize( StackBlockSize );
+            mStackBlockLen = 0;
+            mStackReads++;
+
+            if ( !mReadMemProc( mProcessContext, address, &mStackBlock[0], StackBlockSize, &lenRead ) )
+                return false;
+
+            mStackBlockAddr = address;
+            mStackBlockLen = lenRead;
+
+            if ( mStackBlockLen < length )
+                return false;
+        }
+
+        memcpy( buffer, &mStackBlock[(size_t) (address - mStackBlockAddr)], length );
+        return true;
+    }
+
+    bool StackWalkerX64::ReadUnwindInfo( uint64_t address, const uint8_t*& unwindInfo )
+    {
+        UnwindInfoMap::iterator it = mUnwindInfos.find( address );
+
+        if ( it != mUnwindInfos.end() )
+        {
+            unwindInfo = &it->second[0];
+            return true;
+        }
+
+        // Read as much as the biggest unwind info in one go. The end can be
+        // unreadable, as long as the part that's used isn't.
+        std::vector<uint8_t>    buffer( MaxUnwindInfoSize );
+        DWORD                   lenRead = 0;
+
+        mUnwindInfoReads++;
+
+        if ( !mReadMemProc( mProcessContext, address, &buffer[0], MaxUnwindInfoSize, &lenRead ) )
+            return false;
+
+        if ( (lenRead < UnwindInfoHeaderSize) || (lenRead < GetUnwindInfoSize( &buffer[0] )) )
+            return false;
+
+        uint8_t version = GetUnwindVersion( &buffer[0] );
+
+        if ( (version != 1) && (version != 2) )
+            return false;
+
+        buffer.resize( GetUnwindInfoSize( &buffer[0] ) );
+
+        it = mUnwindInfos.insert( UnwindInfoMap::value_type( address, std::vector<uint8_t>() ) ).first;
+        it->second.swap( buffer );
+
+        unwindInfo = &it->second[0];
+        return true;
+    }
+}
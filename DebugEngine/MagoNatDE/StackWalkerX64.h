@@ -0,0 +1,98 @@
+/*
+   Copyright (c) 2014 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+#include "ArchData.h"
+#include <WinPlat.h>
+
+
+namespace Mago
+{
+    struct StackWalkerX64Stats
+    {
+        uint32_t    Frames;
+        uint32_t    StackReads;
+        uint32_t    UnwindInfoReads;
+    };
+
+
+    // Walks an x64 stack by running the unwind codes (UNWIND_INFO) of each
+    // function backwards, the way the OS unwinds for exceptions. It gives the
+    // same frames as the DbgHelp StackWalk64 routine, without going through
+    // DbgHelp.
+    //
+    // The pdata comes from the function table callback. The unwind info of a
+    // function is read once a walk, no matter how many times the function is
+    // on the stack. Stack memory is read in blocks that cover many frames.
+    //
+    // A function without pdata is a leaf function, which doesn't move the
+    // stack pointer or save registers: the return address is at the top of
+    // the stack.
+
+    class StackWalkerX64 : public StackWalker
+    {
+        typedef std::map<uint64_t, std::vector<uint8_t> >   UnwindInfoMap;
+
+        // The amount of stack memory read at a time
+        static const uint32_t   StackBlockSize = 0x4000;
+
+        void*                       mProcessContext;
+        ReadProcessMemory64Proc     mReadMemProc;
+        FunctionTableAccess64Proc   mFuncTabProc;
+        GetModuleBase64Proc         mGetModBaseProc;
+        UniquePtr<BYTE[]>           mThreadContext;
+        uint32_t                    mThreadContextSize;
+        uint32_t                    mFrameCount;
+        bool                        mDone;
+
+        std::vector<uint8_t>        mStackBlock;
+        uint64_t                    mStackBlockAddr;
+        uint32_t                    mStackBlockLen;
+        UnwindInfoMap               mUnwindInfos;   // by address
+
+        uint32_t                    mStackReads;
+        uint32_t                    mUnwindInfoReads;
+
+    public:
+        StackWalkerX64(
+            void* processContext,
+            ReadProcessMemory64Proc readMemProc,
+            FunctionTableAccess64Proc funcTabProc,
+            GetModuleBase64Proc getModBaseProc );
+        HRESULT Init( const void* threadContext, uint32_t threadContextSize );
+
+        virtual bool WalkStack();
+
+        virtual void GetThreadContext( const void*& context, uint32_t& contextSize );
+
+        void GetStats( StackWalkerX64Stats& stats );
+
+    private:
+        bool UnwindFrame( CONTEXT_X64& context, bool topFrame );
+        bool UnwindEpilog(
+            CONTEXT_X64& context,
+            const IMAGE_RUNTIME_FUNCTION_ENTRY& funcEntry,
+            uint64_t imageBase,
+            const uint8_t* unwindInfo,
+            bool& inEpilog );
+        bool FindPrimaryEntry(
+            const IMAGE_RUNTIME_FUNCTION_ENTRY& funcEntry,
+            uint64_t imageBase,
+            const uint8_t* unwindInfo,
+            IMAGE_RUNTIME_FUNCTION_ENTRY& primaryEntry );
+        bool ApplyUnwindCodes(
+            CONTEXT_X64& context,
+            const uint8_t* unwindInfo,
+            uint64_t prologOffset,
+            bool& machineFrame );
+        bool PopReturnAddress( CONTEXT_X64& context );
+
+        bool ReadStack( uint64_t address, void* buffer, uint32_t length );
+        bool ReadUnwindInfo( uint64_t address, const uint8_t*& unwindInfo );
+    };
+}
@@ -0,0 +1,114 @@
+/*
+   Copyright (c) 2014 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "Common.h"
+#include "StopSnapshot.h"
+#include "ArchData.h"
+#include "MagoRemoteEvent_i.h"
+
+
+namespace Mago
+{
+    StopSnapshot::StopSnapshot()
+        :   mValid( false ),
+            mPid( 0 ),
+            mTid( 0 ),
+            mStackAddr( 0 ),
+            mPDataImageBase( 0 )
+    {
+    }
+
+    void StopSnapshot::Set( uint32_t pid, uint32_t tid, const MagoRemote_StopSnapshot* snapshot )
+    {
+        GuardedArea guard( mGuard );
+
+        mValid = false;
+        mContext.clear();
+        mStack.clear();
+        mPData.clear();
+
+        if ( snapshot == NULL )
+            return;
+
+        mPid = pid;
+        mTid = tid;
+        mStackAddr = snapshot->StackAddr;
+        mPDataImageBase = snapshot->PDataImageBase;
+
+        if ( snapshot->Context != NULL )
+            mContext.assign( snapshot->Context, snapshot->Context + snapshot->ContextSize );
+        if ( snapshot->Stack != NULL )
+            mStack.assign( snapshot->Stack, snapshot->Stack + snapshot->StackSize );
+        if ( snapshot->PData != NULL )
+            mPData.assign( snapshot->PData, snapshot->PData + snapshot->PDataSize );
+
+        mValid = true;
+    }
+
+    void StopSnapshot::Clear()
+    {
+        Set( 0, 0, NULL );
+    }
+
+    bool StopSnapshot::ReadMemory( uint32_t pid, Address64 address, uint32_t length, uint8_t* buffer )
+    {
+        GuardedArea guard( mGuard );
+
+        if ( !mValid || (pid != mPid) || mStack.empty() )
+            return false;
+
+        if ( (address < mStackAddr) || (length > mStack.size()) )
+            return false;
+
+        Address64   offset = address - mStackAddr;
+
+        if ( offset > mStack.size() - length )
+            return false;
+
+        memcpy( buffer, &mStack[(size_t) offset], length );
+        return true;
+    }
+
+    bool StopSnapshot::GetThreadContext( uint32_t pid, uint32_t tid, uint32_t size, uint8_t* context )
+    {
+        GuardedArea guard( mGuard );
+
+        if ( !mValid || (pid != mPid) || (tid != mTid) || mContext.empty() || (size != mContext.size()) )
+            return false;
+
+        memcpy( context, &mContext[0], size );
+        return true;
+    }
+
+    bool StopSnapshot::GetPData( 
+        uint32_t pid, 
+        Address64 address, 
+        Address64 imageBase, 
+        ArchData* archData, 
+        uint32_t size, 
+        uint8_t* pdata )
+    {
+        GuardedArea guard( mGuard );
+
+        if ( !mValid || (pid != mPid) || mPData.empty() || (size != mPData.size()) )
+            return false;
+        if ( imageBase != mPDataImageBase )
+            return false;
+
+        Address64   begin = 0;
+        Address64   end = 0;
+
+        archData->GetPDataRange( imageBase, &mPData[0], begin, end );
+
+        // same range check as the agent's lookup
+        if ( (address < begin) || (address > end) )
+            return false;
+
+        memcpy( pdata, &mPData[0], size );
+        return true;
+    }
+}
@@ -0,0 +1,56 @@
+/*
+   Copyright (c) 2014 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+
+typedef struct MagoRemote_StopSnapshot MagoRemote_StopSnapshot;
+
+
+namespace Mago
+{
+    class ArchData;
+
+
+    // Holds the snapshot that the remote agent sent with the last breakpoint 
+    // or step event: the stopped thread's context, the top of its stack, and 
+    // the pdata entry for where it stopped. Requests that it can answer don't 
+    // have to go to the agent. It has to be cleared before the debuggee runs 
+    // again, or its memory or registers are changed.
+
+    class StopSnapshot
+    {
+        Guard                   mGuard;
+        bool                    mValid;
+        uint32_t                mPid;
+        uint32_t                mTid;
+        std::vector<uint8_t>    mContext;
+        Address64               mStackAddr;
+        std::vector<uint8_t>    mStack;
+        Address64               mPDataImageBase;
+        std::vector<uint8_t>    mPData;
+
+    public:
+        StopSnapshot();
+
+        // A NULL snapshot clears the one that's held.
+        void Set( uint32_t pid, uint32_t tid, const MagoRemote_StopSnapshot* snapshot );
+        void Clear();
+
+        // Each method returns true if it could answer the whole request.
+
+        bool ReadMemory( uint32_t pid, Address64 address, uint32_t length, uint8_t* buffer );
+        bool GetThreadContext( uint32_t pid, uint32_t tid, uint32_t size, uint8_t* context );
+        bool GetPData( 
+            uint32_t pid, 
+            Address64 address, 
+            Address64 imageBase, 
+            ArchData* archData, 
+            uint32_t size, 
+            uint8_t* pdata );
+    };
+}
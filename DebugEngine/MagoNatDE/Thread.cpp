@@ -20,71 +20,106 @@
 
 namespace Mago
 {
+    // The walk reads small pieces of memory, mostly of the stack, one frame 
+    // after another toward the stack base, and each read is a trip to the 
+    // debuggee. So memory is read a block at a time, along with the next 
+    // block in one vectored read, and the blocks are kept for the walk.
 
-class PdataCache
-{
-    typedef AddressRange64 MapKey;
+    const uint32_t  WalkBlockSize = 0x1000;
 
-    typedef bool (*RangePred)( const MapKey& left, const MapKey& right );
-    static bool RangeLess( const MapKey& left, const MapKey& right );
+    struct WalkBlock
+    {
+        Address64   Addr;
+        uint32_t    LengthRead;
+        uint8_t     Data[WalkBlockSize];
+    };
 
-    typedef std::vector<BYTE> PdataBuffer;
-    typedef std::map<MapKey, int, RangePred> PdataMap;
+    struct WalkContext
+    {
+        Mago::Thread*           Thread;
+        std::list<WalkBlock>    Blocks;
 
-    PdataBuffer mBuffer;
-    PdataMap    mMap;
-    int         mEntrySize;
+        const WalkBlock* FindBlock( Address64 addr );
+        const WalkBlock* FindReadBlock( Address64 blockAddr );
+    };
 
-public:
-    PdataCache( int pdataSize );
-    void* Find( Address64 address );
-    void* Add( Address64 begin, Address64 end, void* pdata );
-};
+    const WalkBlock* WalkContext::FindReadBlock( Address64 blockAddr )
+    {
+        for ( std::list<WalkBlock>::iterator it = Blocks.begin(); 
+            it != Blocks.end(); 
+            it++ )
+        {
+            if ( it->Addr == blockAddr )
+                return &*it;
+        }
 
-PdataCache::PdataCache( int pdataSize )
-    :   mMap( RangeLess ),
-        mEntrySize( pdataSize )
-{
-}
+        return NULL;
+    }
 
-bool PdataCache::RangeLess( const MapKey& left, const MapKey& right )
-{
-    return left.End < right.Begin;
-}
+    const WalkBlock* WalkContext::FindBlock( Address64 addr )
+    {
+        Address64           blockAddr = addr & ~((Address64) WalkBlockSize - 1);
+        const WalkBlock*    block = FindReadBlock( blockAddr );
 
-void* PdataCache::Find( Address64 address )
-{
-    MapKey range = { address, address };
+        if ( block != NULL )
+            return block;
 
-    PdataMap::iterator it = mMap.find( range );
-    if ( it == mMap.end() )
-        return NULL;
+        HRESULT             hr = S_OK;
+        ReadMemoryRange64   ranges[2] = { 0 };
+        uint8_t*            buffers[2] = { 0 };
+        WalkBlock*          newBlocks[2] = { 0 };
+        uint32_t            count = 0;
+        Address64           nextAddr = blockAddr + WalkBlockSize;
 
-    return &mBuffer[it->second];
-}
+        newBlocks[count++] = &*Blocks.insert( Blocks.end(), WalkBlock() );
 
-void* PdataCache::Add( Address64 begin, Address64 end, void* pdata )
-{
-    size_t origSize = mBuffer.size();
-    mBuffer.resize( mBuffer.size() + mEntrySize );
+        if ( (nextAddr != 0) && (FindReadBlock( nextAddr ) == NULL) )
+            newBlocks[count++] = &*Blocks.insert( Blocks.end(), WalkBlock() );
 
-    memcpy( &mBuffer[origSize], pdata, mEntrySize );
+        for ( uint32_t i = 0; i < count; i++ )
+        {
+            newBlocks[i]->Addr = blockAddr + (i * WalkBlockSize);
+            newBlocks[i]->LengthRead = 0;
 
-    MapKey range = { begin, end };
-    mMap.insert( PdataMap::value_type( range, origSize ) );
-    return &mBuffer[origSize];
-}
+            ranges[i].Addr = newBlocks[i]->Addr;
+            ranges[i].Length = WalkBlockSize;
+            buffers[i] = newBlocks[i]->Data;
+        }
 
-}
+        hr = Thread->GetDebuggerProxy()->ReadMemoryV( 
+            Thread->GetCoreProcess(), count, ranges, buffers );
+        if ( FAILED( hr ) )
+        {
+            for ( uint32_t i = 0; i < count; i++ )
+                Blocks.pop_back();
 
+            return NULL;
+        }
 
-namespace Mago
-{
-    struct WalkContext
+        for ( uint32_t i = 0; i < count; i++ )
+            newBlocks[i]->LengthRead = ranges[i].LengthRead;
+
+        return newBlocks[0];
+    }
+
+    class ThreadReturnAddressReader : public IReturnAddressReader
     {
-        Mago::Thread*       Thread;
-        PdataCache*         Cache;
-        UniquePtr<BYTE[]>   TempEntry;
+        Mago::Thread*   mThread;
+
+    public:
+        ThreadReturnAddressReader( Mago::Thread* thread )
+            :   mThread( thread )
+        {
+        }
+
+        virtual HRESULT ReadMemoryV( 
+            uint32_t count, 
+            ReadMemoryRange64* ranges, 
+            uint8_t** buffers )
+        {
+            return mThread->GetDebuggerProxy()->ReadMemoryV( 
+                mThread->GetCoreProcess(), count, ranges, buffers );
+        }
     };
 
 
@@ -93,6 +128,7 @@ namespace Mago
             mCurPC( 0 ),
             mCallerPC( 0 )
     {
+        memset( &mCallstackStats, 0, sizeof mCallstackStats );
     }
 
     Thread::~Thread()
@@ -289,6 +325,21 @@ namespace Mago
         return mDebugger;
     }
 
+    void Thread::Dispose()
+    {
+        GuardedArea guard( mCallstackGuard );
+
+        mLastCallstack.clear();
+        mLastFrameKeys.clear();
+    }
+
+    void Thread::GetCallstackStats( CallstackStats& stats )
+    {
+        GuardedArea guard( mCallstackGuard );
+
+        stats = mCallstackStats;
+    }
+
     HRESULT Thread::Step( ICoreProcess* coreProc, STEPKIND sk, STEPUNIT step, bool handleException )
     {
         _RPT1( _CRT_WARN, "Thread::Step (%d)\n", mCoreThread->GetTid() );
@@ -385,32 +436,41 @@ namespace Mago
 
     HRESULT Thread::BuildCallstack( IRegisterSet* topRegSet, Callstack& callstack )
     {
-        OutputDebugStringA( "Thread::BuildCallstack\n" );
-
         HRESULT             hr = S_OK;
         int                 frameIndex = 0;
         ArchData*           archData = NULL;
         StackWalker*        pWalker = NULL;
         UniquePtr<StackWalker> walker;
         WalkContext         walkContext;
-        int                 pdataSize = 0;
+        FrameKeyList        frameKeys;
+        FrameKey            frameKey = { 0 };
+        const void*         topContext = NULL;
+        uint32_t            topContextSize = 0;
+        size_t              lastIndex = 0;
+        size_t              reusedCount = 0;
+        ThreadReturnAddressReader   reader( this );
+        GuardedArea         guard( mCallstackGuard );
 
         archData = mProg->GetCoreProcess()->GetArchData();
-        pdataSize = archData->GetPDataSize();
 
-        PdataCache          pdataCache( pdataSize );
+        CallstackReuse      reuse( mLastFrameKeys, (uint32_t) archData->GetPointerSize() );
 
         walkContext.Thread = this;
-        walkContext.Cache = &pdataCache;
-        walkContext.TempEntry.Attach( new BYTE[pdataSize] );
 
-        if ( walkContext.TempEntry.IsEmpty() )
-            return E_OUTOFMEMORY;
+        if ( !topRegSet->GetThreadContext( topContext, topContextSize ) )
+            return E_FAIL;
+
+        hr = archData->GetFrameAddresses( 
+            topContext, topContextSize, frameKey.PC, frameKey.Stack, frameKey.Frame );
+        if ( FAILED( hr ) )
+            return hr;
 
         hr = AddCallstackFrame( topRegSet, callstack );
         if ( FAILED( hr ) )
             return hr;
 
+        frameKeys.push_back( frameKey );
+
         hr = archData->BeginWalkStack( 
             topRegSet,
             &walkContext,
@@ -434,6 +494,29 @@ namespace Mago
 
             walker->GetThreadContext( context, contextSize );
 
+            hr = archData->GetFrameAddresses( 
+                context, contextSize, frameKey.PC, frameKey.Stack, frameKey.Frame );
+            if ( FAILED( hr ) )
+                return hr;
+
+            // The rest of the stack is unchanged from the last callstack 
+            // once a frame is found in it, as long as the return addresses 
+            // older than it are still there.
+            if ( (frameIndex > 0) && reuse.FindFrame( frameKey, &reader, lastIndex ) )
+            {
+                callstack.insert( 
+                    callstack.end(), 
+                    mLastCallstack.begin() + lastIndex, 
+                    mLastCallstack.end() );
+                frameKeys.insert( 
+                    frameKeys.end(), 
+                    mLastFrameKeys.begin() + lastIndex, 
+                    mLastFrameKeys.end() );
+
+                reusedCount = mLastCallstack.size() - lastIndex;
+                break;
+            }
+
             if ( frameIndex == 0 )
                 hr = archData->BuildRegisterSet( context, contextSize, regSet.Ref() );
             else
@@ -452,9 +535,17 @@ namespace Mago
             if ( FAILED( hr ) )
                 return hr;
 
+            frameKeys.push_back( frameKey );
             frameIndex++;
         }
 
+        mLastCallstack = callstack;
+        mLastFrameKeys.swap( frameKeys );
+
+        mCallstackStats.Walks++;
+        mCallstackStats.Frames += (uint32_t) callstack.size();
+        mCallstackStats.ReusedFrames += (uint32_t) reusedCount;
+
         return S_OK;
     }
 
@@ -468,26 +559,41 @@ namespace Mago
     {
         _ASSERT( hProcess != NULL );
         WalkContext*    walkContext = (WalkContext*) hProcess;
-        Thread*         pThis = walkContext->Thread;
+        Address64       addr = (Address64) lpBaseAddress;
+        DWORD           totalRead = 0;
+
+        // copy from each block that the range covers, up to the first part 
+        // that couldn't be read
+        while ( totalRead < nSize )
+        {
+            const WalkBlock*    block = walkContext->FindBlock( addr );
 
-        HRESULT     hr = S_OK;
-        uint32_t    lenRead = 0;
-        uint32_t    lenUnreadable = 0;
-        RefPtr<ICoreProcess>    proc;
+            if ( block == NULL )
+            {
+                if ( totalRead == 0 )
+                    return FALSE;
+                break;
+            }
 
-        pThis->mProg->GetCoreProcess( proc.Ref() );
+            uint32_t    offset = (uint32_t) (addr - block->Addr);
+            uint32_t    len = nSize - totalRead;
 
-        hr = pThis->mDebugger->ReadMemory( 
-            proc.Get(), 
-            (Address64) lpBaseAddress, 
-            nSize, 
-            lenRead, 
-            lenUnreadable, 
-            (uint8_t*) lpBuffer );
-        if ( FAILED( hr ) )
-            return FALSE;
+            if ( offset >= block->LengthRead )
+                break;
+
+            if ( len > block->LengthRead - offset )
+                len = block->LengthRead - offset;
 
-        *lpNumberOfBytesRead = lenRead;
+            memcpy( (uint8_t*) lpBuffer + totalRead, block->Data + offset, len );
+
+            totalRead += len;
+            addr += len;
+
+            if ( offset + len < WalkBlockSize )
+                break;
+        }
+
+        *lpNumberOfBytesRead = totalRead;
 
         return TRUE;
     }
@@ -499,42 +605,27 @@ namespace Mago
     {
         _ASSERT( hProcess != NULL );
 
-        HRESULT         hr = S_OK;
         WalkContext*    walkContext = (WalkContext*) hProcess;
         Thread*         pThis = walkContext->Thread;
         ArchData*       archData = pThis->GetCoreProcess()->GetArchData();
-        uint32_t        size = 0;
-        int             pdataSize = archData->GetPDataSize();
-        void*           pdata = NULL;
 
-        if ( pdataSize == 0 )
+        if ( archData->GetPDataSize() == 0 )
             return NULL;
 
-        pdata = walkContext->Cache->Find( addrBase );
-        if ( pdata != NULL )
-            return pdata;
-
         RefPtr<Module>      mod;
 
         if ( !pThis->mProg->FindModuleContainingAddress( (Address64) addrBase, mod ) )
             return NULL;
 
-        IDebuggerProxy* debugger = pThis->GetDebuggerProxy();
-
-        hr = debugger->GetPData( 
-            pThis->GetCoreProcess(), addrBase, mod->GetAddress(), pdataSize, size, 
-            walkContext->TempEntry.Get() );
-        if ( hr != S_OK )
-            return NULL;
-
-        Address64   begin;
-        Address64   end;
-
-        pThis->GetCoreProcess()->GetArchData()->GetPDataRange( 
-            mod->GetAddress(), walkContext->TempEntry.Get(), begin, end );
+        // the module's table outlives the walk, because the module can't 
+        // unload while the debuggee is stopped
+        PDataTable*     table = mod->GetPDataTable();
 
-        pdata = walkContext->Cache->Add( begin, end, walkContext->TempEntry.Get() );
-        return pdata;
+        return (PVOID) table->Find( 
+            pThis->GetDebuggerProxy(), 
+            pThis->GetCoreProcess(), 
+            mod->GetAddress(), 
+            (Address64) addrBase );
     }
 
     DWORD64 Thread::GetModuleBase64(
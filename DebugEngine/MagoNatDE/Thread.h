@@ -7,6 +7,8 @@
 
 #pragma once
 
+#include "CallstackReuse.h"
+
 
 namespace Mago
 {
@@ -30,6 +32,22 @@ namespace Mago
         Address64           mCallerPC;
         IDebuggerProxy*     mDebugger;
 
+        // The callstack built last, and the keys of its frames. When a walk
+        // comes to a frame that's still there, that frame and the ones older
+        // than it are taken from here instead of being walked again.
+        //
+        // The kept frames, their register sets, and their expression 
+        // contexts are handed out again as they are. The register sets only 
+        // hold the PC, stack pointer, and frame pointer, which are the 
+        // frame's key, so they're still right when the key matches. The 
+        // contexts only cache what's made from the module's symbols at the 
+        // frame's PC, and read the debuggee's memory anew each time an 
+        // expression is evaluated.
+        Callstack           mLastCallstack;
+        FrameKeyList        mLastFrameKeys;
+        CallstackStats      mCallstackStats;
+        Guard               mCallstackGuard;
+
     public:
         Thread();
         ~Thread();
@@ -74,6 +92,13 @@ namespace Mago
         ICoreProcess*   GetCoreProcess();
         IDebuggerProxy* GetDebuggerProxy();
 
+        // Lets go of the frames kept from the last callstack. They refer to 
+        // the thread, so this has to be called when the thread goes away.
+        void            Dispose();
+
+        // The frames walked and reused by the callstacks built so far
+        void            GetCallstackStats( CallstackStats& stats );
+
         HRESULT Step( ICoreProcess* coreProc, STEPKIND sk, STEPUNIT step, bool handleException );
 
     private:
@@ -0,0 +1,109 @@
+/*
+   Copyright (c) 2013 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "Common.h"
+#include "ThreadContextCache.h"
+
+
+namespace Mago
+{
+    ThreadContextCache::ThreadContextCache()
+        :   mUsedThisStop( false )
+    {
+        memset( &mStats, 0, sizeof mStats );
+    }
+
+    bool ThreadContextCache::Find( 
+        uint32_t pid, 
+        uint32_t tid, 
+        uint32_t featureMask, 
+        uint64_t extFeatureMask, 
+        uint32_t size, 
+        uint8_t* context )
+    {
+        _ASSERT( context != NULL );
+
+        GuardedArea guard( mGuard );
+
+        ContextMap::iterator    it = mContexts.find( MakeKey( pid, tid ) );
+
+        if ( (it == mContexts.end()) || !it->second.Valid )
+            return false;
+
+        Entry&  entry = it->second;
+
+        if ( ((featureMask & ~entry.FeatureMask) != 0)
+            || ((extFeatureMask & ~entry.ExtFeatureMask) != 0)
+            || (size > entry.Context.size()) )
+            return false;
+
+        memcpy( context, &entry.Context[0], size );
+
+        mStats.Hits++;
+        mUsedThisStop = true;
+        return true;
+    }
+
+    void ThreadContextCache::Add( 
+        uint32_t pid, 
+        uint32_t tid, 
+        uint32_t featureMask, 
+        uint64_t extFeatureMask, 
+        const uint8_t* context, 
+        uint32_t size )
+    {
+        _ASSERT( context != NULL );
+        if ( size == 0 )
+            return;
+
+        GuardedArea guard( mGuard );
+
+        Entry&  entry = mContexts[MakeKey( pid, tid )];
+
+        if ( entry.FetchCount > 0 )
+            mStats.Refetches++;
+
+        entry.Valid = true;
+        entry.FetchCount++;
+        entry.FeatureMask = featureMask;
+        entry.ExtFeatureMask = extFeatureMask;
+        entry.Context.assign( context, context + size );
+
+        mStats.Fetches++;
+        mUsedThisStop = true;
+    }
+
+    void ThreadContextCache::Invalidate( uint32_t pid, uint32_t tid )
+    {
+        GuardedArea guard( mGuard );
+
+        ContextMap::iterator    it = mContexts.find( MakeKey( pid, tid ) );
+
+        // the written context might have fewer features than the cached one, 
+        // so it can't simply replace it
+        if ( it != mContexts.end() )
+            it->second.Valid = false;
+    }
+
+    void ThreadContextCache::Clear()
+    {
+        GuardedArea guard( mGuard );
+
+        if ( mUsedThisStop )
+            mStats.Stops++;
+
+        mUsedThisStop = false;
+        mContexts.clear();
+    }
+
+    void ThreadContextCache::GetStats( ThreadContextCacheStats& stats )
+    {
+        GuardedArea guard( mGuard );
+
+        stats = mStats;
+    }
+}
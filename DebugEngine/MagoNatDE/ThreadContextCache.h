@@ -0,0 +1,95 @@
+/*
+   Copyright (c) 2013 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+
+namespace Mago
+{
+    struct ThreadContextCacheStats
+    {
+        uint32_t    Stops;
+        uint32_t    Hits;
+        uint32_t    Fetches;
+        uint32_t    Refetches;      // fetches of a thread that was already fetched in the stop
+    };
+
+
+    // Holds the contexts of the threads of stopped debuggees, so that the 
+    // stack walker, register sets, and expression contexts of one stop don't 
+    // each get the same context from the debuggee. A context is kept with 
+    // the features it was read with, and it answers any request for those 
+    // features or fewer.
+    //
+    // The contexts are good until the debuggee runs again, so the cache has 
+    // to be cleared wherever it's resumed. Writing a thread's context drops 
+    // the cached one.
+
+    class ThreadContextCache
+    {
+        struct Entry
+        {
+            bool                    Valid;
+            uint32_t                FetchCount;
+            uint32_t                FeatureMask;
+            uint64_t                ExtFeatureMask;
+            std::vector<uint8_t>    Context;
+
+            Entry()
+                :   Valid( false ),
+                    FetchCount( 0 ),
+                    FeatureMask( 0 ),
+                    ExtFeatureMask( 0 )
+            {
+            }
+        };
+
+        typedef std::map<uint64_t, Entry>   ContextMap;
+
+        ContextMap                  mContexts;
+        ThreadContextCacheStats     mStats;
+        bool                        mUsedThisStop;
+        Guard                       mGuard;
+
+    public:
+        ThreadContextCache();
+
+        // Returns true if the thread's context was cached with at least the 
+        // features asked for. The ContextFlags that are returned can have 
+        // more features than were asked for.
+        bool Find( 
+            uint32_t pid, 
+            uint32_t tid, 
+            uint32_t featureMask, 
+            uint64_t extFeatureMask, 
+            uint32_t size, 
+            uint8_t* context );
+
+        // Adds a context that was fetched from the debuggee.
+        void Add( 
+            uint32_t pid, 
+            uint32_t tid, 
+            uint32_t featureMask, 
+            uint64_t extFeatureMask, 
+            const uint8_t* context, 
+            uint32_t size );
+
+        // Drops the thread's context, because a new one was written to it.
+        void Invalidate( uint32_t pid, uint32_t tid );
+
+        // Throws away all the contexts, and ends the stop they were read in.
+        void Clear();
+
+        void GetStats( ThreadContextCacheStats& stats );
+
+    private:
+        static uint64_t MakeKey( uint32_t pid, uint32_t tid )
+        {
+            return ((uint64_t) pid << 32) | tid;
+        }
+    };
+}
@@ -184,6 +184,15 @@ namespace Mago
         Address64 End;
     };
 
+    // One block of a vectored memory read; see ReadMemoryRange in Exec.
+    struct ReadMemoryRange64
+    {
+        Address64   Addr;
+        uint32_t    Length;
+        uint32_t    LengthRead;
+        uint32_t    LengthUnreadable;
+    };
+
     // 2 chars a byte in hex, and 2 for 0x prefix
     const size_t MaxAddrStringLength = (sizeof Address64 * 2) + 2;
 
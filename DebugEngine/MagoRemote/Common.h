@@ -36,6 +36,8 @@
 
 // C++
 #include <string>
+#include <map>
+#include <vector>
 
 // Magus
 #include <SmartPtr.h>
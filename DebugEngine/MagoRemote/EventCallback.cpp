@@ -9,17 +9,60 @@
 #include "EventCallback.h"
 #include "MagoRemoteEvent_h.h"
 #include "RpcUtil.h"
+#include <..\Exec\DebuggerProxy.h>
 
 
 namespace Mago
 {
+    bool GetStackAndPC( 
+        uint16_t machineType, 
+        const uint8_t* context, 
+        uint32_t size, 
+        Address& pc, 
+        Address& sp )
+    {
+        if ( machineType == IMAGE_FILE_MACHINE_I386 )
+        {
+#if defined( _M_X64 )
+            typedef WOW64_CONTEXT   X86Context;
+#else
+            typedef CONTEXT         X86Context;
+#endif
+            if ( size < sizeof( X86Context ) )
+                return false;
+
+            const X86Context*   x86Context = (const X86Context*) context;
+
+            pc = x86Context->Eip;
+            sp = x86Context->Esp;
+            return true;
+        }
+#if defined( _M_X64 )
+        else if ( machineType == IMAGE_FILE_MACHINE_AMD64 )
+        {
+            if ( size < sizeof( CONTEXT ) )
+                return false;
+
+            const CONTEXT*      x64Context = (const CONTEXT*) context;
+
+            pc = x64Context->Rip;
+            sp = x64Context->Rsp;
+            return true;
+        }
+#endif
+
+        return false;
+    }
+
+
     //----------------------------------------------------------------------------
     //  EventCallback
     //----------------------------------------------------------------------------
 
     EventCallback::EventCallback( HCTXEVENT hEventContext )
         :   mRefCount( 0 ),
-            mhEventCtx( hEventContext )
+            mhEventCtx( hEventContext ),
+            mExecThread( NULL )
     {
     }
 
@@ -47,6 +90,154 @@ namespace Mago
         }
     }
 
+    void EventCallback::SetExecThread( MagoCore::DebuggerProxy* execThread )
+    {
+        mExecThread = execThread;
+    }
+
+    HRESULT EventCallback::SetSnapshotSpec( uint32_t pid, const SnapshotSpec& spec )
+    {
+        GuardedArea guard( mSnapshotGuard );
+
+        mSnapshotInfo[pid].Spec = spec;
+
+        return S_OK;
+    }
+
+    void EventCallback::AddSnapshotModule( uint32_t pid, Address imageBase, uint32_t size )
+    {
+        GuardedArea guard( mSnapshotGuard );
+
+        mSnapshotInfo[pid].Modules[imageBase] = size;
+    }
+
+    void EventCallback::RemoveSnapshotModule( uint32_t pid, Address imageBase )
+    {
+        GuardedArea guard( mSnapshotGuard );
+
+        SnapshotInfoMap::iterator it = mSnapshotInfo.find( pid );
+        if ( it == mSnapshotInfo.end() )
+            return;
+
+        it->second.Modules.erase( imageBase );
+    }
+
+    void EventCallback::RemoveSnapshotProcess( uint32_t pid )
+    {
+        GuardedArea guard( mSnapshotGuard );
+
+        mSnapshotInfo.erase( pid );
+    }
+
+    bool EventCallback::FindSnapshotModule( 
+        const ProcessSnapshotInfo& info, Address address, Address& imageBase )
+    {
+        ModuleMap::const_iterator it = info.Modules.upper_bound( address );
+        if ( it == info.Modules.begin() )
+            return false;
+
+        it--;
+
+        if ( address - it->first >= it->second )
+            return false;
+
+        imageBase = it->first;
+        return true;
+    }
+
+    // Reads the stopped thread's context, the top of its stack, and the pdata 
+    // entry for where it stopped, as much of it as can be read. Returns false 
+    // if snapshots are off for the process, or the context can't be read.
+
+    bool EventCallback::MakeSnapshot( 
+        IProcess* process, uint32_t threadId, MagoRemote_StopSnapshot& snapshot )
+    {
+        HRESULT         hr = S_OK;
+        SnapshotSpec    spec = { 0 };
+        Address         pc = 0;
+        Address         sp = 0;
+        Address         imageBase = 0;
+        bool            foundModule = false;
+        uint32_t        lengthRead = 0;
+        uint32_t        lengthUnreadable = 0;
+
+        memset( &snapshot, 0, sizeof snapshot );
+
+        if ( mExecThread == NULL )
+            return false;
+
+        {
+            GuardedArea guard( mSnapshotGuard );
+
+            SnapshotInfoMap::iterator it = mSnapshotInfo.find( process->GetId() );
+            if ( it == mSnapshotInfo.end() )
+                return false;
+
+            spec = it->second.Spec;
+        }
+
+        if ( spec.StackSize == 0 || spec.ContextSize == 0 )
+            return false;
+
+        // we're on the exec thread, so these calls are run directly
+
+        mSnapContext.resize( spec.ContextSize );
+
+        hr = mExecThread->GetThreadContext( 
+            process, 
+            threadId, 
+            spec.FeatureMask, 
+            spec.ExtFeatureMask, 
+            &mSnapContext[0], 
+            spec.ContextSize );
+        if ( FAILED( hr ) )
+            return false;
+
+        if ( !GetStackAndPC( process->GetMachineType(), &mSnapContext[0], spec.ContextSize, pc, sp ) )
+            return false;
+
+        snapshot.ContextSize = spec.ContextSize;
+        snapshot.Context = &mSnapContext[0];
+
+        mSnapStack.resize( spec.StackSize );
+
+        hr = mExecThread->ReadMemory( 
+            process, sp, spec.StackSize, lengthRead, lengthUnreadable, &mSnapStack[0] );
+        if ( SUCCEEDED( hr ) && (lengthRead > 0) )
+        {
+            snapshot.StackAddr = sp;
+            snapshot.StackSize = lengthRead;
+            snapshot.Stack = &mSnapStack[0];
+        }
+
+        if ( spec.PDataSize > 0 )
+        {
+            GuardedArea guard( mSnapshotGuard );
+
+            SnapshotInfoMap::iterator it = mSnapshotInfo.find( process->GetId() );
+            if ( it != mSnapshotInfo.end() )
+                foundModule = FindSnapshotModule( it->second, pc, imageBase );
+        }
+
+        if ( foundModule )
+        {
+            uint32_t    sizeRead = 0;
+
+            mSnapPData.resize( spec.PDataSize );
+
+            hr = mExecThread->GetPData( 
+                process, pc, imageBase, spec.PDataSize, sizeRead, &mSnapPData[0] );
+            if ( (hr == S_OK) && (sizeRead == spec.PDataSize) )
+            {
+                snapshot.PDataImageBase = imageBase;
+                snapshot.PDataSize = sizeRead;
+                snapshot.PData = &mSnapPData[0];
+            }
+        }
+
+        return true;
+    }
+
     void EventCallback::OnProcessStart( IProcess* process )
     {
         __try
@@ -64,6 +255,8 @@ namespace Mago
 
     void EventCallback::OnProcessExit( IProcess* process, DWORD exitCode )
     {
+        RemoveSnapshotProcess( process->GetId() );
+
         __try
         {
             MagoRemoteEvent_OnProcessExit( 
@@ -127,6 +320,8 @@ namespace Mago
         modInfo.MachineType = module->GetMachine();
         modInfo.Path = module->GetPath();
 
+        AddSnapshotModule( process->GetId(), module->GetImageBase(), module->GetSize() );
+
         __try
         {
             MagoRemoteEvent_OnModuleLoad( 
@@ -143,6 +338,8 @@ namespace Mago
 
     void EventCallback::OnModuleUnload( IProcess* process, Address baseAddr )
     {
+        RemoveSnapshotModule( process->GetId(), baseAddr );
+
         __try
         {
             MagoRemoteEvent_OnModuleUnload( 
@@ -247,6 +444,11 @@ namespace Mago
         bool embedded )
     {
         RunMode mode = RunMode_Run;
+        MagoRemote_StopSnapshot     snapshot;
+        MagoRemote_StopSnapshot*    snapshotPtr = NULL;
+
+        if ( MakeSnapshot( process, threadId, snapshot ) )
+            snapshotPtr = &snapshot;
 
         __try
         {
@@ -255,7 +457,8 @@ namespace Mago
                 process->GetId(),
                 threadId,
                 address,
-                embedded );
+                embedded,
+                snapshotPtr );
         }
         __except ( CommonRpcExceptionFilter( RpcExceptionCode() ) )
         {
@@ -268,12 +471,19 @@ namespace Mago
 
     void EventCallback::OnStepComplete( IProcess* process, uint32_t threadId )
     {
+        MagoRemote_StopSnapshot     snapshot;
+        MagoRemote_StopSnapshot*    snapshotPtr = NULL;
+
+        if ( MakeSnapshot( process, threadId, snapshot ) )
+            snapshotPtr = &snapshot;
+
         __try
         {
             MagoRemoteEvent_OnStepComplete( 
                 GetContextHandle(),
                 process->GetId(),
-                threadId );
+                threadId,
+                snapshotPtr );
         }
         __except ( CommonRpcExceptionFilter( RpcExceptionCode() ) )
         {
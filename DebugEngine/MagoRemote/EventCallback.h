@@ -9,14 +9,56 @@
 
 
 typedef void* HCTXEVENT;
+typedef struct MagoRemote_StopSnapshot MagoRemote_StopSnapshot;
+
+namespace MagoCore
+{
+    class DebuggerProxy;
+}
 
 
 namespace Mago
 {
+    // What to read for the snapshot that goes with a breakpoint or step 
+    // event. See MagoRemote_SnapshotSpec.
+    struct SnapshotSpec
+    {
+        uint32_t    StackSize;
+        uint32_t    ContextSize;
+        uint32_t    FeatureMask;
+        uint64_t    ExtFeatureMask;
+        uint32_t    PDataSize;
+    };
+
+
     class EventCallback : public IEventCallback
     {
+        // image base -> size
+        typedef std::map<Address, uint32_t> ModuleMap;
+
+        struct ProcessSnapshotInfo
+        {
+            SnapshotSpec    Spec;
+            ModuleMap       Modules;
+
+            ProcessSnapshotInfo()
+            {
+                memset( &Spec, 0, sizeof Spec );
+            }
+        };
+
+        typedef std::map<uint32_t, ProcessSnapshotInfo> SnapshotInfoMap;
+
         long            mRefCount;
         HCTXEVENT       mhEventCtx;
+        MagoCore::DebuggerProxy*    mExecThread;    // backward reference
+        Guard                       mSnapshotGuard;
+        SnapshotInfoMap             mSnapshotInfo;
+
+        // buffers for the last snapshot; only used on the exec thread
+        std::vector<uint8_t>        mSnapContext;
+        std::vector<uint8_t>        mSnapStack;
+        std::vector<uint8_t>        mSnapPData;
 
     public:
         EventCallback( HCTXEVENT hEventContext );
@@ -25,6 +67,9 @@ namespace Mago
         virtual void AddRef();
         virtual void Release();
 
+        void SetExecThread( MagoCore::DebuggerProxy* execThread );
+        HRESULT SetSnapshotSpec( uint32_t pid, const SnapshotSpec& spec );
+
         virtual void OnProcessStart( IProcess* process );
         virtual void OnProcessExit( IProcess* process, DWORD exitCode );
         virtual void OnThreadStart( IProcess* process, Thread* thread );
@@ -49,5 +94,13 @@ namespace Mago
 
     private:
         HCTXEVENT GetContextHandle();
+
+        void AddSnapshotModule( uint32_t pid, Address imageBase, uint32_t size );
+        void RemoveSnapshotModule( uint32_t pid, Address imageBase );
+        void RemoveSnapshotProcess( uint32_t pid );
+
+        bool MakeSnapshot( IProcess* process, uint32_t threadId, MagoRemote_StopSnapshot& snapshot );
+        bool FindSnapshotModule( 
+            const ProcessSnapshotInfo& info, Address address, Address& imageBase );
     };
 }
@@ -13,9 +13,11 @@
 #include "MagoRemoteEvent_h.h"
 #include "RpcUtil.h"
 #include <..\Exec\DebuggerProxy.h>
+#include <..\Exec\MemoryCodec.h>
 #include <MagoDECommon.h>
 #include <list>
 #include <map>
+#include <vector>
 
 
 struct SessionContext
@@ -23,6 +25,7 @@ struct SessionContext
     typedef std::map<UINT32, IProcess*> CmdProcessMap;
 
     MagoCore::DebuggerProxy ExecThread;
+    RefPtr<Mago::EventCallback> Callback;
     HCTXEVENT               HEventContext;
     CmdProcessMap           ProcMap;
     Guard                   ProcGuard;
@@ -239,6 +242,9 @@ HRESULT MakeSessionContext( const GUID* uuid, HCTXEVENT hEventCtx, SessionContex
     if ( sessionContext.IsEmpty() )
         return E_OUTOFMEMORY;
 
+    callback->SetExecThread( &sessionContext->ExecThread );
+
+    sessionContext->Callback = callback;
     sessionContext->HEventContext = hEventCtx;
     sessionContext->RefCount = 0;
     sessionContext->Uuid = *uuid;
@@ -627,6 +633,138 @@ HRESULT MagoRemoteCmd_ReadMemory(
     return hr;
 }
 
+HRESULT MagoRemoteCmd_ReadMemoryV( 
+    /* [in] */ HCTXCMD hContext,
+    /* [in] */ unsigned int pid,
+    /* [in] */ unsigned int rangeCount,
+    /* [in][out][size_is] */ MagoRemote_ReadMemoryRange *ranges,
+    /* [in] */ unsigned int bufferSize,
+    /* [out][size_is] */ byte *buffer)
+{
+    if ( hContext == NULL || (rangeCount > 0 && (ranges == NULL || buffer == NULL)) )
+        return E_INVALIDARG;
+    if ( bufferSize > MagoRemote_MaxReadMemoryVSize )
+        return E_INVALIDARG;
+
+    HRESULT             hr = S_OK;
+    CmdContext*         context = (CmdContext*) hContext;
+    RefPtr<IProcess>    process;
+    uint32_t            offset = 0;
+    std::vector<ReadMemoryRange>    execRanges( rangeCount );
+    std::vector<uint8_t*>           buffers( rangeCount );
+
+    if ( !context->Session->FindProcess( pid, process.Ref() ) )
+        return E_NOT_FOUND;
+
+    if ( rangeCount == 0 )
+        return S_OK;
+
+    for ( unsigned int i = 0; i < rangeCount; i++ )
+    {
+        if ( ranges[i].Length > bufferSize - offset )
+            return E_INVALIDARG;
+
+        execRanges[i].Addr = (Address) ranges[i].Addr;
+        execRanges[i].Length = ranges[i].Length;
+        execRanges[i].LengthRead = 0;
+        execRanges[i].LengthUnreadable = 0;
+        buffers[i] = buffer + offset;
+        offset += ranges[i].Length;
+    }
+
+    hr = context->Session->ExecThread.ReadMemoryV( 
+        process.Get(),
+        rangeCount,
+        &execRanges[0],
+        &buffers[0] );
+    if ( FAILED( hr ) )
+        return hr;
+
+    for ( unsigned int i = 0; i < rangeCount; i++ )
+    {
+        ranges[i].LengthRead = execRanges[i].LengthRead;
+        ranges[i].LengthUnreadable = execRanges[i].LengthUnreadable;
+    }
+
+    return S_OK;
+}
+
+static HRESULT ReadMemoryPacked( 
+    HCTXCMD hContext,
+    unsigned int pid,
+    MagoRemote_Address address,
+    unsigned int length,
+    unsigned int *lengthRead,
+    unsigned int *lengthUnreadable,
+    unsigned int packedCapacity,
+    unsigned int *packedSize,
+    byte *packed)
+{
+    if ( hContext == NULL || lengthRead == NULL || lengthUnreadable == NULL 
+        || packedSize == NULL || packed == NULL )
+        return E_INVALIDARG;
+
+    // the packed length has to be good even if the call fails
+    *packedSize = 0;
+    *lengthRead = 0;
+    *lengthUnreadable = 0;
+
+    if ( length > MagoRemote_MaxReadMemoryPackedSize || packedCapacity < GetMaxPackedSize( length ) )
+        return E_INVALIDARG;
+
+    HRESULT             hr = S_OK;
+    CmdContext*         context = (CmdContext*) hContext;
+    RefPtr<IProcess>    process;
+    std::vector<uint8_t>    buffer( length );
+
+    if ( !context->Session->FindProcess( pid, process.Ref() ) )
+        return E_NOT_FOUND;
+
+    if ( length == 0 )
+        return S_OK;
+
+    hr = context->Session->ExecThread.ReadMemory( 
+        process.Get(),
+        (Address) address,
+        length,
+        *lengthRead,
+        *lengthUnreadable,
+        &buffer[0] );
+    if ( FAILED( hr ) )
+        return hr;
+
+    // only the bytes that were read are packed
+    return PackMemory( &buffer[0], *lengthRead, packed, packedCapacity, *packedSize );
+}
+
+void MagoRemoteCmd_ReadMemoryPacked( 
+    /* [in] */ PRPC_ASYNC_STATE asyncState,
+    /* [in] */ HCTXCMD hContext,
+    /* [in] */ unsigned int pid,
+    /* [in] */ MagoRemote_Address address,
+    /* [in] */ unsigned int length,
+    /* [out] */ unsigned int *lengthRead,
+    /* [out] */ unsigned int *lengthUnreadable,
+    /* [in] */ unsigned int packedCapacity,
+    /* [out] */ unsigned int *packedSize,
+    /* [out][length_is][size_is] */ byte *packed)
+{
+    HRESULT hr = ReadMemoryPacked( 
+        hContext,
+        pid,
+        address,
+        length,
+        lengthRead,
+        lengthUnreadable,
+        packedCapacity,
+        packedSize,
+        packed );
+
+    // the call is done right away; it's asynchronous so that the client 
+    // can have more than one outstanding
+    RpcAsyncCompleteCall( asyncState, &hr );
+}
+
 HRESULT MagoRemoteCmd_WriteMemory( 
     /* [in] */ HCTXCMD hContext,
     /* [in] */ unsigned int pid,
@@ -903,3 +1041,32 @@ HRESULT MagoRemoteCmd_GetPData(
 
     return hr;
 }
+
+HRESULT MagoRemoteCmd_SetStopSnapshot( 
+    /* [in] */ HCTXCMD hContext,
+    /* [in] */ unsigned int pid,
+    /* [in] */ MagoRemote_SnapshotSpec *spec)
+{
+    if ( hContext == NULL || spec == NULL )
+        return E_INVALIDARG;
+    if ( spec->StackSize > MagoRemote_MaxSnapshotStackSize )
+        return E_INVALIDARG;
+
+    HRESULT             hr = S_OK;
+    CmdContext*         context = (CmdContext*) hContext;
+    RefPtr<IProcess>    process;
+    Mago::SnapshotSpec  snapshotSpec = { 0 };
+
+    if ( !context->Session->FindProcess( pid, process.Ref() ) )
+        return E_NOT_FOUND;
+
+    snapshotSpec.StackSize = spec->StackSize;
+    snapshotSpec.ContextSize = spec->ContextSize;
+    snapshotSpec.FeatureMask = spec->MainFeatureMask;
+    snapshotSpec.ExtFeatureMask = spec->ExtFeatureMask;
+    snapshotSpec.PDataSize = spec->PDataSize;
+
+    hr = context->Session->Callback->SetSnapshotSpec( pid, snapshotSpec );
+
+    return hr;
+}
@@ -0,0 +1,258 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "stdafx.h"
+#include "DecodeX86Suite.h"
+
+
+// each instruction is decoded as if it were here
+const Address   InstAddr = 0x1000;
+
+
+DecodeX86Suite::DecodeX86Suite()
+{
+    TEST_ADD( DecodeX86Suite::ConditionalBranches );
+    TEST_ADD( DecodeX86Suite::DirectBranches );
+    TEST_ADD( DecodeX86Suite::CallsAndReturns );
+    TEST_ADD( DecodeX86Suite::IndirectBranches );
+    TEST_ADD( DecodeX86Suite::Loops );
+    TEST_ADD( DecodeX86Suite::RepStrings );
+    TEST_ADD( DecodeX86Suite::Prefixes );
+    TEST_ADD( DecodeX86Suite::OtherInstructions );
+    TEST_ADD( DecodeX86Suite::BadInstructions );
+}
+
+void DecodeX86Suite::ConditionalBranches()
+{
+    const uint8_t   jzShort[] = { 0x74, 0x05 };
+    const uint8_t   jzShortBack[] = { 0x74, 0xF0 };
+    const uint8_t   jnzNear[] = { 0x0F, 0x85, 0x10, 0x00, 0x00, 0x00 };
+    const uint8_t   jgNearBack[] = { 0x0F, 0x8F, 0xFA, 0xFF, 0xFF, 0xFF };
+
+    AssertBranch( jzShort, sizeof jzShort, Cpu_32, 2, Branch_Conditional, InstAddr + 2 + 5 );
+    AssertBranch( jzShortBack, sizeof jzShortBack, Cpu_32, 2, Branch_Conditional, InstAddr + 2 - 0x10 );
+    AssertBranch( jnzNear, sizeof jnzNear, Cpu_32, 6, Branch_Conditional, InstAddr + 6 + 0x10 );
+    AssertBranch( jgNearBack, sizeof jgNearBack, Cpu_32, 6, Branch_Conditional, InstAddr + 6 - 6 );
+    AssertBranch( jnzNear, sizeof jnzNear, Cpu_64, 6, Branch_Conditional, InstAddr + 6 + 0x10 );
+}
+
+void DecodeX86Suite::DirectBranches()
+{
+    const uint8_t   jmpShortSelf[] = { 0xEB, 0xFE };
+    const uint8_t   jmpNear[] = { 0xE9, 0x00, 0x01, 0x00, 0x00 };
+    const uint8_t   jmpNearBack[] = { 0xE9, 0xF6, 0xFF, 0xFF, 0xFF };
+
+    AssertBranch( jmpShortSelf, sizeof jmpShortSelf, Cpu_32, 2, Branch_Direct, InstAddr );
+    AssertBranch( jmpNear, sizeof jmpNear, Cpu_32, 5, Branch_Direct, InstAddr + 5 + 0x100 );
+    AssertBranch( jmpNearBack, sizeof jmpNearBack, Cpu_64, 5, Branch_Direct, InstAddr + 5 - 10 );
+}
+
+void DecodeX86Suite::CallsAndReturns()
+{
+    const uint8_t   call[] = { 0xE8, 0x00, 0x00, 0x00, 0x00 };
+    const uint8_t   callFar[] = { 0x9A, 0x00, 0x00, 0x00, 0x00, 0x23, 0x00 };
+    const uint8_t   ret[] = { 0xC3 };
+    const uint8_t   retImm[] = { 0xC2, 0x08, 0x00 };
+    const uint8_t   retFar[] = { 0xCB };
+    const uint8_t   int3[] = { 0xCC };
+    const uint8_t   intN[] = { 0xCD, 0x2E };
+    const uint8_t   syscall[] = { 0x0F, 0x05 };
+    const uint8_t   sysenter[] = { 0x0F, 0x34 };
+
+    AssertBranch( call, sizeof call, Cpu_32, 5, Branch_Other, 0 );
+    AssertBranch( call, sizeof call, Cpu_64, 5, Branch_Other, 0 );
+    AssertBranch( callFar, sizeof callFar, Cpu_32, 7, Branch_Other, 0 );
+    AssertBranch( ret, sizeof ret, Cpu_32, 1, Branch_Other, 0 );
+    AssertBranch( retImm, sizeof retImm, Cpu_32, 3, Branch_Other, 0 );
+    AssertBranch( retFar, sizeof retFar, Cpu_64, 1, Branch_Other, 0 );
+    AssertBranch( int3, sizeof int3, Cpu_32, 1, Branch_Other, 0 );
+    AssertBranch( intN, sizeof intN, Cpu_32, 2, Branch_Other, 0 );
+    AssertBranch( syscall, sizeof syscall, Cpu_64, 2, Branch_Other, 0 );
+    AssertBranch( sysenter, sizeof sysenter, Cpu_32, 2, Branch_Other, 0 );
+}
+
+void DecodeX86Suite::IndirectBranches()
+{
+    const uint8_t   callReg[] = { 0xFF, 0xD0 };                             // call eax
+    const uint8_t   callMem[] = { 0xFF, 0x15, 0x00, 0x20, 0x00, 0x00 };     // call [0x2000]
+    const uint8_t   jmpReg[] = { 0xFF, 0xE0 };                              // jmp eax
+    const uint8_t   jmpSib[] = { 0xFF, 0x24, 0x85, 0x00, 0x20, 0x00, 0x00 };   // jmp [eax*4+0x2000]
+    const uint8_t   jmpFarMem[] = { 0xFF, 0x2D, 0x00, 0x20, 0x00, 0x00 };   // jmp far [0x2000]
+    const uint8_t   jmpRip[] = { 0xFF, 0x25, 0x00, 0x00, 0x00, 0x00 };      // jmp [rip]
+
+    AssertBranch( callReg, sizeof callReg, Cpu_32, 2, Branch_Other, 0 );
+    AssertBranch( callMem, sizeof callMem, Cpu_32, 6, Branch_Other, 0 );
+    AssertBranch( jmpReg, sizeof jmpReg, Cpu_32, 2, Branch_Other, 0 );
+    AssertBranch( jmpSib, sizeof jmpSib, Cpu_32, 7, Branch_Other, 0 );
+    AssertBranch( jmpFarMem, sizeof jmpFarMem, Cpu_32, 6, Branch_Other, 0 );
+    AssertBranch( jmpRip, sizeof jmpRip, Cpu_64, 6, Branch_Other, 0 );
+}
+
+void DecodeX86Suite::Loops()
+{
+    const uint8_t   loop[] = { 0xE2, 0xFC };
+    const uint8_t   loopz[] = { 0xE1, 0xFC };
+    const uint8_t   jecxz[] = { 0xE3, 0x10 };
+
+    AssertBranch( loop, sizeof loop, Cpu_32, 2, Branch_Conditional, InstAddr + 2 - 4 );
+    AssertBranch( loopz, sizeof loopz, Cpu_64, 2, Branch_Conditional, InstAddr + 2 - 4 );
+    AssertBranch( jecxz, sizeof jecxz, Cpu_32, 2, Branch_Conditional, InstAddr + 2 + 0x10 );
+}
+
+// A REP string instruction repeats itself, but it never goes anywhere else.
+
+void DecodeX86Suite::RepStrings()
+{
+    const uint8_t   repMovsb[] = { 0xF3, 0xA4 };
+    const uint8_t   repStosd[] = { 0xF3, 0xAB };
+    const uint8_t   repneScasb[] = { 0xF2, 0xAE };
+    const uint8_t   repMovsq[] = { 0xF3, 0x48, 0xA5 };
+
+    AssertBranch( repMovsb, sizeof repMovsb, Cpu_32, 2, Branch_None, 0 );
+    AssertBranch( repStosd, sizeof repStosd, Cpu_32, 2, Branch_None, 0 );
+    AssertBranch( repneScasb, sizeof repneScasb, Cpu_32, 2, Branch_None, 0 );
+    AssertBranch( repMovsq, sizeof repMovsq, Cpu_64, 3, Branch_None, 0 );
+}
+
+void DecodeX86Suite::Prefixes()
+{
+    // a 16 bit operand size shortens the displacement, and wraps the target
+    const uint8_t   jmp16[] = { 0x66, 0xE9, 0x10, 0x00 };
+    // but not in 64-bit mode, where it's ignored
+    const uint8_t   jmp16In64[] = { 0x66, 0xE9, 0x10, 0x00, 0x00, 0x00 };
+    // segment and branch hint prefixes
+    const uint8_t   jzHinted[] = { 0x3E, 0x74, 0x05 };
+    const uint8_t   movFs[] = { 0x64, 0xA1, 0x18, 0x00, 0x00, 0x00 };        // mov eax, fs:[0x18]
+    const uint8_t   movGs[] = { 0x65, 0x48, 0x8B, 0x04, 0x25, 0x30, 0x00, 0x00, 0x00 }; // mov rax, gs:[0x30]
+    // a 16 bit address size changes the ModR/M layout
+    const uint8_t   movAddr16[] = { 0x67, 0x8B, 0x46, 0x02 };               // mov eax, [bp+2]
+    // REX.W makes the immediate 64 bits
+    const uint8_t   movImm64[] = { 0x48, 0xB8, 1, 2, 3, 4, 5, 6, 7, 8 };
+    const uint8_t   movImm32[] = { 0xB8, 1, 2, 3, 4 };
+    const uint8_t   lockAdd[] = { 0xF0, 0x01, 0x03 };                       // lock add [ebx], eax
+
+    AssertBranch( jmp16, sizeof jmp16, Cpu_32, 4, Branch_Direct, (InstAddr + 4 + 0x10) & 0xFFFF );
+    AssertBranch( jmp16In64, sizeof jmp16In64, Cpu_64, 6, Branch_Direct, InstAddr + 6 + 0x10 );
+    AssertBranch( jzHinted, sizeof jzHinted, Cpu_32, 3, Branch_Conditional, InstAddr + 3 + 5 );
+    AssertBranch( movFs, sizeof movFs, Cpu_32, 6, Branch_None, 0 );
+    AssertBranch( movGs, sizeof movGs, Cpu_64, 9, Branch_None, 0 );
+    AssertBranch( movAddr16, sizeof movAddr16, Cpu_32, 4, Branch_None, 0 );
+    AssertBranch( movImm64, sizeof movImm64, Cpu_64, 10, Branch_None, 0 );
+    AssertBranch( movImm32, sizeof movImm32, Cpu_64, 5, Branch_None, 0 );
+    AssertBranch( lockAdd, sizeof lockAdd, Cpu_32, 3, Branch_None, 0 );
+}
+
+void DecodeX86Suite::OtherInstructions()
+{
+    const uint8_t   movSib[] = { 0x8B, 0x44, 0x8B, 0x10 };                  // mov eax, [ebx+ecx*4+0x10]
+    const uint8_t   movNoBase[] = { 0x8B, 0x04, 0x8D, 0, 0, 0, 0 };         // mov eax, [ecx*4]
+    const uint8_t   pushMem[] = { 0xFF, 0x30 };                             // push [eax]
+    const uint8_t   incMem[] = { 0xFF, 0x00 };                              // inc [eax]
+    const uint8_t   testImm8[] = { 0xF6, 0xC0, 0x01 };                      // test al, 1
+    const uint8_t   testImm32[] = { 0xF7, 0xC0, 1, 0, 0, 0 };               // test eax, 1
+    const uint8_t   notReg[] = { 0xF7, 0xD0 };                              // not eax
+    const uint8_t   enter[] = { 0xC8, 0x10, 0x00, 0x00 };
+    const uint8_t   fld[] = { 0xD9, 0x45, 0x08 };                           // fld [ebp+8]
+    const uint8_t   movdqa[] = { 0x66, 0x0F, 0x6F, 0x04, 0x24 };            // movdqa xmm0, [esp]
+    const uint8_t   pshufb[] = { 0x66, 0x0F, 0x38, 0x00, 0xC1 };            // pshufb xmm0, xmm1
+    const uint8_t   palignr[] = { 0x66, 0x0F, 0x3A, 0x0F, 0xC1, 0x08 };     // palignr xmm0, xmm1, 8
+    const uint8_t   cmovz[] = { 0x0F, 0x44, 0xC1 };
+
+    AssertBranch( movSib, sizeof movSib, Cpu_32, 4, Branch_None, 0 );
+    AssertBranch( movNoBase, sizeof movNoBase, Cpu_32, 7, Branch_None, 0 );
+    AssertBranch( pushMem, sizeof pushMem, Cpu_32, 2, Branch_None, 0 );
+    AssertBranch( incMem, sizeof incMem, Cpu_32, 2, Branch_None, 0 );
+    AssertBranch( testImm8, sizeof testImm8, Cpu_32, 3, Branch_None, 0 );
+    AssertBranch( testImm32, sizeof testImm32, Cpu_32, 6, Branch_None, 0 );
+    AssertBranch( notReg, sizeof notReg, Cpu_32, 2, Branch_None, 0 );
+    AssertBranch( enter, sizeof enter, Cpu_32, 4, Branch_None, 0 );
+    AssertBranch( fld, sizeof fld, Cpu_32, 3, Branch_None, 0 );
+    AssertBranch( movdqa, sizeof movdqa, Cpu_32, 5, Branch_None, 0 );
+    AssertBranch( pshufb, sizeof pshufb, Cpu_32, 5, Branch_None, 0 );
+    AssertBranch( palignr, sizeof palignr, Cpu_64, 6, Branch_None, 0 );
+    AssertBranch( cmovz, sizeof cmovz, Cpu_32, 3, Branch_None, 0 );
+}
+
+void DecodeX86Suite::BadInstructions()
+{
+    const uint8_t   truncatedJmp[] = { 0xE9, 0x00, 0x00 };
+    const uint8_t   truncatedModRm[] = { 0x8B };
+    const uint8_t   onlyPrefixes[] = { 0x66, 0x67 };
+    const uint8_t   pushEs[] = { 0x06 };
+    const uint8_t   vzeroupper[] = { 0xC5, 0xF8, 0x77 };
+    const uint8_t   ud0[] = { 0x0F, 0xFF, 0x00 };
+
+    AssertBad( truncatedJmp, sizeof truncatedJmp, Cpu_32 );
+    AssertBad( truncatedModRm, sizeof truncatedModRm, Cpu_32 );
+    AssertBad( onlyPrefixes, sizeof onlyPrefixes, Cpu_32 );
+    AssertBad( pushEs, sizeof pushEs, Cpu_64 );
+    AssertBad( vzeroupper, sizeof vzeroupper, Cpu_32 );
+    AssertBad( vzeroupper, sizeof vzeroupper, Cpu_64 );
+    AssertBad( ud0, sizeof ud0, Cpu_32 );
+
+    // PUSH ES is fine in 32-bit mode
+    AssertBranch( pushEs, sizeof pushEs, Cpu_32, 1, Branch_None, 0 );
+}
+
+void DecodeX86Suite::AssertBranch( 
+    const uint8_t* code, 
+    int codeLen, 
+    CpuSizeMode mode, 
+    int expectedSize, 
+    BranchType expectedType, 
+    Address expectedTarget )
+{
+    uint8_t     mem[MAX_INSTRUCTION_SIZE] = { 0 };
+    int         size = 0;
+    BranchType  type = Branch_None;
+    Address     target = 0;
+    char        msg[256] = "";
+
+    memcpy( mem, code, codeLen );
+
+    if ( !GetInstructionBranch( mem, codeLen, mode, InstAddr, size, type, target ) )
+    {
+        sprintf_s( msg, "Couldn't decode the instruction starting with %02x %02x.", code[0], (codeLen > 1) ? code[1] : 0 );
+        TEST_FAIL_MSG( msg );
+        return;
+    }
+
+    if ( size != expectedSize )
+    {
+        sprintf_s( msg, "Expected size %d, got %d, for %02x %02x.", expectedSize, size, code[0], (codeLen > 1) ? code[1] : 0 );
+        TEST_FAIL_MSG( msg );
+    }
+
+    if ( type != expectedType )
+    {
+        sprintf_s( msg, "Expected branch type %d, got %d, for %02x %02x.", expectedType, type, code[0], (codeLen > 1) ? code[1] : 0 );
+        TEST_FAIL_MSG( msg );
+    }
+
+    if ( ((type == Branch_Direct) || (type == Branch_Conditional)) && (target != expectedTarget) )
+    {
+        sprintf_s( msg, "Expected target %p, got %p, for %02x %02x.", expectedTarget, target, code[0], (codeLen > 1) ? code[1] : 0 );
+        TEST_FAIL_MSG( msg );
+    }
+}
+
+void DecodeX86Suite::AssertBad( const uint8_t* code, int codeLen, CpuSizeMode mode )
+{
+    uint8_t     mem[MAX_INSTRUCTION_SIZE] = { 0 };
+    int         size = 0;
+    BranchType  type = Branch_None;
+    Address     target = 0;
+    char        msg[256] = "";
+
+    memcpy( mem, code, codeLen );
+
+    if ( GetInstructionBranch( mem, codeLen, mode, InstAddr, size, type, target ) )
+    {
+        sprintf_s( msg, "Expected a bad instruction, got size %d for %02x.", size, code[0] );
+        TEST_FAIL_MSG( msg );
+    }
+}
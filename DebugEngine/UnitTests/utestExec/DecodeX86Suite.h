@@ -0,0 +1,35 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+
+class DecodeX86Suite : public Test::Suite
+{
+public:
+    DecodeX86Suite();
+
+private:
+    void ConditionalBranches();
+    void DirectBranches();
+    void CallsAndReturns();
+    void IndirectBranches();
+    void Loops();
+    void RepStrings();
+    void Prefixes();
+    void OtherInstructions();
+    void BadInstructions();
+
+    void AssertBranch( 
+        const uint8_t* code, 
+        int codeLen, 
+        CpuSizeMode mode, 
+        int expectedSize, 
+        BranchType expectedType, 
+        Address expectedTarget );
+    void AssertBad( const uint8_t* code, int codeLen, CpuSizeMode mode );
+};
@@ -0,0 +1,145 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "stdafx.h"
+#include "MemoryCodecSuite.h"
+#include "..\..\Exec\MemoryCodec.h"
+
+
+// bytes that the LZ codec can't make smaller
+static void FillNoise( uint8_t* mem, uint32_t length, uint32_t seed )
+{
+    for ( uint32_t i = 0; i < length; i++ )
+    {
+        seed = seed * 1103515245 + 12345;
+        mem[i] = (uint8_t) (seed >> 16);
+    }
+}
+
+// bytes like a stack or a heap block, with runs and repeated words
+static void FillRepeats( uint8_t* mem, uint32_t length )
+{
+    for ( uint32_t i = 0; i < length; i++ )
+    {
+        if ( (i % 64) < 16 )
+            mem[i] = 0;
+        else
+            mem[i] = (uint8_t) ("0123456789ABCDEF"[i % 16]);
+    }
+}
+
+
+MemoryCodecSuite::MemoryCodecSuite()
+{
+    TEST_ADD( MemoryCodecSuite::ZeroPages );
+    TEST_ADD( MemoryCodecSuite::RawPages );
+    TEST_ADD( MemoryCodecSuite::LzPages );
+    TEST_ADD( MemoryCodecSuite::PartialPages );
+    TEST_ADD( MemoryCodecSuite::MixedPages );
+    TEST_ADD( MemoryCodecSuite::SmallCapacity );
+    TEST_ADD( MemoryCodecSuite::BadPacked );
+}
+
+void MemoryCodecSuite::ZeroPages()
+{
+    std::vector<uint8_t>    mem( PackedPageSize * 3 );
+
+    // one tag byte a page
+    AssertRoundTrip( &mem[0], mem.size(), 3 );
+}
+
+void MemoryCodecSuite::RawPages()
+{
+    std::vector<uint8_t>    mem( PackedPageSize * 2 );
+
+    FillNoise( &mem[0], mem.size(), 1 );
+
+    AssertRoundTrip( &mem[0], mem.size(), GetMaxPackedSize( mem.size() ) );
+}
+
+void MemoryCodecSuite::LzPages()
+{
+    std::vector<uint8_t>    mem( PackedPageSize * 2 );
+
+    FillRepeats( &mem[0], mem.size() );
+
+    AssertRoundTrip( &mem[0], mem.size(), (uint32_t) mem.size() / 4 );
+}
+
+void MemoryCodecSuite::PartialPages()
+{
+    const uint32_t  Lengths[] = { 0, 1, 3, 4, 5, 100, PackedPageSize - 1, PackedPageSize + 1, PackedPageSize * 2 + 7 };
+    std::vector<uint8_t>    mem( PackedPageSize * 3 );
+
+    FillRepeats( &mem[0], mem.size() );
+
+    for ( int i = 0; i < _countof( Lengths ); i++ )
+        AssertRoundTrip( &mem[0], Lengths[i], GetMaxPackedSize( Lengths[i] ) );
+
+    FillNoise( &mem[0], mem.size(), 2 );
+
+    for ( int i = 0; i < _countof( Lengths ); i++ )
+        AssertRoundTrip( &mem[0], Lengths[i], GetMaxPackedSize( Lengths[i] ) );
+}
+
+void MemoryCodecSuite::MixedPages()
+{
+    std::vector<uint8_t>    mem( PackedPageSize * 4 );
+
+    // zero, raw, LZ, and a zero page with one byte set
+    FillNoise( &mem[PackedPageSize], PackedPageSize, 3 );
+    FillRepeats( &mem[PackedPageSize * 2], PackedPageSize );
+    mem[PackedPageSize * 4 - 1] = 1;
+
+    AssertRoundTrip( &mem[0], mem.size(), GetMaxPackedSize( mem.size() ) );
+}
+
+void MemoryCodecSuite::SmallCapacity()
+{
+    std::vector<uint8_t>    mem( PackedPageSize );
+    std::vector<uint8_t>    packed( GetMaxPackedSize( mem.size() ) );
+    uint32_t                packedSize = 0;
+
+    TEST_ASSERT( PackMemory( &mem[0], mem.size(), &packed[0], packed.size() - 1, packedSize ) == E_INVALIDARG );
+}
+
+void MemoryCodecSuite::BadPacked()
+{
+    std::vector<uint8_t>    mem( PackedPageSize * 2 );
+    std::vector<uint8_t>    packed( GetMaxPackedSize( mem.size() ) );
+    std::vector<uint8_t>    unpacked( mem.size() );
+    uint32_t                packedSize = 0;
+
+    FillRepeats( &mem[0], PackedPageSize );
+    FillNoise( &mem[PackedPageSize], PackedPageSize, 4 );
+
+    TEST_ASSERT_RETURN( PackMemory( &mem[0], mem.size(), &packed[0], packed.size(), packedSize ) == S_OK );
+
+    // cut short, one byte too many, unpacked to the wrong length, and a bad tag
+    TEST_ASSERT( FAILED( UnpackMemory( &packed[0], packedSize - 1, &unpacked[0], unpacked.size() ) ) );
+    TEST_ASSERT( FAILED( UnpackMemory( &packed[0], packedSize, &unpacked[0], unpacked.size() - 1 ) ) );
+    TEST_ASSERT( FAILED( UnpackMemory( &packed[0], packedSize, &unpacked[0], PackedPageSize ) ) );
+
+    packed.push_back( 0 );
+    TEST_ASSERT( FAILED( UnpackMemory( &packed[0], packedSize + 1, &unpacked[0], unpacked.size() ) ) );
+
+    packed[0] = 0xFF;
+    TEST_ASSERT( FAILED( UnpackMemory( &packed[0], packedSize, &unpacked[0], unpacked.size() ) ) );
+}
+
+void MemoryCodecSuite::AssertRoundTrip( const uint8_t* mem, uint32_t length, uint32_t maxPackedSize )
+{
+    std::vector<uint8_t>    packed( GetMaxPackedSize( length ) + 1 );
+    std::vector<uint8_t>    unpacked( length + 1 );
+    uint32_t                packedSize = 0;
+
+    TEST_ASSERT_RETURN( PackMemory( mem, length, &packed[0], packed.size(), packedSize ) == S_OK );
+    TEST_ASSERT( packedSize <= maxPackedSize );
+
+    TEST_ASSERT_RETURN( UnpackMemory( &packed[0], packedSize, &unpacked[0], length ) == S_OK );
+    TEST_ASSERT( memcmp( mem, &unpacked[0], length ) == 0 );
+}
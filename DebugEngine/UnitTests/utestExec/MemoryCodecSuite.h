@@ -0,0 +1,26 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+
+class MemoryCodecSuite : public Test::Suite
+{
+public:
+    MemoryCodecSuite();
+
+private:
+    void ZeroPages();
+    void RawPages();
+    void LzPages();
+    void PartialPages();
+    void MixedPages();
+    void SmallCapacity();
+    void BadPacked();
+
+    void AssertRoundTrip( const uint8_t* mem, uint32_t length, uint32_t maxPackedSize );
+};
@@ -50,6 +50,8 @@ StepOneThreadSuite::StepOneThreadSuite()
     TEST_ADD( StepOneThreadSuite::StepInstructionInSourceHaveSource );
     TEST_ADD( StepOneThreadSuite::StepInstructionInSourceNoSource );
     TEST_ADD( StepOneThreadSuite::StepInstructionOverInterruptedByBP );
+    TEST_ADD( StepOneThreadSuite::StepRangeOverLoop );
+    TEST_ADD( StepOneThreadSuite::StepRangeOverLoopWithOtherThread );
 }
 
 void StepOneThreadSuite::setup()
@@ -189,6 +191,160 @@ void StepOneThreadSuite::StepInstructionOverInterruptedByBP()
     RunDebuggee( steps, _countof( steps ) );
 }
 
+// The loop in the range goes around 100000 times. Single stepping it takes
+// a debug event for each instruction, but running through it only takes the
+// one at the end of the range.
+
+void StepOneThreadSuite::StepRangeOverLoop()
+{
+    int     rangeEventCount = 0;
+
+    RunLoopDebuggee( 2, rangeEventCount );
+
+    TEST_ASSERT( (rangeEventCount > 0) && (rangeEventCount < 10) );
+}
+
+// The other thread reaches the range's BPs over and over. It has to step 
+// over them on its own, instead of hitting them again until the range step
+// is done.
+
+void StepOneThreadSuite::StepRangeOverLoopWithOtherThread()
+{
+    int     rangeEventCount = 0;
+
+    RunLoopDebuggee( 3, rangeEventCount );
+
+    TEST_ASSERT( rangeEventCount > 0 );
+}
+
+void StepOneThreadSuite::RunLoopDebuggee( int scenario, int& rangeEventCount )
+{
+    Exec    exec;
+
+    TEST_ASSERT_RETURN( SUCCEEDED( exec.Init( mCallback ) ) );
+
+    LaunchInfo  info = { 0 };
+    wchar_t     cmdLine[ MAX_PATH ] = L"";
+    IProcess*   proc = NULL;
+    const wchar_t*  Debuggee = StepOneThreadDebuggee;
+
+    swprintf_s( cmdLine, L"\"%s\" %d", Debuggee, scenario );
+
+    info.CommandLine = cmdLine;
+    info.Exe = Debuggee;
+
+    TEST_ASSERT_RETURN( SUCCEEDED( exec.Launch( &info, proc ) ) );
+
+    // the int 3, stepping to the call and into RunLoop, then stepping 
+    // through its loop
+    enum
+    {
+        Step_AtBP,
+        Step_AtCall,
+        Step_AtLoop,
+        Step_AfterLoop,
+        Step_Exit,
+    };
+
+    int                 nextStep = Step_AtBP;
+    uintptr_t           loopAddr = 0;
+    char                msg[1024] = "";
+    RefPtr<IProcess>    process;
+
+    process = proc;
+    proc->Release();
+    mCallback->SetTrackLastEvent( true );
+    rangeEventCount = 0;
+
+    for ( int i = 0; !mCallback->GetProcessExited(); i++ )
+    {
+        bool    continued = false;
+        HRESULT hr = exec.WaitForEvent( DefaultTimeoutMillis );
+
+        if ( hr == E_TIMEOUT )
+            break;
+
+        TEST_ASSERT_RETURN( SUCCEEDED( hr ) );
+        TEST_ASSERT_RETURN( SUCCEEDED( hr = exec.DispatchEvent() ) );
+
+        if ( nextStep == Step_AfterLoop )
+            rangeEventCount++;
+
+        if ( !process->IsStopped() )
+            continue;
+
+        ExecEvent   code = mCallback->GetLastEvent()->Code;
+
+        if ( (code == ExecEvent_ModuleLoad)
+            || (code == ExecEvent_ModuleUnload)
+            || (code == ExecEvent_ThreadStart)
+            || (code == ExecEvent_ThreadExit)
+            || (code == ExecEvent_LoadComplete) )
+        {
+            TEST_ASSERT_RETURN( SUCCEEDED( exec.Continue( process, true ) ) );
+            continue;
+        }
+
+        RefPtr<Thread>  thread;
+        CONTEXT_X86     context = { 0 };
+        ExecEvent       expectedCode = ExecEvent_StepComplete;
+
+        if ( nextStep == Step_AtBP )
+            expectedCode = ExecEvent_Breakpoint;
+        else if ( nextStep == Step_Exit )
+            expectedCode = ExecEvent_ProcessExit;
+
+        if ( code != expectedCode )
+        {
+            sprintf_s( msg, "Expected event '%s', got '%s'.", 
+                GetEventName( expectedCode ),
+                GetEventName( code ) );
+            TEST_FAIL_MSG( msg );
+            break;
+        }
+
+        if ( code == ExecEvent_ProcessExit )
+            break;
+
+        TEST_ASSERT_RETURN( process->FindThread( mCallback->GetLastThreadId(), thread.Ref() ) );
+        TEST_ASSERT_RETURN( exec.GetThreadContext( 
+            process, thread->GetId(), CONTEXT_X86_FULL, 0, &context, sizeof context ) == S_OK );
+
+        if ( (nextStep == Step_AtBP) || (nextStep == Step_AtCall) )
+        {
+            TEST_ASSERT_RETURN( SUCCEEDED( exec.StepInstruction( process.Get(), true, true ) ) );
+            continued = true;
+        }
+        else if ( nextStep == Step_AtLoop )
+        {
+            // mov ecx, imm32; dec ecx; jnz again
+            AddressRange range = { context.Eip, context.Eip + 5 + 1 + 2 - 1 };
+
+            loopAddr = context.Eip;
+            TEST_ASSERT_RETURN( SUCCEEDED( exec.StepRange( process.Get(), false, range, true ) ) );
+            continued = true;
+        }
+        else if ( nextStep == Step_AfterLoop )
+        {
+            // on the ret after the loop
+            if ( context.Eip != loopAddr + 8 )
+            {
+                sprintf_s( msg, "Expected instruction pointer at %p, got %08x.", loopAddr + 8, context.Eip );
+                TEST_FAIL_MSG( msg );
+                break;
+            }
+        }
+
+        nextStep++;
+
+        if ( !continued )
+            TEST_ASSERT_RETURN( SUCCEEDED( exec.Continue( process, true ) ) );
+    }
+
+    TEST_ASSERT( nextStep == Step_Exit );
+    TEST_ASSERT( mCallback->GetProcessExited() );
+}
+
 void StepOneThreadSuite::RunDebuggee( Step* steps, int stepsCount )
 {
     Exec    exec;
@@ -28,6 +28,9 @@ private:
     void StepInstructionInSourceHaveSource();
     void StepInstructionInSourceNoSource();
     void StepInstructionOverInterruptedByBP();
+    void StepRangeOverLoop();
+    void StepRangeOverLoopWithOtherThread();
 
     void RunDebuggee( Step* steps, int stepsCount );
+    void RunLoopDebuggee( int scenario, int& rangeEventCount );
 };
@@ -28,6 +28,7 @@
 #include <list>
 #include <map>
 #include <memory>
+#include <vector>
 
 // Windows
 #include <windows.h>
@@ -45,6 +46,7 @@
 #include "..\..\Exec\IModule.h"
 #include "..\..\Exec\Thread.h"
 #include "..\..\Exec\Enumerator.h"
+#include "..\..\Exec\DecodeX86.h"
 
 // This project
 #include "Utility.h"
@@ -9,8 +9,10 @@
 //
 
 #include "stdafx.h"
+#include "DecodeX86Suite.h"
 #include "StartStopSuite.h"
 #include "EventSuite.h"
+#include "MemoryCodecSuite.h"
 #include "StepOneThreadSuite.h"
 
 using namespace std;
@@ -144,6 +146,8 @@ int _tmain(int argc, _TCHAR* argv[])
     comboSuite.add( auto_ptr<Test::Suite>( new StartStopSuite() ) );
     comboSuite.add( auto_ptr<Test::Suite>( new EventSuite() ) );
     comboSuite.add( auto_ptr<Test::Suite>( new StepOneThreadSuite() ) );
+    comboSuite.add( auto_ptr<Test::Suite>( new DecodeX86Suite() ) );
+    comboSuite.add( auto_ptr<Test::Suite>( new MemoryCodecSuite() ) );
 
     bool    passed = comboSuite.run( *options.Out.get() );
 
@@ -0,0 +1,370 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "stdafx.h"
+#include "BulkReadSuite.h"
+#include "..\..\MagoNatDE\BulkMemoryReader.h"
+#include "..\..\Exec\MemoryCodec.h"
+
+using namespace Mago;
+
+
+const uint64_t  MemBase = 0x10000000;
+const uint32_t  SlotCount = 4;
+const uint32_t  MemChunks = 8;
+const HRESULT   LinkFailedHr = HRESULT_FROM_WIN32( RPC_S_CALL_FAILED );
+const uint32_t  NoRequest = 0xFFFFFFFF;
+
+
+// Answers each chunk read right away from a block of memory in this 
+// process. The memory is packed the way it is over the link.
+//
+// Requests are counted from 0 in the order that the reader makes them, 
+// so that one of them can be made to fail.
+
+class FakeBulkReadTransport : public IBulkReadTransport
+{
+    struct Slot
+    {
+        bool                    Busy;
+        uint32_t                Request;
+        Address64               Address;
+        uint32_t                Length;
+        std::vector<uint8_t>    Packed;
+    };
+
+    std::vector<Slot>   mSlots;
+    uint64_t            mBase;
+    const uint8_t*      mMem;
+    uint32_t            mSize;
+    uint32_t            mReadableSize;
+    uint32_t            mUnreadableSize;
+
+    uint32_t            mFailRequest;
+    HRESULT             mFailRequestHr;
+    uint32_t            mFailResult;
+    HRESULT             mFailResultHr;
+
+    uint32_t            mNextRequest;
+    uint32_t            mRequestCount;
+    uint32_t            mEndCount;
+    uint32_t            mOutstanding;
+    uint32_t            mMostOutstanding;
+    bool                mSlotMisused;
+
+public:
+    FakeBulkReadTransport( uint32_t slotCount )
+        :   mSlots( slotCount ),
+            mBase( 0 ),
+            mMem( NULL ),
+            mSize( 0 ),
+            mReadableSize( 0 ),
+            mUnreadableSize( 0 ),
+            mFailRequest( NoRequest ),
+            mFailRequestHr( S_OK ),
+            mFailResult( NoRequest ),
+            mFailResultHr( S_OK ),
+            mNextRequest( 0 ),
+            mRequestCount( 0 ),
+            mEndCount( 0 ),
+            mOutstanding( 0 ),
+            mMostOutstanding( 0 ),
+            mSlotMisused( false )
+    {
+        for ( size_t i = 0; i < mSlots.size(); i++ )
+            mSlots[i].Busy = false;
+    }
+
+    void SetMemory( 
+        uint64_t base, 
+        const uint8_t* mem, 
+        uint32_t size, 
+        uint32_t readableSize, 
+        uint32_t unreadableSize )
+    {
+        mBase = base;
+        mMem = mem;
+        mSize = size;
+        mReadableSize = readableSize;
+        mUnreadableSize = unreadableSize;
+    }
+
+    void FailRequest( uint32_t request, HRESULT hr )
+    {
+        mFailRequest = request;
+        mFailRequestHr = hr;
+    }
+
+    void FailResult( uint32_t request, HRESULT hr )
+    {
+        mFailResult = request;
+        mFailResultHr = hr;
+    }
+
+    uint32_t GetRequestCount()      { return mRequestCount; }
+    uint32_t GetEndCount()          { return mEndCount; }
+    uint32_t GetMostOutstanding()   { return mMostOutstanding; }
+    bool GetSlotMisused()           { return mSlotMisused; }
+
+    virtual uint32_t GetSlotCount()
+    {
+        return mSlots.size();
+    }
+
+    virtual HRESULT BeginRead( uint32_t slotIndex, Address64 address, uint32_t length )
+    {
+        uint32_t    request = mNextRequest++;
+
+        if ( (slotIndex >= mSlots.size()) || mSlots[slotIndex].Busy )
+        {
+            mSlotMisused = true;
+            return E_UNEXPECTED;
+        }
+
+        if ( request == mFailRequest )
+            return mFailRequestHr;
+
+        Slot&   slot = mSlots[slotIndex];
+
+        slot.Busy = true;
+        slot.Request = request;
+        slot.Address = address;
+        slot.Length = length;
+
+        mRequestCount++;
+        mOutstanding++;
+        if ( mOutstanding > mMostOutstanding )
+            mMostOutstanding = mOutstanding;
+
+        return S_OK;
+    }
+
+    virtual void EndRead( uint32_t slotIndex, BulkReadChunk& chunk )
+    {
+        memset( &chunk, 0, sizeof chunk );
+
+        if ( (slotIndex >= mSlots.size()) || !mSlots[slotIndex].Busy )
+        {
+            mSlotMisused = true;
+            chunk.Result = E_UNEXPECTED;
+            return;
+        }
+
+        Slot&       slot = mSlots[slotIndex];
+        uint64_t    readableEnd = mBase + mReadableSize;
+        uint64_t    unreadableEnd = readableEnd + mUnreadableSize;
+        uint32_t    lenRead = 0;
+        uint32_t    lenUnreadable = 0;
+
+        slot.Busy = false;
+        mEndCount++;
+        mOutstanding--;
+
+        if ( slot.Request == mFailResult )
+        {
+            chunk.Result = mFailResultHr;
+            return;
+        }
+
+        if ( (slot.Address < mBase) || (slot.Address + slot.Length > mBase + mSize) )
+        {
+            chunk.Result = E_INVALIDARG;
+            return;
+        }
+
+        // Like ReadMemory, the readable bytes come first, then the 
+        // unreadable ones. It stops short where readable memory starts again.
+        if ( slot.Address >= unreadableEnd )
+        {
+            lenRead = slot.Length;
+        }
+        else
+        {
+            uint64_t    end = slot.Address + slot.Length;
+
+            if ( slot.Address < readableEnd )
+                lenRead = (uint32_t) (((end < readableEnd) ? end : readableEnd) - slot.Address);
+
+            lenUnreadable = (uint32_t) (((end < unreadableEnd) ? end : unreadableEnd) - (slot.Address + lenRead));
+        }
+
+        slot.Packed.resize( GetMaxPackedSize( lenRead ) + 1 );
+
+        chunk.Result = PackMemory( 
+            mMem + (slot.Address - mBase), 
+            lenRead, 
+            &slot.Packed[0], 
+            slot.Packed.size(), 
+            chunk.PackedSize );
+        chunk.LengthRead = lenRead;
+        chunk.LengthUnreadable = lenUnreadable;
+        chunk.Packed = &slot.Packed[0];
+    }
+};
+
+
+
+BulkReadSuite::BulkReadSuite()
+    :   mTransport( NULL ),
+        mReader( NULL )
+{
+    TEST_ADD( BulkReadSuite::WholeBlock );
+    TEST_ADD( BulkReadSuite::UnreadableTail );
+    TEST_ADD( BulkReadSuite::UnreadableGap );
+    TEST_ADD( BulkReadSuite::UnreadableBlock );
+    TEST_ADD( BulkReadSuite::RequestFailure );
+    TEST_ADD( BulkReadSuite::RequestFailureAfterEnd );
+    TEST_ADD( BulkReadSuite::ResultFailure );
+    TEST_ADD( BulkReadSuite::ResultFailureAfterEnd );
+}
+
+void BulkReadSuite::setup()
+{
+    uint32_t    seed = 1;
+
+    mTransport = new FakeBulkReadTransport( SlotCount );
+    mReader = new BulkMemoryReader();
+
+    // half of each page is zeros and half is noise, so that the pages are 
+    // packed different ways
+    mMem.resize( MemChunks * BulkMemoryReader::ChunkSize );
+
+    for ( size_t i = 0; i < mMem.size(); i++ )
+    {
+        seed = seed * 1103515245 + 12345;
+        mMem[i] = ((i & 0x800) != 0) ? (uint8_t) (seed >> 16) : 0;
+    }
+}
+
+void BulkReadSuite::tear_down()
+{
+    delete mReader;
+    mReader = NULL;
+    delete mTransport;
+    mTransport = NULL;
+
+    mMem.clear();
+}
+
+void BulkReadSuite::WholeBlock()
+{
+    uint32_t    length = BulkMemoryReader::ChunkSize * 5 + 0x123;
+
+    AssertRead( length, length, 0, S_OK );
+
+    // every slot was kept busy
+    TEST_ASSERT( mTransport->GetMostOutstanding() == SlotCount );
+    TEST_ASSERT( mTransport->GetRequestCount() == 6 );
+}
+
+void BulkReadSuite::UnreadableTail()
+{
+    uint32_t    chunkSize = BulkMemoryReader::ChunkSize;
+    uint32_t    length = chunkSize * MemChunks;
+
+    AssertRead( length, chunkSize * 2 + 0x800, length, S_OK );
+
+    // readable memory could have come after, so all of it was asked for
+    TEST_ASSERT( mTransport->GetRequestCount() == MemChunks );
+}
+
+void BulkReadSuite::UnreadableGap()
+{
+    uint32_t    chunkSize = BulkMemoryReader::ChunkSize;
+
+    // The third chunk comes back short, which ends the block. The chunks 
+    // after it that are already out aren't used, and no more are asked for.
+    AssertRead( chunkSize * MemChunks, chunkSize * 2 + 0x800, 0x1000, S_OK );
+
+    TEST_ASSERT( mTransport->GetRequestCount() == 6 );
+}
+
+void BulkReadSuite::UnreadableBlock()
+{
+    uint32_t    length = BulkMemoryReader::ChunkSize * 3;
+
+    AssertRead( length, 0, length, S_OK );
+}
+
+void BulkReadSuite::RequestFailure()
+{
+    uint32_t    length = BulkMemoryReader::ChunkSize * MemChunks;
+
+    // The sixth request fails with the third, fourth, and fifth chunks 
+    // still out. They're taken in, but they don't reach the end of the 
+    // block, so the read fails.
+    mTransport->FailRequest( 5, LinkFailedHr );
+
+    AssertRead( length, length, 0, LinkFailedHr );
+
+    TEST_ASSERT( mTransport->GetRequestCount() == 5 );
+}
+
+void BulkReadSuite::RequestFailureAfterEnd()
+{
+    uint32_t    chunkSize = BulkMemoryReader::ChunkSize;
+
+    // the fourth chunk, still out when the sixth request fails, ends the block
+    mTransport->FailRequest( 5, LinkFailedHr );
+
+    AssertRead( chunkSize * MemChunks, chunkSize * 3 + 0x100, 0x100, S_OK );
+}
+
+void BulkReadSuite::ResultFailure()
+{
+    uint32_t    length = BulkMemoryReader::ChunkSize * MemChunks;
+
+    // what came before the failed chunk isn't returned as a short read
+    mTransport->FailResult( 2, LinkFailedHr );
+
+    AssertRead( length, length, 0, LinkFailedHr );
+}
+
+void BulkReadSuite::ResultFailureAfterEnd()
+{
+    uint32_t    chunkSize = BulkMemoryReader::ChunkSize;
+
+    // the second chunk ends the block before the third one fails
+    mTransport->FailResult( 2, LinkFailedHr );
+
+    AssertRead( chunkSize * MemChunks, chunkSize + 0x10, 0x10, S_OK );
+}
+
+void BulkReadSuite::AssertRead( 
+    uint32_t length, 
+    uint32_t readableSize, 
+    uint32_t unreadableSize, 
+    HRESULT expectedHr )
+{
+    HRESULT                 hr = S_OK;
+    uint32_t                lenRead = 0xFFFFFFFF;
+    uint32_t                lenUnreadable = 0xFFFFFFFF;
+    uint32_t                expectedLenRead = (readableSize < length) ? readableSize : length;
+    uint32_t                expectedLenUnreadable = length - expectedLenRead;
+    std::vector<uint8_t>    buffer( length );
+
+    if ( unreadableSize < expectedLenUnreadable )
+        expectedLenUnreadable = unreadableSize;
+
+    mTransport->SetMemory( MemBase, &mMem[0], mMem.size(), readableSize, unreadableSize );
+
+    hr = mReader->Read( mTransport, MemBase, length, lenRead, lenUnreadable, &buffer[0] );
+
+    // every request that was made is taken back, whatever the result
+    TEST_ASSERT( !mTransport->GetSlotMisused() );
+    TEST_ASSERT( mTransport->GetEndCount() == mTransport->GetRequestCount() );
+    TEST_ASSERT( mTransport->GetMostOutstanding() <= SlotCount );
+
+    TEST_ASSERT_RETURN( hr == expectedHr );
+
+    if ( FAILED( hr ) )
+        return;
+
+    TEST_ASSERT( lenRead == expectedLenRead );
+    TEST_ASSERT( lenUnreadable == expectedLenUnreadable );
+    TEST_ASSERT( (expectedLenRead == 0) || (memcmp( &buffer[0], &mMem[0], expectedLenRead ) == 0) );
+}
@@ -0,0 +1,45 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+namespace Mago
+{
+    class BulkMemoryReader;
+}
+
+class FakeBulkReadTransport;
+
+
+class BulkReadSuite : public Test::Suite
+{
+    FakeBulkReadTransport*  mTransport;
+    Mago::BulkMemoryReader* mReader;
+    std::vector<uint8_t>    mMem;
+
+public:
+    BulkReadSuite();
+
+    void setup();
+    void tear_down();
+
+private:
+    void WholeBlock();
+    void UnreadableTail();
+    void UnreadableGap();
+    void UnreadableBlock();
+    void RequestFailure();
+    void RequestFailureAfterEnd();
+    void ResultFailure();
+    void ResultFailureAfterEnd();
+
+    void AssertRead( 
+        uint32_t length, 
+        uint32_t readableSize, 
+        uint32_t unreadableSize, 
+        HRESULT expectedHr );
+};
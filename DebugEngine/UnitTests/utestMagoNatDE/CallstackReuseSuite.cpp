@@ -0,0 +1,537 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "stdafx.h"
+#include "CallstackReuseSuite.h"
+#include "..\..\MagoNatDE\Thread.h"
+#include "..\..\MagoNatDE\Program.h"
+#include "..\..\MagoNatDE\CodeContext.h"
+#include "..\..\MagoNatDE\IDebuggerProxy.h"
+#include "..\..\MagoNatDE\ArchDataX64.h"
+#include "..\..\MagoNatDE\RemoteProcess.h"
+
+using namespace Mago;
+
+
+namespace
+{
+    const uint32_t  Pid = 100;
+    const uint32_t  Tid = 200;
+
+    // CONTEXT_AMD64 | CONTEXT_CONTROL | CONTEXT_INTEGER, which WinNT.h only
+    // has in x64 builds
+    const DWORD     ContextX64ControlInteger = 0x00100003;
+
+    const uint64_t  StackTop = 0x30000000;
+    const uint64_t  HighStackTop = 0x40000000;
+    const uint64_t  LowStackTop = 0x20000000;
+
+    // main calls g or h, which call f, which calls itself
+    const uint64_t  MainPC = 0x401000;
+    const uint64_t  MainCallGReturn = 0x401010;
+    const uint64_t  MainCallHReturn = 0x401020;
+    const uint64_t  GPC = 0x402000;
+    const uint64_t  GCallFReturn = 0x402010;
+    const uint64_t  HPC = 0x403000;
+    const uint64_t  HCallFReturn = 0x403010;
+    const uint64_t  FPC = 0x404000;
+    const uint64_t  FCallFReturn = 0x404010;
+    const uint64_t  FStepPC = 0x404020;
+    const uint64_t  FiberPC = 0x405000;
+
+    const uint32_t  Depth = 10;
+}
+
+
+// An x64 debuggee with one thread, whose stacks are made up by a test, with
+// one stack for each fiber. There are no modules, so the stack walker
+// unwinds each frame like a leaf function's: a frame is only its return
+// address, which its stack pointer points to.
+//
+// The stack walk reads whole blocks of memory. CallstackReuse reads single
+// return addresses, and those reads are counted, and can be made to fail.
+
+class FakeStackDebugger : public IDebuggerProxy
+{
+    struct Fiber
+    {
+        uint64_t                StackTop;
+        std::vector<uint64_t>   PCs;        // oldest first
+    };
+
+    RefPtr<ArchData>                mArchData;
+    std::vector<Fiber>              mFibers;
+    uint32_t                        mCurFiber;
+    std::map<uint64_t, uint64_t>    mStackMem;
+    uint32_t                        mRetAddrReadCount;
+    bool                            mFailRetAddrReads;
+
+public:
+    FakeStackDebugger( ArchData* archData )
+        :   mArchData( archData ),
+            mCurFiber( 0 ),
+            mRetAddrReadCount( 0 ),
+            mFailRetAddrReads( false )
+    {
+    }
+
+    // The fiber starts with one frame, which returns to address 0, where
+    // the walk stops
+    uint32_t AddFiber( uint64_t stackTop, uint64_t pc )
+    {
+        Fiber   fiber;
+
+        fiber.StackTop = stackTop;
+        fiber.PCs.push_back( pc );
+
+        mFibers.push_back( fiber );
+        mStackMem[stackTop] = 0;
+
+        return (uint32_t) mFibers.size() - 1;
+    }
+
+    void SwitchToFiber( uint32_t fiber )
+    {
+        _ASSERT( fiber < mFibers.size() );
+        mCurFiber = fiber;
+    }
+
+    // Moves the current fiber's top frame
+    void SetPC( uint64_t pc )
+    {
+        mFibers[mCurFiber].PCs.back() = pc;
+    }
+
+    // The caller is left at the return address, which is pushed where the
+    // callee's stack pointer points
+    void Call( uint64_t returnPC, uint64_t targetPC )
+    {
+        Fiber&  fiber = mFibers[mCurFiber];
+
+        fiber.PCs.back() = returnPC;
+        fiber.PCs.push_back( targetPC );
+
+        mStackMem[GetTopStack( fiber )] = returnPC;
+    }
+
+    // The return address is left on the stack, the way it's left in a real one
+    void Return()
+    {
+        Fiber&  fiber = mFibers[mCurFiber];
+
+        _ASSERT( fiber.PCs.size() > 1 );
+        fiber.PCs.pop_back();
+    }
+
+    // The PCs of the current fiber's frames, youngest first
+    void GetPCs( std::vector<uint64_t>& pcs )
+    {
+        const Fiber&    fiber = mFibers[mCurFiber];
+
+        pcs.assign( fiber.PCs.rbegin(), fiber.PCs.rend() );
+    }
+
+    void FailReturnAddressReads( bool fail )
+    {
+        mFailRetAddrReads = fail;
+    }
+
+    uint32_t GetReturnAddressReadCount()
+    {
+        return mRetAddrReadCount;
+    }
+
+    virtual HRESULT GetThreadContext( ICoreProcess* process, ICoreThread* thread, IRegisterSet*& regSet )
+    {
+        UNREFERENCED_PARAMETER( process );
+        UNREFERENCED_PARAMETER( thread );
+
+        const Fiber&    fiber = mFibers[mCurFiber];
+        CONTEXT_X64     context = { 0 };
+
+        context.ContextFlags = ContextX64ControlInteger;
+        context.Rip = fiber.PCs.back();
+        context.Rsp = GetTopStack( fiber );
+        context.Rbp = fiber.StackTop;
+
+        return mArchData->BuildRegisterSet( &context, sizeof context, regSet );
+    }
+
+    virtual HRESULT ReadMemoryV(
+        ICoreProcess* process,
+        uint32_t rangeCount,
+        ReadMemoryRange64* ranges,
+        uint8_t** buffers )
+    {
+        UNREFERENCED_PARAMETER( process );
+
+        bool    retAddrs = (rangeCount > 0) && (ranges[0].Length == sizeof( uint64_t ));
+
+        if ( retAddrs )
+            mRetAddrReadCount++;
+
+        for ( uint32_t i = 0; i < rangeCount; i++ )
+        {
+            ranges[i].LengthRead = 0;
+            ranges[i].LengthUnreadable = 0;
+
+            if ( retAddrs && mFailRetAddrReads )
+                continue;
+
+            uint64_t    end = ranges[i].Addr + ranges[i].Length;
+
+            memset( buffers[i], 0, ranges[i].Length );
+
+            for ( std::map<uint64_t, uint64_t>::iterator it = mStackMem.lower_bound( ranges[i].Addr );
+                (it != mStackMem.end()) && (it->first + sizeof it->second <= end);
+                it++ )
+            {
+                memcpy( buffers[i] + (it->first - ranges[i].Addr), &it->second, sizeof it->second );
+            }
+
+            ranges[i].LengthRead = ranges[i].Length;
+        }
+
+        return S_OK;
+    }
+
+    virtual HRESULT Launch( LaunchInfo* launchInfo, ICoreProcess*& process ) { return E_NOTIMPL; }
+    virtual HRESULT Attach( uint32_t id, ICoreProcess*& process ) { return E_NOTIMPL; }
+    virtual HRESULT Terminate( ICoreProcess* process ) { return E_NOTIMPL; }
+    virtual HRESULT Detach( ICoreProcess* process ) { return E_NOTIMPL; }
+    virtual HRESULT ResumeLaunchedProcess( ICoreProcess* process ) { return E_NOTIMPL; }
+
+    virtual HRESULT ReadMemory(
+        ICoreProcess* process,
+        Address64 address,
+        uint32_t length,
+        uint32_t& lengthRead,
+        uint32_t& lengthUnreadable,
+        uint8_t* buffer )
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT WriteMemory(
+        ICoreProcess* process,
+        Address64 address,
+        uint32_t length,
+        uint32_t& lengthWritten,
+        uint8_t* buffer )
+    {
+        return E_NOTIMPL;
+    }
+
+    virtual HRESULT SetBreakpoint( ICoreProcess* process, Address64 address ) { return E_NOTIMPL; }
+    virtual HRESULT RemoveBreakpoint( ICoreProcess* process, Address64 address ) { return E_NOTIMPL; }
+
+    virtual HRESULT StepOut( ICoreProcess* process, Address64 targetAddr, bool handleException ) { return E_NOTIMPL; }
+    virtual HRESULT StepInstruction( ICoreProcess* process, bool stepIn, bool handleException ) { return E_NOTIMPL; }
+    virtual HRESULT StepRange(
+        ICoreProcess* process, bool stepIn, AddressRange64 range, bool handleException ) { return E_NOTIMPL; }
+
+    virtual HRESULT Continue( ICoreProcess* process, bool handleException ) { return E_NOTIMPL; }
+    virtual HRESULT Execute( ICoreProcess* process, bool handleException ) { return E_NOTIMPL; }
+    virtual HRESULT AsyncBreak( ICoreProcess* process ) { return E_NOTIMPL; }
+
+    virtual HRESULT SetThreadContext( ICoreProcess* process, ICoreThread* thread, IRegisterSet* regSet ) { return E_NOTIMPL; }
+
+    virtual HRESULT GetPData(
+        ICoreProcess* process,
+        Address64 address,
+        Address64 imageBase,
+        uint32_t size,
+        uint32_t& sizeRead,
+        uint8_t* pdata )
+    {
+        return E_NOTIMPL;
+    }
+
+private:
+    static uint64_t GetTopStack( const Fiber& fiber )
+    {
+        return fiber.StackTop - (fiber.PCs.size() - 1) * sizeof( uint64_t );
+    }
+};
+
+
+CallstackReuseSuite::CallstackReuseSuite()
+    :   mDebugger( NULL ),
+        mProg( NULL ),
+        mThread( NULL )
+{
+    TEST_ADD( CallstackReuseSuite::RecursionStep );
+    TEST_ADD( CallstackReuseSuite::RecursionDeeper );
+    TEST_ADD( CallstackReuseSuite::RecursionReturn );
+    TEST_ADD( CallstackReuseSuite::DifferentCaller );
+    TEST_ADD( CallstackReuseSuite::FiberSwitch );
+    TEST_ADD( CallstackReuseSuite::FiberSwitchBack );
+    TEST_ADD( CallstackReuseSuite::UnreadableStack );
+}
+
+void CallstackReuseSuite::setup()
+{
+    RefPtr<ArchData>        archData = new ArchDataX64( 0 );
+    RefPtr<RemoteProcess>   process = new RemoteProcess();
+    RefPtr<ICoreThread>     coreThread = new RemoteThread( Tid, MainPC, 0 );
+    RefPtr<Program>         prog;
+    RefPtr<Thread>          thread;
+
+    process->Init( Pid, L"test.exe", Create_Launch, IMAGE_FILE_MACHINE_AMD64, archData );
+
+    mDebugger = new FakeStackDebugger( archData );
+    mDebugger->AddFiber( StackTop, MainPC );
+
+    if ( FAILED( MakeCComObject( prog ) ) || FAILED( MakeCComObject( thread ) ) )
+        return;
+
+    prog->SetCoreProcess( process );
+    prog->SetDebuggerProxy( mDebugger );
+
+    thread->SetCoreThread( coreThread );
+    thread->SetProgram( prog, mDebugger );
+
+    mProg = prog.Detach();
+    mThread = thread.Detach();
+}
+
+void CallstackReuseSuite::tear_down()
+{
+    mLastFrames.clear();
+
+    if ( mThread != NULL )
+    {
+        // the kept frames refer to the thread
+        mThread->Dispose();
+        mThread->Release();
+        mThread = NULL;
+    }
+
+    if ( mProg != NULL )
+    {
+        mProg->Release();
+        mProg = NULL;
+    }
+
+    if ( mDebugger != NULL )
+    {
+        delete mDebugger;
+        mDebugger = NULL;
+    }
+}
+
+// main calls g, which calls f, which calls itself until there are depth
+// frames of f
+
+void CallstackReuseSuite::Recurse( uint32_t depth )
+{
+    mDebugger->Call( MainCallGReturn, GPC );
+    mDebugger->Call( GCallFReturn, FPC );
+
+    for ( uint32_t i = 1; i < depth; i++ )
+        mDebugger->Call( FCallFReturn, FPC );
+}
+
+void CallstackReuseSuite::AssertWalk( uint32_t expectedReused )
+{
+    HRESULT                     hr = S_OK;
+    CComPtr<IEnumDebugFrameInfo2>   enumFrames;
+    CallstackStats              statsBefore = { 0 };
+    CallstackStats              statsAfter = { 0 };
+    std::vector<uint64_t>       expectedPCs;
+    std::vector< RefPtr<IDebugStackFrame2> >    frames;
+    ULONG                       count = 0;
+
+    TEST_ASSERT_RETURN( mThread != NULL );
+
+    mThread->GetCallstackStats( statsBefore );
+
+    hr = mThread->EnumFrameInfo( FIF_FRAME, 16, &enumFrames );
+    TEST_ASSERT_RETURN( SUCCEEDED( hr ) );
+
+    mThread->GetCallstackStats( statsAfter );
+    TEST_ASSERT( statsAfter.Walks == statsBefore.Walks + 1 );
+    TEST_ASSERT( statsAfter.ReusedFrames - statsBefore.ReusedFrames == expectedReused );
+
+    for ( ;; )
+    {
+        FRAMEINFO   info = { 0 };
+        ULONG       fetched = 0;
+
+        if ( (enumFrames->Next( 1, &info, &fetched ) != S_OK) || (fetched == 0) )
+            break;
+
+        RefPtr<IDebugStackFrame2>   frame;
+
+        frame.Attach( info.m_pFrame );
+        frames.push_back( frame );
+    }
+
+    mDebugger->GetPCs( expectedPCs );
+
+    TEST_ASSERT_RETURN( frames.size() == expectedPCs.size() );
+
+    for ( size_t i = 0; i < frames.size(); i++ )
+    {
+        CComPtr<IDebugCodeContext2>     codeContext;
+        Address64                       pc = 0;
+
+        hr = frames[i]->GetCodeContext( &codeContext );
+        TEST_ASSERT_RETURN( SUCCEEDED( hr ) );
+
+        CComQIPtr<IMagoMemoryContext>   memContext = codeContext;
+        TEST_ASSERT_RETURN( memContext != NULL );
+
+        memContext->GetAddress( pc );
+        TEST_ASSERT( pc == expectedPCs[i] );
+    }
+
+    // the reused frames are the same ones that the last walk handed out
+    TEST_ASSERT_RETURN( expectedReused <= mLastFrames.size() );
+
+    for ( size_t i = 1; i <= expectedReused; i++ )
+    {
+        TEST_ASSERT( frames[frames.size() - i].Get() == mLastFrames[mLastFrames.size() - i].Get() );
+    }
+
+    mLastFrames.swap( frames );
+}
+
+void CallstackReuseSuite::RecursionStep()
+{
+    const uint32_t  FrameCount = Depth + 2;
+
+    Recurse( Depth );
+    AssertWalk( 0 );
+
+    // a step in the top frame leaves all but the top frame and its caller
+    // as they were, and the recursive frames, with the same PC, are told
+    // apart by their stack pointers
+    mDebugger->SetPC( FStepPC );
+    AssertWalk( FrameCount - 2 );
+    TEST_ASSERT( mDebugger->GetReturnAddressReadCount() == 1 );
+
+    AssertWalk( FrameCount - 2 );
+    TEST_ASSERT( mDebugger->GetReturnAddressReadCount() == 2 );
+}
+
+void CallstackReuseSuite::RecursionDeeper()
+{
+    const uint32_t  FrameCount = Depth + 2;
+
+    Recurse( Depth );
+    AssertWalk( 0 );
+
+    // the last top frame is now a caller with another PC, so the new
+    // frames are walked down to the last walk's third frame
+    for ( uint32_t i = 0; i < 3; i++ )
+        mDebugger->Call( FCallFReturn, FPC );
+
+    AssertWalk( FrameCount - 2 );
+}
+
+void CallstackReuseSuite::RecursionReturn()
+{
+    const uint32_t  FrameCount = Depth + 2;
+
+    Recurse( Depth );
+    AssertWalk( 0 );
+
+    for ( uint32_t i = 0; i < 3; i++ )
+        mDebugger->Return();
+
+    mDebugger->SetPC( FStepPC );
+    AssertWalk( FrameCount - 3 - 2 );
+
+    // back to the same depth by the same path, which leaves the same stack
+    for ( uint32_t i = 0; i < 3; i++ )
+        mDebugger->Call( FCallFReturn, FPC );
+
+    AssertWalk( FrameCount - 3 - 2 );
+}
+
+void CallstackReuseSuite::DifferentCaller()
+{
+    Recurse( 3 );
+    AssertWalk( 0 );
+
+    // f is called again at the same place, with the same frames, but from
+    // h instead of g
+    for ( uint32_t i = 0; i < 4; i++ )
+        mDebugger->Return();
+
+    mDebugger->Call( MainCallHReturn, HPC );
+    mDebugger->Call( HCallFReturn, FPC );
+    mDebugger->Call( FCallFReturn, FPC );
+    mDebugger->Call( FCallFReturn, FPC );
+
+    AssertWalk( 0 );
+    TEST_ASSERT( mDebugger->GetReturnAddressReadCount() == 1 );
+}
+
+void CallstackReuseSuite::FiberSwitch()
+{
+    uint32_t    mainFiber = 0;
+    uint32_t    highFiber = mDebugger->AddFiber( HighStackTop, FiberPC );
+    uint32_t    lowFiber = mDebugger->AddFiber( LowStackTop, FiberPC );
+
+    Recurse( Depth );
+    AssertWalk( 0 );
+
+    // a stack above the last one, and then one below it
+    mDebugger->SwitchToFiber( highFiber );
+    Recurse( Depth );
+    AssertWalk( 0 );
+
+    mDebugger->SwitchToFiber( lowFiber );
+    Recurse( Depth );
+    AssertWalk( 0 );
+
+    // none of the other stacks' frames were mistaken for this one's
+    TEST_ASSERT( mDebugger->GetReturnAddressReadCount() == 0 );
+
+    mDebugger->SwitchToFiber( mainFiber );
+    AssertWalk( 0 );
+}
+
+void CallstackReuseSuite::FiberSwitchBack()
+{
+    const uint32_t  FrameCount = Depth + 2;
+    uint32_t        mainFiber = 0;
+    uint32_t        otherFiber = mDebugger->AddFiber( HighStackTop, FiberPC );
+
+    Recurse( Depth );
+
+    mDebugger->SwitchToFiber( otherFiber );
+    Recurse( Depth );
+    AssertWalk( 0 );
+
+    mDebugger->SwitchToFiber( mainFiber );
+    AssertWalk( 0 );
+
+    // the fiber was switched back in where it left off
+    mDebugger->SwitchToFiber( otherFiber );
+    AssertWalk( 0 );
+    mDebugger->SetPC( FStepPC );
+    AssertWalk( FrameCount - 2 );
+}
+
+void CallstackReuseSuite::UnreadableStack()
+{
+    const uint32_t  FrameCount = Depth + 2;
+
+    Recurse( Depth );
+    AssertWalk( 0 );
+
+    mDebugger->FailReturnAddressReads( true );
+    mDebugger->SetPC( FStepPC );
+    AssertWalk( 0 );
+    TEST_ASSERT( mDebugger->GetReturnAddressReadCount() == 1 );
+
+    mDebugger->FailReturnAddressReads( false );
+    AssertWalk( FrameCount - 2 );
+}
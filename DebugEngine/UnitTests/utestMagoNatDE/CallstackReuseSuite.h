@@ -0,0 +1,44 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+namespace Mago
+{
+    class Program;
+    class Thread;
+}
+
+class FakeStackDebugger;
+
+
+class CallstackReuseSuite : public Test::Suite
+{
+    FakeStackDebugger*      mDebugger;
+    Mago::Program*          mProg;
+    Mago::Thread*           mThread;
+    std::vector< RefPtr<IDebugStackFrame2> >  mLastFrames;
+
+public:
+    CallstackReuseSuite();
+
+    void setup();
+    void tear_down();
+
+private:
+    void RecursionStep();
+    void RecursionDeeper();
+    void RecursionReturn();
+    void DifferentCaller();
+    void FiberSwitch();
+    void FiberSwitchBack();
+    void UnreadableStack();
+
+    void Recurse( uint32_t depth );
+    // Walks the thread's stack, and checks that the frames match the stack
+    void AssertWalk( uint32_t expectedReused );
+};
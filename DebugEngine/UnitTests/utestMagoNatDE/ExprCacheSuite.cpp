@@ -0,0 +1,341 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "stdafx.h"
+#include "ExprCacheSuite.h"
+#include "..\..\MagoNatDE\ExprContext.h"
+#include "..\..\MagoNatDE\Module.h"
+#include "..\..\MagoNatDE\Thread.h"
+#include "..\..\MagoNatDE\Program.h"
+#include "..\..\MagoNatDE\ParsedExprCache.h"
+#include "..\..\MagoNatDE\ArchDataX64.h"
+#include "..\..\MagoNatDE\RemoteProcess.h"
+
+using namespace Mago;
+
+
+namespace
+{
+    const uint32_t  Pid = 100;
+    const uint32_t  Tid = 200;
+    const uint64_t  PC = 0x401000;
+
+    // CONTEXT_AMD64 | CONTEXT_CONTROL | CONTEXT_INTEGER, which WinNT.h only
+    // has in x64 builds
+    const DWORD     ContextX64ControlInteger = 0x00100003;
+
+    const uint32_t  Radix = 10;
+
+    // constants bind without symbols
+    const wchar_t   SumText[] = L"1 + 2";
+    const uint64_t  SumValue = 3;
+    const wchar_t   ProductText[] = L"3 * 4";
+    const uint64_t  ProductValue = 12;
+
+    // the module has no symbols to find it in
+    const wchar_t   UnknownText[] = L"noSuchName";
+}
+
+
+// The expressions are parsed and bound by real expression contexts in an x64 
+// program without a debuggee. The module has no symbols and no address, so 
+// only constant expressions bind.
+
+ExprCacheSuite::ExprCacheSuite()
+    :   mProg( NULL ),
+        mThread( NULL ),
+        mModule( NULL ),
+        mRegSet( NULL )
+{
+    TEST_ADD( ExprCacheSuite::SameContextNextStop );
+    TEST_ADD( ExprCacheSuite::OtherContext );
+    TEST_ADD( ExprCacheSuite::TwoHolders );
+    TEST_ADD( ExprCacheSuite::BindFailure );
+    TEST_ADD( ExprCacheSuite::DisposeContext );
+    TEST_ADD( ExprCacheSuite::ReleaseAfterDispose );
+    TEST_ADD( ExprCacheSuite::RemoveModule );
+}
+
+void ExprCacheSuite::setup()
+{
+    RefPtr<ArchData>        archData = new ArchDataX64( 0 );
+    RefPtr<RemoteProcess>   process = new RemoteProcess();
+    RefPtr<Program>         prog;
+    RefPtr<Thread>          thread;
+    RefPtr<Module>          mod;
+    RefPtr<IRegisterSet>    regSet;
+    CONTEXT_X64             context = { 0 };
+
+    process->Init( Pid, L"test.exe", Create_Launch, IMAGE_FILE_MACHINE_AMD64, archData );
+
+    context.ContextFlags = ContextX64ControlInteger;
+    context.Rip = PC;
+
+    if ( FAILED( archData->BuildRegisterSet( &context, sizeof context, regSet.Ref() ) ) )
+        return;
+
+    if ( FAILED( MakeCComObject( prog ) ) 
+        || FAILED( MakeCComObject( thread ) ) 
+        || FAILED( MakeCComObject( mod ) ) )
+        return;
+
+    prog->SetCoreProcess( process );
+
+    thread->SetCoreThread( new RemoteThread( Tid, PC, 0 ) );
+    thread->SetProgram( prog, NULL );
+
+    mProg = prog.Detach();
+    mThread = thread.Detach();
+    mModule = mod.Detach();
+    mRegSet = regSet.Detach();
+}
+
+void ExprCacheSuite::tear_down()
+{
+    for ( size_t i = 0; i < mContexts.size(); i++ )
+    {
+        mContexts[i]->Dispose();
+    }
+
+    mContexts.clear();
+
+    if ( mModule != NULL )
+    {
+        // its declaration cache's symbol store refers to it
+        mModule->Dispose();
+        mModule->Release();
+        mModule = NULL;
+    }
+
+    if ( mProg != NULL )
+    {
+        // the cached expressions hold contexts
+        mProg->Dispose();
+        mProg->Release();
+        mProg = NULL;
+    }
+
+    if ( mThread != NULL )
+    {
+        mThread->Release();
+        mThread = NULL;
+    }
+
+    if ( mRegSet != NULL )
+    {
+        mRegSet->Release();
+        mRegSet = NULL;
+    }
+}
+
+ExprContext* ExprCacheSuite::MakeContext()
+{
+    RefPtr<ExprContext>             context;
+    MagoST::SymHandle               funcSH = { 0 };
+    std::vector<MagoST::SymHandle>  blockSH;
+
+    if ( FAILED( MakeCComObject( context ) ) )
+        return NULL;
+
+    if ( FAILED( context->Init( mModule, mThread, funcSH, blockSH, PC, mRegSet ) ) )
+        return NULL;
+
+    mContexts.push_back( context );
+    return context;
+}
+
+RefPtr<MagoEE::IEEDParsedExpr> ExprCacheSuite::AssertGet( 
+    ExprContext* context, 
+    const wchar_t* text, 
+    uint64_t value, 
+    uint32_t hits, 
+    uint32_t misses, 
+    uint32_t busy )
+{
+    ParsedExprCacheStats            before = { 0 };
+    ParsedExprCacheStats            after = { 0 };
+    RefPtr<MagoEE::IEEDParsedExpr>  expr;
+    MagoEE::EvalOptions             options = { 0 };
+    MagoEE::EvalResult              result = { 0 };
+
+    mProg->GetParsedExprCache()->GetStats( before );
+
+    if ( FAILED( context->GetParsedExpr( text, 0, Radix, expr.Ref() ) ) )
+    {
+        TEST_FAIL( "The expression couldn't be parsed and bound." );
+        return NULL;
+    }
+
+    mProg->GetParsedExprCache()->GetStats( after );
+
+    // a cached expression is still bound to the context
+    TEST_ASSERT( SUCCEEDED( expr->Evaluate( options, context, result ) ) );
+    TEST_ASSERT( result.ObjVal.Value.UInt64Value == value );
+
+    TEST_ASSERT( after.Hits - before.Hits == hits );
+    TEST_ASSERT( after.Misses - before.Misses == misses );
+    TEST_ASSERT( after.Busy - before.Busy == busy );
+
+    return expr;
+}
+
+bool ExprCacheSuite::IsCached( ExprContext* context, const wchar_t* text )
+{
+    RefPtr<MagoEE::IEEDParsedExpr>  expr;
+    ParsedExprCache*                cache = mProg->GetParsedExprCache();
+
+    if ( !cache->Find( 
+        mModule->GetAddress(), 
+        context->GetFunctionSH(), 
+        context->GetTypeEnv(), 
+        context, 
+        text, 
+        0, 
+        Radix, 
+        expr.Ref() ) )
+        return false;
+
+    // put it back the way it was
+    cache->Add( 
+        mModule->GetAddress(), 
+        context->GetFunctionSH(), 
+        context->GetTypeEnv(), 
+        context, 
+        text, 
+        0, 
+        Radix, 
+        expr );
+    return true;
+}
+
+void ExprCacheSuite::SameContextNextStop()
+{
+    // a watch in a frame that's reused from the last callstack
+    ExprContext*    context = MakeContext();
+    TEST_ASSERT_RETURN( context != NULL );
+
+    RefPtr<MagoEE::IEEDParsedExpr>  first = AssertGet( context, SumText, SumValue, 0, 1, 0 );
+    TEST_ASSERT_RETURN( first != NULL );
+    context->ReleaseParsedExpr( SumText, 0, Radix, first );
+
+    mProg->GetParsedExprCache()->EndStop();
+
+    // it's neither parsed nor bound again
+    RefPtr<MagoEE::IEEDParsedExpr>  second = AssertGet( context, SumText, SumValue, 1, 0, 0 );
+    TEST_ASSERT_RETURN( second != NULL );
+    context->ReleaseParsedExpr( SumText, 0, Radix, second );
+
+    TEST_ASSERT( second.Get() == first.Get() );
+}
+
+void ExprCacheSuite::OtherContext()
+{
+    // the top frame gets a new context every stop
+    ExprContext*    context = MakeContext();
+    ExprContext*    otherContext = MakeContext();
+    TEST_ASSERT_RETURN( (context != NULL) && (otherContext != NULL) );
+
+    RefPtr<MagoEE::IEEDParsedExpr>  first = AssertGet( context, SumText, SumValue, 0, 1, 0 );
+    TEST_ASSERT_RETURN( first != NULL );
+    context->ReleaseParsedExpr( SumText, 0, Radix, first );
+
+    // the other context doesn't take the expression bound to the first one
+    RefPtr<MagoEE::IEEDParsedExpr>  other = AssertGet( otherContext, SumText, SumValue, 0, 1, 0 );
+    TEST_ASSERT_RETURN( other != NULL );
+    otherContext->ReleaseParsedExpr( SumText, 0, Radix, other );
+
+    TEST_ASSERT( other.Get() != first.Get() );
+    TEST_ASSERT( IsCached( context, SumText ) );
+    TEST_ASSERT( IsCached( otherContext, SumText ) );
+    TEST_ASSERT( !IsCached( context, ProductText ) );
+}
+
+void ExprCacheSuite::TwoHolders()
+{
+    ExprContext*    context = MakeContext();
+    TEST_ASSERT_RETURN( context != NULL );
+
+    RefPtr<MagoEE::IEEDParsedExpr>  first = AssertGet( context, ProductText, ProductValue, 0, 1, 0 );
+    TEST_ASSERT_RETURN( first != NULL );
+    context->ReleaseParsedExpr( ProductText, 0, Radix, first );
+
+    RefPtr<MagoEE::IEEDParsedExpr>  held = AssertGet( context, ProductText, ProductValue, 1, 0, 0 );
+    RefPtr<MagoEE::IEEDParsedExpr>  other = AssertGet( context, ProductText, ProductValue, 0, 0, 1 );
+    TEST_ASSERT_RETURN( (held != NULL) && (other != NULL) );
+
+    // the second holder doesn't share the first one's tree
+    TEST_ASSERT( held.Get() == first.Get() );
+    TEST_ASSERT( other.Get() != held.Get() );
+
+    // the first one put back is kept
+    context->ReleaseParsedExpr( ProductText, 0, Radix, held );
+    context->ReleaseParsedExpr( ProductText, 0, Radix, other );
+
+    RefPtr<MagoEE::IEEDParsedExpr>  last = AssertGet( context, ProductText, ProductValue, 1, 0, 0 );
+    TEST_ASSERT_RETURN( last != NULL );
+    context->ReleaseParsedExpr( ProductText, 0, Radix, last );
+
+    TEST_ASSERT( last.Get() == held.Get() );
+}
+
+void ExprCacheSuite::BindFailure()
+{
+    ExprContext*    context = MakeContext();
+    TEST_ASSERT_RETURN( context != NULL );
+
+    RefPtr<MagoEE::IEEDParsedExpr>  expr;
+
+    TEST_ASSERT( FAILED( context->GetParsedExpr( UnknownText, 0, Radix, expr.Ref() ) ) );
+    TEST_ASSERT( expr == NULL );
+
+    // an expression that didn't bind isn't cached
+    TEST_ASSERT( !IsCached( context, UnknownText ) );
+}
+
+void ExprCacheSuite::DisposeContext()
+{
+    ExprContext*    context = MakeContext();
+    TEST_ASSERT_RETURN( context != NULL );
+
+    RefPtr<MagoEE::IEEDParsedExpr>  expr = AssertGet( context, SumText, SumValue, 0, 1, 0 );
+    TEST_ASSERT_RETURN( expr != NULL );
+    context->ReleaseParsedExpr( SumText, 0, Radix, expr );
+
+    // the frame went away, and its expressions don't hold its context
+    context->Dispose();
+
+    TEST_ASSERT( !IsCached( context, SumText ) );
+}
+
+void ExprCacheSuite::ReleaseAfterDispose()
+{
+    ExprContext*    context = MakeContext();
+    TEST_ASSERT_RETURN( context != NULL );
+
+    RefPtr<MagoEE::IEEDParsedExpr>  expr = AssertGet( context, SumText, SumValue, 0, 1, 0 );
+    TEST_ASSERT_RETURN( expr != NULL );
+
+    // the expression outlived its frame
+    context->Dispose();
+    context->ReleaseParsedExpr( SumText, 0, Radix, expr );
+
+    TEST_ASSERT( !IsCached( context, SumText ) );
+}
+
+void ExprCacheSuite::RemoveModule()
+{
+    ExprContext*    context = MakeContext();
+    TEST_ASSERT_RETURN( context != NULL );
+
+    RefPtr<MagoEE::IEEDParsedExpr>  expr = AssertGet( context, SumText, SumValue, 0, 1, 0 );
+    TEST_ASSERT_RETURN( expr != NULL );
+    context->ReleaseParsedExpr( SumText, 0, Radix, expr );
+
+    mProg->GetParsedExprCache()->RemoveModule( mModule->GetAddress() );
+
+    TEST_ASSERT( !IsCached( context, SumText ) );
+}
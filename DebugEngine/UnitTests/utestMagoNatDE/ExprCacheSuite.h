@@ -0,0 +1,54 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+namespace Mago
+{
+    class ExprContext;
+    class Module;
+    class Program;
+    class Thread;
+    class IRegisterSet;
+}
+
+
+class ExprCacheSuite : public Test::Suite
+{
+    Mago::Program*          mProg;
+    Mago::Thread*           mThread;
+    Mago::Module*           mModule;
+    Mago::IRegisterSet*     mRegSet;
+    std::vector< RefPtr<Mago::ExprContext> >    mContexts;
+
+public:
+    ExprCacheSuite();
+
+    void setup();
+    void tear_down();
+
+private:
+    void SameContextNextStop();
+    void OtherContext();
+    void TwoHolders();
+    void BindFailure();
+    void DisposeContext();
+    void ReleaseAfterDispose();
+    void RemoveModule();
+
+    Mago::ExprContext* MakeContext();
+    // Gets the text's expression from the context, checks that it evaluates 
+    // to the value, and checks how the cache's stats went up
+    RefPtr<MagoEE::IEEDParsedExpr> AssertGet( 
+        Mago::ExprContext* context, 
+        const wchar_t* text, 
+        uint64_t value, 
+        uint32_t hits, 
+        uint32_t misses, 
+        uint32_t busy );
+    bool IsCached( Mago::ExprContext* context, const wchar_t* text );
+};
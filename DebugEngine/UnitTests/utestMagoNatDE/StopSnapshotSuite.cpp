@@ -0,0 +1,164 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "stdafx.h"
+#include "StopSnapshotSuite.h"
+#include "..\..\MagoNatDE\StopSnapshot.h"
+#include "..\..\MagoNatDE\ArchDataX64.h"
+#include "MagoRemoteEvent_i.h"
+
+using namespace Mago;
+
+
+const uint32_t  Pid = 100;
+const uint32_t  Tid = 200;
+const uint64_t  StackAddr = 0x0012F000;
+const uint32_t  StackSize = 0x200;
+const uint32_t  ContextSize = 0x2CC;
+const uint64_t  ImageBase = 0x140000000;
+
+
+StopSnapshotSuite::StopSnapshotSuite()
+    :   mSnapshot( NULL )
+{
+    TEST_ADD( StopSnapshotSuite::AnswersFromSnapshot );
+    TEST_ADD( StopSnapshotSuite::RefusesOutsideSnapshot );
+    TEST_ADD( StopSnapshotSuite::NothingAfterClear );
+    TEST_ADD( StopSnapshotSuite::NothingWithoutSnapshot );
+    TEST_ADD( StopSnapshotSuite::PDataForItsFunction );
+}
+
+void StopSnapshotSuite::setup()
+{
+    mSnapshot = new StopSnapshot();
+
+    mContext.resize( ContextSize );
+    mStack.resize( StackSize );
+
+    for ( size_t i = 0; i < mContext.size(); i++ )
+        mContext[i] = (uint8_t) (i * 7 + 1);
+
+    for ( size_t i = 0; i < mStack.size(); i++ )
+        mStack[i] = (uint8_t) (i * 13 + 5);
+
+    MagoRemote_StopSnapshot snapshot = { 0 };
+
+    snapshot.ContextSize = ContextSize;
+    snapshot.Context = &mContext[0];
+    snapshot.StackAddr = StackAddr;
+    snapshot.StackSize = StackSize;
+    snapshot.Stack = &mStack[0];
+
+    mSnapshot->Set( Pid, Tid, &snapshot );
+}
+
+void StopSnapshotSuite::tear_down()
+{
+    delete mSnapshot;
+    mSnapshot = NULL;
+
+    mContext.clear();
+    mStack.clear();
+}
+
+// What the agent sent with a stop is what comes back, in whole or in part.
+
+void StopSnapshotSuite::AnswersFromSnapshot()
+{
+    std::vector<uint8_t>    context( ContextSize );
+    std::vector<uint8_t>    stack( StackSize );
+    uint8_t                 part[8] = { 0 };
+
+    TEST_ASSERT_RETURN( mSnapshot->GetThreadContext( Pid, Tid, ContextSize, &context[0] ) );
+    TEST_ASSERT( context == mContext );
+
+    TEST_ASSERT_RETURN( mSnapshot->ReadMemory( Pid, StackAddr, StackSize, &stack[0] ) );
+    TEST_ASSERT( stack == mStack );
+
+    TEST_ASSERT_RETURN( mSnapshot->ReadMemory( Pid, StackAddr + 4, sizeof part, part ) );
+    TEST_ASSERT( memcmp( part, &mStack[4], sizeof part ) == 0 );
+
+    TEST_ASSERT_RETURN( mSnapshot->ReadMemory( Pid, StackAddr + StackSize - sizeof part, sizeof part, part ) );
+    TEST_ASSERT( memcmp( part, &mStack[StackSize - sizeof part], sizeof part ) == 0 );
+}
+
+// What the snapshot can't answer whole has to go to the debuggee.
+
+void StopSnapshotSuite::RefusesOutsideSnapshot()
+{
+    std::vector<uint8_t>    context( ContextSize );
+    uint8_t                 part[8] = { 0 };
+
+    TEST_ASSERT( !mSnapshot->ReadMemory( Pid, StackAddr - 4, sizeof part, part ) );
+    TEST_ASSERT( !mSnapshot->ReadMemory( Pid, StackAddr + StackSize - 4, sizeof part, part ) );
+    TEST_ASSERT( !mSnapshot->ReadMemory( Pid, StackAddr + StackSize, sizeof part, part ) );
+    TEST_ASSERT( !mSnapshot->ReadMemory( Pid + 1, StackAddr, sizeof part, part ) );
+
+    TEST_ASSERT( !mSnapshot->GetThreadContext( Pid, Tid + 1, ContextSize, &context[0] ) );
+    TEST_ASSERT( !mSnapshot->GetThreadContext( Pid + 1, Tid, ContextSize, &context[0] ) );
+    TEST_ASSERT( !mSnapshot->GetThreadContext( Pid, Tid, ContextSize - 1, &context[0] ) );
+}
+
+// Nothing is answered once the debuggee runs again.
+
+void StopSnapshotSuite::NothingAfterClear()
+{
+    std::vector<uint8_t>    context( ContextSize );
+    uint8_t                 part[4] = { 0 };
+
+    mSnapshot->Clear();
+
+    TEST_ASSERT( !mSnapshot->ReadMemory( Pid, StackAddr, sizeof part, part ) );
+    TEST_ASSERT( !mSnapshot->GetThreadContext( Pid, Tid, ContextSize, &context[0] ) );
+}
+
+// A stop without a snapshot replaces the last one.
+
+void StopSnapshotSuite::NothingWithoutSnapshot()
+{
+    std::vector<uint8_t>    context( ContextSize );
+    uint8_t                 part[4] = { 0 };
+
+    mSnapshot->Set( Pid, Tid, NULL );
+
+    TEST_ASSERT( !mSnapshot->ReadMemory( Pid, StackAddr, sizeof part, part ) );
+    TEST_ASSERT( !mSnapshot->GetThreadContext( Pid, Tid, ContextSize, &context[0] ) );
+}
+
+// The pdata entry is only given for an address in its function.
+
+void StopSnapshotSuite::PDataForItsFunction()
+{
+    IMAGE_RUNTIME_FUNCTION_ENTRY    funcEntry = { 0 };
+    IMAGE_RUNTIME_FUNCTION_ENTRY    gotEntry = { 0 };
+    MagoRemote_StopSnapshot         snapshot = { 0 };
+    RefPtr<ArchData>                archData;
+
+    archData = new ArchDataX64( 0 );
+
+    funcEntry.BeginAddress = 0x1000;
+    funcEntry.EndAddress = 0x1080;
+
+    snapshot.ContextSize = ContextSize;
+    snapshot.Context = &mContext[0];
+    snapshot.PDataImageBase = ImageBase;
+    snapshot.PDataSize = sizeof funcEntry;
+    snapshot.PData = (byte*) &funcEntry;
+
+    mSnapshot->Set( Pid, Tid, &snapshot );
+
+    TEST_ASSERT_RETURN( mSnapshot->GetPData( 
+        Pid, ImageBase + 0x1040, ImageBase, archData.Get(), sizeof gotEntry, (uint8_t*) &gotEntry ) );
+    TEST_ASSERT( memcmp( &gotEntry, &funcEntry, sizeof funcEntry ) == 0 );
+
+    TEST_ASSERT( !mSnapshot->GetPData( 
+        Pid, ImageBase + 0x2000, ImageBase, archData.Get(), sizeof gotEntry, (uint8_t*) &gotEntry ) );
+    TEST_ASSERT( !mSnapshot->GetPData( 
+        Pid, ImageBase + 0x1040, ImageBase + 0x10000, archData.Get(), sizeof gotEntry, (uint8_t*) &gotEntry ) );
+    TEST_ASSERT( !mSnapshot->GetPData( 
+        Pid + 1, ImageBase + 0x1040, ImageBase, archData.Get(), sizeof gotEntry, (uint8_t*) &gotEntry ) );
+}
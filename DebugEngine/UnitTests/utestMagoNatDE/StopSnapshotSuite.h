@@ -0,0 +1,34 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+namespace Mago
+{
+    class StopSnapshot;
+}
+
+
+class StopSnapshotSuite : public Test::Suite
+{
+    Mago::StopSnapshot*     mSnapshot;
+    std::vector<uint8_t>    mContext;
+    std::vector<uint8_t>    mStack;
+
+public:
+    StopSnapshotSuite();
+
+    void setup();
+    void tear_down();
+
+private:
+    void AnswersFromSnapshot();
+    void RefusesOutsideSnapshot();
+    void NothingAfterClear();
+    void NothingWithoutSnapshot();
+    void PDataForItsFunction();
+};
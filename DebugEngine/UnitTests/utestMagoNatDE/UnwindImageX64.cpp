@@ -0,0 +1,218 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "stdafx.h"
+#include "..\..\MagoNatDE\StackWalkerX64.h"
+#include "..\..\MagoNatDE\WinStackWalker.h"
+#include "UnwindImageX64.h"
+#include <algorithm>
+
+using namespace Mago;
+
+
+namespace
+{
+    // where the unwind infos go in the module, after the code
+    const uint32_t  UnwindInfoRva = 0x8000;
+
+    bool StartsBefore( const IMAGE_RUNTIME_FUNCTION_ENTRY& entry, const IMAGE_RUNTIME_FUNCTION_ENTRY& other )
+    {
+        return entry.BeginAddress < other.BeginAddress;
+    }
+
+    // copies from a block of memory at blockAddr, as much as is there
+    bool ReadBlock( 
+        const std::vector<uint8_t>& block, 
+        uint64_t blockAddr, 
+        uint64_t address, 
+        void* buffer, 
+        uint32_t size, 
+        uint32_t& sizeRead )
+    {
+        if ( (address < blockAddr) || (address - blockAddr >= block.size()) )
+            return false;
+
+        uint32_t    offset = (uint32_t) (address - blockAddr);
+
+        sizeRead = size;
+        if ( sizeRead > block.size() - offset )
+            sizeRead = block.size() - offset;
+
+        memcpy( buffer, &block[offset], sizeRead );
+        return true;
+    }
+}
+
+
+UnwindImageX64::UnwindImageX64( uint32_t stackSize )
+    :   mImage( ImageSize ),
+        mStack( stackSize ),
+        mNextUnwindRva( UnwindInfoRva ),
+        mReadCount( 0 )
+{
+}
+
+uint32_t UnwindImageX64::AddUnwindInfo( const uint8_t* unwindInfo, uint32_t size )
+{
+    uint32_t    rva = mNextUnwindRva;
+
+    _ASSERT( rva + size <= mImage.size() );
+
+    memcpy( &mImage[rva], unwindInfo, size );
+
+    // unwind info is DWORD aligned
+    mNextUnwindRva = (rva + size + 3) & ~3;
+    return rva;
+}
+
+void UnwindImageX64::AddFunction( uint32_t beginRva, uint32_t endRva, uint32_t unwindInfoRva )
+{
+    IMAGE_RUNTIME_FUNCTION_ENTRY    entry = { 0 };
+
+    entry.BeginAddress = beginRva;
+    entry.EndAddress = endRva;
+    entry.UnwindInfoAddress = unwindInfoRva;
+
+    mPData.insert( std::upper_bound( mPData.begin(), mPData.end(), entry, StartsBefore ), entry );
+}
+
+void UnwindImageX64::SetCode( uint32_t rva, const uint8_t* code, uint32_t size )
+{
+    _ASSERT( rva + size <= UnwindInfoRva );
+
+    memcpy( &mImage[rva], code, size );
+}
+
+void UnwindImageX64::WriteStack( uint64_t address, uint64_t value )
+{
+    _ASSERT( (address >= StackBase) && (address + sizeof value <= StackBase + mStack.size()) );
+
+    memcpy( &mStack[(size_t) (address - StackBase)], &value, sizeof value );
+}
+
+void UnwindImageX64::Walk( 
+    const CONTEXT_X64& context, 
+    bool useDbgHelp, 
+    uint32_t maxFrames, 
+    std::vector<UnwindFrameX64>& frames )
+{
+    UniquePtr<StackWalker>  walker;
+
+    frames.clear();
+
+    if ( useDbgHelp )
+    {
+        UniquePtr<WindowsStackWalker>   winWalker( new WindowsStackWalker(
+            IMAGE_FILE_MACHINE_AMD64,
+            context.Rip,
+            context.Rsp,
+            context.Rbp,
+            this,
+            ReadMemory,
+            FunctionTableAccess,
+            GetModuleBase ) );
+
+        if ( FAILED( winWalker->Init( &context, sizeof context ) ) )
+            return;
+
+        walker.Attach( winWalker.Detach() );
+    }
+    else
+    {
+        UniquePtr<StackWalkerX64>   x64Walker( new StackWalkerX64(
+            this,
+            ReadMemory,
+            FunctionTableAccess,
+            GetModuleBase ) );
+
+        if ( FAILED( x64Walker->Init( &context, sizeof context ) ) )
+            return;
+
+        walker.Attach( x64Walker.Detach() );
+    }
+
+    while ( (frames.size() < maxFrames) && walker->WalkStack() )
+    {
+        const void*         contextPtr = NULL;
+        uint32_t            contextSize = 0;
+        UnwindFrameX64      frame = { 0 };
+
+        walker->GetThreadContext( contextPtr, contextSize );
+
+        const CONTEXT_X64*  frameContext = (const CONTEXT_X64*) contextPtr;
+
+        frame.Rip = frameContext->Rip;
+        memcpy( frame.Regs, &frameContext->Rax, sizeof frame.Regs );
+
+        frames.push_back( frame );
+    }
+}
+
+uint32_t UnwindImageX64::GetReadCount()
+{
+    return mReadCount;
+}
+
+BOOL CALLBACK UnwindImageX64::ReadMemory(
+    void* processContext,
+    DWORD64 address,
+    void* buffer,
+    DWORD size,
+    DWORD* sizeRead )
+{
+    UnwindImageX64* image = (UnwindImageX64*) processContext;
+    uint32_t        lenRead = 0;
+
+    image->mReadCount++;
+
+    if ( !ReadBlock( image->mImage, ImageBase, address, buffer, size, lenRead )
+        && !ReadBlock( image->mStack, StackBase, address, buffer, size, lenRead ) )
+        return FALSE;
+
+    *sizeRead = lenRead;
+    return TRUE;
+}
+
+void* CALLBACK UnwindImageX64::FunctionTableAccess(
+    void* processContext,
+    DWORD64 address )
+{
+    UnwindImageX64* image = (UnwindImageX64*) processContext;
+
+    if ( (address < ImageBase) || (address - ImageBase >= ImageSize) )
+        return NULL;
+
+    IMAGE_RUNTIME_FUNCTION_ENTRY    key = { 0 };
+
+    key.BeginAddress = (DWORD) (address - ImageBase);
+
+    // the last entry that starts at or before the address
+    std::vector<IMAGE_RUNTIME_FUNCTION_ENTRY>::iterator it = 
+        std::upper_bound( image->mPData.begin(), image->mPData.end(), key, StartsBefore );
+
+    if ( it == image->mPData.begin() )
+        return NULL;
+
+    --it;
+
+    if ( key.BeginAddress >= it->EndAddress )
+        return NULL;
+
+    return &*it;
+}
+
+DWORD64 CALLBACK UnwindImageX64::GetModuleBase(
+    void* processContext,
+    DWORD64 address )
+{
+    UNREFERENCED_PARAMETER( processContext );
+
+    if ( (address < ImageBase) || (address - ImageBase >= ImageSize) )
+        return 0;
+
+    return ImageBase;
+}
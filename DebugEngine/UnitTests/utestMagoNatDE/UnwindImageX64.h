@@ -0,0 +1,77 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+#include <WinPlat.h>
+
+
+struct UnwindFrameX64
+{
+    uint64_t    Rip;
+    uint64_t    Regs[16];   // in the order of the unwind codes, starting at Rax
+};
+
+
+// A snapshot of an x64 module and a stack, made up by a test, that the debug 
+// engine's x64 stack walker runs on. Each function is given its code, and 
+// its unwind info, which is found through the module's pdata the way the 
+// stack walker's callbacks find it in a real module.
+//
+// The same snapshot can be walked with DbgHelp's StackWalk64, to compare 
+// the two walkers.
+
+class UnwindImageX64
+{
+public:
+    static const uint64_t   ImageBase = 0x140000000;
+    static const uint32_t   ImageSize = 0x10000;
+    static const uint64_t   StackBase = 0x20000000;     // the lowest address
+
+private:
+    std::vector<uint8_t>                        mImage;
+    std::vector<uint8_t>                        mStack;
+    std::vector<IMAGE_RUNTIME_FUNCTION_ENTRY>   mPData;     // sorted by address
+    uint32_t                                    mNextUnwindRva;
+    uint32_t                                    mReadCount;
+
+public:
+    UnwindImageX64( uint32_t stackSize );
+
+    // Copies the unwind info into the module, and returns its RVA
+    uint32_t AddUnwindInfo( const uint8_t* unwindInfo, uint32_t size );
+    void AddFunction( uint32_t beginRva, uint32_t endRva, uint32_t unwindInfoRva );
+    void SetCode( uint32_t rva, const uint8_t* code, uint32_t size );
+
+    void WriteStack( uint64_t address, uint64_t value );
+
+    // Walks at most maxFrames frames, starting with the one in the context
+    void Walk( 
+        const CONTEXT_X64& context, 
+        bool useDbgHelp, 
+        uint32_t maxFrames, 
+        std::vector<UnwindFrameX64>& frames );
+
+    // The number of reads of module and stack memory by the walks so far
+    uint32_t GetReadCount();
+
+private:
+    static BOOL CALLBACK ReadMemory(
+        void* processContext,
+        DWORD64 address,
+        void* buffer,
+        DWORD size,
+        DWORD* sizeRead );
+
+    static void* CALLBACK FunctionTableAccess(
+        void* processContext,
+        DWORD64 address );
+
+    static DWORD64 CALLBACK GetModuleBase(
+        void* processContext,
+        DWORD64 address );
+};
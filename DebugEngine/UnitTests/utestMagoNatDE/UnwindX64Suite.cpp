@@ -0,0 +1,428 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "stdafx.h"
+#include "UnwindX64Suite.h"
+#include "UnwindImageX64.h"
+
+
+namespace
+{
+    const uint32_t  RegRbx = 3;
+    const uint32_t  RegRsp = 4;
+    const uint32_t  RegRbp = 5;
+
+    // CONTEXT_AMD64 | CONTEXT_CONTROL | CONTEXT_INTEGER, which WinNT.h only 
+    // has in x64 builds
+    const DWORD     ContextX64ControlInteger = 0x00100003;
+
+    const uint32_t  StackSize = 0x10000;
+    const uint64_t  TopSp = UnwindImageX64::StackBase + 0x1000;
+
+    const uint8_t   Nop = 0x90;
+
+    // The module's functions. Each one's unwind codes are listed last 
+    // operation first, as a code offset and then the operation and its info.
+
+    // push rbx; sub rsp, 20h
+    const uint32_t  PushAllocRva = 0x1000;
+    const uint32_t  PushAllocEndRva = 0x1100;
+    const uint32_t  PushAllocBodyRva = 0x1040;
+    const uint32_t  PushAllocReturnRva = 0x1045;
+    const uint32_t  PushAllocEpilogRva = 0x1080;
+    const uint32_t  PushAllocFrameSize = 0x30;
+    const uint8_t   PushAllocProlog[] = { 0x53, 0x48, 0x83, 0xEC, 0x20 };
+    const uint8_t   PushAllocCall[] = { 0xE8, 0xBB, 0xFF, 0xFF, 0xFF };
+    const uint8_t   PushAllocEpilog[] = { 0x48, 0x83, 0xC4, 0x20, 0x5B, 0xC3 };
+    const uint8_t   PushAllocUnwind[] = 
+    {
+        0x01, 0x05, 0x02, 0x00,     // version 1, 5 byte prolog, 2 codes
+        0x05, 0x32,                 // alloc small 20h
+        0x01, 0x30,                 // push rbx
+    };
+
+    // push rbp; sub rsp, 40h; lea rbp, [rsp+20h]
+    const uint32_t  FramePtrRva = 0x1200;
+    const uint32_t  FramePtrEndRva = 0x1300;
+    const uint32_t  FramePtrBodyRva = 0x1240;
+    const uint32_t  FramePtrEpilogRva = 0x1280;
+    const uint8_t   FramePtrProlog[] = { 0x55, 0x48, 0x83, 0xEC, 0x40, 0x48, 0x8D, 0x6C, 0x24, 0x20 };
+    const uint8_t   FramePtrEpilog[] = { 0x48, 0x8D, 0x65, 0x20, 0x5D, 0xC3 };
+    const uint8_t   FramePtrUnwind[] = 
+    {
+        0x01, 0x0A, 0x03, 0x25,     // version 1, 10 byte prolog, 3 codes, rbp + 20h
+        0x0A, 0x03,                 // set frame register
+        0x05, 0x72,                 // alloc small 40h
+        0x01, 0x50,                 // push rbp
+        0x00, 0x00,
+    };
+
+    // an interrupt handler, with and without an error code on the stack
+    const uint32_t  TrapRva = 0x1400;
+    const uint32_t  TrapEndRva = 0x1440;
+    const uint32_t  TrapErrorRva = 0x1480;
+    const uint32_t  TrapErrorEndRva = 0x14C0;
+    const uint8_t   TrapUnwind[] = 
+    {
+        0x01, 0x00, 0x01, 0x00,     // version 1, 1 code
+        0x00, 0x0A,                 // machine frame
+        0x00, 0x00,
+    };
+    const uint8_t   TrapErrorUnwind[] = 
+    {
+        0x01, 0x00, 0x01, 0x00,
+        0x00, 0x1A,                 // machine frame after an error code
+        0x00, 0x00,
+    };
+
+    // A function with the same prolog as PushAlloc, and a part of it 
+    // elsewhere, which has the primary part's unwind info chained to its own.
+    // The part has three ends:
+    //   pop rbx; jmp to the primary part
+    //   pop rbx; jmp to another function, which is a tail call
+    //   pop rbx; jmp to the same part
+    const uint32_t  PrimaryRva = 0x1600;
+    const uint32_t  PrimaryEndRva = 0x1680;
+    const uint32_t  PrimaryBodyRva = 0x1640;
+    const uint32_t  PartRva = 0x1700;
+    const uint32_t  PartEndRva = 0x1740;
+    const uint32_t  PartReturnRva = 0x1705;
+    const uint32_t  PartJmpPrimaryRva = 0x1710;
+    const uint32_t  PartJmpOutRva = 0x1720;
+    const uint32_t  PartJmpPartRva = 0x1730;
+
+    // where there's no function, so leaf code
+    const uint32_t  LeafRva = 0x3000;
+
+    uint64_t ToAddr( uint32_t rva )
+    {
+        return UnwindImageX64::ImageBase + rva;
+    }
+
+    void SetJmp( UnwindImageX64* image, uint32_t rva, uint32_t targetRva )
+    {
+        uint8_t     code[6] = { 0x5B, 0xE9 };
+        int32_t     disp = (int32_t) (targetRva - (rva + sizeof code));
+
+        memcpy( &code[2], &disp, sizeof disp );
+
+        image->SetCode( rva, code, sizeof code );
+    }
+
+    void BuildImage( UnwindImageX64* image )
+    {
+        std::vector<uint8_t>    nops( PartEndRva - PushAllocRva, Nop );
+        uint32_t                unwindRva = 0;
+
+        image->SetCode( PushAllocRva, &nops[0], nops.size() );
+
+        image->SetCode( PushAllocRva, PushAllocProlog, sizeof PushAllocProlog );
+        image->SetCode( PushAllocBodyRva, PushAllocCall, sizeof PushAllocCall );
+        image->SetCode( PushAllocEpilogRva, PushAllocEpilog, sizeof PushAllocEpilog );
+        unwindRva = image->AddUnwindInfo( PushAllocUnwind, sizeof PushAllocUnwind );
+        image->AddFunction( PushAllocRva, PushAllocEndRva, unwindRva );
+
+        image->SetCode( FramePtrRva, FramePtrProlog, sizeof FramePtrProlog );
+        image->SetCode( FramePtrEpilogRva, FramePtrEpilog, sizeof FramePtrEpilog );
+        unwindRva = image->AddUnwindInfo( FramePtrUnwind, sizeof FramePtrUnwind );
+        image->AddFunction( FramePtrRva, FramePtrEndRva, unwindRva );
+
+        unwindRva = image->AddUnwindInfo( TrapUnwind, sizeof TrapUnwind );
+        image->AddFunction( TrapRva, TrapEndRva, unwindRva );
+
+        unwindRva = image->AddUnwindInfo( TrapErrorUnwind, sizeof TrapErrorUnwind );
+        image->AddFunction( TrapErrorRva, TrapErrorEndRva, unwindRva );
+
+        image->SetCode( PrimaryRva, PushAllocProlog, sizeof PushAllocProlog );
+        unwindRva = image->AddUnwindInfo( PushAllocUnwind, sizeof PushAllocUnwind );
+        image->AddFunction( PrimaryRva, PrimaryEndRva, unwindRva );
+
+        uint8_t     partUnwind[4 + sizeof( IMAGE_RUNTIME_FUNCTION_ENTRY )] = 
+        {
+            0x21, 0x00, 0x00, 0x00,     // version 1, chained, no codes
+        };
+        IMAGE_RUNTIME_FUNCTION_ENTRY    primaryEntry = { PrimaryRva, PrimaryEndRva, unwindRva };
+
+        memcpy( &partUnwind[4], &primaryEntry, sizeof primaryEntry );
+
+        SetJmp( image, PartJmpPrimaryRva, PrimaryBodyRva );
+        SetJmp( image, PartJmpOutRva, FramePtrRva );
+        SetJmp( image, PartJmpPartRva, PartRva );
+        unwindRva = image->AddUnwindInfo( partUnwind, sizeof partUnwind );
+        image->AddFunction( PartRva, PartEndRva, unwindRva );
+    }
+
+    // Lays out a recursion of PushAlloc depth frames deep, from the top of 
+    // the stack, and returns the stack pointer of the top one. It's called 
+    // from leaf code, whose return address is 0, which ends the stack.
+    uint64_t BuildRecursion( UnwindImageX64* image, uint64_t sp, uint32_t depth )
+    {
+        for ( uint32_t i = 0; i < depth; i++ )
+        {
+            uint64_t    frameSp = sp + i * PushAllocFrameSize;
+            uint64_t    retAddr = (i + 1 < depth) ? ToAddr( PushAllocReturnRva ) : ToAddr( LeafRva );
+
+            image->WriteStack( frameSp + 0x20, 0xB0000 + i );   // rbx
+            image->WriteStack( frameSp + 0x28, retAddr );
+        }
+
+        image->WriteStack( sp + depth * PushAllocFrameSize, 0 );
+        return sp;
+    }
+
+    void InitContext( CONTEXT_X64& context, uint64_t pc, uint64_t sp, uint64_t fp )
+    {
+        memset( &context, 0, sizeof context );
+
+        context.ContextFlags = ContextX64ControlInteger;
+        context.Rip = pc;
+        context.Rsp = sp;
+        context.Rbp = fp;
+        context.Rbx = 0xBAD;
+    }
+}
+
+
+UnwindX64Suite::UnwindX64Suite()
+    :   mImage( NULL )
+{
+    TEST_ADD( UnwindX64Suite::Prolog );
+    TEST_ADD( UnwindX64Suite::Body );
+    TEST_ADD( UnwindX64Suite::Epilog );
+    TEST_ADD( UnwindX64Suite::FramePointer );
+    TEST_ADD( UnwindX64Suite::MachineFrame );
+    TEST_ADD( UnwindX64Suite::ChainedTop );
+    TEST_ADD( UnwindX64Suite::ChainedCaller );
+    TEST_ADD( UnwindX64Suite::Leaf );
+    TEST_ADD( UnwindX64Suite::MatchesDbgHelp );
+}
+
+void UnwindX64Suite::setup()
+{
+    mImage = new UnwindImageX64( StackSize );
+
+    BuildImage( mImage );
+}
+
+void UnwindX64Suite::tear_down()
+{
+    if ( mImage != NULL )
+    {
+        delete mImage;
+        mImage = NULL;
+    }
+}
+
+void UnwindX64Suite::Prolog()
+{
+    // rbx was pushed, but the stack wasn't allocated yet
+    mImage->WriteStack( TopSp, 0x1111 );
+    mImage->WriteStack( TopSp + 8, ToAddr( LeafRva ) );
+
+    AssertCaller( ToAddr( PushAllocRva + 1 ), TopSp, 0, ToAddr( LeafRva ), TopSp + 16, 0x1111, RegRbx );
+
+    // nothing has run yet
+    mImage->WriteStack( TopSp, ToAddr( LeafRva ) );
+
+    AssertCaller( ToAddr( PushAllocRva ), TopSp, 0, ToAddr( LeafRva ), TopSp + 8, 0xBAD, RegRbx );
+}
+
+void UnwindX64Suite::Body()
+{
+    mImage->WriteStack( TopSp + 0x20, 0x2222 );
+    mImage->WriteStack( TopSp + 0x28, ToAddr( LeafRva ) );
+
+    AssertCaller( ToAddr( PushAllocBodyRva ), TopSp, 0, ToAddr( LeafRva ), TopSp + 0x30, 0x2222, RegRbx );
+}
+
+void UnwindX64Suite::Epilog()
+{
+    // at the start of the epilog, nothing has been undone
+    mImage->WriteStack( TopSp + 0x20, 0x3333 );
+    mImage->WriteStack( TopSp + 0x28, ToAddr( LeafRva ) );
+
+    AssertCaller( ToAddr( PushAllocEpilogRva ), TopSp, 0, ToAddr( LeafRva ), TopSp + 0x30, 0x3333, RegRbx );
+
+    // after the add, only the pop and the return are left
+    mImage->WriteStack( TopSp, 0x4444 );
+    mImage->WriteStack( TopSp + 8, ToAddr( LeafRva ) );
+
+    AssertCaller( ToAddr( PushAllocEpilogRva + 4 ), TopSp, 0, ToAddr( LeafRva ), TopSp + 16, 0x4444, RegRbx );
+
+    // only the return is left
+    mImage->WriteStack( TopSp, ToAddr( LeafRva ) );
+
+    AssertCaller( ToAddr( PushAllocEpilogRva + 5 ), TopSp, 0, ToAddr( LeafRva ), TopSp + 8, 0xBAD, RegRbx );
+}
+
+void UnwindX64Suite::FramePointer()
+{
+    // The stack pointer has moved below the fixed frame, so only the frame 
+    // pointer finds it, in the body and in the epilog.
+    uint64_t    frameSp = TopSp + 0x100;
+    uint64_t    fp = frameSp + 0x20;
+
+    mImage->WriteStack( frameSp + 0x40, 0x5555 );   // rbp
+    mImage->WriteStack( frameSp + 0x48, ToAddr( LeafRva ) );
+
+    AssertCaller( ToAddr( FramePtrBodyRva ), TopSp, fp, ToAddr( LeafRva ), frameSp + 0x50, 0x5555, RegRbp );
+    AssertCaller( ToAddr( FramePtrEpilogRva ), TopSp, fp, ToAddr( LeafRva ), frameSp + 0x50, 0x5555, RegRbp );
+}
+
+void UnwindX64Suite::MachineFrame()
+{
+    // the interrupted code's RIP, CS, EFLAGS, RSP, and SS
+    uint64_t    interruptedSp = TopSp + 0x200;
+
+    mImage->WriteStack( TopSp, ToAddr( LeafRva ) );
+    mImage->WriteStack( TopSp + 24, interruptedSp );
+    mImage->WriteStack( interruptedSp, 0 );
+
+    AssertCaller( ToAddr( TrapRva + 0x10 ), TopSp, 0, ToAddr( LeafRva ), interruptedSp, 0xBAD, RegRbx );
+
+    // with an error code on top
+    mImage->WriteStack( TopSp, 0xE );
+    mImage->WriteStack( TopSp + 8, ToAddr( LeafRva ) );
+    mImage->WriteStack( TopSp + 32, interruptedSp );
+
+    AssertCaller( ToAddr( TrapErrorRva + 0x10 ), TopSp, 0, ToAddr( LeafRva ), interruptedSp, 0xBAD, RegRbx );
+}
+
+void UnwindX64Suite::ChainedTop()
+{
+    // A jump to the primary part stays in the function, so it doesn't end 
+    // an epilog, and the primary part's unwind codes are undone.
+    mImage->WriteStack( TopSp + 0x20, 0x6666 );
+    mImage->WriteStack( TopSp + 0x28, ToAddr( LeafRva ) );
+
+    AssertCaller( ToAddr( PartJmpPrimaryRva ), TopSp, 0, ToAddr( LeafRva ), TopSp + 0x30, 0x6666, RegRbx );
+
+    // the same for a jump in the same part
+    AssertCaller( ToAddr( PartJmpPartRva ), TopSp, 0, ToAddr( LeafRva ), TopSp + 0x30, 0x6666, RegRbx );
+
+    // a jump out of the function is a tail call, so the rest of the epilog runs
+    mImage->WriteStack( TopSp, 0x7777 );
+    mImage->WriteStack( TopSp + 8, ToAddr( LeafRva ) );
+
+    AssertCaller( ToAddr( PartJmpOutRva ), TopSp, 0, ToAddr( LeafRva ), TopSp + 16, 0x7777, RegRbx );
+}
+
+void UnwindX64Suite::ChainedCaller()
+{
+    std::vector<UnwindFrameX64>     frames;
+    CONTEXT_X64                     context;
+
+    // PushAlloc was called from the part, and the primary part's unwind 
+    // codes take the part's frame apart
+    mImage->WriteStack( TopSp + 0x20, 0x8888 );
+    mImage->WriteStack( TopSp + 0x28, ToAddr( PartReturnRva ) );
+    mImage->WriteStack( TopSp + 0x50, 0x9999 );
+    mImage->WriteStack( TopSp + 0x58, ToAddr( LeafRva ) );
+    mImage->WriteStack( TopSp + 0x60, 0 );
+
+    InitContext( context, ToAddr( PushAllocBodyRva ), TopSp, 0 );
+
+    mImage->Walk( context, false, 10, frames );
+
+    TEST_ASSERT_RETURN( frames.size() == 3 );
+    TEST_ASSERT( frames[1].Rip == ToAddr( PartReturnRva ) );
+    TEST_ASSERT( frames[1].Regs[RegRbx] == 0x8888 );
+    TEST_ASSERT( frames[2].Rip == ToAddr( LeafRva ) );
+    TEST_ASSERT( frames[2].Regs[RegRsp] == TopSp + 0x60 );
+    TEST_ASSERT( frames[2].Regs[RegRbx] == 0x9999 );
+}
+
+void UnwindX64Suite::Leaf()
+{
+    mImage->WriteStack( TopSp, ToAddr( PushAllocReturnRva ) );
+
+    AssertCaller( ToAddr( LeafRva ), TopSp, 0, ToAddr( PushAllocReturnRva ), TopSp + 8, 0xBAD, RegRbx );
+}
+
+void UnwindX64Suite::MatchesDbgHelp()
+{
+    const uint32_t  Depth = 200;
+    std::vector<UnwindFrameX64>     frames;
+    std::vector<UnwindFrameX64>     dbgHelpFrames;
+    CONTEXT_X64                     context;
+
+    InitContext( context, ToAddr( PushAllocBodyRva ), BuildRecursion( mImage, TopSp, Depth ), 0 );
+
+    mImage->Walk( context, false, Depth * 2, frames );
+    mImage->Walk( context, true, Depth * 2, dbgHelpFrames );
+
+    // the recursion, the leaf code, and the end
+    TEST_ASSERT( frames.size() == Depth + 1 );
+    TEST_ASSERT_RETURN( frames.size() == dbgHelpFrames.size() );
+
+    for ( size_t i = 0; i < frames.size(); i++ )
+    {
+        TEST_ASSERT_RETURN( frames[i].Rip == dbgHelpFrames[i].Rip );
+        TEST_ASSERT_RETURN( frames[i].Regs[RegRsp] == dbgHelpFrames[i].Regs[RegRsp] );
+        TEST_ASSERT_RETURN( frames[i].Regs[RegRbx] == dbgHelpFrames[i].Regs[RegRbx] );
+    }
+}
+
+void UnwindX64Suite::AssertCaller( 
+    uint64_t pc, 
+    uint64_t sp, 
+    uint64_t fp, 
+    uint64_t callerPc, 
+    uint64_t callerSp, 
+    uint64_t savedReg, 
+    uint32_t savedRegIndex )
+{
+    std::vector<UnwindFrameX64>     frames;
+    CONTEXT_X64                     context;
+
+    InitContext( context, pc, sp, fp );
+
+    mImage->Walk( context, false, 2, frames );
+
+    TEST_ASSERT_RETURN( frames.size() == 2 );
+    TEST_ASSERT( frames[0].Rip == pc );
+    TEST_ASSERT( frames[0].Regs[RegRsp] == sp );
+    TEST_ASSERT( frames[1].Rip == callerPc );
+    TEST_ASSERT( frames[1].Regs[RegRsp] == callerSp );
+    TEST_ASSERT( frames[1].Regs[savedRegIndex] == savedReg );
+}
+
+
+void RunUnwindBench( uint32_t depth, uint32_t iterations, std::ostream& out )
+{
+    UnwindImageX64  image( depth * PushAllocFrameSize + 0x2000 );
+    CONTEXT_X64     context;
+    LARGE_INTEGER   freq = { 0 };
+
+    QueryPerformanceFrequency( &freq );
+    BuildImage( &image );
+
+    InitContext( context, ToAddr( PushAllocBodyRva ), BuildRecursion( &image, TopSp, depth ), 0 );
+
+    for ( int useDbgHelp = 0; useDbgHelp < 2; useDbgHelp++ )
+    {
+        std::vector<UnwindFrameX64>     frames;
+        LARGE_INTEGER   start = { 0 };
+        LARGE_INTEGER   end = { 0 };
+        uint32_t        startReads = image.GetReadCount();
+
+        QueryPerformanceCounter( &start );
+
+        for ( uint32_t i = 0; i < iterations; i++ )
+            image.Walk( context, useDbgHelp != 0, depth + 2, frames );
+
+        QueryPerformanceCounter( &end );
+
+        double  micros = (double) (end.QuadPart - start.QuadPart) * 1000000.0 / (double) freq.QuadPart;
+
+        out << (useDbgHelp ? "StackWalk64:    " : "StackWalkerX64: ")
+            << frames.size() << " frames, "
+            << (micros / iterations) << " us a walk, "
+            << ((image.GetReadCount() - startReads) / iterations) << " reads a walk"
+            << std::endl;
+    }
+}
@@ -0,0 +1,47 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+class UnwindImageX64;
+struct UnwindFrameX64;
+
+
+class UnwindX64Suite : public Test::Suite
+{
+    UnwindImageX64*     mImage;
+
+public:
+    UnwindX64Suite();
+
+    void setup();
+    void tear_down();
+
+private:
+    void Prolog();
+    void Body();
+    void Epilog();
+    void FramePointer();
+    void MachineFrame();
+    void ChainedTop();
+    void ChainedCaller();
+    void Leaf();
+    void MatchesDbgHelp();
+
+    void AssertCaller( 
+        uint64_t pc, 
+        uint64_t sp, 
+        uint64_t fp, 
+        uint64_t callerPc, 
+        uint64_t callerSp, 
+        uint64_t savedReg, 
+        uint32_t savedRegIndex );
+};
+
+// Walks a deep recursion with the debug engine's x64 stack walker and with 
+// DbgHelp, and writes how long each took.
+void RunUnwindBench( uint32_t depth, uint32_t iterations, std::ostream& out );
@@ -0,0 +1,39 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+// stdafx.h : include file for standard system include files,
+// or project specific include files that are used frequently, but
+// are changed infrequently
+//
+
+#pragma once
+
+// The debug engine (test target), built the way its own files are. It 
+// brings in Windows, ATL, Exec and the symbol table.
+#include "..\..\MagoNatDE\Common.h"
+
+// C
+#include <stdio.h>
+#include <tchar.h>
+
+// C++
+#include <iostream>
+#include <fstream>
+#include <memory>
+
+// Other
+#include <cpptest.h>
+
+
+#define TEST_ASSERT_RETURN( expr )                                  \
+    {                                                               \
+        if (!(expr))                                                \
+        {                                                           \
+            assertment(::Test::Source(__FILE__, __LINE__, #expr));  \
+            return;                                                 \
+        }                                                           \
+    }
@@ -0,0 +1,184 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+// utestMagoNatDE.cpp : Defines the entry point for the console application.
+//
+
+#include "stdafx.h"
+#include "BulkReadSuite.h"
+#include "CallstackReuseSuite.h"
+#include "ExprCacheSuite.h"
+#include "StopSnapshotSuite.h"
+#include "UnwindX64Suite.h"
+
+using namespace std;
+
+
+enum OutputType
+{
+    Out_None,
+    Out_Text,
+    Out_Compiler,
+    Out_Html,
+};
+
+struct Options
+{
+    OutputType                      OutType;
+    std::shared_ptr<Test::Output> Out;
+    wstring                         Filename;
+    uint32_t                        UnwindBenchDepth;
+};
+
+const uint32_t  UnwindBenchIterations = 100;
+
+
+// The debug engine's COM objects lock the module that holds them. In the 
+// engine's DLL, that's the DLL's ATL module.
+class CTestModule : public CAtlExeModuleT<CTestModule>
+{
+};
+
+CTestModule _AtlModule;
+
+
+void InitDebug()
+{
+    int f = _CrtSetDbgFlag( _CRTDBG_REPORT_FLAG );
+    f |= _CRTDBG_LEAK_CHECK_DF;     // should always use in debug build
+    f |= _CRTDBG_CHECK_ALWAYS_DF;   // check on free AND alloc
+    _CrtSetDbgFlag( f );
+}
+
+bool ParseCommandLine( int argc, wchar_t* argv[], Options& options )
+{
+    options.OutType = Out_None;
+    options.UnwindBenchDepth = 0;
+
+    for ( int i = 1; i < argc; i++ )
+    {
+        if ( _wcsicmp( argv[i], L"-textOut" ) == 0 )
+        {
+            if ( (i + 1) >= argc )
+                return false;
+
+            Test::TextOutput::Mode  mode;
+
+            i++;
+            if ( _wcsicmp( argv[i], L"terse" ) == 0 )
+                mode = Test::TextOutput::Terse;
+            else if ( _wcsicmp( argv[i], L"verbose" ) == 0 )
+                mode = Test::TextOutput::Verbose;
+            else
+                return false;
+
+            options.OutType = Out_Text;
+            options.Out.reset( new Test::TextOutput( mode ) );
+        }
+        else if ( _wcsicmp( argv[i], L"-compilerOut" ) == 0 )
+        {
+            if ( (i + 1) >= argc )
+                return false;
+
+            Test::CompilerOutput::Format    format;
+
+            i++;
+            if ( _wcsicmp( argv[i], L"generic" ) == 0 )
+                format = Test::CompilerOutput::Generic;
+            else if ( _wcsicmp( argv[i], L"bcc" ) == 0 )
+                format = Test::CompilerOutput::BCC;
+            else if ( _wcsicmp( argv[i], L"gcc" ) == 0 )
+                format = Test::CompilerOutput::GCC;
+            else if ( _wcsicmp( argv[i], L"msvc" ) == 0 )
+                format = Test::CompilerOutput::MSVC;
+            else
+                return false;
+
+            options.OutType = Out_Compiler;
+            options.Out.reset( new Test::CompilerOutput( format ) );
+        }
+        else if ( _wcsicmp( argv[i], L"-htmlOut" ) == 0 )
+        {
+            options.OutType = Out_Html;
+            options.Out.reset( new Test::HtmlOutput() );
+        }
+        else if ( _wcsicmp( argv[i], L"-filename" ) == 0 )
+        {
+            if ( (i + 1) >= argc )
+                return false;
+
+            i++;
+            options.Filename = argv[i];
+        }
+        else if ( _wcsicmp( argv[i], L"-unwindBench" ) == 0 )
+        {
+            if ( (i + 1) >= argc )
+                return false;
+
+            i++;
+            options.UnwindBenchDepth = wcstoul( argv[i], NULL, 10 );
+            if ( options.UnwindBenchDepth == 0 )
+                return false;
+        }
+        else
+            return false;
+    }
+
+    if ( options.OutType == Out_None )
+    {
+        options.Out.reset( new Test::TextOutput( Test::TextOutput::Verbose ) );
+    }
+
+    _ASSERT( options.Out.get() != NULL );
+
+    return true;
+}
+
+void GenerateHtml( Options& options )
+{
+    if ( options.Filename.empty() )
+    {
+        ((Test::HtmlOutput*) options.Out.get())->generate( cout );
+    }
+    else
+    {
+        ofstream    file( options.Filename.c_str() );
+        ((Test::HtmlOutput*) options.Out.get())->generate( file );
+    }
+}
+
+int _tmain(int argc, _TCHAR* argv[])
+{
+    Options options;
+
+    InitDebug();
+
+    if ( !ParseCommandLine( argc, argv, options ) )
+        return EXIT_FAILURE;
+
+    // runs instead of the tests
+    if ( options.UnwindBenchDepth > 0 )
+    {
+        RunUnwindBench( options.UnwindBenchDepth, UnwindBenchIterations, cout );
+        return EXIT_SUCCESS;
+    }
+
+    Test::Suite         comboSuite;
+
+    comboSuite.add( auto_ptr<Test::Suite>( new StopSnapshotSuite() ) );
+    comboSuite.add( auto_ptr<Test::Suite>( new BulkReadSuite() ) );
+    comboSuite.add( auto_ptr<Test::Suite>( new UnwindX64Suite() ) );
+    comboSuite.add( auto_ptr<Test::Suite>( new CallstackReuseSuite() ) );
+    comboSuite.add( auto_ptr<Test::Suite>( new ExprCacheSuite() ) );
+
+    bool    passed = comboSuite.run( *options.Out.get() );
+
+    if ( options.OutType == Out_Html )
+        GenerateHtml( options );
+
+    return passed ? EXIT_SUCCESS : EXIT_FAILURE;
+}
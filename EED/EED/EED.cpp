@@ -8,7 +8,7 @@
 #include "Common.h"
 #include "EED.h"
 #include "TypeEnv.h"
-#include "SimpleNameTable.h"
+#include "InternNameTable.h"
 #include "Scanner.h"
 #include "Parser.h"
 #include "Expression.h"
@@ -23,18 +23,29 @@ namespace MagoEE
         long                mRefCount;
         RefPtr<Expression>  mExpr;
         RefPtr<NameTable>   mStrTable;      // expr holds refs to strings in here
+        uint32_t            mGeneration;    // of the strings in the table
         RefPtr<ITypeEnv>    mTypeEnv;       // eval will need this
 
     public:
-        EEDParsedExpr( Expression* e, NameTable* strTable, ITypeEnv* typeEnv )
+        EEDParsedExpr( Expression* e, NameTable* strTable, uint32_t generation, ITypeEnv* typeEnv )
             :   mRefCount( 0 ),
                 mExpr( e ),
                 mStrTable( strTable ),
+                mGeneration( generation ),
                 mTypeEnv( typeEnv )
         {
             _ASSERT( e != NULL );
             _ASSERT( strTable != NULL );
             _ASSERT( typeEnv != NULL );
+
+            mStrTable->HoldGeneration( mGeneration );
+        }
+
+        ~EEDParsedExpr()
+        {
+            // the strings have to stay until the expression is gone
+            mExpr = NULL;
+            mStrTable->ReleaseGeneration( mGeneration );
         }
 
         virtual void AddRef()
@@ -114,7 +125,7 @@ namespace MagoEE
 
     HRESULT MakeNameTable( NameTable*& nameTable )
     {
-        nameTable = new SimpleNameTable();
+        nameTable = new InternNameTable();
 
         if ( nameTable == NULL )
             return E_OUTOFMEMORY;
@@ -144,11 +155,13 @@ namespace MagoEE
         return S_OK;
     }
 
-    HRESULT ParseText( const wchar_t* text, ITypeEnv* typeEnv, NameTable* strTable, IEEDParsedExpr*& expr )
+    static HRESULT ParseInGeneration( 
+        const wchar_t* text, 
+        ITypeEnv* typeEnv, 
+        NameTable* strTable, 
+        uint32_t generation, 
+        IEEDParsedExpr*& expr )
     {
-        if ( (text == NULL) || (typeEnv == NULL) || (strTable == NULL) )
-            return E_INVALIDARG;
-
         Scanner scanner( text, wcslen( text ), strTable );
         Parser  parser( &scanner, typeEnv );
         RefPtr<Expression>  e;
@@ -168,7 +181,7 @@ namespace MagoEE
             return E_MAGOEE_SYNTAX_ERROR;
         }
 
-        expr = new EEDParsedExpr( e, strTable, typeEnv );
+        expr = new EEDParsedExpr( e, strTable, generation, typeEnv );
         if ( expr == NULL )
             return E_OUTOFMEMORY;
 
@@ -177,6 +190,19 @@ namespace MagoEE
         return S_OK;
     }
 
+    HRESULT ParseText( const wchar_t* text, ITypeEnv* typeEnv, NameTable* strTable, IEEDParsedExpr*& expr )
+    {
+        if ( (text == NULL) || (typeEnv == NULL) || (strTable == NULL) )
+            return E_INVALIDARG;
+
+        uint32_t    generation = strTable->NewGeneration();
+        HRESULT     hr = ParseInGeneration( text, typeEnv, strTable, generation, expr );
+
+        // the expression holds its generation now, if it was made
+        strTable->EndGeneration( generation );
+        return hr;
+    }
+
 
     HRESULT EnumValueChildren( 
         IValueBinder* binder, 
@@ -54,12 +54,14 @@ namespace MagoEE
         virtual HRESULT Skip( uint32_t count ) = 0;
         virtual HRESULT Clone( IEEDEnumValues*& copiedEnum ) = 0;
 
+        // The full name is the text of an expression that evaluates to the 
+        // child. It's only made if fullName isn't NULL.
         // TODO: can we use something else, like CString, instead of using wstring here?
         virtual HRESULT EvaluateNext( 
             const EvalOptions& options, 
             EvalResult& result,
             std::wstring& name,
-            std::wstring& fullName ) = 0;
+            std::wstring* fullName ) = 0;
     };
 
     HRESULT Init();
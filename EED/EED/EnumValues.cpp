@@ -51,6 +51,67 @@ namespace MagoEE
         mParentVal = parentVal;
         mTypeEnv = typeEnv;
         mStrTable = strTable;
+        mWrappedParentText.clear();
+
+        return S_OK;
+    }
+
+    const std::wstring& EEDEnumValues::GetWrappedParentText()
+    {
+        if ( mWrappedParentText.empty() )
+        {
+            bool isIdent = IsIdentifier( mParentExprText.c_str() );
+
+            if ( !isIdent )
+                mWrappedParentText.append( L"(" );
+            mWrappedParentText.append( mParentExprText );
+            if ( !isIdent )
+                mWrappedParentText.append( L")" );
+        }
+
+        return mWrappedParentText;
+    }
+
+    HRESULT EEDEnumValues::EvaluateText( 
+        const EvalOptions& options, 
+        const std::wstring& text, 
+        EvalResult& result )
+    {
+        HRESULT hr = S_OK;
+        RefPtr<IEEDParsedExpr>  parsedExpr;
+
+        hr = ParseText( text.c_str(), mTypeEnv, mStrTable, parsedExpr.Ref() );
+        if ( FAILED( hr ) )
+            return hr;
+
+        hr = parsedExpr->Bind( options, mBinder );
+        if ( FAILED( hr ) )
+            return hr;
+
+        hr = parsedExpr->Evaluate( options, mBinder, result );
+        if ( FAILED( hr ) )
+            return hr;
+
+        return S_OK;
+    }
+
+    // Makes the same result as evaluating the text of a child that's at a 
+    // known address, such as an element or a field. This saves parsing and 
+    // binding the child's text, and evaluating the parent all over again 
+    // for each child.
+
+    HRESULT EEDEnumValues::EvaluateInMemory( Address addr, Type* type, EvalResult& result )
+    {
+        HRESULT hr = S_OK;
+
+        result.ObjVal._Type = type;
+        result.ObjVal.Addr = addr;
+
+        hr = mBinder->GetValue( addr, type, result.ObjVal.Value );
+        if ( FAILED( hr ) )
+            return hr;
+
+        FillValueTraits( result, nullptr );
 
         return S_OK;
     }
@@ -115,29 +176,35 @@ namespace MagoEE
         const EvalOptions& options, 
         EvalResult& result,
         std::wstring& name,
-        std::wstring& fullName )
+        std::wstring* fullName )
     {
         if ( mCountDone >= GetCount() )
             return E_FAIL;
 
+        UNREFERENCED_PARAMETER( options );
+
         HRESULT hr = S_OK;
-        RefPtr<IEEDParsedExpr>  parsedExpr;
 
         name.clear();
-        fullName.clear();
-        fullName.append( L"*(" );
-        fullName.append( mParentExprText );
-        fullName.append( 1, L')' );
 
-        hr = ParseText( fullName.c_str(), mTypeEnv, mStrTable, parsedExpr.Ref() );
-        if ( FAILED( hr ) )
-            return hr;
+        if ( fullName != NULL )
+        {
+            fullName->clear();
+            fullName->append( L"*(" );
+            fullName->append( mParentExprText );
+            fullName->append( 1, L')' );
+        }
 
-        hr = parsedExpr->Bind( options, mBinder );
-        if ( FAILED( hr ) )
-            return hr;
+        // the same checks as dereferencing the pointer in an expression
+        RefPtr<Type>    voidType = mTypeEnv->GetType( Tvoid );
+        Type*           pointedType = mParentVal._Type->AsTypeNext()->GetNext();
 
-        hr = parsedExpr->Evaluate( options, mBinder, result );
+        if ( mParentVal._Type->IsReference() )
+            return E_MAGOEE_BAD_TYPES_FOR_OP;
+        if ( pointedType->Equals( voidType ) || pointedType->IsFunction() )
+            return E_MAGOEE_BAD_TYPES_FOR_OP;
+
+        hr = EvaluateInMemory( mParentVal.Value.Addr, pointedType, result );
         if ( FAILED( hr ) )
             return hr;
 
@@ -152,7 +219,9 @@ namespace MagoEE
     //------------------------------------------------------------------------
 
     EEDEnumSArray::EEDEnumSArray()
-        :   mCountDone( 0 )
+        :   mCountDone( 0 ),
+            mWindowStart( 0 ),
+            mWindowRead( false )
     {
     }
 
@@ -220,7 +289,7 @@ namespace MagoEE
         const EvalOptions& options, 
         EvalResult& result,
         std::wstring& name,
-        std::wstring& fullName )
+        std::wstring* fullName )
     {
         if ( mCountDone >= GetCount() )
             return E_FAIL;
@@ -230,8 +299,9 @@ namespace MagoEE
         // "[indexInt]", and add some padding
         const int   MaxIndexStrLen = MaxIntStrLen + 2 + 10;
 
+        UNREFERENCED_PARAMETER( options );
+
         HRESULT hr = S_OK;
-        RefPtr<IEEDParsedExpr>  parsedExpr;
         wchar_t indexStr[ MaxIndexStrLen + 1 ] = L"";
 
         swprintf_s( indexStr, L"[%d]", mCountDone );
@@ -239,32 +309,107 @@ namespace MagoEE
         name.clear();
         name.append( indexStr );
 
-        bool isIdent = IsIdentifier( mParentExprText.data() );
-        fullName.clear();
-        if ( !isIdent )
-            fullName.append( L"(" );
-        fullName.append( mParentExprText );
-        if ( !isIdent )
-            fullName.append( L")" );
-        fullName.append( name );
+        if ( fullName != NULL )
+        {
+            fullName->clear();
+            fullName->append( GetWrappedParentText() );
+            fullName->append( name );
+        }
 
-        hr = ParseText( fullName.c_str(), mTypeEnv, mStrTable, parsedExpr.Ref() );
-        if ( FAILED( hr ) )
-            return hr;
+        // the same checks as indexing the array in an expression
+        RefPtr<Type>    voidType = mTypeEnv->GetType( Tvoid );
+        Type*           elemType = mParentVal._Type->AsTypeNext()->GetNext();
+        Address         arrayAddr = 0;
 
-        hr = parsedExpr->Bind( options, mBinder );
-        if ( FAILED( hr ) )
-            return hr;
+        if ( elemType == NULL )
+            return E_MAGOEE_BAD_INDEX;
+        if ( elemType->Equals( voidType ) )
+            return E_MAGOEE_BAD_TYPES_FOR_OP;
 
-        hr = parsedExpr->Evaluate( options, mBinder, result );
-        if ( FAILED( hr ) )
-            return hr;
+        if ( mParentVal._Type->IsSArray() )
+        {
+            if ( mParentVal.Addr == 0 )
+                return E_FAIL;
+
+            arrayAddr = mParentVal.Addr;
+        }
+        else
+        {
+            arrayAddr = mParentVal.Value.Array.Addr;
+        }
+
+        Address elemAddr = arrayAddr + (Address) elemType->GetSize() * mCountDone;
+
+        if ( CanReadAhead( elemType ) 
+            && (ReadWindow( arrayAddr, elemType ) == S_OK) )
+        {
+            result.ObjVal._Type = elemType;
+            result.ObjVal.Addr = elemAddr;
+            result.ObjVal.Value = mWindow[mCountDone - mWindowStart];
+
+            FillValueTraits( result, nullptr );
+        }
+        else
+        {
+            // if the window couldn't be read, then read the element by itself,
+            // so that only the elements that can't be read fail
+            hr = EvaluateInMemory( elemAddr, elemType, result );
+            if ( FAILED( hr ) )
+                return hr;
+        }
 
         mCountDone++;
 
         return S_OK;
     }
 
+    bool EEDEnumSArray::CanReadAhead( Type* elemType )
+    {
+        if ( elemType->GetSize() == 0 )
+            return false;
+
+        return elemType->IsScalar() 
+            || elemType->IsDArray() 
+            || elemType->IsAArray() 
+            || elemType->IsDelegate();
+    }
+
+    // Makes sure that the current element is in the window. Skipping and 
+    // resetting only move the index, so the window starts where the 
+    // elements are needed, not at the start of the array. If the window 
+    // couldn't be read, then it isn't read again for each of its elements.
+
+    HRESULT EEDEnumSArray::ReadWindow( Address arrayAddr, Type* elemType )
+    {
+        if ( (mCountDone >= mWindowStart) 
+            && (mCountDone - mWindowStart < mWindow.size()) )
+            return mWindowRead ? S_OK : S_FALSE;
+
+        HRESULT     hr = S_OK;
+        uint32_t    elemSize = elemType->GetSize();
+        uint32_t    count = GetCount() - mCountDone;
+
+        if ( count > MaxWindowLength )
+            count = MaxWindowLength;
+        if ( count > MaxWindowSize / elemSize )
+            count = MaxWindowSize / elemSize;
+        if ( count == 0 )
+            count = 1;
+
+        mWindow.resize( count );
+        mWindowStart = mCountDone;
+
+        hr = mBinder->GetValues( 
+            arrayAddr + (Address) elemSize * mCountDone, 
+            elemType, 
+            count, 
+            &mWindow.front() );
+
+        mWindowRead = SUCCEEDED( hr );
+
+        return hr;
+    }
+
     //------------------------------------------------------------------------
     //  EEDEnumRawDArray
     //------------------------------------------------------------------------
@@ -324,37 +469,28 @@ namespace MagoEE
         const EvalOptions& options, 
         EvalResult& result,
         std::wstring& name,
-        std::wstring& fullName )
+        std::wstring* fullName )
     {
         if ( mCountDone >= GetCount() )
             return E_FAIL;
 
         HRESULT hr = S_OK;
-        RefPtr<IEEDParsedExpr>  parsedExpr;
         const wchar_t* field = (mCountDone == 0 ? L"length" : L"ptr");
+        std::wstring    text;
 
         name.clear();
         name.append( field );
 
-        bool isIdent = IsIdentifier( mParentExprText.data() );
-        fullName.clear();
-        if ( !isIdent )
-            fullName.append( L"(" );
-        fullName.append( mParentExprText );
-        if ( !isIdent )
-            fullName.append( L")" );
-        fullName.append( L"." );
-        fullName.append( name );
-
-        hr = ParseText( fullName.c_str(), mTypeEnv, mStrTable, parsedExpr.Ref() );
-        if ( FAILED( hr ) )
-            return hr;
+        // the field has to be looked up by the binder, so the text is 
+        // made either way
+        text.append( GetWrappedParentText() );
+        text.append( L"." );
+        text.append( name );
 
-        hr = parsedExpr->Bind( options, mBinder );
-        if ( FAILED( hr ) )
-            return hr;
+        if ( fullName != NULL )
+            *fullName = text;
 
-        hr = parsedExpr->Evaluate( options, mBinder, result );
+        hr = EvaluateText( options, text, result );
         if ( FAILED( hr ) )
             return hr;
 
@@ -375,6 +511,8 @@ namespace MagoEE
         mBB.nodes = UINT64_MAX;
         mBucketIndex = 0;
         mNextNode = NULL;
+        mSlotWindowStart = 0;
+        mSlotWindowLength = 0;
     }
 
     HRESULT EEDEnumAArray::ReadBB()
@@ -509,6 +647,146 @@ namespace MagoEE
         return S_OK;
     }
 
+    // Gets a slot of the bucket table. The new AA has two slots for each 
+    // bucket: the hash and the entry. If the window of slots couldn't be 
+    // read, then the slot is read by itself, but the window isn't read again 
+    // for each of its slots.
+
+    HRESULT EEDEnumAArray::ReadSlot( uint64_t slot, Address& ptrValue )
+    {
+        if ( (slot < mSlotWindowStart) 
+            || (slot - mSlotWindowStart >= mSlotWindowLength) )
+            ReadSlotWindow( slot );
+
+        if ( (slot >= mSlotWindowStart) 
+            && (slot - mSlotWindowStart < mSlotWindow.size()) )
+        {
+            ptrValue = mSlotWindow[(size_t) (slot - mSlotWindowStart)];
+            return S_OK;
+        }
+
+        return ReadAddress( mBB.b.ptr, slot, ptrValue );
+    }
+
+    void EEDEnumAArray::ReadSlotWindow( uint64_t slot )
+    {
+        uint32_t    ptrSize = mParentVal._Type->GetSize();
+        uint64_t    slotCount = (mAAVersion == 1) ? 2 * mBB.b.length : mBB.b.length;
+        uint64_t    count = slotCount - slot;
+        uint32_t    sizeRead = 0;
+        std::vector<uint8_t>    buf;
+
+        mSlotWindowStart = slot;
+        mSlotWindowLength = 0;
+        mSlotWindow.clear();
+        mHeadNexts.clear();
+        mHeadNextsRead.clear();
+
+        if ( slot >= slotCount )
+            return;
+
+        if ( count > MaxSlotWindowLength )
+            count = MaxSlotWindowLength;
+
+        mSlotWindowLength = (uint32_t) count;
+
+        buf.resize( (size_t) count * ptrSize );
+
+        HRESULT hr = mBinder->ReadMemory( 
+            mBB.b.ptr + (slot * ptrSize), 
+            (uint32_t) buf.size(), 
+            sizeRead, 
+            &buf[0] );
+        if ( FAILED( hr ) )
+            return;
+
+        // only keep the slots that were read whole
+        mSlotWindow.resize( sizeRead / ptrSize );
+
+        for ( size_t i = 0; i < mSlotWindow.size(); i++ )
+        {
+            if ( ptrSize == 4 )
+                mSlotWindow[i] = *(uint32_t*) &buf[i * ptrSize];
+            else
+                mSlotWindow[i] = *(uint64_t*) &buf[i * ptrSize];
+        }
+
+        if ( mAAVersion != 1 )
+            ReadHeadNexts();
+    }
+
+    // In the older AA, each bucket is a list of nodes, and a node starts with 
+    // the pointer to the next one. Most lists have one node, so reading the 
+    // next pointers of the first nodes in the window together saves reading 
+    // each one when moving past it.
+
+    void EEDEnumAArray::ReadHeadNexts()
+    {
+        uint32_t                ptrSize = mParentVal._Type->GetSize();
+        std::vector<Address>    nodes;
+        std::vector<size_t>     slotIndexes;
+
+        mHeadNexts.resize( mSlotWindow.size() );
+        mHeadNextsRead.resize( mSlotWindow.size() );
+
+        for ( size_t i = 0; i < mSlotWindow.size(); i++ )
+        {
+            if ( mSlotWindow[i] != 0 )
+            {
+                nodes.push_back( mSlotWindow[i] );
+                slotIndexes.push_back( i );
+            }
+        }
+
+        if ( nodes.size() == 0 )
+            return;
+
+        std::vector<uint8_t>    buf( nodes.size() * ptrSize );
+        std::vector<uint32_t>   sizesRead( nodes.size() );
+
+        HRESULT hr = mBinder->ReadMemoryV( 
+            (uint32_t) nodes.size(), 
+            &nodes[0], 
+            ptrSize, 
+            &sizesRead[0], 
+            &buf[0] );
+        if ( FAILED( hr ) )
+            return;
+
+        for ( size_t i = 0; i < nodes.size(); i++ )
+        {
+            size_t  slotIndex = slotIndexes[i];
+
+            if ( sizesRead[i] < ptrSize )
+                continue;
+
+            if ( ptrSize == 4 )
+                mHeadNexts[slotIndex] = *(uint32_t*) &buf[i * ptrSize];
+            else
+                mHeadNexts[slotIndex] = *(uint64_t*) &buf[i * ptrSize];
+
+            mHeadNextsRead[slotIndex] = true;
+        }
+    }
+
+    // Finds the next pointer of the node, if it's the first node of the 
+    // current bucket, and it was read with the window.
+
+    bool EEDEnumAArray::FindHeadNext( Address node, Address& next )
+    {
+        if ( (mBucketIndex < mSlotWindowStart) 
+            || (mBucketIndex - mSlotWindowStart >= mHeadNextsRead.size()) )
+            return false;
+
+        size_t  slotIndex = (size_t) (mBucketIndex - mSlotWindowStart);
+
+        if ( !mHeadNextsRead[slotIndex] || (mSlotWindow[slotIndex] != node) )
+            return false;
+
+        next = mHeadNexts[slotIndex];
+        return true;
+    }
+
     uint32_t EEDEnumAArray::AlignTSize( uint32_t size )
     {
         uint32_t ptrSize = mParentVal._Type->GetSize();
@@ -551,12 +829,12 @@ namespace MagoEE
             while( mNextNode == NULL && mBucketIndex < mBB.b.length )
             {
                 Address hash;
-                HRESULT hr = ReadAddress( mBB.b.ptr, 2 * mBucketIndex, hash );
+                HRESULT hr = ReadSlot( 2 * mBucketIndex, hash );
                 if ( FAILED( hr ) )
                     return hr;
 
                 if ( hash & hashFilledMark )
-                    return ReadAddress( mBB.b.ptr, 2 * mBucketIndex + 1, mNextNode );
+                    return ReadSlot( 2 * mBucketIndex + 1, mNextNode );
 
                 mBucketIndex++;
             }
@@ -565,7 +843,7 @@ namespace MagoEE
         {
             while( mNextNode == NULL && mBucketIndex < mBB.b.length )
             {
-                HRESULT hr = ReadAddress( mBB.b.ptr, mBucketIndex, mNextNode );
+                HRESULT hr = ReadSlot( mBucketIndex, mNextNode );
                 if ( FAILED( hr ) )
                     return hr;
 
@@ -592,9 +870,12 @@ namespace MagoEE
             }
             else
             {
-                hr = ReadAddress( mNextNode, 0, mNextNode );
-                if ( FAILED( hr ) )
-                    return hr;
+                if ( !FindHeadNext( mNextNode, mNextNode ) )
+                {
+                    hr = ReadAddress( mNextNode, 0, mNextNode );
+                    if ( FAILED( hr ) )
+                        return hr;
+                }
 
                 if( mNextNode != NULL )
                     return S_OK;
@@ -659,7 +940,7 @@ namespace MagoEE
         const EvalOptions& options, 
         EvalResult& result,
         std::wstring& name,
-        std::wstring& fullName )
+        std::wstring* fullName )
     {
         if ( mCountDone >= GetCount() )
             return E_FAIL;
@@ -692,14 +973,12 @@ namespace MagoEE
 
         name = L"[" + keystr + L"]";
 
-        bool isIdent = IsIdentifier( mParentExprText.data() );
-        fullName.clear();
-        if ( !isIdent )
-            fullName.append( L"(" );
-        fullName.append( mParentExprText );
-        if ( !isIdent )
-            fullName.append( L")" );
-        fullName.append( name );
+        if ( fullName != NULL )
+        {
+            fullName->clear();
+            fullName->append( GetWrappedParentText() );
+            fullName->append( name );
+        }
 
         uint32_t alignKeySize = ( mAAVersion == 1 ? mBB_V1.valoff : AlignTSize( aa->GetIndex()->GetSize() ) );
 
@@ -722,7 +1001,8 @@ namespace MagoEE
 
     EEDEnumStruct::EEDEnumStruct( bool skipHeadRef )
         :   mCountDone( 0 ),
-            mSkipHeadRef( skipHeadRef )
+            mSkipHeadRef( skipHeadRef ),
+            mObjectAddr( 0 )
     {
     }
 
@@ -741,9 +1021,15 @@ namespace MagoEE
         if ( parentValCopy._Type == NULL )
             return E_INVALIDARG;
 
+        // the value of a reference is the address of the object
         if ( mSkipHeadRef && parentValCopy._Type->IsReference() )
         {
             parentValCopy._Type = parentValCopy._Type->AsTypeNext()->GetNext();
+            mObjectAddr = parentValCopy.Value.Addr;
+        }
+        else
+        {
+            mObjectAddr = parentValCopy.Addr;
         }
 
         if ( parentValCopy._Type->AsTypeStruct() == NULL )
@@ -842,17 +1128,18 @@ namespace MagoEE
         const EvalOptions& options, 
         EvalResult& result,
         std::wstring& name,
-        std::wstring& fullName )
+        std::wstring* fullName )
     {
         if ( mCountDone >= GetCount() )
             return E_FAIL;
 
         HRESULT hr = S_OK;
         RefPtr<Declaration>     decl;
-        RefPtr<IEEDParsedExpr>  parsedExpr;
+        std::wstring            text;
 
         name.clear();
-        fullName.clear();
+        if ( fullName != NULL )
+            fullName->clear();
 
         if( mCountDone > 0 || mClassName.empty() )
             if ( !mMembers->Next( decl.Ref() ) )
@@ -860,36 +1147,44 @@ namespace MagoEE
 
         mCountDone++;
 
+        // Only a field at a known offset can be evaluated without its text.
+        // The others are looked up by the binder, so their text is made 
+        // either way.
+
         if ( !decl )
         {
             name = L"[" + mClassName + L"]";
-            fullName = L"*cast(" + mClassName + L"*)&(" + mParentExprText + L")";
+            text = L"*cast(" + mClassName + L"*)&(" + mParentExprText + L")";
         }
         else if ( decl->IsBaseClass() )
         {
-            if ( !NameBaseClass( decl, name, fullName ) )
+            if ( !NameBaseClass( decl, name, text ) )
                 return E_FAIL;
         }
         else if( decl->IsStaticField() )
         {
-            if ( !NameStaticMember( decl, name, fullName ) )
+            if ( !NameStaticMember( decl, name, text ) )
                 return E_FAIL;
         }
         else
         {
-            if ( !NameRegularMember( decl, name, fullName ) )
-                return E_FAIL;
-        }
+            NameRegularMember( decl, name );
 
-        hr = ParseText( fullName.c_str(), mTypeEnv, mStrTable, parsedExpr.Ref() );
-        if ( FAILED( hr ) )
-            return hr;
+            hr = EvaluateRegularMember( decl, result );
+            if ( hr != S_FALSE )
+            {
+                if ( fullName != NULL )
+                    AppendRegularMemberFullName( name, *fullName );
+                return hr;
+            }
 
-        hr = parsedExpr->Bind( options, mBinder );
-        if ( FAILED( hr ) )
-            return hr;
+            AppendRegularMemberFullName( name, text );
+        }
 
-        hr = parsedExpr->Evaluate( options, mBinder, result );
+        if ( fullName != NULL )
+            *fullName = text;
+
+        hr = EvaluateText( options, text, result );
         if ( FAILED( hr ) )
             return hr;
 
@@ -945,22 +1240,41 @@ namespace MagoEE
         return true;
     }
 
-    bool EEDEnumStruct::NameRegularMember( 
+    void EEDEnumStruct::NameRegularMember( 
             Declaration* decl, 
-            std::wstring& name,
-            std::wstring& fullName )
+            std::wstring& name )
     {
         name.append( decl->GetName() );
+    }
 
-        bool isIdent = IsIdentifier( mParentExprText.data() );
-        if( !isIdent )
-            fullName.append( L"(" );
-        fullName.append( mParentExprText );
-        if( !isIdent )
-            fullName.append( L")" );
+    void EEDEnumStruct::AppendRegularMemberFullName( 
+            const std::wstring& name, 
+            std::wstring& fullName )
+    {
+        fullName.append( GetWrappedParentText() );
         fullName.append( L"." );
         fullName.append( name );
+    }
 
-        return true;
+    // Returns S_FALSE if the member's text has to be evaluated instead.
+
+    HRESULT EEDEnumStruct::EvaluateRegularMember( Declaration* decl, EvalResult& result )
+    {
+        RefPtr<Type>    type;
+        int             offset = 0;
+
+        if ( mObjectAddr == 0 )
+            return S_FALSE;
+
+        if ( !decl->IsField() )
+            return S_FALSE;
+
+        if ( !decl->GetType( type.Ref() ) || (type == NULL) )
+            return S_FALSE;
+
+        if ( !decl->GetOffset( offset ) )
+            return S_FALSE;
+
+        return EvaluateInMemory( mObjectAddr + offset, type, result );
     }
 }
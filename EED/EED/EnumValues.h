@@ -17,6 +17,7 @@ namespace MagoEE
 
     protected:
         std::wstring        mParentExprText;
+        std::wstring        mWrappedParentText; // made when it's first needed
         DataObject          mParentVal;
         IValueBinder*       mBinder;
         RefPtr<ITypeEnv>    mTypeEnv;
@@ -35,6 +36,17 @@ namespace MagoEE
             const DataObject& parentVal,
             ITypeEnv* typeEnv,
             NameTable* strTable );
+
+    protected:
+        // The parent's text, in parentheses if it's not an identifier
+        const std::wstring& GetWrappedParentText();
+
+        HRESULT EvaluateText( 
+            const EvalOptions& options, 
+            const std::wstring& text, 
+            EvalResult& result );
+
+        HRESULT EvaluateInMemory( Address addr, Type* type, EvalResult& result );
     };
 
 
@@ -55,13 +67,24 @@ namespace MagoEE
             const EvalOptions& options, 
             EvalResult& result, 
             std::wstring& name, 
-            std::wstring& fullName );
+            std::wstring* fullName );
     };
 
 
+    // Elements of a type like an integer or pointer, whose value is in its 
+    // own bytes, are read ahead a window at a time. That way, a window of 
+    // elements that a user sees takes one memory read, not one each.
+
     class EEDEnumSArray : public EEDEnumValues
     {
-        uint32_t        mCountDone;
+        // The most elements and bytes read ahead at a time
+        static const uint32_t   MaxWindowLength = 256;
+        static const uint32_t   MaxWindowSize = 0x4000;
+
+        uint32_t                mCountDone;
+        uint32_t                mWindowStart;
+        std::vector<DataValue>  mWindow;
+        bool                    mWindowRead;    // false if the read failed
 
     public:
         EEDEnumSArray();
@@ -76,7 +99,11 @@ namespace MagoEE
             const EvalOptions& options, 
             EvalResult& result, 
             std::wstring& name, 
-            std::wstring& fullName );
+            std::wstring* fullName );
+
+    private:
+        static bool CanReadAhead( Type* elemType );
+        HRESULT ReadWindow( Address arrayAddr, Type* elemType );
     };
 
     typedef EEDEnumSArray EEDEnumDArray;
@@ -98,12 +125,20 @@ namespace MagoEE
             const EvalOptions& options, 
             EvalResult& result, 
             std::wstring& name, 
-            std::wstring& fullName );
+            std::wstring* fullName );
     };
 
 
+    // The bucket table is read ahead a window of slots at a time, instead of 
+    // a slot at a time, because most buckets of a table can be empty. For the 
+    // older AA, the next pointers of the nodes that the buckets in the window 
+    // point to are read together too, in one vectored read.
+
     class EEDEnumAArray : public EEDEnumValues
     {
+        // The most bucket table slots read ahead at a time
+        static const uint32_t   MaxSlotWindowLength = 256;
+
         int             mAAVersion;
         uint64_t        mCountDone;
         uint64_t        mBucketIndex;
@@ -114,8 +149,18 @@ namespace MagoEE
             BB64_V1         mBB_V1;
         };
 
+        uint64_t                mSlotWindowStart;
+        uint32_t                mSlotWindowLength;  // even if not all was read
+        std::vector<Address>    mSlotWindow;
+        std::vector<Address>    mHeadNexts;     // older AA: next of each slot's node
+        std::vector<bool>       mHeadNextsRead;
+
         HRESULT ReadBB();
         HRESULT ReadAddress( Address baseAddr, uint64_t index, Address& ptrValue );
+        HRESULT ReadSlot( uint64_t slot, Address& ptrValue );
+        void ReadSlotWindow( uint64_t slot );
+        void ReadHeadNexts();
+        bool FindHeadNext( Address node, Address& next );
         HRESULT FindCurrent();
         HRESULT FindNext();
         uint32_t AlignTSize( uint32_t size );
@@ -133,7 +178,7 @@ namespace MagoEE
             const EvalOptions& options, 
             EvalResult& result, 
             std::wstring& name, 
-            std::wstring& fullName );
+            std::wstring* fullName );
     };
 
 
@@ -141,6 +186,7 @@ namespace MagoEE
     {
         uint32_t        mCountDone;
         bool            mSkipHeadRef;
+        Address         mObjectAddr;
 
         RefPtr<IEnumDeclarationMembers> mMembers;
         std::wstring    mClassName;
@@ -165,7 +211,7 @@ namespace MagoEE
             const EvalOptions& options, 
             EvalResult& result, 
             std::wstring& name, 
-            std::wstring& fullName );
+            std::wstring* fullName );
 
     private:
         bool NameBaseClass( 
@@ -178,9 +224,14 @@ namespace MagoEE
             std::wstring& name,
             std::wstring& fullName );
 
-        bool NameRegularMember( 
+        void NameRegularMember( 
             Declaration* decl, 
-            std::wstring& name,
+            std::wstring& name );
+
+        void AppendRegularMemberFullName( 
+            const std::wstring& name, 
             std::wstring& fullName );
+
+        HRESULT EvaluateRegularMember( Declaration* decl, EvalResult& result );
     };
 }
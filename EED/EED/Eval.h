@@ -108,8 +108,16 @@ namespace MagoEE
         virtual HRESULT GetSuper( Declaration*& decl ) = 0;
         virtual HRESULT GetReturnType( Type*& type ) = 0;
 
+        // Gets the address of a variable in the binder's frame and thread. 
+        // The declaration can be shared by other frames, so this is used 
+        // instead of Declaration::GetAddress when evaluating.
+        virtual HRESULT GetAddress( Declaration* decl, Address& addr ) = 0;
+
         virtual HRESULT GetValue( Declaration* decl, DataValue& value ) = 0;
         virtual HRESULT GetValue( Address addr, Type* type, DataValue& value ) = 0;
+        // Gets the values of count objects of the type that are next to each 
+        // other in memory, starting at addr.
+        virtual HRESULT GetValues( Address addr, Type* type, uint32_t count, DataValue* values ) = 0;
         virtual HRESULT GetValue( Address aArrayAddr, const DataObject& key, Address& valueAddr ) = 0;
         virtual int GetAAVersion() = 0;
         virtual HRESULT GetClassName( Address addr, std::wstring& className ) = 0;
@@ -118,5 +126,14 @@ namespace MagoEE
         virtual HRESULT SetValue( Address addr, Type* type, const DataValue& value ) = 0;
 
         virtual HRESULT ReadMemory( Address addr, uint32_t sizeToRead, uint32_t& sizeRead, uint8_t* buffer ) = 0;
+        // Reads count blocks of sizeToRead bytes, one at each address, into 
+        // the buffer back to back, in one trip to the debuggee. sizesRead 
+        // gets the size read of each block.
+        virtual HRESULT ReadMemoryV( 
+            uint32_t count, 
+            const Address* addrs, 
+            uint32_t sizeToRead, 
+            uint32_t* sizesRead, 
+            uint8_t* buffer ) = 0;
     };
 }
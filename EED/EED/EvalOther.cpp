@@ -694,7 +694,7 @@ namespace MagoEE
         }
         else
         {
-            if( !Decl->GetAddress( obj.Addr ) )
+            if( FAILED( binder->GetAddress( Decl, obj.Addr ) ) )
                 return E_MAGOEE_NO_ADDRESS;
         }
 
@@ -725,7 +725,7 @@ namespace MagoEE
 
         if ( !thisType->IsPointer() )
         {
-            if ( !thisDecl->GetAddress( addr ) )
+            if ( FAILED( binder->GetAddress( thisDecl, addr ) ) )
                 return E_FAIL;
         }
         else
@@ -912,7 +912,7 @@ namespace MagoEE
         }
         // else is some other value: constant, var
         else
-            Decl->GetAddress( obj.Addr );
+            binder->GetAddress( Decl, obj.Addr );
 
         if ( mode == EvalMode_Address )
         {
@@ -991,7 +991,7 @@ namespace MagoEE
         UNREFERENCED_PARAMETER( evalData );
 
         obj._Type = _Type;
-        Decl->GetAddress( obj.Addr );
+        binder->GetAddress( Decl, obj.Addr );
 
         if ( mode == EvalMode_Address )
         {
@@ -1039,7 +1039,7 @@ namespace MagoEE
         UNREFERENCED_PARAMETER( evalData );
 
         obj._Type = _Type;
-        Decl->GetAddress( obj.Addr );
+        binder->GetAddress( Decl, obj.Addr );
 
         if ( mode == EvalMode_Address )
         {
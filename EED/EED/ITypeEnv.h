@@ -41,5 +41,8 @@ namespace MagoEE
         virtual HRESULT NewParams( ParameterList*& paramList ) = 0;
         virtual HRESULT NewFunction( Type* returnType, ParameterList* params, int varArgs, Type*& type ) = 0;
         virtual HRESULT NewDelegate( Type* funcType, Type*& type ) = 0;
+
+        // lets go of the cached pointer, array and delegate types
+        virtual void ClearTypes() = 0;
     };
 }
@@ -0,0 +1,314 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "Common.h"
+#include "InternNameTable.h"
+
+
+namespace MagoEE
+{
+    InternNameTable::InternNameTable()
+        :   mRefCount( 0 ),
+            mCurBlock( NULL ),
+            mBlockBytes( 0 ),
+            mGeneration( 0 ),
+            mGenerationsSinceSweep( 0 )
+    {
+    }
+
+    void InternNameTable::AddRef()
+    {
+        InterlockedIncrement( &mRefCount );
+    }
+
+    void InternNameTable::Release()
+    {
+        long    newRef = InterlockedDecrement( &mRefCount );
+        _ASSERT( newRef >= 0 );
+        if ( newRef == 0 )
+        {
+            delete this;
+        }
+    }
+
+    InternNameTable::~InternNameTable()
+    {
+        for ( BlockVector::iterator it = mBlocks.begin();
+            it != mBlocks.end();
+            it++ )
+        {
+            Block*  block = *it;
+            delete [] (uint8_t*) block;
+        }
+    }
+
+    ByteString* InternNameTable::AddString( const char* str, size_t length )
+    {
+        GuardedArea area( mGuard );
+        Entry*  entry = Intern( StringKind_Byte, str, length, sizeof( char ) );
+
+        return &entry->Str.Byte;
+    }
+
+    Utf16String* InternNameTable::AddString( const wchar_t* str, size_t length )
+    {
+        GuardedArea area( mGuard );
+        Entry*  entry = Intern( StringKind_Utf16, str, length, sizeof( wchar_t ) );
+
+        return &entry->Str.Utf16;
+    }
+
+    Utf32String* InternNameTable::AddString( const dchar_t* str, size_t length )
+    {
+        GuardedArea area( mGuard );
+        Entry*  entry = Intern( StringKind_Utf32, str, length, sizeof( dchar_t ) );
+
+        return &entry->Str.Utf32;
+    }
+
+    Utf16String* InternNameTable::GetEmpty()
+    {
+        static Utf16String  s;
+
+        s.Kind = StringKind_Utf16;
+        s.Length = 0;
+        s.Str = L"";
+
+        return &s;
+    }
+
+    uint32_t InternNameTable::NewGeneration()
+    {
+        GuardedArea area( mGuard );
+
+        mGenerationsSinceSweep++;
+
+        if ( mGenerationsSinceSweep >= SweepInterval )
+        {
+            Sweep();
+            mGenerationsSinceSweep = 0;
+        }
+
+        mGeneration++;
+        mOpenGenerations[mGeneration]++;
+        return mGeneration;
+    }
+
+    void InternNameTable::EndGeneration( uint32_t generation )
+    {
+        GuardedArea area( mGuard );
+        GenerationMap::iterator it = mOpenGenerations.find( generation );
+
+        _ASSERT( it != mOpenGenerations.end() );
+        if ( it == mOpenGenerations.end() )
+            return;
+
+        it->second--;
+        if ( it->second == 0 )
+            mOpenGenerations.erase( it );
+    }
+
+    void InternNameTable::HoldGeneration( uint32_t generation )
+    {
+        GuardedArea area( mGuard );
+
+        mHeldGenerations[generation]++;
+    }
+
+    void InternNameTable::ReleaseGeneration( uint32_t generation )
+    {
+        GuardedArea area( mGuard );
+        GenerationMap::iterator it = mHeldGenerations.find( generation );
+
+        _ASSERT( it != mHeldGenerations.end() );
+        if ( it == mHeldGenerations.end() )
+            return;
+
+        it->second--;
+        if ( it->second == 0 )
+            mHeldGenerations.erase( it );
+    }
+
+    void InternNameTable::GetStats( NameTableStats& stats )
+    {
+        GuardedArea area( mGuard );
+
+        stats.Strings = (uint32_t) mEntries.size();
+        stats.Blocks = (uint32_t) mBlocks.size();
+        stats.BlockBytes = mBlockBytes;
+        stats.HeldGenerations = (uint32_t) mHeldGenerations.size();
+    }
+
+    InternNameTable::Entry* InternNameTable::Intern(
+        StringKind kind,
+        const void* chars,
+        size_t length,
+        size_t charSize )
+    {
+        size_t  size = length * charSize;
+        size_t  hash = Hash( kind, chars, size );
+        // the oldest parse going on might be the one adding the string
+        uint32_t    firstGen = mOpenGenerations.empty() ? mGeneration : mOpenGenerations.begin()->first;
+
+        std::pair<EntryMap::iterator, EntryMap::iterator> range = mEntries.equal_range( hash );
+
+        for ( EntryMap::iterator it = range.first; it != range.second; it++ )
+        {
+            Entry*  entry = it->second;
+
+            if ( (entry->Str.Base.Kind == kind)
+                && (entry->Str.Base.Length == length)
+                && (memcmp( GetChars( entry ), chars, size ) == 0) )
+            {
+                if ( firstGen < entry->FirstGeneration )
+                    entry->FirstGeneration = firstGen;
+                entry->LastGeneration = mGeneration;
+                return entry;
+            }
+        }
+
+        // the entry, then the characters and a nul-char
+        Block*  owner = NULL;
+        Entry*  entry = (Entry*) Allocate( sizeof( Entry ) + size + charSize, owner );
+        void*   entryChars = GetChars( entry );
+
+        memcpy( entryChars, chars, size );
+        memset( (uint8_t*) entryChars + size, 0, charSize );
+
+        entry->Owner = owner;
+        entry->FirstGeneration = firstGen;
+        entry->LastGeneration = mGeneration;
+        entry->Str.Base.Kind = kind;
+        entry->Str.Base.Length = (uint32_t) length;
+
+        // all the string kinds keep the pointer in the same place
+        entry->Str.Utf16.Str = (wchar_t*) entryChars;
+
+        owner->LiveCount++;
+        mEntries.insert( EntryMap::value_type( hash, entry ) );
+
+        return entry;
+    }
+
+    void* InternNameTable::Allocate( size_t size, Block*& owner )
+    {
+        size = AlignSize( size );
+
+        // a big string's block is only for that string
+        if ( size > MaxSharedSize )
+        {
+            owner = NewBlock( size );
+            owner->Used = size;
+            return GetBlockData( owner );
+        }
+
+        if ( (mCurBlock == NULL) || (mCurBlock->Size - mCurBlock->Used < size) )
+            mCurBlock = NewBlock( BlockSize );
+
+        void*   p = GetBlockData( mCurBlock ) + mCurBlock->Used;
+
+        mCurBlock->Used += size;
+        owner = mCurBlock;
+        return p;
+    }
+
+    InternNameTable::Block* InternNameTable::NewBlock( size_t size )
+    {
+        Block*  block = (Block*) new uint8_t[ AlignSize( sizeof( Block ) ) + size ];
+
+        block->Size = size;
+        block->Used = 0;
+        block->LiveCount = 0;
+
+        mBlocks.push_back( block );
+        mBlockBytes += size;
+        return block;
+    }
+
+    // A string is kept if any generation from the first to the last one that 
+    // added it is held or still being parsed, even if that generation didn't 
+    // add it. That way, an expression that's held for a long time only keeps 
+    // the strings that were around when it was parsed.
+
+    void InternNameTable::Sweep()
+    {
+        for ( EntryMap::iterator it = mEntries.begin(); it != mEntries.end(); )
+        {
+            Entry*  entry = it->second;
+            GenerationMap::iterator heldIt = mHeldGenerations.lower_bound( entry->FirstGeneration );
+
+            GenerationMap::iterator openIt = mOpenGenerations.lower_bound( entry->FirstGeneration );
+            bool    held = (heldIt != mHeldGenerations.end()) && (heldIt->first <= entry->LastGeneration);
+            bool    open = (openIt != mOpenGenerations.end()) && (openIt->first <= entry->LastGeneration);
+
+            if ( !held && !open )
+            {
+                entry->Owner->LiveCount--;
+                it = mEntries.erase( it );
+            }
+            else
+                it++;
+        }
+
+        BlockVector::iterator   liveEnd = mBlocks.begin();
+
+        for ( BlockVector::iterator it = mBlocks.begin(); it != mBlocks.end(); it++ )
+        {
+            Block*  block = *it;
+
+            if ( block->LiveCount == 0 )
+            {
+                if ( block == mCurBlock )
+                    mCurBlock = NULL;
+
+                mBlockBytes -= block->Size;
+                delete [] (uint8_t*) block;
+            }
+            else
+            {
+                *liveEnd = block;
+                liveEnd++;
+            }
+        }
+
+        mBlocks.erase( liveEnd, mBlocks.end() );
+    }
+
+    // FNV-1a
+
+    size_t InternNameTable::Hash( StringKind kind, const void* chars, size_t size )
+    {
+        const uint8_t*  bytes = (const uint8_t*) chars;
+        uint32_t        hash = 2166136261U;
+
+        hash = (hash ^ (uint32_t) kind) * 16777619U;
+
+        for ( size_t i = 0; i < size; i++ )
+        {
+            hash = (hash ^ bytes[i]) * 16777619U;
+        }
+
+        return hash;
+    }
+
+    void* InternNameTable::GetChars( Entry* entry )
+    {
+        return (uint8_t*) entry + sizeof( Entry );
+    }
+
+    uint8_t* InternNameTable::GetBlockData( Block* block )
+    {
+        return (uint8_t*) block + AlignSize( sizeof( Block ) );
+    }
+
+    // keeps the blocks and entries aligned
+
+    size_t InternNameTable::AlignSize( size_t size )
+    {
+        return (size + sizeof( uint64_t ) - 1) & ~(sizeof( uint64_t ) - 1);
+    }
+}
@@ -0,0 +1,106 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+#include "NameTable.h"
+#include <unordered_map>
+#include <Guard.h>
+
+
+namespace MagoEE
+{
+    // Keeps one copy of each string, found by its hash. The strings are
+    // allocated out of blocks, and a block is freed when all of its strings
+    // are freed.
+    //
+    // Strings whose generations aren't held anymore are freed every so many
+    // generations, so a table that parses expressions over and over doesn't
+    // keep growing.
+    //
+    // Expressions are parsed and released on different threads, so the 
+    // table is guarded. While a parse goes on, the strings it adds are kept 
+    // as if they were added in its generation, even if a later parse started.
+
+    class InternNameTable : public NameTable
+    {
+        struct Block
+        {
+            size_t      Size;
+            size_t      Used;
+            uint32_t    LiveCount;
+        };
+
+        struct Entry
+        {
+            Block*      Owner;
+            uint32_t    FirstGeneration;
+            uint32_t    LastGeneration;
+            union
+            {
+                String      Base;
+                ByteString  Byte;
+                Utf16String Utf16;
+                Utf32String Utf32;
+            }           Str;
+        };
+
+        typedef std::unordered_multimap<size_t, Entry*>    EntryMap;
+        typedef std::vector<Block*>                         BlockVector;
+        typedef std::map<uint32_t, uint32_t>                GenerationMap;
+
+        static const size_t     BlockSize = 0x4000;
+
+        // Strings bigger than this get their own block
+        static const size_t     MaxSharedSize = BlockSize / 4;
+
+        // How many generations go by between freeing strings
+        static const uint32_t   SweepInterval = 64;
+
+        long                mRefCount;
+        EntryMap            mEntries;       // by hash
+        BlockVector         mBlocks;
+        Block*              mCurBlock;
+        uint64_t            mBlockBytes;
+        uint32_t            mGeneration;
+        uint32_t            mGenerationsSinceSweep;
+        GenerationMap       mHeldGenerations;   // hold counts by generation
+        GenerationMap       mOpenGenerations;   // parses going on, by generation
+        Guard               mGuard;
+
+    public:
+        InternNameTable();
+        ~InternNameTable();
+
+        virtual void AddRef();
+        virtual void Release();
+
+        virtual ByteString* AddString( const char* str, size_t length );
+        virtual Utf16String* AddString( const wchar_t* str, size_t length );
+        virtual Utf32String* AddString( const dchar_t* str, size_t length );
+
+        virtual Utf16String* GetEmpty();
+
+        virtual uint32_t NewGeneration();
+        virtual void EndGeneration( uint32_t generation );
+        virtual void HoldGeneration( uint32_t generation );
+        virtual void ReleaseGeneration( uint32_t generation );
+
+        virtual void GetStats( NameTableStats& stats );
+
+    private:
+        Entry* Intern( StringKind kind, const void* chars, size_t length, size_t charSize );
+        void* Allocate( size_t size, Block*& owner );
+        Block* NewBlock( size_t size );
+        void Sweep();
+
+        static size_t Hash( StringKind kind, const void* chars, size_t size );
+        static void* GetChars( Entry* entry );
+        static uint8_t* GetBlockData( Block* block );
+        static size_t AlignSize( size_t size );
+    };
+}
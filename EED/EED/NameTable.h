@@ -12,6 +12,22 @@
 
 namespace MagoEE
 {
+    struct NameTableStats
+    {
+        uint32_t    Strings;
+        uint32_t    Blocks;
+        uint64_t    BlockBytes;
+        uint32_t    HeldGenerations;
+    };
+
+
+    // Adding a string that's already in the table returns the same object, 
+    // so identifiers from the same table can be compared by pointer.
+    //
+    // Each parse of an expression is a new generation, which lasts until the 
+    // parse ends it. A string can be freed once no expression is held from 
+    // the generations between the first and the last one that added it.
+
     class NameTable
     {
     public:
@@ -23,5 +39,12 @@ namespace MagoEE
         virtual Utf32String* AddString( const dchar_t* str, size_t length ) = 0;
 
         virtual Utf16String* GetEmpty() = 0;
+
+        virtual uint32_t NewGeneration() = 0;
+        virtual void EndGeneration( uint32_t generation ) = 0;
+        virtual void HoldGeneration( uint32_t generation ) = 0;
+        virtual void ReleaseGeneration( uint32_t generation ) = 0;
+
+        virtual void GetStats( NameTableStats& stats ) = 0;
     };
 }
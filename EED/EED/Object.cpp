@@ -35,6 +35,11 @@ namespace MagoEE
         }
     }
 
+    long Object::GetRefCount()
+    {
+        return mRefCount;
+    }
+
     ObjectKind ObjectList::GetObjectKind()
     {
         return ObjectKind_ObjectList;
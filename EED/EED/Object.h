@@ -33,6 +33,9 @@ namespace MagoEE
         virtual void AddRef();
         virtual void Release();
 
+        // lets a cache tell if it holds the only reference
+        long GetRefCount();
+
         virtual ObjectKind GetObjectKind() = 0;
     };
 
@@ -623,15 +623,20 @@ Done:
     RefPtr<Type>        Parser::ParseBasicType2( Type* type )
     {
         RefPtr<Type>    type2 = type;
-        int             ptrSize = mTypeEnv->GetVoidPointerType()->GetSize();
 
         for ( ; ; )
         {
             switch ( GetTokenCode() )
             {
             case TOKmul:
-                type2 = new TypePointer( type2.Get(), ptrSize );
-                NextToken();
+                {
+                    RefPtr<Type>    newType;
+                    HRESULT hr = mTypeEnv->NewPointer( type2, newType.Ref() );
+                    if ( FAILED( hr ) )
+                        throw 90;
+                    NextToken();
+                    type2 = newType;
+                }
                 break;
 
             case TOKlbracket:
@@ -732,13 +737,16 @@ Done:
                     funcType->SetNoThrow( isnothrow );
                     funcType->SetProperty( isproperty );
                     funcType->SetTrust( trust );
+
+                    RefPtr<Type>    newType;
+                    HRESULT         hr = S_OK;
                     if ( tokCode == TOKdelegate )
-                    {
-                        RefPtr<TypePointer> ptrType = new TypePointer( funcType, ptrSize );
-                        type2 = new TypeDelegate( ptrType );
-                    }
+                        hr = mTypeEnv->NewDelegate( funcType, newType.Ref() );
                     else
-                        type2 = new TypePointer( funcType.Get(), ptrSize );  // pointer to function
+                        hr = mTypeEnv->NewPointer( funcType, newType.Ref() );  // pointer to function
+                    if ( FAILED( hr ) )
+                        throw 90;
+                    type2 = newType;
                 }
                 break;
 
@@ -1296,7 +1296,7 @@ namespace MagoEE
             {
                 start = GetCharPtr();
                 Scan();
-                if ( (mTok.Code == TOKidentifier) && (wcscmp( mTok.Utf16Str->Str, id->Str ) == 0) )
+                if ( (mTok.Code == TOKidentifier) && (mTok.Utf16Str == id) )
                 {
                     if ( GetChar() != L'"' )
                         throw 14;
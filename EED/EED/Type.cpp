@@ -628,6 +628,10 @@ namespace MagoEE
 
     bool TypePointer::Equals( Type* other )
     {
+        // the type environment makes one of these for the same operands
+        if ( other == this )
+            return true;
+
         if ( other->Ty != Tpointer )
             return false;
 
@@ -696,6 +700,9 @@ namespace MagoEE
 
     bool TypeReference::Equals( Type* other )
     {
+        if ( other == this )
+            return true;
+
         if ( other->Ty != Treference )
             return false;
 
@@ -763,6 +770,9 @@ namespace MagoEE
 
     bool TypeDArray::Equals( Type* other )
     {
+        if ( other == this )
+            return true;
+
         if ( other->Ty != Tarray )
             return false;
 
@@ -831,6 +841,9 @@ namespace MagoEE
 
     bool TypeAArray::Equals( Type* other )
     {
+        if ( other == this )
+            return true;
+
         if ( other->Ty != Taarray )
             return false;
 
@@ -907,6 +920,9 @@ namespace MagoEE
 
     bool TypeSArray::Equals( Type* other )
     {
+        if ( other == this )
+            return true;
+
         if ( other->Ty != Tsarray )
             return false;
 
@@ -1190,6 +1206,9 @@ namespace MagoEE
 
     bool TypeDelegate::Equals( Type* other )
     {
+        if ( other == this )
+            return true;
+
         if ( other->Ty != Ty )
             return false;
 
@@ -17,7 +17,8 @@ namespace MagoEE
 {
     TypeEnv::TypeEnv( int pointerSize )
         :   mRefCount( 0 ),
-            mPtrSize( pointerSize )
+            mPtrSize( pointerSize ),
+            mSweepSize( MinSweepSize )
     {
     }
 
@@ -59,7 +60,11 @@ namespace MagoEE
             return false;
         }
 
+        TypeKey voidPtrKey = { Tnone };
+
         mVoidPtr = new TypePointer( GetType( Tvoid ), mPtrSize );
+        MakeKey( Tpointer, GetType( Tvoid ), NULL, 0, voidPtrKey );
+        AddType( voidPtrKey, mVoidPtr );
 
         return true;
     }
@@ -107,25 +112,63 @@ namespace MagoEE
 
     HRESULT TypeEnv::NewPointer( Type* pointed, Type*& pointer )
     {
-        pointer = new TypePointer( pointed, mPtrSize );
+        GuardedArea area( mGuard );
+        TypeKey     key = { Tnone };
+        bool        cache = MakeKey( Tpointer, pointed, NULL, 0, key );
+
+        pointer = cache ? FindType( key ) : NULL;
+        if ( pointer == NULL )
+        {
+            pointer = new TypePointer( GetOperand( key.Next, pointed ), mPtrSize );
+            if ( cache )
+                AddType( key, pointer );
+        }
+
         pointer->AddRef();
         return S_OK;
     }
 
     HRESULT TypeEnv::NewReference( Type* pointed, Type*& pointer )
     {
-        pointer = new TypeReference( pointed, mPtrSize );
+        GuardedArea area( mGuard );
+        TypeKey     key = { Tnone };
+        bool        cache = MakeKey( Treference, pointed, NULL, 0, key );
+
+        pointer = cache ? FindType( key ) : NULL;
+        if ( pointer == NULL )
+        {
+            pointer = new TypeReference( GetOperand( key.Next, pointed ), mPtrSize );
+            if ( cache )
+                AddType( key, pointer );
+        }
+
         pointer->AddRef();
         return S_OK;
     }
 
     HRESULT TypeEnv::NewDArray( Type* elem, Type*& type )
     {
-        // TODO: don't allocate these every time
-        RefPtr<Type>    lenType = GetType( mPtrSize == 8 ? Tuns64 : Tuns32 );
-        RefPtr<Type>    ptrType = new TypePointer( elem, mPtrSize );
+        GuardedArea area( mGuard );
+        TypeKey     key = { Tnone };
+        bool        cache = MakeKey( Tarray, elem, NULL, 0, key );
+
+        type = cache ? FindType( key ) : NULL;
+        if ( type == NULL )
+        {
+            HRESULT         hr = S_OK;
+            Type*           elemOperand = GetOperand( key.Next, elem );
+            RefPtr<Type>    lenType = GetType( mPtrSize == 8 ? Tuns64 : Tuns32 );
+            RefPtr<Type>    ptrType;
+
+            hr = NewPointer( elemOperand, ptrType.Ref() );
+            if ( FAILED( hr ) )
+                return hr;
+
+            type = new TypeDArray( elemOperand, lenType, ptrType );
+            if ( cache )
+                AddType( key, type );
+        }
 
-        type = new TypeDArray( elem, lenType, ptrType );
         type->AddRef();
         return S_OK;
     }
@@ -137,14 +180,39 @@ namespace MagoEE
         if ( ptrType == NULL )
             return E_OUTOFMEMORY;
 
-        type = new TypeAArray( elem, key, ptrType->GetSize() );
+        GuardedArea area( mGuard );
+        TypeKey     typeKey = { Tnone };
+        bool        cache = MakeKey( Taarray, elem, key, 0, typeKey );
+
+        type = cache ? FindType( typeKey ) : NULL;
+        if ( type == NULL )
+        {
+            type = new TypeAArray( 
+                GetOperand( typeKey.Next, elem ), 
+                GetOperand( typeKey.Index, key ), 
+                ptrType->GetSize() );
+            if ( cache )
+                AddType( typeKey, type );
+        }
+
         type->AddRef();
         return S_OK;
     }
 
     HRESULT TypeEnv::NewSArray( Type* elem, uint32_t length, Type*& type )
     {
-        type = new TypeSArray( elem, length );
+        GuardedArea area( mGuard );
+        TypeKey     key = { Tnone };
+        bool        cache = MakeKey( Tsarray, elem, NULL, length, key );
+
+        type = cache ? FindType( key ) : NULL;
+        if ( type == NULL )
+        {
+            type = new TypeSArray( GetOperand( key.Next, elem ), length );
+            if ( cache )
+                AddType( key, type );
+        }
+
         type->AddRef();
         return S_OK;
     }
@@ -193,9 +261,236 @@ namespace MagoEE
 
     HRESULT TypeEnv::NewDelegate( Type* funcType, Type*& type )
     {
-        RefPtr<Type>    ptrToFunc = new TypePointer( funcType, mPtrSize );
-        type = new TypeDelegate( ptrToFunc );
+        GuardedArea area( mGuard );
+        TypeKey     key = { Tnone };
+        bool        cache = MakeKey( Tdelegate, funcType, NULL, 0, key );
+
+        type = cache ? FindType( key ) : NULL;
+        if ( type == NULL )
+        {
+            HRESULT         hr = S_OK;
+            RefPtr<Type>    ptrToFunc;
+
+            hr = NewPointer( GetOperand( key.Next, funcType ), ptrToFunc.Ref() );
+            if ( FAILED( hr ) )
+                return hr;
+
+            type = new TypeDelegate( ptrToFunc );
+            if ( cache )
+                AddType( key, type );
+        }
+
         type->AddRef();
         return S_OK;
     }
+
+    bool TypeEnv::TypeKey::operator<( const TypeKey& other ) const
+    {
+        if ( Ty != other.Ty )
+            return Ty < other.Ty;
+        if ( Next != other.Next )
+            return Next < other.Next;
+        if ( NextMod != other.NextMod )
+            return NextMod < other.NextMod;
+        if ( Index != other.Index )
+            return Index < other.Index;
+        if ( IndexMod != other.IndexMod )
+            return IndexMod < other.IndexMod;
+        return Length < other.Length;
+    }
+
+    // Returns false if the type can't be cached, because an operand isn't 
+    // resolved yet. Then the key holds the operands as they are.
+
+    bool TypeEnv::MakeKey( ENUMTY ty, Type* next, Type* index, uint32_t length, TypeKey& key )
+    {
+        bool    resolved = IsResolved( next ) && ((index == NULL) || IsResolved( index ));
+
+        key.Ty = ty;
+        key.Next = resolved ? Canonicalize( next ) : next;
+        key.NextMod = next->Mod;
+        key.Index = (resolved && (index != NULL)) ? Canonicalize( index ) : index;
+        key.IndexMod = (index != NULL) ? index->Mod : MODnone;
+        key.Length = length;
+
+        return resolved;
+    }
+
+    // Finds the object that stands for a type in the keys: the basic type 
+    // of the same kind, apart from its modifiers, or the cached type that 
+    // was made from the same operands. Other types stand for themselves.
+
+    Type* TypeEnv::Canonicalize( Type* type )
+    {
+        if ( type->IsBasic() && (type->Ty < TMAX) && (mBasic[type->Ty] != NULL) )
+            return mBasic[type->Ty].Get();
+
+        // a cached type has no modifiers
+        if ( type->Mod != MODnone )
+            return type;
+
+        TypeKey     key = { Tnone };
+        Type*       index = NULL;
+        uint32_t    length = 0;
+        Type*       next = NULL;
+
+        switch ( type->Ty )
+        {
+        case Tpointer:
+        case Treference:
+        case Tarray:
+            next = type->AsTypeNext()->GetNext();
+            break;
+
+        case Taarray:
+            next = type->AsTypeAArray()->GetElement();
+            index = type->AsTypeAArray()->GetIndex();
+            break;
+
+        case Tsarray:
+            if ( type->AsTypeSArray() == NULL )
+                return type;
+            next = type->AsTypeSArray()->GetElement();
+            length = type->AsTypeSArray()->GetLength();
+            break;
+
+        case Tdelegate:
+            // the function type that the delegate's pointer points to
+            next = type->AsTypeNext()->GetNext()->AsTypeNext()->GetNext();
+            break;
+
+        default:
+            return type;
+        }
+
+        MakeKey( type->Ty, next, index, length, key );
+
+        Type*   cachedType = FindType( key );
+
+        return (cachedType != NULL) ? cachedType : type;
+    }
+
+    // A basic operand with modifiers is keyed by the plain basic type, so 
+    // the type is made from the original operand to keep its modifiers.
+
+    Type* TypeEnv::GetOperand( Type* canonical, Type* type )
+    {
+        if ( type->Mod != MODnone )
+            return type;
+
+        return canonical;
+    }
+
+    // The parser makes types from names and expressions that are only 
+    // resolved when the expression is bound.
+
+    bool TypeEnv::IsResolved( Type* type )
+    {
+        switch ( type->Ty )
+        {
+        case Tident:
+        case Tinstance:
+        case Ttypeof:
+        case Treturn:
+        case Tslice:
+            return false;
+
+        case Tsarray:
+            if ( type->AsTypeSArray() == NULL )
+                return false;
+            break;
+
+        case Taarray:
+            if ( !IsResolved( type->AsTypeAArray()->GetIndex() ) )
+                return false;
+            break;
+
+        case Tfunction:
+            {
+                ParameterList*  params = type->AsTypeFunction()->GetParams();
+
+                if ( params != NULL )
+                {
+                    for ( ParameterList::ListType::iterator it = params->List.begin();
+                        it != params->List.end();
+                        it++ )
+                    {
+                        if ( !IsResolved( (*it)->_Type ) )
+                            return false;
+                    }
+                }
+            }
+            break;
+
+        default:
+            break;
+        }
+
+        if ( type->AsTypeNext() != NULL )
+            return IsResolved( type->AsTypeNext()->GetNext() );
+
+        return true;
+    }
+
+    void TypeEnv::ClearTypes()
+    {
+        TypeMap types;
+
+        // the types are released outside of the lock
+        {
+            GuardedArea area( mGuard );
+
+            mTypes.swap( types );
+            mSweepSize = MinSweepSize;
+        }
+    }
+
+    Type* TypeEnv::FindType( const TypeKey& key )
+    {
+        TypeMap::iterator   it = mTypes.find( key );
+
+        if ( it == mTypes.end() )
+            return NULL;
+
+        return it->second.Get();
+    }
+
+    // The cached type holds its operands, so their addresses in the key 
+    // can't be reused for other types while it's in the cache.
+
+    void TypeEnv::AddType( const TypeKey& key, Type* type )
+    {
+        if ( mTypes.size() >= mSweepSize )
+        {
+            SweepTypes();
+
+            mSweepSize = mTypes.size() * 2;
+            if ( mSweepSize < MinSweepSize )
+                mSweepSize = MinSweepSize;
+        }
+
+        mTypes.insert( TypeMap::value_type( key, type ) );
+    }
+
+    void TypeEnv::SweepTypes()
+    {
+        bool    removed = false;
+
+        // letting go of a type can leave its operands unused, so go again
+        do
+        {
+            removed = false;
+
+            for ( TypeMap::iterator it = mTypes.begin(); it != mTypes.end(); )
+            {
+                if ( it->second->GetRefCount() == 1 )
+                {
+                    it = mTypes.erase( it );
+                    removed = true;
+                }
+                else
+                    it++;
+            }
+        } while ( removed );
+    }
 }
@@ -9,6 +9,7 @@
 
 #include "TypeCommon.h"
 #include "ITypeEnv.h"
+#include <Guard.h>
 
 
 namespace MagoEE
@@ -18,13 +19,41 @@ namespace MagoEE
     enum ENUMTY;
 
 
+    // Pointers, references, arrays and delegates are made once for each set
+    // of operand types, and then found again. Operands are looked up as the 
+    // basic or cached type that's equal to them, so a type made from equal 
+    // operands is the same object. Types over operands that the parser 
+    // hasn't resolved yet aren't cached.
+    //
+    // When the cache gets big, the types that nobody else holds are let go.
+
     class TypeEnv : public ITypeEnv
     {
+        struct TypeKey
+        {
+            ENUMTY      Ty;
+            Type*       Next;
+            MOD         NextMod;
+            Type*       Index;      // key type of an associative array
+            MOD         IndexMod;
+            uint32_t    Length;     // of a static array
+
+            bool operator<( const TypeKey& other ) const;
+        };
+
+        typedef std::map<TypeKey, RefPtr<Type> >    TypeMap;
+
+        // The fewest types cached before the unused ones are let go
+        static const size_t MinSweepSize = 1024;
+
         long            mRefCount;
         RefPtr<Type>    mBasic[TMAX];
         RefPtr<Type>    mVoidPtr;
         ENUMTY          mAlias[ALIASTMAX];
         int             mPtrSize;
+        TypeMap         mTypes;
+        size_t          mSweepSize;
+        Guard           mGuard;
 
     public:
         TypeEnv( int pointerSize );
@@ -51,5 +80,16 @@ namespace MagoEE
         virtual HRESULT NewParams( ParameterList*& paramList );
         virtual HRESULT NewFunction( Type* returnType, ParameterList* params, int varArgs, Type*& type );
         virtual HRESULT NewDelegate( Type* funcType, Type*& type );
+
+        virtual void ClearTypes();
+
+    private:
+        bool MakeKey( ENUMTY ty, Type* next, Type* index, uint32_t length, TypeKey& key );
+        Type* Canonicalize( Type* type );
+        static Type* GetOperand( Type* canonical, Type* type );
+        static bool IsResolved( Type* type );
+        Type* FindType( const TypeKey& key );
+        void AddType( const TypeKey& key, Type* type );
+        void SweepTypes();
     };
 }
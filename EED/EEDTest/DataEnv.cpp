@@ -9,6 +9,7 @@
 #include "DataEnv.h"
 #include "DataValue.h"
 #include "DataElement.h"
+#include "SymUtil.h"
 
 using MagoEE::Type;
 using MagoEE::Declaration;
@@ -294,6 +295,17 @@ Real10 DataEnv::ReadFloat( uint8_t* srcBuf, MagoEE::Address address, MagoEE::Typ
 
 //----------------------------------------------------------------------------
 
+BasicTypeScope::BasicTypeScope( MagoEE::ITypeEnv* typeEnv )
+    :   mTypeEnv( typeEnv )
+{
+}
+
+HRESULT BasicTypeScope::FindObject( const wchar_t* name, MagoEE::Declaration*& decl )
+{
+    return FindBasicType( name, mTypeEnv, decl );
+}
+
+
 DataEnvBinder::DataEnvBinder( IValueEnv* env, IScope* scope )
     :   mDataEnv( env ),
         mScope( scope )
@@ -320,6 +332,14 @@ HRESULT DataEnvBinder::GetReturnType( MagoEE::Type*& type )
     return E_NOTIMPL;
 }
 
+HRESULT DataEnvBinder::GetAddress( MagoEE::Declaration* decl, MagoEE::Address& addr )
+{
+    if ( !decl->GetAddress( addr ) )
+        return E_FAIL;
+
+    return S_OK;
+}
+
 
 HRESULT DataEnvBinder::GetValue( MagoEE::Declaration* decl, MagoEE::DataValue& value )
 {
@@ -343,6 +363,18 @@ HRESULT DataEnvBinder::GetValue( MagoEE::Address addr, MagoEE::Type* type, MagoE
     return S_OK;
 }
 
+HRESULT DataEnvBinder::GetValues( MagoEE::Address addr, MagoEE::Type* type, uint32_t count, MagoEE::DataValue* values )
+{
+    for ( uint32_t i = 0; i < count; i++ )
+    {
+        HRESULT hr = GetValue( addr + ((MagoEE::Address) type->GetSize() * i), type, values[i] );
+        if ( FAILED( hr ) )
+            return hr;
+    }
+
+    return S_OK;
+}
+
 HRESULT DataEnvBinder::GetValue( MagoEE::Address aArrayAddr, const MagoEE::DataObject& key, MagoEE::Address& valueAddr )
 {
     return E_NOTIMPL;
@@ -386,3 +418,9 @@ HRESULT DataEnvBinder::ReadMemory( MagoEE::Address addr, uint32_t sizeToRead, ui
 {
     return E_NOTIMPL;
 }
+
+HRESULT DataEnvBinder::ReadMemoryV( 
+    uint32_t count, const MagoEE::Address* addrs, uint32_t sizeToRead, uint32_t* sizesRead, uint8_t* buffer )
+{
+    return E_NOTIMPL;
+}
@@ -44,6 +44,18 @@ private:
 };
 
 
+// Finds only the basic types, for expressions that name no symbols.
+class BasicTypeScope : public IScope
+{
+    MagoEE::ITypeEnv*   mTypeEnv;
+
+public:
+    BasicTypeScope( MagoEE::ITypeEnv* typeEnv );
+
+    virtual HRESULT FindObject( const wchar_t* name, MagoEE::Declaration*& decl );
+};
+
+
 class DataEnvBinder : public MagoEE::IValueBinder
 {
     IValueEnv*  mDataEnv;
@@ -58,8 +70,11 @@ public:
     virtual HRESULT GetSuper( MagoEE::Declaration*& decl );
     virtual HRESULT GetReturnType( MagoEE::Type*& type );
 
+    virtual HRESULT GetAddress( MagoEE::Declaration* decl, MagoEE::Address& addr );
+
     virtual HRESULT GetValue( MagoEE::Declaration* decl, MagoEE::DataValue& value );
     virtual HRESULT GetValue( MagoEE::Address addr, MagoEE::Type* type, MagoEE::DataValue& value );
+    virtual HRESULT GetValues( MagoEE::Address addr, MagoEE::Type* type, uint32_t count, MagoEE::DataValue* values );
     virtual HRESULT GetValue( MagoEE::Address aArrayAddr, const MagoEE::DataObject& key, MagoEE::Address& valueAddr );
     virtual int GetAAVersion();
 
@@ -67,4 +82,6 @@ public:
     virtual HRESULT SetValue( MagoEE::Address addr, MagoEE::Type* type, const MagoEE::DataValue& value );
 
     virtual HRESULT ReadMemory( MagoEE::Address addr, uint32_t sizeToRead, uint32_t& sizeRead, uint8_t* buffer );
+    virtual HRESULT ReadMemoryV( 
+        uint32_t count, const MagoEE::Address* addrs, uint32_t sizeToRead, uint32_t* sizesRead, uint8_t* buffer );
 };
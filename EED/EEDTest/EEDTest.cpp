@@ -18,6 +18,8 @@
 #include "ProgValueEnv.h"
 #include "AppSettings.h"
 #include "SymUtil.h"
+#include "EnumBench.h"
+#include "SoakTest.h"
 
 using namespace std;
 using MagoEE::ITypeEnv;
@@ -99,6 +101,8 @@ struct Options
     bool            SelfTest;
     bool            DisableAssignment;
     bool            TempAssignment;
+    uint32_t        EnumBenchCount;
+    uint32_t        SoakCount;
 
     static bool ParseOptions( int argc, wchar_t* argv[], Options& options )
     {
@@ -156,8 +160,32 @@ struct Options
             {
                 options.TempAssignment = true;
             }
+            else if ( _wcsicmp( argv[i], L"-enumBench" ) == 0 )
+            {
+                i++;
+                if ( i >= argc )
+                    return false;
+
+                options.EnumBenchCount = wcstoul( argv[i], NULL, 10 );
+                if ( options.EnumBenchCount == 0 )
+                    return false;
+            }
+            else if ( _wcsicmp( argv[i], L"-soak" ) == 0 )
+            {
+                i++;
+                if ( i >= argc )
+                    return false;
+
+                options.SoakCount = wcstoul( argv[i], NULL, 10 );
+                if ( options.SoakCount == 0 )
+                    return false;
+            }
         }
 
+        // these run instead of the tests
+        if ( (options.EnumBenchCount > 0) || (options.SoakCount > 0) )
+            return true;
+
         if ( (options.DataFile == NULL) && (options.TestFile == NULL) && (options.ProgFile == NULL) )
             return false;
 
@@ -188,6 +216,15 @@ int _tmain(int argc, _TCHAR* argv[])
     if ( !Options::ParseOptions( argc, argv, options ) )
         return 1;
 
+    if ( options.EnumBenchCount > 0 )
+        return RunEnumBench( options.EnumBenchCount, std::cout );
+
+    if ( options.SoakCount > 0 )
+        return RunSoakTest( options.SoakCount, std::cout );
+
+    if ( RunNameTableTest( std::cout ) != 0 )
+        return 1;
+
     gAppSettings.SelfTest = options.SelfTest;
     gAppSettings.PromoteTypedValue = true;
     gAppSettings.AllowAssignment = !options.DisableAssignment;
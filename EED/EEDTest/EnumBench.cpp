@@ -0,0 +1,173 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "Common.h"
+#include "EnumBench.h"
+#include "DataEnv.h"
+
+
+namespace
+{
+    HRESULT EvaluateText( 
+        const wchar_t* text, 
+        MagoEE::ITypeEnv* typeEnv, 
+        MagoEE::NameTable* strTable, 
+        MagoEE::IValueBinder* binder, 
+        MagoEE::EvalResult& result )
+    {
+        HRESULT                         hr = S_OK;
+        MagoEE::EvalOptions             options = { 0 };
+        RefPtr<MagoEE::IEEDParsedExpr>  parsedExpr;
+
+        hr = MagoEE::ParseText( text, typeEnv, strTable, parsedExpr.Ref() );
+        if ( FAILED( hr ) )
+            return hr;
+
+        hr = parsedExpr->Bind( options, binder );
+        if ( FAILED( hr ) )
+            return hr;
+
+        return parsedExpr->Evaluate( options, binder, result );
+    }
+
+    double GetMicros( const LARGE_INTEGER& start, const LARGE_INTEGER& end )
+    {
+        LARGE_INTEGER   freq = { 0 };
+
+        QueryPerformanceFrequency( &freq );
+
+        return (double) (end.QuadPart - start.QuadPart) * 1000000.0 / (double) freq.QuadPart;
+    }
+}
+
+
+int RunEnumBench( uint32_t count, std::ostream& out )
+{
+    HRESULT                     hr = S_OK;
+    RefPtr<MagoEE::ITypeEnv>    typeEnv;
+    RefPtr<MagoEE::NameTable>   strTable;
+    MagoEE::EvalResult          arrayResult = { 0 };
+    MagoEE::Address             arrayAddr = 0;
+    wchar_t                     arrayText[64] = L"";
+    uint64_t                    textSum = 0;
+
+    hr = MagoEE::MakeTypeEnv( 4, typeEnv.Ref() );
+    if ( FAILED( hr ) )
+        return 1;
+
+    hr = MagoEE::MakeNameTable( strTable.Ref() );
+    if ( FAILED( hr ) )
+        return 1;
+
+    DataEnv             dataEnv( (size_t) count * sizeof( int32_t ) + 16 );
+    BasicTypeScope      scope( typeEnv );
+    DataEnvBinder       binder( &dataEnv, &scope );
+
+    arrayAddr = dataEnv.Allocate( count * sizeof( int32_t ) );
+
+    for ( uint32_t i = 0; i < count; i++ )
+    {
+        int32_t     elem = (int32_t) i;
+        memcpy( dataEnv.GetBuffer() + arrayAddr + (i * sizeof elem), &elem, sizeof elem );
+    }
+
+    swprintf_s( arrayText, L"*cast(int[%u]*)%u", count, (uint32_t) arrayAddr );
+
+    hr = EvaluateText( arrayText, typeEnv, strTable, &binder, arrayResult );
+    if ( FAILED( hr ) )
+    {
+        out << "The array couldn't be evaluated: " << std::hex << hr << std::endl;
+        return 1;
+    }
+
+    // each element by its text
+    {
+        LARGE_INTEGER   start = { 0 };
+        LARGE_INTEGER   end = { 0 };
+        std::wstring    elemText;
+        wchar_t         indexStr[32] = L"";
+
+        QueryPerformanceCounter( &start );
+
+        for ( uint32_t i = 0; i < count; i++ )
+        {
+            MagoEE::EvalResult  result = { 0 };
+
+            swprintf_s( indexStr, L"[%u]", i );
+
+            elemText = L"(";
+            elemText.append( arrayText );
+            elemText.append( L")" );
+            elemText.append( indexStr );
+
+            hr = EvaluateText( elemText.c_str(), typeEnv, strTable, &binder, result );
+            if ( FAILED( hr ) )
+                return 1;
+
+            textSum += result.ObjVal.Value.UInt64Value;
+        }
+
+        QueryPerformanceCounter( &end );
+
+        out << "Element text:            " << count << " elements, "
+            << GetMicros( start, end ) << " us" << std::endl;
+    }
+
+    // with the enumerator, with and without full names
+    for ( int withFullNames = 1; withFullNames >= 0; withFullNames-- )
+    {
+        LARGE_INTEGER                   start = { 0 };
+        LARGE_INTEGER                   end = { 0 };
+        MagoEE::EvalOptions             options = { 0 };
+        MagoEE::FormatOptions           fmtopts( 10 );
+        RefPtr<MagoEE::IEEDEnumValues>  enumerator;
+        std::wstring                    name;
+        std::wstring                    fullName;
+        uint32_t                        elemCount = 0;
+        uint64_t                        enumSum = 0;
+
+        QueryPerformanceCounter( &start );
+
+        hr = MagoEE::EnumValueChildren( 
+            &binder, 
+            arrayText, 
+            arrayResult.ObjVal, 
+            typeEnv, 
+            strTable, 
+            fmtopts, 
+            enumerator.Ref() );
+        if ( FAILED( hr ) )
+            return 1;
+
+        while ( enumerator->GetIndex() < enumerator->GetCount() )
+        {
+            MagoEE::EvalResult  result = { 0 };
+
+            hr = enumerator->EvaluateNext( 
+                options, result, name, withFullNames ? &fullName : NULL );
+            if ( FAILED( hr ) )
+                return 1;
+
+            enumSum += result.ObjVal.Value.UInt64Value;
+            elemCount++;
+        }
+
+        QueryPerformanceCounter( &end );
+
+        out << (withFullNames ? "Enumerator, full names:  " : "Enumerator, names only:  ")
+            << elemCount << " elements, "
+            << GetMicros( start, end ) << " us" << std::endl;
+
+        if ( (elemCount != count) || (enumSum != textSum) )
+        {
+            out << "The enumerator's elements didn't match the text's." << std::endl;
+            return 1;
+        }
+    }
+
+    return 0;
+}
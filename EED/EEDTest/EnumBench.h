@@ -0,0 +1,16 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+
+// Expands an array of count ints the way a watch window does, and writes 
+// how long it took: by evaluating the text of each element, which is how 
+// elements used to be enumerated, and with the array enumerator, with and 
+// without the elements' full names. Returns non-zero if the enumerator's 
+// elements weren't the same as the text's.
+int RunEnumBench( uint32_t count, std::ostream& out );
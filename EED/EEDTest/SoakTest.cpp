@@ -0,0 +1,331 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#include "Common.h"
+#include "SoakTest.h"
+#include "DataEnv.h"
+
+
+namespace
+{
+    const uint32_t  WarmUpCount = 10000;
+    const uint32_t  ReportInterval = 100000;
+    const uint32_t  HeldCount = 16;
+    const uint32_t  BigStringInterval = 64;
+    const size_t    BigStringLength = 5000;
+    const uint32_t  BoundedSoakCount = WarmUpCount * 2;
+    const uint32_t  SweepGenerations = 128;     // more than the table's sweep interval
+    const uint32_t  ReleaseRounds = 32;
+    const uint32_t  ReleaseBatchSize = 256;
+
+    typedef std::vector< RefPtr<MagoEE::IEEDParsedExpr> >   ExprVector;
+
+    void Max( MagoEE::NameTableStats& peak, const MagoEE::NameTableStats& stats )
+    {
+        if ( stats.Strings > peak.Strings )
+            peak.Strings = stats.Strings;
+        if ( stats.Blocks > peak.Blocks )
+            peak.Blocks = stats.Blocks;
+        if ( stats.BlockBytes > peak.BlockBytes )
+            peak.BlockBytes = stats.BlockBytes;
+        if ( stats.HeldGenerations > peak.HeldGenerations )
+            peak.HeldGenerations = stats.HeldGenerations;
+    }
+
+    void PrintStats( const MagoEE::NameTableStats& stats, std::ostream& out )
+    {
+        out << stats.Strings << " strings, " 
+            << stats.Blocks << " blocks, " 
+            << stats.BlockBytes << " bytes, " 
+            << stats.HeldGenerations << " held generations" << std::endl;
+    }
+
+    // goes through enough empty generations that the table sweeps
+    void Sweep( MagoEE::NameTable* strTable )
+    {
+        for ( uint32_t i = 0; i < SweepGenerations; i++ )
+        {
+            strTable->EndGeneration( strTable->NewGeneration() );
+        }
+    }
+
+    bool CheckStrings( MagoEE::NameTable* strTable, uint32_t expected, const char* when, std::ostream& out )
+    {
+        MagoEE::NameTableStats  stats = { 0 };
+
+        strTable->GetStats( stats );
+        if ( stats.Strings == expected )
+            return true;
+
+        out << "The name table had " << stats.Strings << " strings instead of " 
+            << expected << " " << when << "." << std::endl;
+        return false;
+    }
+
+    int TestOpenGeneration( std::ostream& out )
+    {
+        HRESULT                         hr = S_OK;
+        RefPtr<MagoEE::NameTable>       strTable;
+
+        hr = MagoEE::MakeNameTable( strTable.Ref() );
+        if ( FAILED( hr ) )
+            return 1;
+
+        // a parse on another thread starts after this one, and ends first
+        uint32_t    older = strTable->NewGeneration();
+        uint32_t    newer = strTable->NewGeneration();
+
+        strTable->AddString( L"open", 4 );
+        strTable->EndGeneration( newer );
+
+        Sweep( strTable );
+        if ( !CheckStrings( strTable, 1, "while its parse was going on", out ) )
+            return 1;
+
+        // the older parse made an expression
+        strTable->HoldGeneration( older );
+        strTable->EndGeneration( older );
+
+        Sweep( strTable );
+        if ( !CheckStrings( strTable, 1, "while its expression was held", out ) )
+            return 1;
+
+        strTable->ReleaseGeneration( older );
+
+        Sweep( strTable );
+        if ( !CheckStrings( strTable, 0, "after its expression was released", out ) )
+            return 1;
+
+        return 0;
+    }
+
+    DWORD WINAPI ReleaseExprs( void* param )
+    {
+        ExprVector* exprs = (ExprVector*) param;
+
+        for ( ExprVector::iterator it = exprs->begin(); it != exprs->end(); it++ )
+        {
+            *it = NULL;
+        }
+
+        return 0;
+    }
+
+    int TestReleaseOnOtherThread( std::ostream& out )
+    {
+        HRESULT                         hr = S_OK;
+        RefPtr<MagoEE::ITypeEnv>        typeEnv;
+        RefPtr<MagoEE::NameTable>       strTable;
+        ExprVector                      exprs[2];
+        wchar_t                         text[64] = L"";
+        MagoEE::NameTableStats          stats = { 0 };
+
+        hr = MagoEE::MakeTypeEnv( 4, typeEnv.Ref() );
+        if ( FAILED( hr ) )
+            return 1;
+
+        hr = MagoEE::MakeNameTable( strTable.Ref() );
+        if ( FAILED( hr ) )
+            return 1;
+
+        for ( uint32_t round = 0; round < ReleaseRounds; round++ )
+        {
+            ExprVector& parsing = exprs[round % 2];
+            ExprVector& releasing = exprs[(round + 1) % 2];
+            HANDLE      thread = CreateThread( NULL, 0, ReleaseExprs, &releasing, 0, NULL );
+
+            if ( thread == NULL )
+                return 1;
+
+            for ( uint32_t i = 0; i < ReleaseBatchSize; i++ )
+            {
+                RefPtr<MagoEE::IEEDParsedExpr>  parsedExpr;
+
+                swprintf_s( text, L"thread%u + \"thread%u\"", round, i );
+
+                hr = MagoEE::ParseText( text, typeEnv, strTable, parsedExpr.Ref() );
+                if ( FAILED( hr ) )
+                {
+                    out << "Expression " << i << " of round " << round << " couldn't be parsed." << std::endl;
+                    WaitForSingleObject( thread, INFINITE );
+                    CloseHandle( thread );
+                    return 1;
+                }
+
+                parsing.push_back( parsedExpr );
+            }
+
+            WaitForSingleObject( thread, INFINITE );
+            CloseHandle( thread );
+            releasing.clear();
+        }
+
+        exprs[0].clear();
+        exprs[1].clear();
+
+        Sweep( strTable );
+        strTable->GetStats( stats );
+
+        if ( (stats.Strings != 0) || (stats.Blocks != 0) || (stats.HeldGenerations != 0) )
+        {
+            out << "The name table kept strings after all expressions were released: ";
+            PrintStats( stats, out );
+            return 1;
+        }
+
+        return 0;
+    }
+}
+
+
+int RunSoakTest( uint32_t count, std::ostream& out )
+{
+    HRESULT                         hr = S_OK;
+    RefPtr<MagoEE::ITypeEnv>        typeEnv;
+    RefPtr<MagoEE::NameTable>       strTable;
+    RefPtr<MagoEE::IEEDParsedExpr>  firstExpr;
+    RefPtr<MagoEE::IEEDParsedExpr>  heldExprs[HeldCount];
+    MagoEE::NameTableStats          warmUpPeak = { 0 };
+    MagoEE::NameTableStats          peak = { 0 };
+    std::wstring                    bigChars( BigStringLength, L'x' );
+    std::wstring                    text;
+    wchar_t                         numStr[32] = L"";
+
+    if ( count <= WarmUpCount )
+    {
+        out << "The soak test needs more than " << WarmUpCount << " expressions." << std::endl;
+        return 1;
+    }
+
+    hr = MagoEE::MakeTypeEnv( 4, typeEnv.Ref() );
+    if ( FAILED( hr ) )
+        return 1;
+
+    hr = MagoEE::MakeNameTable( strTable.Ref() );
+    if ( FAILED( hr ) )
+        return 1;
+
+    DataEnv             dataEnv( 16 );
+    BasicTypeScope      scope( typeEnv );
+    DataEnvBinder       binder( &dataEnv, &scope );
+
+    hr = MagoEE::ParseText( L"soakFirst + \"first\"", typeEnv, strTable, firstExpr.Ref() );
+    if ( FAILED( hr ) )
+        return 1;
+
+    for ( uint32_t i = 0; i < count; i++ )
+    {
+        RefPtr<MagoEE::IEEDParsedExpr>  parsedExpr;
+        MagoEE::NameTableStats          stats = { 0 };
+        bool                            evaluate = false;
+
+        swprintf_s( numStr, L"%u", i );
+
+        if ( (i % BigStringInterval) == BigStringInterval - 1 )
+        {
+            // a string too big to share a block
+            text = L"\"";
+            text.append( numStr );
+            text.append( bigChars );
+            text.append( L"\"" );
+        }
+        else
+        {
+            switch ( i % 3 )
+            {
+            case 0:
+                text = L"cast(uint)";
+                text.append( numStr );
+                text.append( L" + 1" );
+                evaluate = true;
+                break;
+
+            case 1:
+                text = L"soak";
+                text.append( numStr );
+                text.append( L" + 1" );
+                break;
+
+            case 2:
+                text = L"\"soak";
+                text.append( numStr );
+                text.append( L"\"" );
+                break;
+            }
+        }
+
+        hr = MagoEE::ParseText( text.c_str(), typeEnv, strTable, parsedExpr.Ref() );
+        if ( FAILED( hr ) )
+        {
+            out << "Expression " << i << " couldn't be parsed: " << std::hex << hr << std::endl;
+            return 1;
+        }
+
+        if ( evaluate )
+        {
+            MagoEE::EvalOptions options = { 0 };
+            MagoEE::EvalResult  result = { 0 };
+
+            hr = parsedExpr->Bind( options, &binder );
+            if ( SUCCEEDED( hr ) )
+                hr = parsedExpr->Evaluate( options, &binder, result );
+            if ( FAILED( hr ) || (result.ObjVal.Value.UInt64Value != (uint64_t) i + 1) )
+            {
+                out << "Expression " << i << " didn't evaluate." << std::endl;
+                return 1;
+            }
+        }
+
+        // the oldest watch goes away
+        heldExprs[i % HeldCount] = parsedExpr;
+
+        strTable->GetStats( stats );
+
+        if ( i < WarmUpCount )
+            Max( warmUpPeak, stats );
+        else
+            Max( peak, stats );
+
+        if ( ((i + 1) % ReportInterval) == 0 )
+        {
+            out << (i + 1) << " expressions: ";
+            PrintStats( stats, out );
+        }
+    }
+
+    out << "Peak in warm-up:         ";
+    PrintStats( warmUpPeak, out );
+    out << "Peak after warm-up:      ";
+    PrintStats( peak, out );
+
+    // The strings only come and go with the generations, so their count 
+    // repeats. The later numbers are longer, so the blocks get some slack.
+
+    if ( (peak.Strings > warmUpPeak.Strings)
+        || (peak.BlockBytes > warmUpPeak.BlockBytes * 2)
+        || (peak.HeldGenerations > HeldCount + 1) )
+    {
+        out << "The name table kept growing." << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+int RunNameTableTest( std::ostream& out )
+{
+    if ( RunSoakTest( BoundedSoakCount, out ) != 0 )
+        return 1;
+
+    if ( TestOpenGeneration( out ) != 0 )
+        return 1;
+
+    if ( TestReleaseOnOtherThread( out ) != 0 )
+        return 1;
+
+    return 0;
+}
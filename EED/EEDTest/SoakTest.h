@@ -0,0 +1,23 @@
+/*
+   Copyright (c) 2010 Aldo J. Nunez
+
+   Licensed under the Apache License, Version 2.0.
+   See the LICENSE text file for details.
+*/
+
+#pragma once
+
+
+// Parses count expressions with new identifiers and string literals in one 
+// name table, the way a long debugging session does, while holding the last 
+// few of them and the first one like watches. Writes the name table's size 
+// along the way. Returns non-zero if an expression failed, or if the table 
+// grew after the warm-up instead of staying bounded.
+// Run it with a count of 1000000 to soak the table.
+int RunSoakTest( uint32_t count, std::ostream& out );
+
+// Runs a short soak, then checks that a string added while an older parse 
+// is still going on lives as long as that parse's expression, and that 
+// expressions released on another thread while more are parsed leave 
+// nothing in the table. Returns non-zero if a check failed.
+int RunNameTableTest( std::ostream& out );
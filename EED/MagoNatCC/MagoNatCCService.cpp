@@ -83,6 +83,27 @@ public:
         return S_OK;
     }
 
+    virtual HRESULT ReadMemoryV( 
+        Mago::ICoreProcess* process, 
+        uint32_t rangeCount, 
+        Mago::ReadMemoryRange64* ranges, 
+        uint8_t** buffers )
+    {
+        for ( uint32_t i = 0; i < rangeCount; i++ )
+        {
+            Mago::ReadMemoryRange64& range = ranges[i];
+            HRESULT hr = ReadMemory( 
+                process, range.Addr, range.Length, range.LengthRead, range.LengthUnreadable, buffers[i] );
+            if ( FAILED( hr ) )
+            {
+                // one bad block doesn't keep the others from being read
+                range.LengthRead = 0;
+                range.LengthUnreadable = 0;
+            }
+        }
+        return S_OK;
+    }
+
     virtual HRESULT WriteMemory( 
         Mago::ICoreProcess* process, 
         Mago::Address64 address,
@@ -217,6 +238,10 @@ public:
         return E_NOINTERFACE;
     }
 
+protected:
+    // so that Release runs the data item's destructor
+    virtual ~CCDataItem() {}
+
 private:
     long mRefCount = 0;
 };
@@ -254,6 +279,11 @@ protected:
     CCModule() : mDRuntime(nullptr), mDebuggerProxy(nullptr) {}
     ~CCModule() 
     {
+        // the module's declaration cache holds the module through its 
+        // symbol store, and the program holds the module
+        if (mProgram)
+            mProgram->Dispose();
+
         delete mDRuntime;
         delete mDebuggerProxy;
     }
@@ -476,6 +506,44 @@ private:
     long mRefCount = 0;
 };
 
+///////////////////////////////////////////////////////////////////////////////
+// A frame's expression context is kept on the frame, so that the expressions 
+// evaluated in it are found again in the program's cache.
+class DECLSPEC_UUID("CB9F50ED-F73B-40BB-B669-22DBD7997A77") CCFrameContext : public CCDataItem<CCFrameContext>
+{
+public:
+    RefPtr<CCExprContext> mExprContext;
+
+protected:
+    ~CCFrameContext()
+    {
+        // the cached expressions hold the context
+        if (mExprContext)
+            mExprContext->Dispose();
+    }
+};
+
+static HRESULT getFrameContext(DkmProcess* process, CallStack::DkmStackWalkFrame* frame, RefPtr<CCExprContext>& exprContext)
+{
+    RefPtr<CCFrameContext> frameContext;
+    frame->GetDataItem(&frameContext.Ref());
+    if (frameContext)
+    {
+        exprContext = frameContext->mExprContext;
+        return S_OK;
+    }
+
+    tryHR(MakeCComObject(exprContext));
+    HRESULT hr = exprContext->Init(process, frame);
+    if (hr != S_OK)
+        return hr;
+
+    frameContext = new CCFrameContext;
+    frameContext->mExprContext = exprContext;
+    tryHR(frame->SetDataItem(DkmDataCreationDisposition::CreateAlways, frameContext.Get()));
+    return S_OK;
+}
+
 ///////////////////////////////////////////////////////////////////////////////
 CComPtr<DkmString> toDkmString(const wchar_t* str)
 {
@@ -636,25 +704,22 @@ HRESULT STDMETHODCALLTYPE CMagoNatCCService::EvaluateExpression(
     auto process = pInspectionContext->RuntimeInstance()->Process();
 
     RefPtr<CCExprContext> exprContext;
-    tryHR(MakeCComObject(exprContext));
-    tryHR(exprContext->Init(process, pStackFrame));
+    tryHR(getFrameContext(process, pStackFrame, exprContext));
 
     std::wstring exprText = pExpression->Text()->Value();
     MagoEE::FormatOptions fmtopt;
     tryHR(MagoEE::StripFormatSpecifier(exprText, fmtopt));
 
+    // the parsed and bound expression is cached by the frame's context
     RefPtr<MagoEE::IEEDParsedExpr> pExpr;
-    hr = MagoEE::ParseText(exprText.c_str(), exprContext->GetTypeEnv(), exprContext->GetStringTable(), pExpr.Ref());
+    hr = exprContext->GetParsedExpr(exprText.c_str(), 0, 0, pExpr.Ref());
     if (FAILED(hr))
         return createEvaluationError(pInspectionContext, pStackFrame, hr, pExpression, pCompletionRoutine);
 
     MagoEE::EvalOptions options = { 0 };
-    hr = pExpr->Bind(options, exprContext);
-    if (FAILED(hr))
-        return createEvaluationError(pInspectionContext, pStackFrame, hr, pExpression, pCompletionRoutine);
-
     MagoEE::EvalResult value = { 0 };
     hr = pExpr->Evaluate(options, exprContext, value);
+    exprContext->ReleaseParsedExpr(exprText.c_str(), 0, 0, pExpr);
     if (FAILED(hr))
         return createEvaluationError(pInspectionContext, pStackFrame, hr, pExpression, pCompletionRoutine);
 
@@ -718,9 +783,8 @@ HRESULT STDMETHODCALLTYPE CMagoNatCCService::GetFrameLocals(
     _In_ IDkmCompletionRoutine<Evaluation::DkmGetFrameLocalsAsyncResult>* pCompletionRoutine)
 {
     RefPtr<CCExprContext> exprContext;
-    tryHR(MakeCComObject(exprContext));
     auto process = pInspectionContext->RuntimeInstance()->Process();
-    tryHR(exprContext->Init(process, pStackFrame));
+    tryHR(getFrameContext(process, pStackFrame, exprContext));
 
     RefPtr<Mago::FrameProperty> frameProp;
     tryHR(MakeCComObject(frameProp));